@@ -204,6 +204,7 @@ const BlendFunc& AtlasNode::getBlendFunc() const
 void AtlasNode::setBlendFunc(const BlendFunc &blendFunc)
 {
     _blendFunc = blendFunc;
+    invalidateCachedAncestors();
 }
 
 void AtlasNode::updateBlendFunc()
@@ -225,6 +226,7 @@ void AtlasNode::setTexture(Texture2D *texture)
     _textureAtlas->setTexture(texture);
     this->updateBlendFunc();
     this->updateOpacityModifyRGB();
+    invalidateCachedAncestors();
 }
 
 Texture2D * AtlasNode::getTexture() const
@@ -237,6 +239,7 @@ void AtlasNode::setTextureAtlas(TextureAtlas* textureAtlas)
     CC_SAFE_RETAIN(textureAtlas);
     CC_SAFE_RELEASE(_textureAtlas);
     _textureAtlas = textureAtlas;
+    invalidateCachedAncestors();
 }
 
 TextureAtlas * AtlasNode::getTextureAtlas() const
@@ -252,6 +255,7 @@ ssize_t AtlasNode::getQuadsToDraw() const
 void AtlasNode::setQuadsToDraw(ssize_t quadsToDraw)
 {
     _quadsToDraw = quadsToDraw;
+    invalidateCachedAncestors();
 }
 
 NS_CC_END
@@ -29,8 +29,13 @@ THE SOFTWARE.
 #include "poly2tri/poly2tri.h"
 #include "base/CCDirector.h"
 #include "renderer/CCTextureCache.h"
+#include "platform/CCFileUtils.h"
+#include "base/CCAsyncTaskPool.h"
 #include "clipper/clipper.hpp"
+#include "xxhash.h"
 #include <algorithm>
+#include <unordered_map>
+#include <memory>
 #include <math.h>
 
 USING_NS_CC;
@@ -671,9 +676,244 @@ PolygonInfo AutoPolygon::generateTriangles(const Rect& rect, const float& epsilo
     ret.rect = realRect;
     return ret;
 }
+
+// polygon cache
+
+namespace
+{
+    const char POLYGON_CACHE_MAGIC[4] = { 'C', 'C', 'P', 'L' };
+    const uint32_t POLYGON_CACHE_VERSION = 1;
+    const char* POLYGON_CACHE_DIRECTORY = "polycache/";
+    const char* POLYGON_CACHE_EXTENSION = ".plyb";
+
+    bool s_cacheEnabled = false;
+    // only used on the main thread
+    std::unordered_map<std::string, PolygonInfo> s_cachedPolygons;
+    std::unordered_map<std::string, std::vector<AutoPolygon::PolygonCallback>> s_pendingPolygons;
+
+    // everything the worker thread needs, resolved on the main thread
+    struct PolygonRequest
+    {
+        std::string filename;
+        std::string fullPath;
+        std::string key;
+        std::string cachePath;
+        Rect rect;
+        float epsilon;
+        float threshold;
+        bool useCache;
+    };
+
+    PolygonRequest makePolygonRequest(const std::string& filename, const Rect& rect, float epsilon, float threshold)
+    {
+        auto fileUtils = FileUtils::getInstance();
+
+        PolygonRequest request;
+        request.filename = filename;
+        request.fullPath = fileUtils->fullPathForFilename(filename);
+        request.rect = rect;
+        request.epsilon = epsilon;
+        request.threshold = threshold;
+        request.useCache = s_cacheEnabled;
+
+        // the content scale factor changes the generated vertices
+        char settings[128];
+        snprintf(settings, sizeof(settings), "|%.3f,%.3f,%.3f,%.3f|%.3f|%.3f|%.3f",
+            rect.origin.x, rect.origin.y, rect.size.width, rect.size.height,
+            epsilon, threshold, Director::getInstance()->getContentScaleFactor());
+        request.key = request.fullPath + settings;
+
+        char name[16];
+        snprintf(name, sizeof(name), "%08x", XXH32(request.key.c_str(), static_cast<int>(request.key.size()), 0));
+        request.cachePath = fileUtils->getWritablePath() + POLYGON_CACHE_DIRECTORY + name + POLYGON_CACHE_EXTENSION;
+        return request;
+    }
+
+    template <typename T>
+    bool readValue(const Data& data, size_t& offset, T& value)
+    {
+        if (sizeof(T) > static_cast<size_t>(data.getSize()) - offset)
+            return false;
+        memcpy(&value, data.getBytes() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    void writeValue(std::vector<unsigned char>& buffer, const T& value)
+    {
+        auto bytes = reinterpret_cast<const unsigned char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    bool readCachedPolygon(const Data& data, const PolygonRequest& request, uint32_t sourceHash, PolygonInfo& info)
+    {
+        if (data.isNull())
+            return false;
+
+        size_t offset = 0;
+        char magic[4];
+        uint32_t version = 0, hash = 0, keyLength = 0;
+        if (!readValue(data, offset, magic) || memcmp(magic, POLYGON_CACHE_MAGIC, sizeof(magic)) != 0
+            || !readValue(data, offset, version) || version != POLYGON_CACHE_VERSION
+            || !readValue(data, offset, hash) || hash != sourceHash
+            || !readValue(data, offset, keyLength) || keyLength != request.key.size()
+            || keyLength > static_cast<size_t>(data.getSize()) - offset
+            || memcmp(data.getBytes() + offset, request.key.c_str(), keyLength) != 0)
+        {
+            return false;
+        }
+        offset += keyLength;
+
+        float rect[4];
+        uint32_t vertCount = 0, indexCount = 0;
+        if (!readValue(data, offset, rect) || !readValue(data, offset, vertCount) || !readValue(data, offset, indexCount))
+            return false;
+
+        size_t size = vertCount * sizeof(V3F_C4B_T2F) + indexCount * sizeof(unsigned short);
+        if (size != static_cast<size_t>(data.getSize()) - offset)
+            return false;
+
+        TrianglesCommand::Triangles triangles;
+        triangles.vertCount = static_cast<int>(vertCount);
+        triangles.indexCount = static_cast<int>(indexCount);
+        triangles.verts = new V3F_C4B_T2F[vertCount];
+        triangles.indices = new unsigned short[indexCount];
+        memcpy(triangles.verts, data.getBytes() + offset, vertCount * sizeof(V3F_C4B_T2F));
+        memcpy(triangles.indices, data.getBytes() + offset + vertCount * sizeof(V3F_C4B_T2F), indexCount * sizeof(unsigned short));
+
+        info.triangles = triangles;
+        info.rect = Rect(rect[0], rect[1], rect[2], rect[3]);
+        info.filename = request.filename;
+        return true;
+    }
+
+    bool writeCachedPolygon(const PolygonRequest& request, uint32_t sourceHash, const PolygonInfo& info)
+    {
+        std::vector<unsigned char> buffer;
+        buffer.insert(buffer.end(), POLYGON_CACHE_MAGIC, POLYGON_CACHE_MAGIC + sizeof(POLYGON_CACHE_MAGIC));
+        writeValue<uint32_t>(buffer, POLYGON_CACHE_VERSION);
+        writeValue<uint32_t>(buffer, sourceHash);
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(request.key.size()));
+        buffer.insert(buffer.end(), request.key.begin(), request.key.end());
+
+        float rect[4] = { info.rect.origin.x, info.rect.origin.y, info.rect.size.width, info.rect.size.height };
+        writeValue(buffer, rect);
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(info.triangles.vertCount));
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(info.triangles.indexCount));
+        auto verts = reinterpret_cast<const unsigned char*>(info.triangles.verts);
+        buffer.insert(buffer.end(), verts, verts + info.triangles.vertCount * sizeof(V3F_C4B_T2F));
+        auto indices = reinterpret_cast<const unsigned char*>(info.triangles.indices);
+        buffer.insert(buffer.end(), indices, indices + info.triangles.indexCount * sizeof(unsigned short));
+
+        Data data;
+        data.copy(buffer.data(), buffer.size());
+        return FileUtils::getInstance()->writeDataToFile(data, request.cachePath);
+    }
+
+    // can run on the worker thread, it only uses the resolved paths of the request
+    void loadPolygon(const PolygonRequest& request, PolygonInfo& info)
+    {
+        uint32_t sourceHash = 0;
+        if (request.useCache)
+        {
+            auto fileUtils = FileUtils::getInstance();
+            Data source = fileUtils->getDataFromFile(request.fullPath);
+            sourceHash = XXH32(source.getBytes(), static_cast<int>(source.getSize()), 0);
+            if (readCachedPolygon(fileUtils->getDataFromFile(request.cachePath), request, sourceHash, info))
+                return;
+        }
+
+        AutoPolygon ap(request.fullPath);
+        info = ap.generateTriangles(request.rect, request.epsilon, request.threshold);
+        info.filename = request.filename;
+
+        if (request.useCache && info.triangles.vertCount > 0 && !writeCachedPolygon(request, sourceHash, info))
+        {
+            CCLOG("cocos2d: AutoPolygon: failed to write the cached polygon of %s", request.filename.c_str());
+        }
+    }
+}
+
 PolygonInfo AutoPolygon::generatePolygon(const std::string& filename, const Rect& rect, const float epsilon, const float threshold)
 {
-    AutoPolygon ap(filename);
-    auto ret = ap.generateTriangles(rect, epsilon, threshold);
+    if (!s_cacheEnabled)
+    {
+        AutoPolygon ap(filename);
+        auto ret = ap.generateTriangles(rect, epsilon, threshold);
+        return ret;
+    }
+
+    auto request = makePolygonRequest(filename, rect, epsilon, threshold);
+    auto it = s_cachedPolygons.find(request.key);
+    if (it != s_cachedPolygons.end())
+        return it->second;
+
+    PolygonInfo ret;
+    loadPolygon(request, ret);
+    s_cachedPolygons[request.key] = ret;
     return ret;
 }
+
+void AutoPolygon::generatePolygonAsync(const std::string& filename, const PolygonCallback& callback, const Rect& rect, const float epsilon, const float threshold)
+{
+    auto request = makePolygonRequest(filename, rect, epsilon, threshold);
+    if (s_cacheEnabled)
+    {
+        auto it = s_cachedPolygons.find(request.key);
+        if (it != s_cachedPolygons.end())
+        {
+            callback(it->second);
+            return;
+        }
+    }
+
+    auto& callbacks = s_pendingPolygons[request.key];
+    callbacks.push_back(callback);
+    if (callbacks.size() > 1)
+        return;
+
+    auto info = std::make_shared<PolygonInfo>();
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, [request, info](void*) {
+        if (s_cacheEnabled)
+        {
+            s_cachedPolygons[request.key] = *info;
+        }
+
+        auto it = s_pendingPolygons.find(request.key);
+        if (it == s_pendingPolygons.end())
+            return;
+        auto pending = std::move(it->second);
+        s_pendingPolygons.erase(it);
+        for (const auto& callback : pending)
+        {
+            callback(*info);
+        }
+    }, nullptr, [request, info]() {
+        loadPolygon(request, *info);
+    });
+}
+
+void AutoPolygon::setCacheEnabled(bool enabled)
+{
+    if (enabled && !s_cacheEnabled)
+    {
+        auto fileUtils = FileUtils::getInstance();
+        fileUtils->createDirectory(fileUtils->getWritablePath() + POLYGON_CACHE_DIRECTORY);
+    }
+    s_cacheEnabled = enabled;
+    if (!enabled)
+    {
+        s_cachedPolygons.clear();
+    }
+}
+
+bool AutoPolygon::isCacheEnabled()
+{
+    return s_cacheEnabled;
+}
+
+void AutoPolygon::purgeCachedPolygons()
+{
+    s_cachedPolygons.clear();
+}
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include <string>
 #include <vector>
+#include <functional>
 #include "platform/CCImage.h"
 #include "renderer/CCTrianglesCommand.h"
 
@@ -246,6 +247,35 @@ public:
      * @endcode
      */
     static PolygonInfo generatePolygon(const std::string& filename, const Rect& rect = Rect::ZERO, const float epsilon = 2.0, const float threshold = 0.05);
+
+    /** Callback of generatePolygonAsync, called on the main thread. */
+    typedef std::function<void(const PolygonInfo&)> PolygonCallback;
+
+    /**
+     * same as generatePolygon, but the image is decoded and traced on the AsyncTaskPool
+     * requests for the same file and settings that are already running share the result
+     * @param   filename     A path to image file, e.g., "scene1/monster.png".
+     * @param   callback     called on the main thread with the generated polygon
+     * @param   rect    texture rect, use Rect::ZERO for the size of the texture, default is Rect::ZERO
+     * @param   epsilon the value used to reduce and expand, default to 2.0
+     * @param   threshold   the value where bigger than the threshold will be counted as opaque, used in trace
+     * @code
+     * auto sp = Sprite::create("grossini.png");
+     * AutoPolygon::generatePolygonAsync("grossini.png", [sp](const PolygonInfo& info){ sp->setPolygonInfo(info); });
+     * @endcode
+     */
+    static void generatePolygonAsync(const std::string& filename, const PolygonCallback& callback, const Rect& rect = Rect::ZERO, const float epsilon = 2.0, const float threshold = 0.05);
+
+    /**
+     * enables the polygon cache used by generatePolygon and generatePolygonAsync
+     * generated polygons are kept in memory and written to the writable path, keyed by file, rect, epsilon, threshold
+     * and content scale factor, so they are only traced again when the image changes. It is disabled by default.
+     */
+    static void setCacheEnabled(bool enabled);
+    static bool isCacheEnabled();
+
+    /** releases the polygons kept in memory, the ones written to the writable path are kept */
+    static void purgeCachedPolygons();
 protected:
     Vec2 findFirstNoneTransparentPixel(const Rect& rect, const float& threshold);
     std::vector<cocos2d::Vec2> marchSquare(const Rect& rect, const Vec2& first, const float& threshold);
@@ -0,0 +1,240 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/CCCachedNode.h"
+#include "2d/CCRenderTexture.h"
+#include "2d/CCSprite.h"
+#include "base/CCDirector.h"
+#include "base/CCEventType.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCEventDispatcher.h"
+#include "renderer/CCRenderer.h"
+
+NS_CC_BEGIN
+
+int CachedNode::s_instanceCount = 0;
+
+CachedNode* CachedNode::create()
+{
+    CachedNode* ret = new (std::nothrow) CachedNode();
+    if (ret && ret->init())
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+CachedNode* CachedNode::create(const Size& size)
+{
+    CachedNode* ret = create();
+    if (ret)
+    {
+        ret->setContentSize(size);
+    }
+    return ret;
+}
+
+CachedNode::CachedNode()
+: _renderTexture(nullptr)
+, _cacheDirty(true)
+, _renderingChildren(false)
+, _invalidationCount(0)
+, _renderCount(0)
+{
+    _cachesSubtree = true;
+    ++s_instanceCount;
+}
+
+CachedNode::~CachedNode()
+{
+    CC_SAFE_RELEASE(_renderTexture);
+    --s_instanceCount;
+}
+
+bool CachedNode::init()
+{
+    if (!Node::init())
+    {
+        return false;
+    }
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // the content of the render texture is lost with the GL context
+    auto listener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom* event){
+        this->invalidate();
+    });
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+#endif
+
+    return true;
+}
+
+void CachedNode::invalidate()
+{
+    if (invalidateBy(nullptr))
+    {
+        invalidateCachedAncestors();
+    }
+}
+
+bool CachedNode::invalidateBy(Node* source)
+{
+    // the changes made by the children while they are rendered are already in the texture
+    if (_cacheDirty || _renderingChildren)
+    {
+        return false;
+    }
+
+    _cacheDirty = true;
+    ++_invalidationCount;
+
+    if (_invalidationCallback)
+    {
+        _invalidationCallback(this, source);
+    }
+    return true;
+}
+
+void CachedNode::resetStats()
+{
+    _invalidationCount = 0;
+    _renderCount = 0;
+}
+
+void CachedNode::setContentSize(const Size& contentSize)
+{
+    bool changed = !contentSize.equals(_contentSize);
+
+    Node::setContentSize(contentSize);
+
+    if (changed)
+    {
+        invalidate();
+    }
+}
+
+bool CachedNode::updateRenderTexture()
+{
+    Size size(ceilf(_contentSize.width), ceilf(_contentSize.height));
+    if (size.width <= 0 || size.height <= 0)
+    {
+        return false;
+    }
+
+    if (_renderTexture && size.equals(_renderTextureSize))
+    {
+        return true;
+    }
+
+    CC_SAFE_RELEASE_NULL(_renderTexture);
+
+    // the stencil buffer is needed by the clipping nodes
+    _renderTexture = RenderTexture::create(static_cast<int>(size.width), static_cast<int>(size.height), Texture2D::PixelFormat::RGBA8888, GL_DEPTH24_STENCIL8);
+    if (!_renderTexture)
+    {
+        CCLOG("cocos2d: CachedNode: couldn't create a render texture of %d x %d", static_cast<int>(size.width), static_cast<int>(size.height));
+        return false;
+    }
+    _renderTexture->retain();
+    // renderChildren() sets a projection matching the space of the node
+    _renderTexture->setKeepMatrix(true);
+    _renderTexture->getSprite()->setAnchorPoint(Vec2::ANCHOR_BOTTOM_LEFT);
+    _renderTextureSize = size;
+
+    return true;
+}
+
+void CachedNode::renderChildren(Renderer* renderer, uint32_t flags)
+{
+    _renderingChildren = true;
+
+    // the children are visited with transforms relative to this node, the culling would test them against the screen
+    bool cullingEnabled = renderer->isCullingEnabled();
+    renderer->setCullingEnabled(false);
+
+    Mat4 projection;
+    Mat4::createOrthographicOffCenter(0, _renderTextureSize.width, 0, _renderTextureSize.height, -1024, 1024, &projection);
+    _director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION);
+    _director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION, projection);
+
+    _renderTexture->beginWithClear(0, 0, 0, 0, 1, 0);
+
+    sortAllChildren();
+    // the transforms of the children were computed in the space of the previous parent, or not at all
+    uint32_t childFlags = FLAGS_TRANSFORM_DIRTY | (flags & FLAGS_CONTENT_SIZE_DIRTY);
+    for (const auto& child : _children)
+    {
+        child->visit(renderer, Mat4::IDENTITY, childFlags);
+    }
+
+    _renderTexture->end();
+
+    _director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION);
+    renderer->setCullingEnabled(cullingEnabled);
+
+    _renderingChildren = false;
+    _cacheDirty = false;
+    ++_renderCount;
+}
+
+void CachedNode::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags)
+{
+    if (!_visible)
+    {
+        return;
+    }
+
+    if (_cacheDirty && !updateRenderTexture())
+    {
+        // nothing to cache into, the children are drawn as usual
+        Node::visit(renderer, parentTransform, parentFlags);
+        return;
+    }
+
+    uint32_t flags = processParentFlags(parentTransform, parentFlags);
+
+    if (!isVisitableByVisitingCamera())
+    {
+        return;
+    }
+
+    if (_cacheDirty)
+    {
+        renderChildren(renderer, flags);
+    }
+
+    _director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+    _director->loadMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform);
+
+    auto sprite = _renderTexture->getSprite();
+    sprite->setCameraMask(getCameraMask(), false);
+    sprite->visit(renderer, _modelViewTransform, flags);
+
+    _director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
+}
+
+NS_CC_END
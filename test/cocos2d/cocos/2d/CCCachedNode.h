@@ -0,0 +1,122 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CCCACHEDNODE_H__
+#define __CCCACHEDNODE_H__
+
+#include <functional>
+
+#include "2d/CCNode.h"
+
+NS_CC_BEGIN
+
+class RenderTexture;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** @class CachedNode
+ * @brief A container that renders its children once into an offscreen texture and then draws this texture as a single quad.
+ *
+ * It suits static subtrees made of many nodes, like the panels of a user interface.
+ * The children are rendered again only when one of its descendants changes its transform, visibility, color, z order,
+ * hierarchy or content, see Node::invalidateCachedAncestors(). Moving the CachedNode itself doesn't render them again.
+ * The engine nodes drawing their own content, like DrawNode, ProgressTimer, LabelAtlas or ui::RichText, invalidate it when
+ * this content changes. Running particle systems and motion streaks invalidate it every frame, the cache doesn't save anything
+ * while they are animated. Custom nodes changing what they draw without a setter of Node must call invalidateCachedAncestors().
+ * The texture covers the content size of the CachedNode, what is drawn outside of it is clipped.
+ * The subtree is rendered with the camera that visits the CachedNode first, the children should use the camera mask of the CachedNode.
+ */
+class CC_DLL CachedNode : public Node
+{
+public:
+    /** Called when the cache is invalidated, with the descendant that changed or nullptr if invalidate() was called. */
+    typedef std::function<void(CachedNode*, Node*)> InvalidationCallback;
+
+    /** Creates a CachedNode, its content size must be set before it is drawn. */
+    static CachedNode* create();
+    /** Creates a CachedNode of the given size. */
+    static CachedNode* create(const Size& size);
+
+    /** Renders the children again at the next visit. */
+    void invalidate();
+    /** Returns true if the children will be rendered again at the next visit. */
+    bool isCacheDirty() const { return _cacheDirty; }
+
+    /** Number of times the cache was invalidated since the last resetStats(). */
+    unsigned int getInvalidationCount() const { return _invalidationCount; }
+    /** Number of times the children were rendered into the texture since the last resetStats(). */
+    unsigned int getRenderCount() const { return _renderCount; }
+    /** Resets the invalidation and render counts. */
+    void resetStats();
+
+    /** Sets a function called each time the cache is invalidated, to track which nodes break the cache for instance. */
+    void setInvalidationCallback(const InvalidationCallback& callback) { _invalidationCallback = callback; }
+
+    /** Returns the render texture holding the children, nullptr until they are rendered. */
+    RenderTexture* getRenderTexture() const { return _renderTexture; }
+
+    // Overrides
+    virtual void visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t parentFlags) override;
+    virtual void setContentSize(const Size& contentSize) override;
+
+CC_CONSTRUCTOR_ACCESS:
+    CachedNode();
+    virtual ~CachedNode();
+
+    virtual bool init() override;
+
+protected:
+    // returns false when the ancestors of this node don't have to be invalidated
+    bool invalidateBy(Node* source);
+    bool updateRenderTexture();
+    void renderChildren(Renderer* renderer, uint32_t flags);
+
+    RenderTexture* _renderTexture;
+    // size of _renderTexture in points
+    Size _renderTextureSize;
+    bool _cacheDirty;
+    bool _renderingChildren;
+    unsigned int _invalidationCount;
+    unsigned int _renderCount;
+    InvalidationCallback _invalidationCallback;
+
+    // number of instances alive, Node::invalidateCachedAncestors() returns at once when it is 0
+    static int s_instanceCount;
+
+    friend class Node;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(CachedNode);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CCCACHEDNODE_H__
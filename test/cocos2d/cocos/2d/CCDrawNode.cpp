@@ -33,6 +33,9 @@
 #include "base/CCEventDispatcher.h"
 #include "2d/CCActionCatmullRom.h"
 #include "platform/CCGL.h"
+#include "xxhash.h"
+
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -102,6 +105,43 @@ static inline Tex2F __t(const Vec2 &v)
     return *(Tex2F*)&v;
 }
 
+static const size_t MAX_CACHED_POLYGONS = 32;
+// the retained buffer is compacted once it has more free vertices than this and than used ones
+static const GLsizei MIN_COMPACTED_VERTICES = 1024;
+
+// cos and sin of the segments of a circle, shared by all the nodes
+static const std::vector<Vec2>& getUnitCircle(unsigned int segments)
+{
+    static std::unordered_map<unsigned int, std::vector<Vec2>> s_unitCircles;
+
+    auto& circle = s_unitCircles[segments];
+    if (circle.empty())
+    {
+        const float coef = 2.0f * (float)M_PI/segments;
+        circle.resize(segments + 1);
+        for (unsigned int i = 0; i <= segments; i++)
+        {
+            circle[i] = v2fforangle(i*coef);
+        }
+    }
+    return circle;
+}
+
+static uint32_t hashPolygon(const Vec2 *verts, int count)
+{
+    return XXH32(verts, static_cast<int>(sizeof(Vec2) * count), static_cast<unsigned int>(count));
+}
+
+static void setVertexAttribPointers()
+{
+    // vertex
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(V2F_C4B_T2F), (GLvoid *)offsetof(V2F_C4B_T2F, vertices));
+    // color
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(V2F_C4B_T2F), (GLvoid *)offsetof(V2F_C4B_T2F, colors));
+    // texcood
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V2F_C4B_T2F), (GLvoid *)offsetof(V2F_C4B_T2F, texCoords));
+}
+
 // implementation of DrawNode
 
 DrawNode::DrawNode(int lineWidth)
@@ -120,6 +160,20 @@ DrawNode::DrawNode(int lineWidth)
 , _bufferCapacityGLLine(0)
 , _bufferCountGLLine(0)
 , _bufferGLLine(nullptr)
+, _vaoRetained(0)
+, _vboRetained(0)
+, _bufferCapacityRetained(0)
+, _bufferCountRetained(0)
+, _bufferRetained(nullptr)
+, _vboCapacityRetained(0)
+, _dirtyRetainedBegin(0)
+, _dirtyRetainedEnd(0)
+, _freeCountRetained(0)
+, _nextPrimitiveHandle(0)
+, _recordingPrimitive(0)
+, _recordingStart(0)
+, _recordingDirty(false)
+, _polygonCacheEnabled(false)
 , _dirty(false)
 , _dirtyGLPoint(false)
 , _dirtyGLLine(false)
@@ -137,13 +191,17 @@ DrawNode::~DrawNode()
     _bufferGLPoint = nullptr;
     free(_bufferGLLine);
     _bufferGLLine = nullptr;
+    delete [] _bufferRetained;
+    _bufferRetained = nullptr;
     
     glDeleteBuffers(1, &_vbo);
     glDeleteBuffers(1, &_vboGLLine);
     glDeleteBuffers(1, &_vboGLPoint);
+    glDeleteBuffers(1, &_vboRetained);
     _vbo = 0;
     _vboGLPoint = 0;
     _vboGLLine = 0;
+    _vboRetained = 0;
     
     if (Configuration::getInstance()->supportsShareableVAO())
     {
@@ -151,7 +209,8 @@ DrawNode::~DrawNode()
         glDeleteVertexArrays(1, &_vao);
         glDeleteVertexArrays(1, &_vaoGLLine);
         glDeleteVertexArrays(1, &_vaoGLPoint);
-        _vao = _vaoGLLine = _vaoGLPoint = 0;
+        glDeleteVertexArrays(1, &_vaoRetained);
+        _vao = _vaoGLLine = _vaoGLPoint = _vaoRetained = 0;
     }
 }
 
@@ -173,6 +232,8 @@ DrawNode* DrawNode::create(int defaultLineWidth)
 void DrawNode::ensureCapacity(int count)
 {
     CCASSERT(count>=0, "capacity must be >= 0");
+    // all the draw functions add their vertices through one of the ensureCapacity functions
+    invalidateCachedAncestors();
     
     if(_bufferCount + count > _bufferCapacity)
     {
@@ -184,6 +245,7 @@ void DrawNode::ensureCapacity(int count)
 void DrawNode::ensureCapacityGLPoint(int count)
 {
     CCASSERT(count>=0, "capacity must be >= 0");
+    invalidateCachedAncestors();
     
     if(_bufferCountGLPoint + count > _bufferCapacityGLPoint)
     {
@@ -195,6 +257,7 @@ void DrawNode::ensureCapacityGLPoint(int count)
 void DrawNode::ensureCapacityGLLine(int count)
 {
     CCASSERT(count>=0, "capacity must be >= 0");
+    invalidateCachedAncestors();
     
     if(_bufferCountGLLine + count > _bufferCapacityGLLine)
     {
@@ -260,6 +323,16 @@ bool DrawNode::init()
         glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
         glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V2F_C4B_T2F), (GLvoid *)offsetof(V2F_C4B_T2F, texCoords));
         
+        // retained primitives, the storage is allocated by uploadRetained()
+        glGenVertexArrays(1, &_vaoRetained);
+        GL::bindVAO(_vaoRetained);
+        glGenBuffers(1, &_vboRetained);
+        glBindBuffer(GL_ARRAY_BUFFER, _vboRetained);
+        glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_POSITION);
+        glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_COLOR);
+        glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
+        setVertexAttribPointers();
+        
         GL::bindVAO(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         
@@ -278,11 +351,14 @@ bool DrawNode::init()
         glBindBuffer(GL_ARRAY_BUFFER, _vboGLPoint);
         glBufferData(GL_ARRAY_BUFFER, sizeof(V2F_C4B_T2F)*_bufferCapacityGLPoint, _bufferGLPoint, GL_STREAM_DRAW);
 
+        glGenBuffers(1, &_vboRetained);
+
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
     
     CHECK_GL_ERROR_DEBUG();
     
+    _vboCapacityRetained = 0;
     _dirty = true;
     _dirtyGLLine = true;
     _dirtyGLPoint = true;
@@ -302,7 +378,7 @@ bool DrawNode::init()
 
 void DrawNode::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
-    if(_bufferCount)
+    if(_bufferCount || _bufferCountRetained)
     {
         _customCommand.init(_globalZOrder, transform, flags);
         _customCommand.func = CC_CALLBACK_0(DrawNode::onDraw, this, transform, flags);
@@ -332,6 +408,34 @@ void DrawNode::onDraw(const Mat4 &transform, uint32_t flags)
     
     GL::blendFunc(_blendFunc.src, _blendFunc.dst);
 
+    if (_bufferCountRetained)
+    {
+        uploadRetained();
+        if (Configuration::getInstance()->supportsShareableVAO())
+        {
+            GL::bindVAO(_vaoRetained);
+        }
+        else
+        {
+            GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+            glBindBuffer(GL_ARRAY_BUFFER, _vboRetained);
+            setVertexAttribPointers();
+        }
+        glDrawArrays(GL_TRIANGLES, 0, _bufferCountRetained);
+        CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _bufferCountRetained);
+    }
+
+    if (!_bufferCount)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (Configuration::getInstance()->supportsShareableVAO())
+        {
+            GL::bindVAO(0);
+        }
+        CHECK_GL_ERROR_DEBUG();
+        return;
+    }
+
     if (_dirty)
     {
         glBindBuffer(GL_ARRAY_BUFFER, _vbo);
@@ -550,19 +654,17 @@ void DrawNode::drawPoly(const Vec2 *poli, unsigned int numberOfPoints, bool clos
 
 void DrawNode::drawCircle(const Vec2& center, float radius, float angle, unsigned int segments, bool drawLineToCenter, float scaleX, float scaleY, const Color4F &color)
 {
-    const float coef = 2.0f * (float)M_PI/segments;
+    const std::vector<Vec2>& circle = getUnitCircle(segments);
+    const float c = cosf(angle);
+    const float s = sinf(angle);
     
     Vec2 *vertices = new (std::nothrow) Vec2[segments+2];
     if( ! vertices )
         return;
     
     for(unsigned int i = 0;i <= segments; i++) {
-        float rads = i*coef;
-        GLfloat j = radius * cosf(rads + angle) * scaleX + center.x;
-        GLfloat k = radius * sinf(rads + angle) * scaleY + center.y;
-        
-        vertices[i].x = j;
-        vertices[i].y = k;
+        vertices[i].x = radius * (circle[i].x * c - circle[i].y * s) * scaleX + center.x;
+        vertices[i].y = radius * (circle[i].y * c + circle[i].x * s) * scaleY + center.y;
     }
     if(drawLineToCenter)
     {
@@ -775,6 +877,10 @@ void DrawNode::drawPolygon(const Vec2 *verts, int count, const Color4F &fillColo
     
     bool outline = (borderColor.a > 0.0 && borderWidth > 0.0);
     
+    // extruding the outline is the expensive part, reuse it when the same polygon is drawn again
+    if (_polygonCacheEnabled && outline && count >= 3 && drawCachedPolygon(verts, count, fillColor, borderWidth, borderColor))
+        return;
+    
     auto  triangle_count = outline ? (3*count - 2) : (count - 2);
     auto vertex_count = 3*triangle_count;
     ensureCapacity(vertex_count);
@@ -845,6 +951,11 @@ void DrawNode::drawPolygon(const Vec2 *verts, int count, const Color4F &fillColo
         }
         
         free(extrude);
+        
+        if (_polygonCacheEnabled && count >= 3)
+        {
+            cachePolygon(verts, count, fillColor, borderWidth, borderColor, _bufferCount);
+        }
     }
     
     _bufferCount += vertex_count;
@@ -871,7 +982,9 @@ void DrawNode::drawSolidPoly(const Vec2 *poli, unsigned int numberOfPoints, cons
 
 void DrawNode::drawSolidCircle(const Vec2& center, float radius, float angle, unsigned int segments, float scaleX, float scaleY, const Color4F &color)
 {
-    const float coef = 2.0f * (float)M_PI/segments;
+    const std::vector<Vec2>& circle = getUnitCircle(segments);
+    const float c = cosf(angle);
+    const float s = sinf(angle);
     
     Vec2 *vertices = new (std::nothrow) Vec2[segments];
     if( ! vertices )
@@ -879,12 +992,8 @@ void DrawNode::drawSolidCircle(const Vec2& center, float radius, float angle, un
     
     for(unsigned int i = 0;i < segments; i++)
     {
-        float rads = i*coef;
-        GLfloat j = radius * cosf(rads + angle) * scaleX + center.x;
-        GLfloat k = radius * sinf(rads + angle) * scaleY + center.y;
-        
-        vertices[i].x = j;
-        vertices[i].y = k;
+        vertices[i].x = radius * (circle[i].x * c - circle[i].y * s) * scaleX + center.x;
+        vertices[i].y = radius * (circle[i].y * c + circle[i].x * s) * scaleY + center.y;
     }
     
     drawSolidPoly(vertices, segments, color);
@@ -920,15 +1029,274 @@ void DrawNode::drawQuadraticBezier(const Vec2& from, const Vec2& control, const
     drawQuadBezier(from, control, to, segments, color);
 }
 
+bool DrawNode::drawCachedPolygon(const Vec2 *verts, int count, const Color4F &fillColor, float borderWidth, const Color4F &borderColor)
+{
+    auto it = _polygonCache.find(hashPolygon(verts, count));
+    if (it == _polygonCache.end())
+        return false;
+    
+    const PolygonTessellation& tessellation = it->second;
+    if (tessellation.verts.size() != static_cast<size_t>(count)
+        || memcmp(tessellation.verts.data(), verts, sizeof(Vec2) * count) != 0
+        || tessellation.fillColor != fillColor
+        || tessellation.borderWidth != borderWidth
+        || tessellation.borderColor != borderColor)
+    {
+        return false;
+    }
+    
+    auto vertex_count = static_cast<int>(tessellation.vertices.size());
+    ensureCapacity(vertex_count);
+    std::copy(tessellation.vertices.begin(), tessellation.vertices.end(), _buffer + _bufferCount);
+    _bufferCount += vertex_count;
+    _dirty = true;
+    return true;
+}
+
+void DrawNode::cachePolygon(const Vec2 *verts, int count, const Color4F &fillColor, float borderWidth, const Color4F &borderColor, GLsizei start)
+{
+    uint32_t key = hashPolygon(verts, count);
+    if (_polygonCache.size() >= MAX_CACHED_POLYGONS && _polygonCache.find(key) == _polygonCache.end())
+    {
+        _polygonCache.clear();
+    }
+    
+    PolygonTessellation& tessellation = _polygonCache[key];
+    tessellation.verts.assign(verts, verts + count);
+    tessellation.fillColor = fillColor;
+    tessellation.borderWidth = borderWidth;
+    tessellation.borderColor = borderColor;
+    tessellation.vertices.assign(_buffer + start, _buffer + start + 3 * (3 * count - 2));
+}
+
+unsigned int DrawNode::beginPrimitive(unsigned int handle)
+{
+    CCASSERT(_recordingPrimitive == 0, "endPrimitive() must be called before recording another primitive");
+    CCASSERT(handle == 0 || hasPrimitive(handle), "invalid primitive handle");
+    
+    if (handle == 0 || !hasPrimitive(handle))
+    {
+        handle = ++_nextPrimitiveHandle;
+    }
+    
+    _recordingPrimitive = handle;
+    _recordingStart = _bufferCount;
+    _recordingDirty = _dirty;
+    return handle;
+}
+
+void DrawNode::endPrimitive()
+{
+    CCASSERT(_recordingPrimitive != 0, "beginPrimitive() wasn't called");
+    if (_recordingPrimitive == 0)
+        return;
+    
+    GLsizei count = _bufferCount - _recordingStart;
+    const V2F_C4B_T2F* vertices = _buffer + _recordingStart;
+    
+    auto it = _primitives.find(_recordingPrimitive);
+    if (it != _primitives.end() && count <= it->second.capacity)
+    {
+        // fits in its slot, only upload it if it changed
+        RetainedPrimitive& primitive = it->second;
+        V2F_C4B_T2F* slot = _bufferRetained + primitive.offset;
+        if (count != primitive.count || memcmp(slot, vertices, sizeof(V2F_C4B_T2F) * count) != 0)
+        {
+            std::copy(vertices, vertices + count, slot);
+            if (count < primitive.count)
+            {
+                std::fill(slot + count, slot + primitive.count, V2F_C4B_T2F());
+            }
+            markRetainedDirty(primitive.offset, primitive.offset + std::max(count, primitive.count));
+            primitive.count = count;
+        }
+    }
+    else
+    {
+        if (it != _primitives.end())
+        {
+            releaseRetained(it->second);
+        }
+        
+        RetainedPrimitive primitive;
+        primitive.offset = allocateRetained(count);
+        primitive.count = count;
+        primitive.capacity = count;
+        std::copy(vertices, vertices + count, _bufferRetained + primitive.offset);
+        markRetainedDirty(primitive.offset, primitive.offset + count);
+        _primitives[_recordingPrimitive] = primitive;
+    }
+    
+    // the recorded geometry doesn't belong to the immediate buffer
+    _bufferCount = _recordingStart;
+    _dirty = _recordingDirty;
+    _recordingPrimitive = 0;
+    
+    compactRetained();
+}
+
+void DrawNode::removePrimitive(unsigned int handle)
+{
+    auto it = _primitives.find(handle);
+    if (it == _primitives.end())
+        return;
+    
+    releaseRetained(it->second);
+    _primitives.erase(it);
+    compactRetained();
+}
+
+bool DrawNode::hasPrimitive(unsigned int handle) const
+{
+    return _primitives.find(handle) != _primitives.end();
+}
+
+void DrawNode::clearPrimitives()
+{
+    invalidateCachedAncestors();
+    _primitives.clear();
+    _freeRetained.clear();
+    _freeCountRetained = 0;
+    _bufferCountRetained = 0;
+    _dirtyRetainedBegin = _dirtyRetainedEnd = 0;
+}
+
+GLsizei DrawNode::allocateRetained(GLsizei count)
+{
+    if (count == 0)
+        return 0;
+    
+    for (auto it = _freeRetained.begin(); it != _freeRetained.end(); ++it)
+    {
+        if (it->capacity >= count)
+        {
+            GLsizei offset = it->offset;
+            it->offset += count;
+            it->capacity -= count;
+            if (it->capacity == 0)
+            {
+                _freeRetained.erase(it);
+            }
+            _freeCountRetained -= count;
+            return offset;
+        }
+    }
+    
+    if (_bufferCountRetained + count > _bufferCapacityRetained)
+    {
+        _bufferCapacityRetained += std::max(_bufferCapacityRetained, count);
+        auto buffer = new V2F_C4B_T2F[_bufferCapacityRetained];
+        std::copy(_bufferRetained, _bufferRetained + _bufferCountRetained, buffer);
+        delete [] _bufferRetained;
+        _bufferRetained = buffer;
+    }
+    
+    GLsizei offset = _bufferCountRetained;
+    _bufferCountRetained += count;
+    return offset;
+}
+
+void DrawNode::releaseRetained(const RetainedPrimitive& primitive)
+{
+    if (primitive.capacity == 0)
+        return;
+    
+    if (primitive.offset + primitive.capacity == _bufferCountRetained)
+    {
+        _bufferCountRetained = primitive.offset;
+        return;
+    }
+    
+    // degenerate triangles aren't rasterized
+    std::fill(_bufferRetained + primitive.offset, _bufferRetained + primitive.offset + primitive.capacity, V2F_C4B_T2F());
+    markRetainedDirty(primitive.offset, primitive.offset + primitive.capacity);
+    
+    RetainedPrimitive slot = { primitive.offset, 0, primitive.capacity };
+    _freeRetained.push_back(slot);
+    _freeCountRetained += primitive.capacity;
+}
+
+void DrawNode::compactRetained()
+{
+    if (_freeCountRetained < MIN_COMPACTED_VERTICES || _freeCountRetained * 2 < _bufferCountRetained)
+        return;
+    
+    std::vector<RetainedPrimitive*> primitives;
+    primitives.reserve(_primitives.size());
+    for (auto& pair : _primitives)
+    {
+        primitives.push_back(&pair.second);
+    }
+    std::sort(primitives.begin(), primitives.end(), [](const RetainedPrimitive* a, const RetainedPrimitive* b) {
+        return a->offset < b->offset;
+    });
+    
+    GLsizei offset = 0;
+    for (auto primitive : primitives)
+    {
+        if (primitive->capacity == 0)
+            continue;
+        if (primitive->offset != offset)
+        {
+            // the slots only move down, a forward copy doesn't overwrite its source
+            std::copy(_bufferRetained + primitive->offset, _bufferRetained + primitive->offset + primitive->capacity, _bufferRetained + offset);
+            primitive->offset = offset;
+        }
+        offset += primitive->capacity;
+    }
+    
+    _bufferCountRetained = offset;
+    _freeRetained.clear();
+    _freeCountRetained = 0;
+    markRetainedDirty(0, offset);
+}
+
+void DrawNode::markRetainedDirty(GLsizei begin, GLsizei end)
+{
+    if (begin >= end)
+        return;
+    
+    invalidateCachedAncestors();
+    
+    if (_dirtyRetainedBegin >= _dirtyRetainedEnd)
+    {
+        _dirtyRetainedBegin = begin;
+        _dirtyRetainedEnd = end;
+    }
+    else
+    {
+        _dirtyRetainedBegin = std::min(_dirtyRetainedBegin, begin);
+        _dirtyRetainedEnd = std::max(_dirtyRetainedEnd, end);
+    }
+}
+
+void DrawNode::uploadRetained()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _vboRetained);
+    if (_vboCapacityRetained < _bufferCapacityRetained)
+    {
+        glBufferData(GL_ARRAY_BUFFER, sizeof(V2F_C4B_T2F)*_bufferCapacityRetained, _bufferRetained, GL_DYNAMIC_DRAW);
+        _vboCapacityRetained = _bufferCapacityRetained;
+    }
+    else if (_dirtyRetainedBegin < _dirtyRetainedEnd)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(V2F_C4B_T2F)*_dirtyRetainedBegin,
+                        sizeof(V2F_C4B_T2F)*(_dirtyRetainedEnd - _dirtyRetainedBegin), _bufferRetained + _dirtyRetainedBegin);
+    }
+    _dirtyRetainedBegin = _dirtyRetainedEnd = 0;
+}
+
 void DrawNode::clear()
 {
     _bufferCount = 0;
+    _recordingStart = 0;
     _dirty = true;
     _bufferCountGLLine = 0;
     _dirtyGLLine = true;
     _bufferCountGLPoint = 0;
     _dirtyGLPoint = true;
     _lineWidth = _defaultLineWidth;
+    invalidateCachedAncestors();
 }
 
 const BlendFunc& DrawNode::getBlendFunc() const
@@ -939,11 +1307,13 @@ const BlendFunc& DrawNode::getBlendFunc() const
 void DrawNode::setBlendFunc(const BlendFunc &blendFunc)
 {
     _blendFunc = blendFunc;
+    invalidateCachedAncestors();
 }
 
 void DrawNode::setLineWidth(int lineWidth)
 {
     _lineWidth = lineWidth;
+    invalidateCachedAncestors();
 }
 
 float DrawNode::getLineWidth()
@@ -36,6 +36,9 @@
 #include "renderer/CCCustomCommand.h"
 #include "math/CCMath.h"
 
+#include <unordered_map>
+#include <vector>
+
 NS_CC_BEGIN
 
 static const int DEFAULT_LINE_WIDTH = 2;
@@ -282,8 +285,35 @@ public:
      */
     CC_DEPRECATED_ATTRIBUTE void drawQuadraticBezier(const Vec2& from, const Vec2& control, const Vec2& to, unsigned int segments, const Color4F &color);
     
-    /** Clear the geometry in the node's buffer. */
+    /** Clear the geometry in the node's buffer. The retained primitives are kept. */
     void clear();
+
+    /** Starts recording a retained primitive.
+     * The filled geometry drawn until endPrimitive() (dots, segments, triangles, polygons, solid rects and circles)
+     * is kept across clear() and only the vertices of the primitives that changed are uploaded again.
+     * Lines and points are still drawn in the immediate buffers.
+     * The retained primitives are drawn before the immediate geometry of the node, whatever the call order,
+     * and their order among themselves isn't kept once they are re-recorded: use several nodes when they overlap.
+     *
+     * @param handle 0 to create a new primitive, or a handle returned earlier to replace its geometry.
+     * @return The handle of the primitive.
+     */
+    unsigned int beginPrimitive(unsigned int handle = 0);
+    /** Stops recording the primitive started by beginPrimitive(). */
+    void endPrimitive();
+    /** Removes a retained primitive. */
+    void removePrimitive(unsigned int handle);
+    /** Returns true if the handle refers to a retained primitive of this node. */
+    bool hasPrimitive(unsigned int handle) const;
+    /** Removes all the retained primitives. */
+    void clearPrimitives();
+
+    /** Keeps the tessellation of the outlined polygons, so drawing the same polygon again after clear() skips the extrusion.
+     * Only worth it for polygons that are redrawn every frame, disabled by default.
+     */
+    void setPolygonCacheEnabled(bool enabled) { _polygonCacheEnabled = enabled; if (!enabled) _polygonCache.clear(); }
+    bool isPolygonCacheEnabled() const { return _polygonCacheEnabled; }
+
     /** Get the color mixed mode.
     * @lua NA
     */
@@ -328,6 +358,32 @@ protected:
     void ensureCapacityGLPoint(int count);
     void ensureCapacityGLLine(int count);
 
+    // slot of a retained primitive in _bufferRetained, vertices past count are degenerate
+    struct RetainedPrimitive
+    {
+        GLsizei offset;
+        GLsizei count;
+        GLsizei capacity;
+    };
+
+    // tessellation of an outlined polygon, reused while the same polygon is drawn again
+    struct PolygonTessellation
+    {
+        std::vector<Vec2> verts;
+        Color4F fillColor;
+        float borderWidth;
+        Color4F borderColor;
+        std::vector<V2F_C4B_T2F> vertices;
+    };
+
+    GLsizei allocateRetained(GLsizei count);
+    void releaseRetained(const RetainedPrimitive& primitive);
+    void compactRetained();
+    void markRetainedDirty(GLsizei begin, GLsizei end);
+    void uploadRetained();
+    bool drawCachedPolygon(const Vec2 *verts, int count, const Color4F &fillColor, float borderWidth, const Color4F &borderColor);
+    void cachePolygon(const Vec2 *verts, int count, const Color4F &fillColor, float borderWidth, const Color4F &borderColor, GLsizei start);
+
     GLuint      _vao;
     GLuint      _vbo;
     GLuint      _vaoGLPoint;
@@ -349,6 +405,26 @@ protected:
     GLsizei     _bufferCountGLLine;
     V2F_C4B_T2F *_bufferGLLine;
 
+    GLuint      _vaoRetained;
+    GLuint      _vboRetained;
+    GLsizei     _bufferCapacityRetained;
+    GLsizei     _bufferCountRetained;
+    V2F_C4B_T2F *_bufferRetained;
+    // size of the retained vbo, 0 when it must be allocated again
+    GLsizei     _vboCapacityRetained;
+    GLsizei     _dirtyRetainedBegin;
+    GLsizei     _dirtyRetainedEnd;
+    GLsizei     _freeCountRetained;
+    std::unordered_map<unsigned int, RetainedPrimitive> _primitives;
+    std::vector<RetainedPrimitive> _freeRetained;
+    unsigned int _nextPrimitiveHandle;
+    unsigned int _recordingPrimitive;
+    GLsizei     _recordingStart;
+    bool        _recordingDirty;
+
+    bool        _polygonCacheEnabled;
+    std::unordered_map<uint32_t, PolygonTessellation> _polygonCache;
+
     BlendFunc   _blendFunc;
     CustomCommand _customCommand;
     CustomCommand _customCommandGLPoint;
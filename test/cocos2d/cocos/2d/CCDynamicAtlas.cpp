@@ -0,0 +1,540 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/CCDynamicAtlas.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "2d/CCSpriteFrame.h"
+#include "2d/CCSpriteFrameCache.h"
+#include "base/CCDirector.h"
+#include "base/CCEventDispatcher.h"
+#include "platform/CCImage.h"
+#include "renderer/CCTexture2D.h"
+#include "renderer/CCTextureCache.h"
+
+NS_CC_BEGIN
+
+const char* DynamicAtlas::EVENT_DEFRAGMENTED = "__cc_DynamicAtlas_defragmented";
+
+namespace
+{
+    // pixels around every frame, filled with its edges so that linear filtering doesn't bleed the neighbours in
+    const int FRAME_PADDING = 1;
+
+    // expands the formats decoded by Image to RGBA8888, returns false for the other ones
+    bool convertToRGBA8888(Image* image, std::vector<unsigned char>& pixels)
+    {
+        size_t count = image->getWidth() * image->getHeight();
+        int bytesPerPixel = 0;
+        switch (image->getRenderFormat())
+        {
+            case Texture2D::PixelFormat::RGBA8888: bytesPerPixel = 4; break;
+            case Texture2D::PixelFormat::RGB888: bytesPerPixel = 3; break;
+            case Texture2D::PixelFormat::AI88: bytesPerPixel = 2; break;
+            case Texture2D::PixelFormat::I8: bytesPerPixel = 1; break;
+            default: return false;
+        }
+        if (image->getDataLen() < static_cast<ssize_t>(count * bytesPerPixel))
+        {
+            return false;
+        }
+
+        pixels.resize(count * 4);
+        const unsigned char* src = image->getData();
+        unsigned char* dst = pixels.data();
+        for (size_t i = 0; i < count; ++i, src += bytesPerPixel, dst += 4)
+        {
+            switch (bytesPerPixel)
+            {
+                case 4: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; break;
+                case 3: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 255; break;
+                case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+                default: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 255; break;
+            }
+        }
+        return true;
+    }
+
+    // copies a RGBA8888 image in a slot of a page, extruding its edges in the padding
+    void writeSlot(Image* pageImage, Texture2D* pageTexture, int slotX, int slotY,
+                   const unsigned char* pixels, int width, int height, bool premultiply)
+    {
+        int slotWidth = width + 2 * FRAME_PADDING;
+        int slotHeight = height + 2 * FRAME_PADDING;
+        std::vector<unsigned char> slotPixels(slotWidth * slotHeight * 4);
+
+        for (int y = 0; y < slotHeight; ++y)
+        {
+            int srcY = std::min(std::max(y - FRAME_PADDING, 0), height - 1);
+            unsigned char* dst = slotPixels.data() + y * slotWidth * 4;
+            for (int x = 0; x < slotWidth; ++x, dst += 4)
+            {
+                int srcX = std::min(std::max(x - FRAME_PADDING, 0), width - 1);
+                const unsigned char* src = pixels + (srcY * width + srcX) * 4;
+                if (premultiply)
+                {
+                    unsigned int alpha = src[3];
+                    dst[0] = (unsigned char)((src[0] * alpha + 127) / 255);
+                    dst[1] = (unsigned char)((src[1] * alpha + 127) / 255);
+                    dst[2] = (unsigned char)((src[2] * alpha + 127) / 255);
+                    dst[3] = src[3];
+                }
+                else
+                {
+                    memcpy(dst, src, 4);
+                }
+            }
+        }
+
+        int pageWidth = pageImage->getWidth();
+        for (int y = 0; y < slotHeight; ++y)
+        {
+            memcpy(pageImage->getData() + ((slotY + y) * pageWidth + slotX) * 4,
+                   slotPixels.data() + y * slotWidth * 4, slotWidth * 4);
+        }
+        pageTexture->updateWithData(slotPixels.data(), slotX, slotY, slotWidth, slotHeight);
+    }
+}
+
+DynamicAtlas* DynamicAtlas::create(int pageWidth, int pageHeight, int maxPages)
+{
+    DynamicAtlas* ret = new (std::nothrow) DynamicAtlas();
+    if (ret && ret->init(pageWidth, pageHeight, maxPages))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+DynamicAtlas::DynamicAtlas()
+: _pageWidth(0)
+, _pageHeight(0)
+, _maxPages(0)
+, _usedArea(0)
+{
+}
+
+DynamicAtlas::~DynamicAtlas()
+{
+    removeAllFrames();
+}
+
+bool DynamicAtlas::init(int pageWidth, int pageHeight, int maxPages)
+{
+    if (pageWidth <= 2 * FRAME_PADDING || pageHeight <= 2 * FRAME_PADDING || maxPages <= 0)
+    {
+        return false;
+    }
+
+    _pageWidth = pageWidth;
+    _pageHeight = pageHeight;
+    _maxPages = maxPages;
+    return true;
+}
+
+SpriteFrame* DynamicAtlas::addImage(const std::string& filename)
+{
+    Image image;
+    if (!image.initWithImageFile(filename))
+    {
+        return nullptr;
+    }
+    return addImage(filename, &image);
+}
+
+SpriteFrame* DynamicAtlas::addImage(const std::string& frameName, Image* image)
+{
+    CCASSERT(image, "image must not be null");
+
+    int width = image->getWidth();
+    int height = image->getHeight();
+    if (image->isCompressed() || width <= 0 || height <= 0)
+    {
+        CCLOG("cocos2d: DynamicAtlas: can't add %s, compressed images aren't supported", frameName.c_str());
+        return nullptr;
+    }
+    if (width + 2 * FRAME_PADDING > _pageWidth || height + 2 * FRAME_PADDING > _pageHeight)
+    {
+        CCLOG("cocos2d: DynamicAtlas: %s (%dx%d) is larger than a page", frameName.c_str(), width, height);
+        return nullptr;
+    }
+
+    std::vector<unsigned char> pixels;
+    if (!convertToRGBA8888(image, pixels))
+    {
+        CCLOG("cocos2d: DynamicAtlas: the pixel format of %s isn't supported", frameName.c_str());
+        return nullptr;
+    }
+
+    Entry entry;
+    if (!allocate(_pages, true, width + 2 * FRAME_PADDING, height + 2 * FRAME_PADDING, entry.page, entry.slot))
+    {
+        CCLOG("cocos2d: DynamicAtlas: no space left for %s", frameName.c_str());
+        return nullptr;
+    }
+
+    // the previous frame of this name is only replaced once the new one has a slot
+    removeFrame(frameName);
+
+    Page& page = _pages[entry.page];
+    writeSlot(page.image, page.texture, entry.slot.x, entry.slot.y, pixels.data(), width, height, !image->hasPremultipliedAlpha());
+
+    entry.frame = SpriteFrame::createWithTexture(page.texture,
+                                                 Rect(entry.slot.x + FRAME_PADDING, entry.slot.y + FRAME_PADDING, width, height),
+                                                 false, Vec2::ZERO, Size(width, height));
+    entry.frame->retain();
+    _usedArea += entry.slot.width * entry.slot.height;
+    _entries[frameName] = entry;
+
+    SpriteFrameCache::getInstance()->addSpriteFrame(entry.frame, frameName);
+    return entry.frame;
+}
+
+void DynamicAtlas::removeFrame(const std::string& frameName)
+{
+    auto it = _entries.find(frameName);
+    if (it == _entries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+    auto cache = SpriteFrameCache::getInstance();
+    if (cache->getSpriteFrameByName(frameName) == entry.frame)
+    {
+        cache->removeSpriteFrameByName(frameName);
+    }
+
+    Page& page = _pages[entry.page];
+    if (--page.frameCount == 0)
+    {
+        // an empty page is free again as a whole
+        page.freeRects.clear();
+        PackRect whole = { 0, 0, _pageWidth, _pageHeight };
+        page.freeRects.push_back(whole);
+    }
+    else
+    {
+        page.freeRects.push_back(entry.slot);
+        pruneFreeRects(page.freeRects);
+    }
+
+    _usedArea -= entry.slot.width * entry.slot.height;
+    entry.frame->release();
+    _entries.erase(it);
+}
+
+void DynamicAtlas::removeAllFrames()
+{
+    auto cache = SpriteFrameCache::getInstance();
+    for (auto& pair : _entries)
+    {
+        if (cache->getSpriteFrameByName(pair.first) == pair.second.frame)
+        {
+            cache->removeSpriteFrameByName(pair.first);
+        }
+        pair.second.frame->release();
+    }
+    _entries.clear();
+    _usedArea = 0;
+
+    releasePages(_pages, 0);
+}
+
+bool DynamicAtlas::hasFrame(const std::string& frameName) const
+{
+    return _entries.find(frameName) != _entries.end();
+}
+
+void DynamicAtlas::defragment()
+{
+    if (_entries.empty())
+    {
+        releasePages(_pages, 0);
+        return;
+    }
+
+    // tall frames first packs best
+    std::vector<std::pair<const std::string*, Entry*>> entries;
+    entries.reserve(_entries.size());
+    for (auto& pair : _entries)
+    {
+        entries.push_back(std::make_pair(&pair.first, &pair.second));
+    }
+    std::sort(entries.begin(), entries.end(), [](const std::pair<const std::string*, Entry*>& a, const std::pair<const std::string*, Entry*>& b) {
+        if (a.second->slot.height != b.second->slot.height)
+            return a.second->slot.height > b.second->slot.height;
+        if (a.second->slot.width != b.second->slot.width)
+            return a.second->slot.width > b.second->slot.width;
+        return *a.first < *b.first;
+    });
+
+    // lay out the frames without touching the current pages
+    std::vector<Page> layout;
+    std::vector<int> newPages(entries.size());
+    std::vector<PackRect> newSlots(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const PackRect& slot = entries[i].second->slot;
+        if (!allocate(layout, false, slot.width, slot.height, newPages[i], newSlots[i]))
+        {
+            CCLOG("cocos2d: DynamicAtlas: the frames don't fit in the atlas once packed again");
+            return;
+        }
+    }
+
+    // move the pixels
+    size_t rowSize = _pageWidth * 4;
+    std::vector<std::vector<unsigned char>> pixels(layout.size(), std::vector<unsigned char>(rowSize * _pageHeight, 0));
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Entry& entry = *entries[i].second;
+        const unsigned char* src = _pages[entry.page].image->getData();
+        unsigned char* dst = pixels[newPages[i]].data();
+        for (int y = 0; y < entry.slot.height; ++y)
+        {
+            memcpy(dst + (newSlots[i].y + y) * rowSize + newSlots[i].x * 4,
+                   src + (entry.slot.y + y) * rowSize + entry.slot.x * 4,
+                   entry.slot.width * 4);
+        }
+    }
+
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        if (i >= _pages.size() && !addPage(_pages, true))
+        {
+            // can't happen, the layout has at most _maxPages pages
+            return;
+        }
+        Page& page = _pages[i];
+        memcpy(page.image->getData(), pixels[i].data(), pixels[i].size());
+        page.texture->updateWithData(page.image->getData(), 0, 0, _pageWidth, _pageHeight);
+        page.freeRects = layout[i].freeRects;
+        page.frameCount = layout[i].frameCount;
+    }
+    releasePages(_pages, layout.size());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        Entry& entry = *entries[i].second;
+        entry.page = newPages[i];
+        entry.slot = newSlots[i];
+        updateFrame(entry);
+    }
+
+    Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(EVENT_DEFRAGMENTED, this);
+}
+
+float DynamicAtlas::getOccupancy() const
+{
+    if (_pages.empty())
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(_usedArea) / (static_cast<float>(_pageWidth) * _pageHeight * _pages.size());
+}
+
+Texture2D* DynamicAtlas::getPageTexture(int page) const
+{
+    CCASSERT(page >= 0 && page < static_cast<int>(_pages.size()), "invalid page");
+    return _pages[page].texture;
+}
+
+bool DynamicAtlas::addPage(std::vector<Page>& pages, bool createTexture)
+{
+    if (static_cast<int>(pages.size()) >= _maxPages)
+    {
+        return false;
+    }
+
+    Page page;
+    page.texture = nullptr;
+    page.image = nullptr;
+    page.frameCount = 0;
+    PackRect whole = { 0, 0, _pageWidth, _pageHeight };
+    page.freeRects.push_back(whole);
+
+    if (createTexture)
+    {
+        std::vector<unsigned char> blank(_pageWidth * _pageHeight * 4, 0);
+        page.image = new (std::nothrow) Image();
+        page.image->initWithRawData(blank.data(), blank.size(), _pageWidth, _pageHeight, 8, true);
+        page.texture = new (std::nothrow) Texture2D();
+        page.texture->initWithImage(page.image, Texture2D::PixelFormat::RGBA8888);
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        // the image is kept up to date, the page is restored from it
+        VolatileTextureMgr::addImage(page.texture, page.image);
+#endif
+    }
+
+    pages.push_back(page);
+    return true;
+}
+
+void DynamicAtlas::releasePages(std::vector<Page>& pages, size_t first)
+{
+    for (size_t i = first; i < pages.size(); ++i)
+    {
+        CC_SAFE_RELEASE(pages[i].texture);
+        CC_SAFE_RELEASE(pages[i].image);
+    }
+    if (first < pages.size())
+    {
+        pages.erase(pages.begin() + first, pages.end());
+    }
+}
+
+bool DynamicAtlas::allocate(std::vector<Page>& pages, bool createTextures, int width, int height, int& page, PackRect& slot)
+{
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        if (findPosition(pages[i].freeRects, width, height, slot))
+        {
+            page = static_cast<int>(i);
+            placeRect(pages[i].freeRects, slot);
+            ++pages[i].frameCount;
+            return true;
+        }
+    }
+
+    if (!addPage(pages, createTextures))
+    {
+        return false;
+    }
+    page = static_cast<int>(pages.size()) - 1;
+    if (!findPosition(pages.back().freeRects, width, height, slot))
+    {
+        return false;
+    }
+    placeRect(pages.back().freeRects, slot);
+    ++pages.back().frameCount;
+    return true;
+}
+
+void DynamicAtlas::updateFrame(Entry& entry)
+{
+    entry.frame->setTexture(_pages[entry.page].texture);
+    entry.frame->setRectInPixels(Rect(entry.slot.x + FRAME_PADDING, entry.slot.y + FRAME_PADDING,
+                                      entry.slot.width - 2 * FRAME_PADDING, entry.slot.height - 2 * FRAME_PADDING));
+}
+
+bool DynamicAtlas::findPosition(const std::vector<PackRect>& freeRects, int width, int height, PackRect& result)
+{
+    int bestShortSide = INT_MAX;
+    int bestLongSide = INT_MAX;
+    for (const auto& free : freeRects)
+    {
+        if (free.width < width || free.height < height)
+            continue;
+
+        int leftoverWidth = free.width - width;
+        int leftoverHeight = free.height - height;
+        int shortSide = std::min(leftoverWidth, leftoverHeight);
+        int longSide = std::max(leftoverWidth, leftoverHeight);
+        if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+        {
+            result.x = free.x;
+            result.y = free.y;
+            result.width = width;
+            result.height = height;
+            bestShortSide = shortSide;
+            bestLongSide = longSide;
+        }
+    }
+    return bestShortSide != INT_MAX;
+}
+
+void DynamicAtlas::placeRect(std::vector<PackRect>& freeRects, const PackRect& used)
+{
+    // split every free rectangle overlapped by the used one into the maximal rectangles around it
+    size_t count = freeRects.size();
+    for (size_t i = 0; i < count;)
+    {
+        PackRect free = freeRects[i];
+        if (used.x >= free.x + free.width || used.x + used.width <= free.x
+            || used.y >= free.y + free.height || used.y + used.height <= free.y)
+        {
+            ++i;
+            continue;
+        }
+
+        if (used.x > free.x)
+        {
+            PackRect left = { free.x, free.y, used.x - free.x, free.height };
+            freeRects.push_back(left);
+        }
+        if (used.x + used.width < free.x + free.width)
+        {
+            PackRect right = { used.x + used.width, free.y, free.x + free.width - used.x - used.width, free.height };
+            freeRects.push_back(right);
+        }
+        if (used.y > free.y)
+        {
+            PackRect top = { free.x, free.y, free.width, used.y - free.y };
+            freeRects.push_back(top);
+        }
+        if (used.y + used.height < free.y + free.height)
+        {
+            PackRect bottom = { free.x, used.y + used.height, free.width, free.y + free.height - used.y - used.height };
+            freeRects.push_back(bottom);
+        }
+
+        freeRects.erase(freeRects.begin() + i);
+        --count;
+    }
+
+    pruneFreeRects(freeRects);
+}
+
+void DynamicAtlas::pruneFreeRects(std::vector<PackRect>& freeRects)
+{
+    auto contains = [](const PackRect& a, const PackRect& b) {
+        return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+    };
+
+    for (int i = 0; i < static_cast<int>(freeRects.size()); ++i)
+    {
+        for (int j = i + 1; j < static_cast<int>(freeRects.size()); ++j)
+        {
+            if (contains(freeRects[j], freeRects[i]))
+            {
+                freeRects.erase(freeRects.begin() + i);
+                --i;
+                break;
+            }
+            if (contains(freeRects[i], freeRects[j]))
+            {
+                freeRects.erase(freeRects.begin() + j);
+                --j;
+            }
+        }
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,159 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CCDYNAMICATLAS_H__
+#define __CCDYNAMICATLAS_H__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/CCRef.h"
+#include "math/CCGeometry.h"
+
+NS_CC_BEGIN
+
+class Image;
+class Texture2D;
+class SpriteFrame;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** @class DynamicAtlas
+ * @brief Packs images loaded at runtime into a few shared textures, so that the sprites showing them can be batched.
+ *
+ * Every image added to the atlas becomes a SpriteFrame registered in the SpriteFrameCache under the given name.
+ * The pages are RGBA8888 textures with premultiplied alpha, a copy of their pixels is kept in memory
+ * to move the frames when the atlas is defragmented and to restore the pages when the GL context is lost.
+ */
+class CC_DLL DynamicAtlas : public Ref
+{
+public:
+    /** Dispatched with the atlas as user data once defragment() moved the frames.
+     Sprites that show a frame of the atlas must set it again.
+     */
+    static const char* EVENT_DEFRAGMENTED;
+
+    /** Creates an atlas.
+     *
+     * @param pageWidth The width of the page textures in pixels.
+     * @param pageHeight The height of the page textures in pixels.
+     * @param maxPages The maximum number of page textures.
+     * @return An autoreleased DynamicAtlas object.
+     */
+    static DynamicAtlas* create(int pageWidth = 2048, int pageHeight = 2048, int maxPages = 4);
+
+    /** Copies an image into the atlas and registers its sprite frame.
+     * An existing frame of the atlas with the same name is replaced, it is kept if the new image doesn't fit.
+     *
+     * @return The sprite frame, or nullptr if the image is compressed or doesn't fit in the atlas.
+     */
+    SpriteFrame* addImage(const std::string& frameName, Image* image);
+    /** Loads an image file and copies it into the atlas, the file name is used as frame name. */
+    SpriteFrame* addImage(const std::string& filename);
+
+    /** Frees the space of a frame and removes it from the SpriteFrameCache. */
+    void removeFrame(const std::string& frameName);
+    /** Removes all the frames of the atlas. */
+    void removeAllFrames();
+    /** Returns true if the atlas has a frame with this name. */
+    bool hasFrame(const std::string& frameName) const;
+
+    /** Packs all the frames again to recover the space lost by removals.
+     * The sprite frames are updated in place, EVENT_DEFRAGMENTED is dispatched when they moved.
+     */
+    void defragment();
+
+    /** Returns the ratio of the page area used by frames, between 0 and 1. */
+    float getOccupancy() const;
+    /** Returns the number of page textures. */
+    int getPageCount() const { return static_cast<int>(_pages.size()); }
+    /** Returns a page texture. */
+    Texture2D* getPageTexture(int page) const;
+
+CC_CONSTRUCTOR_ACCESS:
+    DynamicAtlas();
+    virtual ~DynamicAtlas();
+
+    bool init(int pageWidth, int pageHeight, int maxPages);
+
+protected:
+    struct PackRect
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    struct Page
+    {
+        Texture2D* texture;
+        // pixels of the texture
+        Image* image;
+        // maximal free rectangles, they overlap each other
+        std::vector<PackRect> freeRects;
+        int frameCount;
+    };
+
+    struct Entry
+    {
+        SpriteFrame* frame;
+        int page;
+        // slot of the frame, including its padding
+        PackRect slot;
+    };
+
+    // MaxRects packing with the best short side fit heuristic
+    static bool findPosition(const std::vector<PackRect>& freeRects, int width, int height, PackRect& result);
+    static void placeRect(std::vector<PackRect>& freeRects, const PackRect& used);
+    static void pruneFreeRects(std::vector<PackRect>& freeRects);
+
+    // without textures the pages are only used to compute a layout
+    bool addPage(std::vector<Page>& pages, bool createTexture);
+    void releasePages(std::vector<Page>& pages, size_t first);
+    bool allocate(std::vector<Page>& pages, bool createTextures, int width, int height, int& page, PackRect& slot);
+    void updateFrame(Entry& entry);
+
+    int _pageWidth;
+    int _pageHeight;
+    int _maxPages;
+    std::vector<Page> _pages;
+    std::unordered_map<std::string, Entry> _entries;
+    long _usedArea;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(DynamicAtlas);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CCDYNAMICATLAS_H__
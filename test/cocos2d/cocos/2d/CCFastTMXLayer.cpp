@@ -43,7 +43,9 @@ THE SOFTWARE.
 #include "renderer/ccGLStateCache.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCVertexIndexBuffer.h"
+#include "renderer/CCPrimitive.h"
 #include "base/CCDirector.h"
+#include "base/CCAsyncTaskPool.h"
 #include "deprecated/CCString.h"
 
 NS_CC_BEGIN
@@ -120,26 +122,31 @@ TMXLayer::TMXLayer()
 , _useAutomaticVertexZ(false)
 , _quadsDirty(true)
 , _dirty(true)
-, _vertexBuffer(nullptr)
-, _vData(nullptr)
-, _indexBuffer(nullptr)
+, _chunkSize(32)
+, _chunkColumns(0)
+, _chunkRows(0)
+, _chunksGeneration(0)
+, _chunkIndexBuffer(nullptr)
+, _asyncChunkLoading(false)
+, _chunkUnloadDelay(0)
 {
 }
 
 TMXLayer::~TMXLayer()
 {
+    releaseChunks();
     CC_SAFE_RELEASE(_tileSet);
     CC_SAFE_RELEASE(_texture);
     CC_SAFE_DELETE_ARRAY(_tiles);
-    CC_SAFE_RELEASE(_vData);
-    CC_SAFE_RELEASE(_vertexBuffer);
-    CC_SAFE_RELEASE(_indexBuffer);
-    
+    CC_SAFE_RELEASE(_chunkIndexBuffer);
 }
 
 void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
 {
-    updateTotalQuads();
+    if (_quadsDirty)
+    {
+        setupChunks();
+    }
 
     bool isViewProjectionUpdated = true;
     auto visitingCamera = Camera::getVisitingCamera();
@@ -148,7 +155,7 @@ void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
         isViewProjectionUpdated = visitingCamera->isViewProjectionUpdated();
     }
     
-    if( flags != 0 || _dirty || _quadsDirty || isViewProjectionUpdated)
+    if( flags != 0 || _dirty || isViewProjectionUpdated)
     {
         Size s = Director::getInstance()->getVisibleSize();
         auto rect = Rect(Camera::getVisitingCamera()->getPositionX() - s.width * 0.5,
@@ -160,21 +167,58 @@ void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
         inv.inverse();
         rect = RectApplyTransform(rect, inv);
         
-        updateTiles(rect);
-        updateIndexBuffer();
-        updatePrimitives();
+        updateVisibleChunks(rect);
         _dirty = false;
     }
+
+    auto frame = Director::getInstance()->getTotalFrames();
+    size_t commandCount = 0;
+    for (auto chunkIndex : _visibleChunks)
+    {
+        auto& chunk = _chunks[chunkIndex];
+        chunk.lastVisibleFrame = frame;
+        if (chunk.dirty && !chunk.loading)
+        {
+            if (_asyncChunkLoading)
+                loadChunkAsync(chunkIndex);
+            else
+                loadChunk(chunkIndex);
+        }
+        commandCount += chunk.primitives.size();
+    }
+
+    if (_asyncChunkLoading)
+    {
+        for (auto chunkIndex : _prefetchChunks)
+        {
+            auto& chunk = _chunks[chunkIndex];
+            chunk.lastVisibleFrame = frame;
+            if (chunk.dirty && !chunk.loading)
+                loadChunkAsync(chunkIndex);
+        }
+    }
+
+    if (_chunkUnloadDelay > 0)
+    {
+        for (auto&& chunk : _chunks)
+        {
+            if (chunk.vertexBuffer && !chunk.loading && frame - chunk.lastVisibleFrame > _chunkUnloadDelay)
+            {
+                releaseChunkBuffers(chunk);
+                chunk.dirty = true;
+            }
+        }
+    }
     
-    if(_renderCommands.size() < static_cast<size_t>(_primitives.size()))
+    if(_renderCommands.size() < commandCount)
     {
-        _renderCommands.resize(_primitives.size());
+        _renderCommands.resize(commandCount);
     }
     
     int index = 0;
-    for(const auto& iter : _primitives)
+    for (auto chunkIndex : _visibleChunks)
     {
-        if(iter.second->getCount() > 0)
+        for (const auto& iter : _chunks[chunkIndex].primitives)
         {
             auto& cmd = _renderCommands[index++];
             cmd.init(iter.first, _texture->getName(), getGLProgramState(), BlendFunc::ALPHA_NON_PREMULTIPLIED, iter.second, _modelViewTransform, flags);
@@ -195,8 +239,13 @@ void TMXLayer::onDraw(Primitive *primitive)
     CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, primitive->getCount() * 4);
 }
 
-void TMXLayer::updateTiles(const Rect& culledRect)
+void TMXLayer::updateVisibleChunks(const Rect& culledRect)
 {
+    _visibleChunks.clear();
+    _prefetchChunks.clear();
+    if (_chunks.empty())
+        return;
+
     Rect visibleTiles = culledRect;
     Size mapTileSize = CC_SIZE_PIXELS_TO_POINTS(_mapTileSize);
     Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
@@ -241,82 +290,34 @@ void TMXLayer::updateTiles(const Rect& culledRect)
         //CCASSERT(0, "TMX invalid value");
     }
     
-    _indicesVertexZNumber.clear();
-    
-    for(const auto& iter : _indicesVertexZOffsets)
-    {
-        _indicesVertexZNumber[iter.first] = iter.second;
-    }
-    
     int yBegin = std::max(0.f,visibleTiles.origin.y - tilesOverY);
     int yEnd = std::min(_layerSize.height,visibleTiles.origin.y + visibleTiles.size.height + tilesOverY);
     int xBegin = std::max(0.f,visibleTiles.origin.x - tilesOverX);
     int xEnd = std::min(_layerSize.width,visibleTiles.origin.x + visibleTiles.size.width + tilesOverX);
-    
-    for (int y =  yBegin; y < yEnd; ++y)
-    {
-        for (int x = xBegin; x < xEnd; ++x)
-        {
-            int tileIndex = getTileIndexByPos(x, y);
-            if(_tiles[tileIndex] == 0) continue;
-            
-            int vertexZ = getVertexZForPos(Vec2(x,y));
-            auto iter = _indicesVertexZNumber.find(vertexZ);
-            int offset = iter->second;
-            iter->second++;
-            
-            int quadIndex = _tileToQuadIndex[tileIndex];
-            CC_ASSERT(-1 != quadIndex);
-            _indices[6 * offset + 0] = quadIndex * 4 + 0;
-            _indices[6 * offset + 1] = quadIndex * 4 + 1;
-            _indices[6 * offset + 2] = quadIndex * 4 + 2;
-            _indices[6 * offset + 3] = quadIndex * 4 + 3;
-            _indices[6 * offset + 4] = quadIndex * 4 + 2;
-            _indices[6 * offset + 5] = quadIndex * 4 + 1;
-            
-        } // for x
-    } // for y
-    
-    for(const auto& iter : _indicesVertexZOffsets)
+    if (xBegin >= xEnd || yBegin >= yEnd)
+        return;
+
+    int chunkXBegin = xBegin / _chunkSize;
+    int chunkXEnd = (xEnd - 1) / _chunkSize + 1;
+    int chunkYBegin = yBegin / _chunkSize;
+    int chunkYEnd = (yEnd - 1) / _chunkSize + 1;
+    for (int y = chunkYBegin; y < chunkYEnd; ++y)
     {
-        _indicesVertexZNumber[iter.first] -= iter.second;
-        if(_indicesVertexZNumber[iter.first] == 0)
+        for (int x = chunkXBegin; x < chunkXEnd; ++x)
         {
-            _indicesVertexZNumber.erase(iter.first);
+            _visibleChunks.push_back(x + y * _chunkColumns);
         }
     }
-    
-}
-
-void TMXLayer::updateVertexBuffer()
-{
-    GL::bindVAO(0);
-    if(nullptr == _vData)
-    {
-        _vertexBuffer = VertexBuffer::create(sizeof(V3F_C4B_T2F), (int)_totalQuads.size() * 4);
-        _vData = VertexData::create();
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(0, GLProgram::VERTEX_ATTRIB_POSITION, GL_FLOAT, 3));
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, colors), GLProgram::VERTEX_ATTRIB_COLOR, GL_UNSIGNED_BYTE, 4, true));
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, texCoords), GLProgram::VERTEX_ATTRIB_TEX_COORD, GL_FLOAT, 2));
-        CC_SAFE_RETAIN(_vData);
-        CC_SAFE_RETAIN(_vertexBuffer);
-    }
-    if(_vertexBuffer)
-    {
-        _vertexBuffer->updateVertices((void*)&_totalQuads[0], (int)_totalQuads.size() * 4, 0);
-    }
-    
-}
 
-void TMXLayer::updateIndexBuffer()
-{
-    if(nullptr == _indexBuffer)
+    // the ring of chunks around the screen is built in advance when the chunks are loaded asynchronously
+    for (int y = std::max(chunkYBegin - 1, 0); y < std::min(chunkYEnd + 1, _chunkRows); ++y)
     {
-        _indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)_indices.size());
-        CC_SAFE_RETAIN(_indexBuffer);
+        for (int x = std::max(chunkXBegin - 1, 0); x < std::min(chunkXEnd + 1, _chunkColumns); ++x)
+        {
+            if (x < chunkXBegin || x >= chunkXEnd || y < chunkYBegin || y >= chunkYEnd)
+                _prefetchChunks.push_back(x + y * _chunkColumns);
+        }
     }
-    _indexBuffer->updateIndices(&_indices[0], (int)_indices.size(), 0);
-    
 }
 
 // FastTMXLayer - setup Tiles
@@ -412,160 +413,317 @@ Mat4 TMXLayer::tileToNodeTransform()
     
 }
 
-void TMXLayer::updatePrimitives()
+struct TMXLayer::ChunkQuads
+{
+    std::vector<V3F_C4B_T2F_Quad> quads;
+    std::vector<int> tileToQuadIndex;
+    /** vertex Z and number of quads, in the order of the quads */
+    std::vector<std::pair<int, int>> vertexZRanges;
+};
+
+void TMXLayer::setChunkSize(int tiles)
 {
-    for(const auto& iter : _indicesVertexZNumber)
+    // the vertices of a chunk are indexed with 16 bits indices
+    CCASSERT(tiles > 0 && tiles <= 128, "TMXLayer: invalid chunk size");
+    tiles = std::max(1, std::min(tiles, 128));
+    if (tiles != _chunkSize)
     {
-        int start = _indicesVertexZOffsets.at(iter.first);
-        
-        auto primitiveIter= _primitives.find(iter.first);
-        if(primitiveIter == _primitives.end())
+        _chunkSize = tiles;
+        _quadsDirty = true;
+        _dirty = true;
+    }
+}
+
+void TMXLayer::setupChunks()
+{
+    releaseChunks();
+    ++_chunksGeneration;
+
+    _chunkColumns = ((int)_layerSize.width + _chunkSize - 1) / _chunkSize;
+    _chunkRows = ((int)_layerSize.height + _chunkSize - 1) / _chunkSize;
+    _chunks.resize(_chunkColumns * _chunkRows);
+    for (int y = 0; y < _chunkRows; ++y)
+    {
+        for (int x = 0; x < _chunkColumns; ++x)
         {
-            auto primitive = Primitive::create(_vData, _indexBuffer, GL_TRIANGLES);
-            primitive->setCount(iter.second * 6);
-            primitive->setStart(start * 6);
-            
-            _primitives.insert(iter.first, primitive);
+            auto& chunk = _chunks[x + y * _chunkColumns];
+            chunk.x = x * _chunkSize;
+            chunk.y = y * _chunkSize;
+            chunk.width = std::min(_chunkSize, (int)_layerSize.width - chunk.x);
+            chunk.height = std::min(_chunkSize, (int)_layerSize.height - chunk.y);
+            chunk.dirty = true;
+            chunk.loading = false;
+            chunk.version = 0;
+            chunk.lastVisibleFrame = 0;
+            chunk.vertexBuffer = nullptr;
+            chunk.vertexData = nullptr;
         }
-        else
+    }
+
+    int maxQuads = _chunkSize * _chunkSize;
+    if (_chunkIndexBuffer == nullptr || _chunkIndexBuffer->getIndexNumber() != maxQuads * 6)
+    {
+        CC_SAFE_RELEASE(_chunkIndexBuffer);
+        std::vector<GLushort> indices(maxQuads * 6);
+        for (int i = 0; i < maxQuads; ++i)
         {
-            primitiveIter->second->setCount(iter.second * 6);
-            primitiveIter->second->setStart(start * 6);
+            indices[6 * i + 0] = i * 4 + 0;
+            indices[6 * i + 1] = i * 4 + 1;
+            indices[6 * i + 2] = i * 4 + 2;
+            indices[6 * i + 3] = i * 4 + 3;
+            indices[6 * i + 4] = i * 4 + 2;
+            indices[6 * i + 5] = i * 4 + 1;
         }
+        _chunkIndexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)indices.size());
+        _chunkIndexBuffer->updateIndices(&indices[0], (int)indices.size(), 0);
+        CC_SAFE_RETAIN(_chunkIndexBuffer);
     }
+
+    _visibleChunks.clear();
+    _prefetchChunks.clear();
+    _quadsDirty = false;
+    _dirty = true;
 }
 
-void TMXLayer::updateTotalQuads()
+void TMXLayer::releaseChunks()
 {
-    if(_quadsDirty)
-    {
-        Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
-        Size texSize = _tileSet->_imageSize;
-        _tileToQuadIndex.clear();
-        _totalQuads.resize(int(_layerSize.width * _layerSize.height));
-        _indices.resize(6 * int(_layerSize.width * _layerSize.height));
-        _tileToQuadIndex.resize(int(_layerSize.width * _layerSize.height),-1);
-        _indicesVertexZOffsets.clear();
-        
-        int quadIndex = 0;
-        for(int y = 0; y < _layerSize.height; ++y)
+    for (auto&& chunk : _chunks)
+    {
+        releaseChunkBuffers(chunk);
+    }
+    _chunks.clear();
+    _visibleChunks.clear();
+    _prefetchChunks.clear();
+}
+
+void TMXLayer::releaseChunkBuffers(Chunk& chunk)
+{
+    for (auto&& iter : chunk.primitives)
+    {
+        iter.second->release();
+    }
+    chunk.primitives.clear();
+    CC_SAFE_RELEASE_NULL(chunk.vertexData);
+    CC_SAFE_RELEASE_NULL(chunk.vertexBuffer);
+    chunk.tileToQuadIndex.clear();
+}
+
+void TMXLayer::setupTileQuad(V3F_C4B_T2F_Quad& quad, int x, int y, int tileGID, float z) const
+{
+    Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
+    Size texSize = _tileSet->_imageSize;
+
+    Vec3 nodePos(float(x), float(y), 0);
+    _tileToNodeTransform.transformPoint(&nodePos);
+
+    float left, right, top, bottom;
+
+    // vertices
+    if (tileGID & kTMXTileDiagonalFlag)
+    {
+        left = nodePos.x;
+        right = nodePos.x + tileSize.height;
+        bottom = nodePos.y + tileSize.width;
+        top = nodePos.y;
+    }
+    else
+    {
+        left = nodePos.x;
+        right = nodePos.x + tileSize.width;
+        bottom = nodePos.y + tileSize.height;
+        top = nodePos.y;
+    }
+    
+    if(tileGID & kTMXTileVerticalFlag)
+        std::swap(top, bottom);
+    if(tileGID & kTMXTileHorizontalFlag)
+        std::swap(left, right);
+    
+    if(tileGID & kTMXTileDiagonalFlag)
+    {
+        // FIXME: not working correctly
+        quad.bl.vertices.x = left;
+        quad.bl.vertices.y = bottom;
+        quad.bl.vertices.z = z;
+        quad.br.vertices.x = left;
+        quad.br.vertices.y = top;
+        quad.br.vertices.z = z;
+        quad.tl.vertices.x = right;
+        quad.tl.vertices.y = bottom;
+        quad.tl.vertices.z = z;
+        quad.tr.vertices.x = right;
+        quad.tr.vertices.y = top;
+        quad.tr.vertices.z = z;
+    }
+    else
+    {
+        quad.bl.vertices.x = left;
+        quad.bl.vertices.y = bottom;
+        quad.bl.vertices.z = z;
+        quad.br.vertices.x = right;
+        quad.br.vertices.y = bottom;
+        quad.br.vertices.z = z;
+        quad.tl.vertices.x = left;
+        quad.tl.vertices.y = top;
+        quad.tl.vertices.z = z;
+        quad.tr.vertices.x = right;
+        quad.tr.vertices.y = top;
+        quad.tr.vertices.z = z;
+    }
+    
+    // texcoords
+    Rect tileTexture = _tileSet->getRectForGID(tileGID);
+    left   = (tileTexture.origin.x / texSize.width);
+    right  = left + (tileTexture.size.width / texSize.width);
+    bottom = (tileTexture.origin.y / texSize.height);
+    top    = bottom + (tileTexture.size.height / texSize.height);
+    
+    quad.bl.texCoords.u = left;
+    quad.bl.texCoords.v = bottom;
+    quad.br.texCoords.u = right;
+    quad.br.texCoords.v = bottom;
+    quad.tl.texCoords.u = left;
+    quad.tl.texCoords.v = top;
+    quad.tr.texCoords.u = right;
+    quad.tr.texCoords.v = top;
+    
+    quad.bl.colors = Color4B::WHITE;
+    quad.br.colors = Color4B::WHITE;
+    quad.tl.colors = Color4B::WHITE;
+    quad.tr.colors = Color4B::WHITE;
+}
+
+void TMXLayer::buildChunkQuads(int chunkX, int chunkY, int width, int height, const uint32_t* gids, int stride, ChunkQuads& out) const
+{
+    // count the quads of each vertex Z first, so that the quads can be sorted by vertex Z in one pass
+    std::map<int, int> vertexZOffsets;
+    int quadCount = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
         {
-            for(int x =0; x < _layerSize.width; ++x)
-            {
-                int tileIndex = getTileIndexByPos(x, y);
-                int tileGID = _tiles[tileIndex];
-                
-                if(tileGID == 0) continue;
-                
-                _tileToQuadIndex[tileIndex] = quadIndex;
-                
-                auto& quad = _totalQuads[quadIndex];
-                
-                Vec3 nodePos(float(x), float(y), 0);
-                _tileToNodeTransform.transformPoint(&nodePos);
-                
-                float left, right, top, bottom, z;
-                
-                z = getVertexZForPos(Vec2(x, y));
-                auto iter = _indicesVertexZOffsets.find(z);
-                if(iter == _indicesVertexZOffsets.end())
-                {
-                    _indicesVertexZOffsets[z] = 1;
-                }
-                else
-                {
-                    iter->second++;
-                }
-                // vertices
-                if (tileGID & kTMXTileDiagonalFlag)
-                {
-                    left = nodePos.x;
-                    right = nodePos.x + tileSize.height;
-                    bottom = nodePos.y + tileSize.width;
-                    top = nodePos.y;
-                }
-                else
-                {
-                    left = nodePos.x;
-                    right = nodePos.x + tileSize.width;
-                    bottom = nodePos.y + tileSize.height;
-                    top = nodePos.y;
-                }
-                
-                if(tileGID & kTMXTileVerticalFlag)
-                    std::swap(top, bottom);
-                if(tileGID & kTMXTileHorizontalFlag)
-                    std::swap(left, right);
-                
-                if(tileGID & kTMXTileDiagonalFlag)
-                {
-                    // FIXME: not working correctly
-                    quad.bl.vertices.x = left;
-                    quad.bl.vertices.y = bottom;
-                    quad.bl.vertices.z = z;
-                    quad.br.vertices.x = left;
-                    quad.br.vertices.y = top;
-                    quad.br.vertices.z = z;
-                    quad.tl.vertices.x = right;
-                    quad.tl.vertices.y = bottom;
-                    quad.tl.vertices.z = z;
-                    quad.tr.vertices.x = right;
-                    quad.tr.vertices.y = top;
-                    quad.tr.vertices.z = z;
-                }
-                else
-                {
-                    quad.bl.vertices.x = left;
-                    quad.bl.vertices.y = bottom;
-                    quad.bl.vertices.z = z;
-                    quad.br.vertices.x = right;
-                    quad.br.vertices.y = bottom;
-                    quad.br.vertices.z = z;
-                    quad.tl.vertices.x = left;
-                    quad.tl.vertices.y = top;
-                    quad.tl.vertices.z = z;
-                    quad.tr.vertices.x = right;
-                    quad.tr.vertices.y = top;
-                    quad.tr.vertices.z = z;
-                }
-                
-                // texcoords
-                Rect tileTexture = _tileSet->getRectForGID(tileGID);
-                left   = (tileTexture.origin.x / texSize.width);
-                right  = left + (tileTexture.size.width / texSize.width);
-                bottom = (tileTexture.origin.y / texSize.height);
-                top    = bottom + (tileTexture.size.height / texSize.height);
-                
-                quad.bl.texCoords.u = left;
-                quad.bl.texCoords.v = bottom;
-                quad.br.texCoords.u = right;
-                quad.br.texCoords.v = bottom;
-                quad.tl.texCoords.u = left;
-                quad.tl.texCoords.v = top;
-                quad.tr.texCoords.u = right;
-                quad.tr.texCoords.v = top;
-                
-                quad.bl.colors = Color4B::WHITE;
-                quad.br.colors = Color4B::WHITE;
-                quad.tl.colors = Color4B::WHITE;
-                quad.tr.colors = Color4B::WHITE;
-                
-                ++quadIndex;
-            }
+            if (gids[x + y * stride] == 0) continue;
+            ++vertexZOffsets[getVertexZForPos(Vec2(chunkX + x, chunkY + y))];
+            ++quadCount;
         }
-        
-        int offset = 0;
-        for(auto iter = _indicesVertexZOffsets.begin(); iter != _indicesVertexZOffsets.end(); ++iter)
+    }
+
+    out.vertexZRanges.clear();
+    int offset = 0;
+    for (auto&& iter : vertexZOffsets)
+    {
+        out.vertexZRanges.push_back(std::make_pair(iter.first, iter.second));
+        std::swap(offset, iter.second);
+        offset += iter.second;
+    }
+
+    out.quads.resize(quadCount);
+    out.tileToQuadIndex.assign(width * height, -1);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
         {
-            std::swap(offset, iter->second);
-            offset += iter->second;
+            int tileGID = gids[x + y * stride];
+            if (tileGID == 0) continue;
+
+            int z = getVertexZForPos(Vec2(chunkX + x, chunkY + y));
+            int quadIndex = vertexZOffsets[z]++;
+            out.tileToQuadIndex[x + y * width] = quadIndex;
+            setupTileQuad(out.quads[quadIndex], chunkX + x, chunkY + y, tileGID, z);
         }
-        updateVertexBuffer();
-        
-        _quadsDirty = false;
     }
 }
 
+void TMXLayer::uploadChunk(Chunk& chunk, ChunkQuads& quads)
+{
+    for (auto&& iter : chunk.primitives)
+    {
+        iter.second->release();
+    }
+    chunk.primitives.clear();
+    chunk.tileToQuadIndex.swap(quads.tileToQuadIndex);
+    chunk.dirty = false;
+
+    int vertexCount = (int)quads.quads.size() * 4;
+    if (vertexCount == 0)
+    {
+        CC_SAFE_RELEASE_NULL(chunk.vertexData);
+        CC_SAFE_RELEASE_NULL(chunk.vertexBuffer);
+        return;
+    }
+
+    GL::bindVAO(0);
+    if (chunk.vertexBuffer == nullptr || chunk.vertexBuffer->getVertexNumber() < vertexCount)
+    {
+        CC_SAFE_RELEASE_NULL(chunk.vertexData);
+        CC_SAFE_RELEASE_NULL(chunk.vertexBuffer);
+        chunk.vertexBuffer = VertexBuffer::create(sizeof(V3F_C4B_T2F), vertexCount);
+        chunk.vertexData = VertexData::create();
+        chunk.vertexData->setStream(chunk.vertexBuffer, VertexStreamAttribute(0, GLProgram::VERTEX_ATTRIB_POSITION, GL_FLOAT, 3));
+        chunk.vertexData->setStream(chunk.vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, colors), GLProgram::VERTEX_ATTRIB_COLOR, GL_UNSIGNED_BYTE, 4, true));
+        chunk.vertexData->setStream(chunk.vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, texCoords), GLProgram::VERTEX_ATTRIB_TEX_COORD, GL_FLOAT, 2));
+        CC_SAFE_RETAIN(chunk.vertexData);
+        CC_SAFE_RETAIN(chunk.vertexBuffer);
+    }
+    chunk.vertexBuffer->updateVertices(&quads.quads[0], vertexCount, 0);
+
+    int start = 0;
+    for (auto&& range : quads.vertexZRanges)
+    {
+        auto primitive = Primitive::create(chunk.vertexData, _chunkIndexBuffer, GL_TRIANGLES);
+        primitive->setStart(start * 6);
+        primitive->setCount(range.second * 6);
+        primitive->retain();
+        chunk.primitives.push_back(std::make_pair(range.first, primitive));
+        start += range.second;
+    }
+}
+
+void TMXLayer::loadChunk(int chunkIndex)
+{
+    auto& chunk = _chunks[chunkIndex];
+    ChunkQuads quads;
+    buildChunkQuads(chunk.x, chunk.y, chunk.width, chunk.height,
+        _tiles + getTileIndexByPos(chunk.x, chunk.y), (int)_layerSize.width, quads);
+    uploadChunk(chunk, quads);
+}
+
+void TMXLayer::loadChunkAsync(int chunkIndex)
+{
+    auto& chunk = _chunks[chunkIndex];
+    chunk.loading = true;
+
+    // the worker reads a copy of the tiles, they can still be changed meanwhile
+    auto gids = std::make_shared<std::vector<uint32_t>>(chunk.width * chunk.height);
+    for (int y = 0; y < chunk.height; ++y)
+    {
+        memcpy(&(*gids)[y * chunk.width], _tiles + getTileIndexByPos(chunk.x, chunk.y + y), chunk.width * sizeof(uint32_t));
+    }
+
+    auto quads = std::make_shared<ChunkQuads>();
+    auto version = chunk.version;
+    auto generation = _chunksGeneration;
+    int chunkX = chunk.x, chunkY = chunk.y, width = chunk.width, height = chunk.height;
+
+    // the layer stays alive until the quads are back on the main thread
+    this->retain();
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, [this, chunkIndex, version, generation, quads](void*) {
+        if (generation == _chunksGeneration)
+        {
+            auto& chunk = _chunks[chunkIndex];
+            chunk.loading = false;
+            // a tile changed meanwhile, the chunk stays dirty and is built again
+            if (chunk.version == version)
+            {
+                uploadChunk(chunk, *quads);
+            }
+        }
+        this->release();
+    }, nullptr, [this, chunkX, chunkY, width, height, gids, quads]() {
+        buildChunkQuads(chunkX, chunkY, width, height, gids->data(), width, *quads);
+    });
+}
+
 // removing / getting tiles
 Sprite* TMXLayer::getTileAt(const Vec2& tileCoordinate)
 {
@@ -638,7 +796,7 @@ Vec2 TMXLayer::getPositionAt(const Vec2& pos)
     return PointApplyTransform(pos, _tileToNodeTransform);
 }
 
-int TMXLayer::getVertexZForPos(const Vec2& pos)
+int TMXLayer::getVertexZForPos(const Vec2& pos) const
 {
     int ret = 0;
     int maxVal = 0;
@@ -695,9 +853,28 @@ void TMXLayer::removeTileAt(const Vec2& tileCoordinate)
 void TMXLayer::setFlaggedTileGIDByIndex(int index, int gid)
 {
     if(gid == _tiles[index]) return;
+    int oldGID = _tiles[index];
     _tiles[index] = gid;
-    _quadsDirty = true;
-    _dirty = true;
+    if (_quadsDirty)
+        return;
+
+    int x = index % (int)_layerSize.width;
+    int y = index / (int)_layerSize.width;
+    auto& chunk = _chunks[x / _chunkSize + (y / _chunkSize) * _chunkColumns];
+    ++chunk.version;
+
+    int quadIndex = chunk.dirty ? -1 : chunk.tileToQuadIndex[(x - chunk.x) + (y - chunk.y) * chunk.width];
+    if (quadIndex != -1 && oldGID != 0 && gid != 0)
+    {
+        // same tile position, so same vertex Z: the quad is updated in place
+        V3F_C4B_T2F_Quad quad;
+        setupTileQuad(quad, x, y, gid, getVertexZForPos(Vec2(x, y)));
+        chunk.vertexBuffer->updateVertices(&quad, 4, quadIndex * 4);
+    }
+    else
+    {
+        chunk.dirty = true;
+    }
 }
 
 void TMXLayer::removeChild(Node* node, bool cleanup)
@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 #include "2d/CCNode.h"
 #include "2d/CCTMXXMLParser.h"
 #include "renderer/CCPrimitiveCommand.h"
@@ -41,6 +42,10 @@ class TMXLayerInfo;
 class TMXTilesetInfo;
 class Texture2D;
 class Sprite;
+class VertexBuffer;
+class VertexData;
+class IndexBuffer;
+class Primitive;
 struct _ccCArray;
 
 namespace experimental{
@@ -71,6 +76,12 @@ namespace experimental{
  
  * For further information, please see the programming guide:
  * http://www.cocos2d-iphone.org/wiki/doku.php/prog_guide:tiled_maps
+
+ * The layer is split into square chunks of tiles (see setChunkSize()). Each chunk keeps its quads in its own
+ * static vertex buffer, sorted by vertex Z, so scrolling only selects the chunks to draw and nothing is rebuilt.
+ * Chunks are built the first time they are visible, changing a tile only updates its chunk. For big maps the
+ * chunks can be built by a worker thread (setAsyncChunkLoading()) and released once they have been out of the
+ * screen for a while (setChunkUnloadDelay()).
  
  * @since v3.2
  * @js NA
@@ -146,6 +157,35 @@ public:
 
     /** Creates the tiles. */
     void setupTiles();
+
+    /** Sets the size of the chunks, in tiles. Chunks are culled and rebuilt independently.
+     *
+     * @param tiles The width and height of a chunk, between 1 and 128. 32 by default.
+     */
+    void setChunkSize(int tiles);
+
+    /** Returns the size of the chunks, in tiles. */
+    int getChunkSize() const { return _chunkSize; }
+
+    /** Builds the vertices of the chunks that become visible on a worker thread.
+     * A chunk is drawn once it is built, the chunks around the screen are built in advance.
+     *
+     * @param enabled Whether chunks are built asynchronously. False by default.
+     */
+    void setAsyncChunkLoading(bool enabled) { _asyncChunkLoading = enabled; }
+
+    /** Returns whether chunks are built asynchronously. */
+    bool isAsyncChunkLoading() const { return _asyncChunkLoading; }
+
+    /** Chunks that have not been visible for this number of frames release their buffers, they are rebuilt
+     * when they become visible again.
+     *
+     * @param frames The number of frames, 0 (the default) keeps the chunks.
+     */
+    void setChunkUnloadDelay(unsigned int frames) { _chunkUnloadDelay = frames; }
+
+    /** Returns the number of frames after which hidden chunks are released. */
+    unsigned int getChunkUnloadDelay() const { return _chunkUnloadDelay; }
     
     /** Get the tile layer name.
      *
@@ -271,9 +311,32 @@ public:
     void removeChild(Node* child, bool cleanup = true) override;
 
 protected:
+    /** A rectangle of tiles drawn from its own vertex buffer. */
+    struct Chunk
+    {
+        /** first tile and size, in tiles */
+        int x;
+        int y;
+        int width;
+        int height;
+        /** the quads must be rebuilt */
+        bool dirty;
+        /** a worker thread is building the quads */
+        bool loading;
+        /** incremented on every change, the quads built from an older version are dropped */
+        unsigned int version;
+        unsigned int lastVisibleFrame;
+        /** tile index in the chunk to quad index, -1 for empty tiles */
+        std::vector<int> tileToQuadIndex;
+        VertexBuffer* vertexBuffer;
+        VertexData* vertexData;
+        /** one primitive per vertex Z, the quads are sorted by vertex Z */
+        std::vector<std::pair<int, Primitive*>> primitives;
+    };
+    struct ChunkQuads;
 
     bool initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *layerInfo, TMXMapInfo *mapInfo);
-    void updateTiles(const Rect& culledRect);
+    void updateVisibleChunks(const Rect& culledRect);
     Vec2 calculateLayerOffset(const Vec2& offset);
 
     /* The layer recognizes some special properties, like cc_vertexz */
@@ -282,20 +345,22 @@ protected:
     Mat4 tileToNodeTransform();
     Rect tileBoundsForClipTransform(const Mat4 &tileToClip);
     
-    int getVertexZForPos(const Vec2& pos);
+    int getVertexZForPos(const Vec2& pos) const;
     
     //Flip flags is packed into gid
     void setFlaggedTileGIDByIndex(int index, int gid);
     
-    //
-    void updateTotalQuads();
-    
     void onDraw(Primitive* primitive);
     inline int getTileIndexByPos(int x, int y) const { return x + y * (int) _layerSize.width; }
     
-    void updateVertexBuffer();
-    void updateIndexBuffer();
-    void updatePrimitives();
+    void setupChunks();
+    void releaseChunks();
+    void releaseChunkBuffers(Chunk& chunk);
+    void setupTileQuad(V3F_C4B_T2F_Quad& quad, int x, int y, int gid, float z) const;
+    void buildChunkQuads(int chunkX, int chunkY, int width, int height, const uint32_t* gids, int stride, ChunkQuads& out) const;
+    void uploadChunk(Chunk& chunk, ChunkQuads& quads);
+    void loadChunk(int chunkIndex);
+    void loadChunkAsync(int chunkIndex);
 protected:
     
     //! name of the layer
@@ -332,21 +397,22 @@ protected:
     Mat4 _tileToNodeTransform;
     /** data for rendering */
     bool _quadsDirty;
-    std::vector<int> _tileToQuadIndex;
-    std::vector<V3F_C4B_T2F_Quad> _totalQuads;
-    std::vector<GLushort> _indices;
-    std::map<int/*vertexZ*/, int/*offset to _indices by quads*/> _indicesVertexZOffsets;
-    std::unordered_map<int/*vertexZ*/, int/*number to quads*/> _indicesVertexZNumber;
     std::vector<PrimitiveCommand> _renderCommands;
     bool _dirty;
-    
-    VertexBuffer* _vertexBuffer;
-    
-    VertexData* _vData;
-    
-    IndexBuffer* _indexBuffer;
-    
-    Map<int , Primitive*> _primitives;
+
+    int _chunkSize;
+    int _chunkColumns;
+    int _chunkRows;
+    std::vector<Chunk> _chunks;
+    /** incremented each time the chunks are recreated */
+    unsigned int _chunksGeneration;
+    /** indices of the chunks to draw, and of the chunks to build in advance */
+    std::vector<int> _visibleChunks;
+    std::vector<int> _prefetchChunks;
+    /** the quads of all the chunks use the same indices */
+    IndexBuffer* _chunkIndexBuffer;
+    bool _asyncChunkLoading;
+    unsigned int _chunkUnloadDelay;
     
 public:
     /** Possible orientations of the TMX map */
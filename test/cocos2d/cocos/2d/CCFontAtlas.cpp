@@ -35,6 +35,10 @@
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "base/CCAsyncTaskPool.h"
+#include "platform/CCFileUtils.h"
+
+#include <zlib.h>
 
 NS_CC_BEGIN
 
@@ -42,16 +46,105 @@ const int FontAtlas::CacheTextureWidth = 512;
 const int FontAtlas::CacheTextureHeight = 512;
 const char* FontAtlas::CMD_PURGE_FONTATLAS = "__cc_PURGE_FONTATLAS";
 const char* FontAtlas::CMD_RESET_FONTATLAS = "__cc_RESET_FONTATLAS";
+const char* FontAtlas::CMD_GLYPHS_READY = "__cc_FONTATLAS_GLYPHS_READY";
+
+namespace
+{
+    const char BAKED_ATLAS_MAGIC[4] = { 'C', 'C', 'F', 'A' };
+    const uint32_t BAKED_ATLAS_VERSION = 1;
+
+    template <typename T>
+    void writeValue(std::vector<unsigned char>& buffer, T value)
+    {
+        auto bytes = reinterpret_cast<const unsigned char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    // reads a baked atlas, every read fails once the end of the data is reached
+    class BakedAtlasReader
+    {
+    public:
+        explicit BakedAtlasReader(const Data& data)
+        : _bytes(data.getBytes())
+        , _size(data.getSize())
+        , _offset(0)
+        {
+        }
+
+        const unsigned char* skip(size_t size)
+        {
+            if (size > static_cast<size_t>(_size - _offset))
+            {
+                _offset = _size;
+                return nullptr;
+            }
+            auto ret = _bytes + _offset;
+            _offset += size;
+            return ret;
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            auto bytes = skip(sizeof(T));
+            if (bytes)
+            {
+                memcpy(&value, bytes, sizeof(T));
+            }
+            return bytes != nullptr;
+        }
+
+    private:
+        const unsigned char* _bytes;
+        ssize_t _size;
+        ssize_t _offset;
+    };
+
+    // 0: none, 1: single channel, 2: multi-channel
+    int32_t bakedDistanceField(FontFreeType* font)
+    {
+        if (font->isMultiChannelDistanceFieldEnabled())
+            return 2;
+        return font->isDistanceFieldEnabled() ? 1 : 0;
+    }
+
+    Texture2D::PixelFormat pagePixelFormat(int bytesPerPixel)
+    {
+        switch (bytesPerPixel)
+        {
+        case 2:
+            return Texture2D::PixelFormat::AI88;
+        case 3:
+            return Texture2D::PixelFormat::RGB888;
+        default:
+            return Texture2D::PixelFormat::A8;
+        }
+    }
+}
+
+struct FontAtlas::AsyncGlyph
+{
+    char16_t utf16Char;
+    unsigned short charCode;
+    unsigned char* bitmap;
+    long width;
+    long height;
+    Rect rect;
+    int xAdvance;
+};
 
 FontAtlas::FontAtlas(Font &theFont) 
 : _font(&theFont)
 , _fontFreeType(nullptr)
 , _iconv(nullptr)
 , _currentPageData(nullptr)
+, _pageBytesPerPixel(1)
 , _fontAscender(0)
 , _rendererRecreatedListener(nullptr)
 , _antialiasEnabled(true)
 , _currLineHeight(0)
+, _asyncGlyphLoading(false)
+, _keepFinishedPages(false)
 {
     _font->retain();
 
@@ -71,20 +164,23 @@ FontAtlas::FontAtlas(Font &theFont)
         {
             _letterPadding += 2 * FontFreeType::DistanceMapSpread;    
         }
-        _currentPageDataSize = CacheTextureWidth * CacheTextureHeight;
         auto outlineSize = _fontFreeType->getOutlineSize();
         if(outlineSize > 0)
         {
             _lineHeight += 2 * outlineSize;
-            _currentPageDataSize *= 2;
+            _pageBytesPerPixel = 2;
         }
+        else if (_fontFreeType->isMultiChannelDistanceFieldEnabled())
+        {
+            _pageBytesPerPixel = 3;
+        }
+        _currentPageDataSize = CacheTextureWidth * CacheTextureHeight * _pageBytesPerPixel;
 
         _currentPageData = new unsigned char[_currentPageDataSize];
         memset(_currentPageData, 0, _currentPageDataSize);
 
-        auto  pixelFormat = outlineSize > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8; 
         texture->initWithData(_currentPageData, _currentPageDataSize, 
-            pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
+            pagePixelFormat(_pageBytesPerPixel), CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
 
         addTexture(texture,0);
         texture->release();
@@ -109,6 +205,9 @@ FontAtlas::~FontAtlas()
     }
 #endif
 
+    // results of the worker thread that arrive later are dropped
+    _asyncHandle.reset();
+
     _font->release();
     relaseTextures();
 
@@ -256,7 +355,7 @@ void FontAtlas::findNewCharacters(const std::u16string& u16Text, std::unordered_
     FT_Encoding charEncoding = _fontFreeType->getEncoding();
 
     //find new characters
-    if (_letterDefinitions.empty())
+    if (_letterDefinitions.empty() && _pendingLetters.empty())
     {
         newChars = u16Text;
     }
@@ -267,7 +366,7 @@ void FontAtlas::findNewCharacters(const std::u16string& u16Text, std::unordered_
         for (size_t i = 0; i < length; ++i)
         {
             auto outIterator = _letterDefinitions.find(u16Text[i]);
-            if (outIterator == _letterDefinitions.end())
+            if (outIterator == _letterDefinitions.end() && _pendingLetters.find(u16Text[i]) == _pendingLetters.end())
             {
                 newChars.push_back(u16Text[i]);
             }
@@ -312,113 +411,416 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16Text)
         return false;
     }
 
-    int adjustForDistanceMap = _letterPadding / 2;
-    int adjustForExtend = _letterEdgeExtend / 2;
+    if (_asyncGlyphLoading)
+    {
+        rasterizeLettersAsync(codeMapOfNewChar);
+        return false;
+    }
+
     long bitmapWidth;
     long bitmapHeight;
     Rect tempRect;
-    FontLetterDefinition tempDef;
-
-    auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
-    auto  pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+    int xAdvance;
 
     float startY = _currentPageOrigY;
 
-    for (auto&& it : codeMapOfNewChar)
     {
-        auto bitmap = _fontFreeType->getGlyphBitmap(it.second, bitmapWidth, bitmapHeight, tempRect, tempDef.xAdvance);
-        if (bitmap && bitmapWidth > 0 && bitmapHeight > 0)
+        // the bitmaps point into the face, the glyph loading thread must not overwrite them before they are copied
+        auto faceLock = _fontFreeType->lockFace();
+        for (auto&& it : codeMapOfNewChar)
         {
-            tempDef.validDefinition = true;
-            tempDef.width = tempRect.size.width + _letterPadding + _letterEdgeExtend;
-            tempDef.height = tempRect.size.height + _letterPadding + _letterEdgeExtend;
-            tempDef.offsetX = tempRect.origin.x + adjustForDistanceMap + adjustForExtend;
-            tempDef.offsetY = _fontAscender + tempRect.origin.y - adjustForDistanceMap - adjustForExtend;
+            auto bitmap = _fontFreeType->getGlyphBitmap(it.second, bitmapWidth, bitmapHeight, tempRect, xAdvance);
+            addLetterBitmap(it.first, bitmap, bitmapWidth, bitmapHeight, tempRect, xAdvance, startY);
+        }
+    }
 
-            if (bitmapHeight > _currLineHeight)
-            {
-                _currLineHeight = static_cast<int>(bitmapHeight) + _letterPadding + _letterEdgeExtend + 1;
-            }
-            if (_currentPageOrigX + tempDef.width > CacheTextureWidth)
+    updateTextureContent(startY);
+
+    return true;
+}
+
+bool FontAtlas::addLetterBitmap(char16_t utf16Char, unsigned char* bitmap, long bitmapWidth, long bitmapHeight,
+    const Rect& bitmapRect, int xAdvance, float& startY)
+{
+    int adjustForDistanceMap = _letterPadding / 2;
+    int adjustForExtend = _letterEdgeExtend / 2;
+    FontLetterDefinition tempDef;
+    tempDef.xAdvance = xAdvance;
+    bool rendered = false;
+
+    auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
+
+    if (bitmap && bitmapWidth > 0 && bitmapHeight > 0)
+    {
+        tempDef.validDefinition = true;
+        tempDef.width = bitmapRect.size.width + _letterPadding + _letterEdgeExtend;
+        tempDef.height = bitmapRect.size.height + _letterPadding + _letterEdgeExtend;
+        tempDef.offsetX = bitmapRect.origin.x + adjustForDistanceMap + adjustForExtend;
+        tempDef.offsetY = _fontAscender + bitmapRect.origin.y - adjustForDistanceMap - adjustForExtend;
+
+        if (bitmapHeight > _currLineHeight)
+        {
+            _currLineHeight = static_cast<int>(bitmapHeight) + _letterPadding + _letterEdgeExtend + 1;
+        }
+        if (_currentPageOrigX + tempDef.width > CacheTextureWidth)
+        {
+            _currentPageOrigY += _currLineHeight;
+            _currLineHeight = 0;
+            _currentPageOrigX = 0;
+            if (_currentPageOrigY + _lineHeight >= CacheTextureHeight)
             {
-                _currentPageOrigY += _currLineHeight;
-                _currLineHeight = 0;
-                _currentPageOrigX = 0;
-                if (_currentPageOrigY + _lineHeight >= CacheTextureHeight)
+                unsigned char *data = _currentPageData + CacheTextureWidth * (int)startY * _pageBytesPerPixel;
+                _atlasTextures[_currentPage]->updateWithData(data, 0, startY,
+                    CacheTextureWidth, CacheTextureHeight - startY);
+
+                if (_keepFinishedPages)
                 {
-                    unsigned char *data = nullptr;
-                    if (pixelFormat == Texture2D::PixelFormat::AI88)
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
-                    }
-                    else
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY;
-                    }
-                    _atlasTextures[_currentPage]->updateWithData(data, 0, startY,
-                        CacheTextureWidth, CacheTextureHeight - startY);
-
-                    startY = 0.0f;
-
-                    _currentPageOrigY = 0;
-                    memset(_currentPageData, 0, _currentPageDataSize);
-                    _currentPage++;
-                    auto tex = new (std::nothrow) Texture2D;
-                    if (_antialiasEnabled)
-                    {
-                        tex->setAntiAliasTexParameters();
-                    }
-                    else
-                    {
-                        tex->setAliasTexParameters();
-                    }
-                    tex->initWithData(_currentPageData, _currentPageDataSize,
-                        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
-                    addTexture(tex, _currentPage);
-                    tex->release();
+                    Data page;
+                    page.copy(_currentPageData, _currentPageDataSize);
+                    _finishedPages.push_back(page);
                 }
+
+                startY = 0.0f;
+
+                _currentPageOrigY = 0;
+                memset(_currentPageData, 0, _currentPageDataSize);
+                _currentPage++;
+                auto tex = new (std::nothrow) Texture2D;
+                if (_antialiasEnabled)
+                {
+                    tex->setAntiAliasTexParameters();
+                }
+                else
+                {
+                    tex->setAliasTexParameters();
+                }
+                tex->initWithData(_currentPageData, _currentPageDataSize,
+                    pagePixelFormat(_pageBytesPerPixel), CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+                addTexture(tex, _currentPage);
+                tex->release();
             }
-            _fontFreeType->renderCharAt(_currentPageData, _currentPageOrigX + adjustForExtend, _currentPageOrigY + adjustForExtend, bitmap, bitmapWidth, bitmapHeight);
-
-            tempDef.U = _currentPageOrigX;
-            tempDef.V = _currentPageOrigY;
-            tempDef.textureID = _currentPage;
-            _currentPageOrigX += tempDef.width + 1;
-            // take from pixels to points
-            tempDef.width = tempDef.width / scaleFactor;
-            tempDef.height = tempDef.height / scaleFactor;
-            tempDef.U = tempDef.U / scaleFactor;
-            tempDef.V = tempDef.V / scaleFactor;
         }
-        else{
-            if (tempDef.xAdvance)
-                tempDef.validDefinition = true;
-            else
-                tempDef.validDefinition = false;
-
-            tempDef.width = 0;
-            tempDef.height = 0;
-            tempDef.U = 0;
-            tempDef.V = 0;
-            tempDef.offsetX = 0;
-            tempDef.offsetY = 0;
-            tempDef.textureID = 0;
-            _currentPageOrigX += 1;
+        _fontFreeType->renderCharAt(_currentPageData, _currentPageOrigX + adjustForExtend, _currentPageOrigY + adjustForExtend, bitmap, bitmapWidth, bitmapHeight);
+        rendered = true;
+
+        tempDef.U = _currentPageOrigX;
+        tempDef.V = _currentPageOrigY;
+        tempDef.textureID = _currentPage;
+        _currentPageOrigX += tempDef.width + 1;
+        // take from pixels to points
+        tempDef.width = tempDef.width / scaleFactor;
+        tempDef.height = tempDef.height / scaleFactor;
+        tempDef.U = tempDef.U / scaleFactor;
+        tempDef.V = tempDef.V / scaleFactor;
+    }
+    else{
+        if (tempDef.xAdvance)
+            tempDef.validDefinition = true;
+        else
+            tempDef.validDefinition = false;
+
+        tempDef.width = 0;
+        tempDef.height = 0;
+        tempDef.U = 0;
+        tempDef.V = 0;
+        tempDef.offsetX = 0;
+        tempDef.offsetY = 0;
+        tempDef.textureID = 0;
+        _currentPageOrigX += 1;
+    }
+
+    _letterDefinitions[utf16Char] = tempDef;
+    return rendered;
+}
+
+void FontAtlas::updateTextureContent(float startY)
+{
+    unsigned char *data = _currentPageData + CacheTextureWidth * (int)startY * _pageBytesPerPixel;
+    _atlasTextures[_currentPage]->updateWithData(data, 0, startY, CacheTextureWidth, _currentPageOrigY - startY + _lineHeight);
+}
+
+void FontAtlas::rasterizeLettersAsync(const std::unordered_map<unsigned short, unsigned short>& charCodeMap)
+{
+    if (!_asyncHandle)
+    {
+        _asyncHandle = std::make_shared<FontAtlas*>(this);
+    }
+
+    auto glyphs = std::make_shared<std::vector<AsyncGlyph>>();
+    glyphs->reserve(charCodeMap.size());
+    for (auto&& it : charCodeMap)
+    {
+        AsyncGlyph glyph;
+        glyph.utf16Char = it.first;
+        glyph.charCode = it.second;
+        glyph.bitmap = nullptr;
+        glyph.width = 0;
+        glyph.height = 0;
+        glyph.xAdvance = 0;
+        glyphs->push_back(glyph);
+
+        _pendingLetters.insert(it.first);
+    }
+
+    // the font is released on the main thread, once the glyphs are back
+    auto font = _fontFreeType;
+    font->retain();
+    std::weak_ptr<FontAtlas*> handle = _asyncHandle;
+
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, [font, glyphs, handle](void*) {
+        auto atlas = handle.lock();
+        if (atlas)
+        {
+            (*atlas)->addAsyncGlyphs(*glyphs);
+        }
+
+        for (auto&& glyph : *glyphs)
+        {
+            delete [] glyph.bitmap;
+        }
+        font->release();
+    }, nullptr, [font, glyphs]() {
+        for (auto&& glyph : *glyphs)
+        {
+            glyph.bitmap = font->getGlyphBitmapCopy(glyph.charCode, glyph.width, glyph.height, glyph.rect, glyph.xAdvance);
+        }
+    });
+}
+
+void FontAtlas::addAsyncGlyphs(std::vector<AsyncGlyph>& glyphs)
+{
+    float startY = _currentPageOrigY;
+    bool added = false;
+
+    for (auto&& glyph : glyphs)
+    {
+        _pendingLetters.erase(glyph.utf16Char);
+        if (_letterDefinitions.find(glyph.utf16Char) != _letterDefinitions.end())
+        {
+            continue;
         }
 
-        _letterDefinitions[it.first] = tempDef;
+        auto rendered = addLetterBitmap(glyph.utf16Char, glyph.bitmap, glyph.width, glyph.height, glyph.rect, glyph.xAdvance, startY);
+        if (rendered && _fontFreeType->isGlyphBitmapAllocated())
+        {
+            // renderCharAt() deletes the bitmaps it owns
+            glyph.bitmap = nullptr;
+        }
+        added = true;
     }
 
-    unsigned char *data = nullptr;
-    if (pixelFormat == Texture2D::PixelFormat::AI88)
+    if (added)
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
+        updateTextureContent(startY);
+        Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(CMD_GLYPHS_READY, this);
     }
-    else
+}
+
+bool FontAtlas::bakeToFile(const std::u16string& utf16Text, const std::string& filePath)
+{
+    if (_fontFreeType == nullptr || _currentPage != 0)
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY;
+        CCLOG("FontAtlas::bakeToFile: only TTF atlases which are still on their first page can be baked");
+        return false;
     }
-    _atlasTextures[_currentPage]->updateWithData(data, 0, startY, CacheTextureWidth, _currentPageOrigY - startY + _lineHeight);
+
+    auto asyncGlyphLoading = _asyncGlyphLoading;
+    _asyncGlyphLoading = false;
+    _keepFinishedPages = true;
+    prepareLetterDefinitions(utf16Text);
+    _keepFinishedPages = false;
+    _asyncGlyphLoading = asyncGlyphLoading;
+
+    std::vector<Data> pages;
+    pages.swap(_finishedPages);
+    Data currentPage;
+    currentPage.copy(_currentPageData, _currentPageDataSize);
+    pages.push_back(currentPage);
+
+    std::vector<unsigned char> buffer;
+    buffer.insert(buffer.end(), BAKED_ATLAS_MAGIC, BAKED_ATLAS_MAGIC + sizeof(BAKED_ATLAS_MAGIC));
+    writeValue<uint32_t>(buffer, BAKED_ATLAS_VERSION);
+    writeValue<float>(buffer, CC_CONTENT_SCALE_FACTOR());
+    writeValue<float>(buffer, _lineHeight);
+    writeValue<int32_t>(buffer, _fontAscender);
+    writeValue<int32_t>(buffer, static_cast<int32_t>(_fontFreeType->getOutlineSize()));
+    writeValue<int32_t>(buffer, bakedDistanceField(_fontFreeType));
+    writeValue<int32_t>(buffer, CacheTextureWidth);
+    writeValue<int32_t>(buffer, CacheTextureHeight);
+    writeValue<int32_t>(buffer, static_cast<int32_t>(pages.size()));
+    writeValue<float>(buffer, _currentPageOrigX);
+    writeValue<float>(buffer, _currentPageOrigY);
+    writeValue<int32_t>(buffer, _currLineHeight);
+
+    writeValue<uint32_t>(buffer, static_cast<uint32_t>(_letterDefinitions.size()));
+    for (auto&& it : _letterDefinitions)
+    {
+        auto& letterDefinition = it.second;
+        writeValue<uint16_t>(buffer, it.first);
+        writeValue<float>(buffer, letterDefinition.U);
+        writeValue<float>(buffer, letterDefinition.V);
+        writeValue<float>(buffer, letterDefinition.width);
+        writeValue<float>(buffer, letterDefinition.height);
+        writeValue<float>(buffer, letterDefinition.offsetX);
+        writeValue<float>(buffer, letterDefinition.offsetY);
+        writeValue<int32_t>(buffer, letterDefinition.textureID);
+        writeValue<int32_t>(buffer, letterDefinition.xAdvance);
+        writeValue<uint8_t>(buffer, letterDefinition.validDefinition ? 1 : 0);
+    }
+
+    for (auto&& page : pages)
+    {
+        auto sizeOffset = buffer.size();
+        uLongf compressedSize = compressBound(static_cast<uLong>(page.getSize()));
+        buffer.resize(sizeOffset + sizeof(uint32_t) + compressedSize);
+        if (compress2(&buffer[sizeOffset + sizeof(uint32_t)], &compressedSize, page.getBytes(),
+            static_cast<uLong>(page.getSize()), Z_BEST_COMPRESSION) != Z_OK)
+        {
+            CCLOG("FontAtlas::bakeToFile: failed to compress a page");
+            return false;
+        }
+        uint32_t pageSize = static_cast<uint32_t>(compressedSize);
+        memcpy(&buffer[sizeOffset], &pageSize, sizeof(pageSize));
+        buffer.resize(sizeOffset + sizeof(uint32_t) + compressedSize);
+    }
+
+    Data data;
+    data.copy(buffer.data(), buffer.size());
+    return FileUtils::getInstance()->writeDataToFile(data, filePath);
+}
+
+bool FontAtlas::loadBakedAtlas(const std::string& filePath)
+{
+    if (_fontFreeType == nullptr || _currentPage != 0 || !_letterDefinitions.empty() || !_pendingLetters.empty())
+    {
+        CCLOG("FontAtlas::loadBakedAtlas: only empty TTF atlases can load a baked atlas");
+        return false;
+    }
+
+    Data data = FileUtils::getInstance()->getDataFromFile(filePath);
+    if (data.isNull())
+    {
+        CCLOG("FontAtlas::loadBakedAtlas: can't read %s", filePath.c_str());
+        return false;
+    }
+
+    BakedAtlasReader reader(data);
+    auto magic = reader.skip(sizeof(BAKED_ATLAS_MAGIC));
+    uint32_t version = 0;
+    reader.read(version);
+    if (magic == nullptr || memcmp(magic, BAKED_ATLAS_MAGIC, sizeof(BAKED_ATLAS_MAGIC)) != 0 || version != BAKED_ATLAS_VERSION)
+    {
+        CCLOG("FontAtlas::loadBakedAtlas: %s is not a baked atlas", filePath.c_str());
+        return false;
+    }
+
+    float scaleFactor = 0.f, lineHeight = 0.f, pageOrigX = 0.f, pageOrigY = 0.f;
+    int32_t fontAscender = 0, outlineSize = 0, distanceField = 0, pageWidth = 0, pageHeight = 0, pageCount = 0, currLineHeight = 0;
+    uint32_t letterCount = 0;
+    reader.read(scaleFactor);
+    reader.read(lineHeight);
+    reader.read(fontAscender);
+    reader.read(outlineSize);
+    reader.read(distanceField);
+    reader.read(pageWidth);
+    reader.read(pageHeight);
+    reader.read(pageCount);
+    reader.read(pageOrigX);
+    reader.read(pageOrigY);
+    reader.read(currLineHeight);
+    if (!reader.read(letterCount))
+    {
+        CCLOG("FontAtlas::loadBakedAtlas: %s is truncated", filePath.c_str());
+        return false;
+    }
+
+    if (scaleFactor != CC_CONTENT_SCALE_FACTOR() || lineHeight != _lineHeight || fontAscender != _fontAscender
+        || outlineSize != static_cast<int32_t>(_fontFreeType->getOutlineSize())
+        || distanceField != bakedDistanceField(_fontFreeType)
+        || pageWidth != CacheTextureWidth || pageHeight != CacheTextureHeight || pageCount <= 0)
+    {
+        CCLOG("FontAtlas::loadBakedAtlas: %s was baked for another font configuration", filePath.c_str());
+        return false;
+    }
+
+    std::unordered_map<char16_t, FontLetterDefinition> letterDefinitions;
+    for (uint32_t i = 0; i < letterCount; ++i)
+    {
+        uint16_t utf16Char = 0;
+        uint8_t validDefinition = 0;
+        int32_t textureID = 0, xAdvance = 0;
+        FontLetterDefinition letterDefinition;
+        reader.read(utf16Char);
+        reader.read(letterDefinition.U);
+        reader.read(letterDefinition.V);
+        reader.read(letterDefinition.width);
+        reader.read(letterDefinition.height);
+        reader.read(letterDefinition.offsetX);
+        reader.read(letterDefinition.offsetY);
+        reader.read(textureID);
+        reader.read(xAdvance);
+        if (!reader.read(validDefinition) || textureID < 0 || textureID >= pageCount)
+        {
+            CCLOG("FontAtlas::loadBakedAtlas: %s is corrupted", filePath.c_str());
+            return false;
+        }
+        letterDefinition.textureID = textureID;
+        letterDefinition.xAdvance = xAdvance;
+        letterDefinition.validDefinition = validDefinition != 0;
+        letterDefinitions[utf16Char] = letterDefinition;
+    }
+
+    std::vector<Data> pages(pageCount);
+    for (auto&& page : pages)
+    {
+        uint32_t compressedSize = 0;
+        reader.read(compressedSize);
+        auto compressed = reader.skip(compressedSize);
+        auto pageData = static_cast<unsigned char*>(malloc(_currentPageDataSize));
+        uLongf pageSize = _currentPageDataSize;
+        if (compressed == nullptr || pageData == nullptr
+            || uncompress(pageData, &pageSize, compressed, compressedSize) != Z_OK
+            || pageSize != static_cast<uLongf>(_currentPageDataSize))
+        {
+            CCLOG("FontAtlas::loadBakedAtlas: %s is corrupted", filePath.c_str());
+            free(pageData);
+            return false;
+        }
+        page.fastSet(pageData, pageSize);
+    }
+
+    auto pixelFormat = pagePixelFormat(_pageBytesPerPixel);
+    for (int32_t i = 0; i < pageCount; ++i)
+    {
+        if (i == 0)
+        {
+            _atlasTextures[0]->updateWithData(pages[i].getBytes(), 0, 0, CacheTextureWidth, CacheTextureHeight);
+        }
+        else
+        {
+            auto tex = new (std::nothrow) Texture2D;
+            if (_antialiasEnabled)
+            {
+                tex->setAntiAliasTexParameters();
+            }
+            else
+            {
+                tex->setAliasTexParameters();
+            }
+            tex->initWithData(pages[i].getBytes(), pages[i].getSize(),
+                pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+            addTexture(tex, i);
+            tex->release();
+        }
+    }
+
+    // new letters are added after the baked ones, on the last page
+    memcpy(_currentPageData, pages.back().getBytes(), _currentPageDataSize);
+    _currentPage = pageCount - 1;
+    _currentPageOrigX = pageOrigX;
+    _currentPageOrigY = pageOrigY;
+    _currLineHeight = currLineHeight;
+    _letterDefinitions.swap(letterDefinitions);
 
     return true;
 }
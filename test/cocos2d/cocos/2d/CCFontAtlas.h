@@ -30,10 +30,15 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <memory>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
 #include "platform/CCStdC.h" // ssize_t on windows
+#include "base/CCData.h"
+#include "math/CCGeometry.h"
 
 NS_CC_BEGIN
 
@@ -63,6 +68,8 @@ public:
     static const int CacheTextureHeight;
     static const char* CMD_PURGE_FONTATLAS;
     static const char* CMD_RESET_FONTATLAS;
+    /** Dispatched with the atlas as user data when glyphs rasterized by the worker thread were added. */
+    static const char* CMD_GLYPHS_READY;
     /**
      * @js ctor
      */
@@ -108,9 +115,42 @@ public:
      */
      void setAliasTexParameters();
 
+    /**
+     * Rasterizes the missing glyphs on a worker thread instead of blocking prepareLetterDefinitions().
+     * Until they are ready the missing letters have no definition, CMD_GLYPHS_READY is dispatched
+     * once they are added to the atlas. Only TTF atlases support it.
+     */
+    void setAsyncGlyphLoading(bool enabled) { _asyncGlyphLoading = enabled; }
+    bool isAsyncGlyphLoading() const { return _asyncGlyphLoading; }
+
+    /** Returns true if some glyphs are being rasterized by the worker thread. */
+    bool hasPendingLetters() const { return !_pendingLetters.empty(); }
+
+    /**
+     * Rasterizes the letters of a string and writes the whole atlas (letter definitions and pages)
+     * to a file that can be loaded with loadBakedAtlas().
+     * The atlas must not have filled its first page yet.
+     */
+    bool bakeToFile(const std::u16string& utf16Text, const std::string& filePath);
+
+    /**
+     * Replaces the content of an empty TTF atlas with a baked one.
+     * The font of the atlas must have the same size, outline and distance field settings as the baked one
+     * and the content scale factor must match, letters missing from the file are still rasterized on demand.
+     */
+    bool loadBakedAtlas(const std::string& filePath);
+
 protected:
+    struct AsyncGlyph;
+
     void relaseTextures();
 
+    bool addLetterBitmap(char16_t utf16Char, unsigned char* bitmap, long bitmapWidth, long bitmapHeight,
+        const Rect& bitmapRect, int xAdvance, float& startY);
+    void updateTextureContent(float startY);
+    void rasterizeLettersAsync(const std::unordered_map<unsigned short, unsigned short>& charCodeMap);
+    void addAsyncGlyphs(std::vector<AsyncGlyph>& glyphs);
+
     void findNewCharacters(const std::u16string& u16Text, std::unordered_map<unsigned short, unsigned short>& charCodeMap);
 
     void conversionU16TOGB2312(const std::u16string& u16Text, std::unordered_map<unsigned short, unsigned short>& charCodeMap);
@@ -133,6 +173,8 @@ protected:
     int _currentPage;
     unsigned char *_currentPageData;
     int _currentPageDataSize;
+    // 1 (A8), 2 (AI88, outlined glyphs) or 3 (RGB888, multi-channel distance fields)
+    int _pageBytesPerPixel;
     float _currentPageOrigX;
     float _currentPageOrigY;
     int _letterPadding;
@@ -143,6 +185,15 @@ protected:
     bool _antialiasEnabled;
     int _currLineHeight;
 
+    bool _asyncGlyphLoading;
+    std::unordered_set<char16_t> _pendingLetters;
+    // lets the worker callbacks know if the atlas is still alive
+    std::shared_ptr<FontAtlas*> _asyncHandle;
+
+    // pages that are full, only kept while baking
+    bool _keepFinishedPages;
+    std::vector<Data> _finishedPages;
+
     friend class Label;
 };
 
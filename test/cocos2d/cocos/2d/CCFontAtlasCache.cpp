@@ -32,10 +32,28 @@
 #include "2d/CCFontAtlas.h"
 #include "2d/CCFontCharMap.h"
 #include "2d/CCLabel.h"
+#include "base/ccUTF8.h"
 
 NS_CC_BEGIN
 
 std::unordered_map<std::string, FontAtlas *> FontAtlasCache::_atlasMap;
+std::unordered_map<std::string, std::string> FontAtlasCache::_bakedAtlasFiles;
+bool FontAtlasCache::_asyncGlyphLoading = false;
+
+namespace
+{
+    // outlined glyphs can't be distance fields
+    bool isMultiChannelDistanceField(const _ttfConfig* config)
+    {
+        return config->multiChannelDistanceFieldEnabled && config->outlineSize <= 0;
+    }
+
+    // multi-channel distance field atlases are shared by all the sizes of a font
+    float getTTFAtlasFontSize(const _ttfConfig* config)
+    {
+        return isMultiChannelDistanceField(config) ? FontFreeType::MultiChannelDistanceFieldFontSize : config->fontSize;
+    }
+}
 
 void FontAtlasCache::purgeCachedData()
 {
@@ -54,23 +72,25 @@ FontAtlas* FontAtlasCache::getFontAtlasTTF(const _ttfConfig* config)
         useDistanceField = false;
     }
 
-    auto atlasName = generateFontName(config->fontFilePath, config->fontSize, useDistanceField);
-    atlasName.append("_outline_");
-    std::stringstream ss;
-    ss << config->outlineSize;
-    atlasName.append(ss.str());
-
+    auto atlasName = generateTTFAtlasName(config);
     auto it = _atlasMap.find(atlasName);
 
     if ( it == _atlasMap.end() )
     {
-        auto font = FontFreeType::create(config->fontFilePath, config->fontSize, config->glyphs,
-            config->customGlyphs, useDistanceField, config->outlineSize);
+        auto font = FontFreeType::create(config->fontFilePath, getTTFAtlasFontSize(config), config->glyphs,
+            config->customGlyphs, useDistanceField, config->outlineSize, isMultiChannelDistanceField(config));
         if (font)
         {
+            auto bakedIter = _bakedAtlasFiles.find(atlasName);
+            if (bakedIter != _bakedAtlasFiles.end())
+            {
+                font->setBakedAtlasFile(bakedIter->second);
+            }
             auto tempAtlas = font->createFontAtlas();
             if (tempAtlas)
             {
+                tempAtlas->setAsyncGlyphLoading(_asyncGlyphLoading);
+
                 _atlasMap[atlasName] = tempAtlas;
                 return _atlasMap[atlasName];
             }
@@ -85,6 +105,61 @@ FontAtlas* FontAtlasCache::getFontAtlasTTF(const _ttfConfig* config)
     return nullptr;
 }
 
+bool FontAtlasCache::bakeFontAtlasTTF(const _ttfConfig* config, const std::string& utf8Text, const std::string& bakedFilePath)
+{
+    bool useDistanceField = config->distanceFieldEnabled;
+    if(config->outlineSize > 0)
+    {
+        useDistanceField = false;
+    }
+
+    std::u16string utf16Text;
+    if (!StringUtils::UTF8ToUTF16(utf8Text, utf16Text))
+    {
+        return false;
+    }
+
+    // a private atlas, the cached ones may have filled pages already
+    auto font = FontFreeType::create(config->fontFilePath, getTTFAtlasFontSize(config), GlyphCollection::DYNAMIC,
+        nullptr, useDistanceField, config->outlineSize, isMultiChannelDistanceField(config));
+    if (font == nullptr)
+    {
+        return false;
+    }
+
+    auto atlas = font->createFontAtlas();
+    if (atlas == nullptr)
+    {
+        return false;
+    }
+
+    bool ret = atlas->bakeToFile(utf16Text, bakedFilePath);
+    atlas->release();
+    return ret;
+}
+
+void FontAtlasCache::addBakedFontAtlasTTF(const _ttfConfig* config, const std::string& bakedFilePath)
+{
+    _bakedAtlasFiles[generateTTFAtlasName(config)] = bakedFilePath;
+}
+
+void FontAtlasCache::removeBakedFontAtlasTTF(const _ttfConfig* config)
+{
+    _bakedAtlasFiles.erase(generateTTFAtlasName(config));
+}
+
+void FontAtlasCache::setAsyncGlyphLoading(bool enabled)
+{
+    _asyncGlyphLoading = enabled;
+    for (auto&& item : _atlasMap)
+    {
+        if (dynamic_cast<const FontFreeType*>(item.second->getFont()))
+        {
+            item.second->setAsyncGlyphLoading(enabled);
+        }
+    }
+}
+
 FontAtlas* FontAtlasCache::getFontAtlasFNT(const std::string& fontFileName, const Vec2& imageOffset /* = Vec2::ZERO */)
 {
     std::string atlasName = generateFontName(fontFileName, 0,false);
@@ -215,6 +290,28 @@ std::string FontAtlasCache::generateFontName(const std::string& fontFileName, fl
     return  tempName.append(ss.str());
 }
 
+std::string FontAtlasCache::generateTTFAtlasName(const _ttfConfig* config)
+{
+    if (isMultiChannelDistanceField(config))
+    {
+        auto atlasName = generateFontName(config->fontFilePath, getTTFAtlasFontSize(config), false);
+        return atlasName.append("_msdf");
+    }
+
+    bool useDistanceField = config->distanceFieldEnabled;
+    if(config->outlineSize > 0)
+    {
+        useDistanceField = false;
+    }
+
+    auto atlasName = generateFontName(config->fontFilePath, config->fontSize, useDistanceField);
+    atlasName.append("_outline_");
+    std::stringstream ss;
+    ss << config->outlineSize;
+    atlasName.append(ss.str());
+    return atlasName;
+}
+
 bool FontAtlasCache::releaseFontAtlas(FontAtlas *atlas)
 {
     if (nullptr != atlas)
@@ -66,9 +66,31 @@ public:
     */
     static void unloadFontAtlasTTF(const std::string& fontFileName);
 
+    /** Rasterizes the characters of a string with a TTF configuration and writes the atlas to a file.
+     Run it on the desktop with the content scale factor of the target, then ship the file and register it
+     with addBakedFontAtlasTTF(). Returns false if the font can't be loaded or the file can't be written.
+    */
+    static bool bakeFontAtlasTTF(const _ttfConfig* config, const std::string& utf8Text, const std::string& bakedFilePath);
+
+    /** Uses a file written by bakeFontAtlasTTF() for the atlas of a TTF configuration.
+     The file is loaded when the atlas is created, so register it before creating the labels.
+     All the labels with this configuration share the baked atlas, letters that were not baked are still rasterized on demand.
+    */
+    static void addBakedFontAtlasTTF(const _ttfConfig* config, const std::string& bakedFilePath);
+    static void removeBakedFontAtlasTTF(const _ttfConfig* config);
+
+    /** Rasterizes the missing glyphs of TTF atlases on a worker thread, they are shown one frame later.
+     It applies to the existing atlases and the ones created after.
+    */
+    static void setAsyncGlyphLoading(bool enabled);
+    static bool isAsyncGlyphLoading() { return _asyncGlyphLoading; }
+
 private:
     static std::string generateFontName(const std::string& fontFileName, float size, bool useDistanceField);
+    static std::string generateTTFAtlasName(const _ttfConfig* config);
     static std::unordered_map<std::string, FontAtlas *> _atlasMap;
+    static std::unordered_map<std::string, std::string> _bakedAtlasFiles;
+    static bool _asyncGlyphLoading;
 };
 
 NS_CC_END
@@ -24,7 +24,10 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "2d/CCFontFreeType.h"
+#include <algorithm>
+#include <math.h>
 #include FT_BBOX_H
+#include FT_OUTLINE_H
 #include "edtaa3func.h"
 #include "CCFontAtlas.h"
 #include "base/CCDirector.h"
@@ -37,6 +40,7 @@ NS_CC_BEGIN
 FT_Library FontFreeType::_FTlibrary;
 bool       FontFreeType::_FTInitialized = false;
 const int  FontFreeType::DistanceMapSpread = 3;
+const float FontFreeType::MultiChannelDistanceFieldFontSize = 32.f;
 
 const char* FontFreeType::_glyphASCII = "\"!#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~¡¢£¤¥¦§¨©ª«¬­®¯°±²³´µ¶·¸¹º»¼½¾¿ÀÁÂÃÄÅÆÇÈÉÊËÌÍÎÏÐÑÒÓÔÕÖ×ØÙÚÛÜÝÞßàáâãäåæçèéêëìíîïðñòóôõö÷øùúûüýþ ";
 const char* FontFreeType::_glyphNEHE = "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~ ";
@@ -49,9 +53,9 @@ typedef struct _DataRef
 
 static std::unordered_map<std::string, DataRef> s_cacheFontData;
 
-FontFreeType * FontFreeType::create(const std::string &fontName, float fontSize, GlyphCollection glyphs, const char *customGlyphs,bool distanceFieldEnabled /* = false */,int outline /* = 0 */)
+FontFreeType * FontFreeType::create(const std::string &fontName, float fontSize, GlyphCollection glyphs, const char *customGlyphs,bool distanceFieldEnabled /* = false */,int outline /* = 0 */,bool multiChannelDistanceFieldEnabled /* = false */)
 {
-    FontFreeType *tempFont =  new FontFreeType(distanceFieldEnabled,outline);
+    FontFreeType *tempFont =  new FontFreeType(distanceFieldEnabled,outline,multiChannelDistanceFieldEnabled);
 
     if (!tempFont)
         return nullptr;
@@ -95,10 +99,11 @@ FT_Library FontFreeType::getFTLibrary()
     return _FTlibrary;
 }
 
-FontFreeType::FontFreeType(bool distanceFieldEnabled /* = false */,int outline /* = 0 */)
+FontFreeType::FontFreeType(bool distanceFieldEnabled /* = false */,int outline /* = 0 */,bool multiChannelDistanceFieldEnabled /* = false */)
 : _fontRef(nullptr)
 , _stroker(nullptr)
-, _distanceFieldEnabled(distanceFieldEnabled)
+, _distanceFieldEnabled(distanceFieldEnabled || multiChannelDistanceFieldEnabled)
+, _multiChannelDistanceFieldEnabled(multiChannelDistanceFieldEnabled)
 , _outlineSize(0.0f)
 , _lineHeight(0)
 , _fontAtlas(nullptr)
@@ -206,6 +211,11 @@ FontAtlas * FontFreeType::createFontAtlas()
     if (_fontAtlas == nullptr)
     {
         _fontAtlas = new (std::nothrow) FontAtlas(*this);
+        if (_fontAtlas && !_bakedAtlasFile.empty())
+        {
+            // a missing or stale file leaves the atlas empty, the glyphs are rasterized below then
+            _fontAtlas->loadBakedAtlas(_bakedAtlasFile);
+        }
         if (_fontAtlas && _usedGlyphs != GlyphCollection::DYNAMIC)
         {
             std::u16string utf16;
@@ -235,6 +245,7 @@ int * FontFreeType::getHorizontalKerningForTextUTF16(const std::u16string& text,
         return nullptr;
     memset(sizes,0,outNumLetters * sizeof(int));
 
+    std::lock_guard<std::mutex> lock(_faceMutex);
     bool hasKerning = FT_HAS_KERNING( _fontRef ) != 0;
     if (hasKerning)
     {
@@ -274,8 +285,39 @@ int FontFreeType::getFontAscender() const
     return (static_cast<int>(_fontRef->size->metrics.ascender >> 6));
 }
 
+std::unique_lock<std::mutex> FontFreeType::lockFace() const
+{
+    return std::unique_lock<std::mutex>(_faceMutex);
+}
+
 unsigned char* FontFreeType::getGlyphBitmap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance)
 {
+    // the caller holds lockFace(): the bitmap may be the glyph slot of the face
+    return loadGlyphBitmap(theChar, outWidth, outHeight, outRect, xAdvance);
+}
+
+unsigned char* FontFreeType::getGlyphBitmapCopy(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance)
+{
+    std::lock_guard<std::mutex> lock(_faceMutex);
+    auto bitmap = loadGlyphBitmap(theChar, outWidth, outHeight, outRect, xAdvance);
+    if (bitmap == nullptr || isGlyphBitmapAllocated())
+    {
+        // the outlined bitmap and the distance map are allocated already
+        return bitmap;
+    }
+
+    auto copyBitmap = new unsigned char[outWidth * outHeight];
+    memcpy(copyBitmap, bitmap, outWidth * outHeight * sizeof(unsigned char));
+    return copyBitmap;
+}
+
+unsigned char* FontFreeType::loadGlyphBitmap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance)
+{
+    if (_multiChannelDistanceFieldEnabled)
+    {
+        return getMultiChannelDistanceMap(theChar, outWidth, outHeight, outRect, xAdvance);
+    }
+
     bool invalidChar = true;
     unsigned char* ret = nullptr;
 
@@ -441,6 +483,371 @@ unsigned char * FontFreeType::getGlyphBitmapWithOutline(unsigned short theChar,
     return ret;
 }
 
+// Multi-channel signed distance field generation, after Viktor Chlumsky's msdfgen.
+// The curves are flattened into segments once the edges are colored, the distance to a segment
+// is only extended past its end points (pseudo-distance) at the ends of the original edge.
+namespace
+{
+    enum EdgeColor
+    {
+        EDGE_BLACK = 0,
+        EDGE_RED = 1,
+        EDGE_GREEN = 2,
+        EDGE_YELLOW = 3,
+        EDGE_BLUE = 4,
+        EDGE_MAGENTA = 5,
+        EDGE_CYAN = 6,
+        EDGE_WHITE = 7
+    };
+
+    struct MSDFPoint
+    {
+        double x;
+        double y;
+    };
+
+    inline MSDFPoint msdfPoint(double x, double y) { MSDFPoint p = { x, y }; return p; }
+    inline MSDFPoint operator-(const MSDFPoint& a, const MSDFPoint& b) { return msdfPoint(a.x - b.x, a.y - b.y); }
+    inline double dot(const MSDFPoint& a, const MSDFPoint& b) { return a.x * b.x + a.y * b.y; }
+    inline double cross(const MSDFPoint& a, const MSDFPoint& b) { return a.x * b.y - a.y * b.x; }
+    inline double length(const MSDFPoint& a) { return sqrt(dot(a, a)); }
+    inline MSDFPoint normalize(const MSDFPoint& a)
+    {
+        double len = length(a);
+        return len > 0 ? msdfPoint(a.x / len, a.y / len) : msdfPoint(0, 1);
+    }
+
+    // an edge of the outline: a line (2 points), a conic (3 points) or a cubic (4 points)
+    struct MSDFEdge
+    {
+        MSDFPoint p[4];
+        int degree;
+        int color;
+
+        MSDFPoint point(double t) const
+        {
+            double s = 1 - t;
+            switch (degree)
+            {
+            case 1:
+                return msdfPoint(s * p[0].x + t * p[1].x, s * p[0].y + t * p[1].y);
+            case 2:
+                return msdfPoint(s * s * p[0].x + 2 * s * t * p[1].x + t * t * p[2].x,
+                                 s * s * p[0].y + 2 * s * t * p[1].y + t * t * p[2].y);
+            default:
+                return msdfPoint(s * s * s * p[0].x + 3 * s * s * t * p[1].x + 3 * s * t * t * p[2].x + t * t * t * p[3].x,
+                                 s * s * s * p[0].y + 3 * s * s * t * p[1].y + 3 * s * t * t * p[2].y + t * t * t * p[3].y);
+            }
+        }
+
+        MSDFPoint startDirection() const
+        {
+            for (int i = 1; i <= degree; ++i)
+            {
+                auto d = p[i] - p[0];
+                if (d.x != 0 || d.y != 0)
+                    return d;
+            }
+            return msdfPoint(0, 0);
+        }
+
+        MSDFPoint endDirection() const
+        {
+            for (int i = degree - 1; i >= 0; --i)
+            {
+                auto d = p[degree] - p[i];
+                if (d.x != 0 || d.y != 0)
+                    return d;
+            }
+            return msdfPoint(0, 0);
+        }
+    };
+
+    struct MSDFSegment
+    {
+        MSDFPoint a;
+        MSDFPoint b;
+        int color;
+        bool edgeStart;
+        bool edgeEnd;
+    };
+
+    struct MSDFShape
+    {
+        std::vector<std::vector<MSDFEdge>> contours;
+        MSDFPoint current;
+        double scale;
+    };
+
+    int msdfMoveTo(const FT_Vector* to, void* user)
+    {
+        auto shape = static_cast<MSDFShape*>(user);
+        shape->contours.push_back(std::vector<MSDFEdge>());
+        shape->current = msdfPoint(to->x * shape->scale, to->y * shape->scale);
+        return 0;
+    }
+
+    int msdfAddEdge(MSDFShape* shape, int degree, const FT_Vector* c1, const FT_Vector* c2, const FT_Vector* to)
+    {
+        MSDFEdge edge;
+        edge.degree = degree;
+        edge.color = EDGE_WHITE;
+        edge.p[0] = shape->current;
+        const FT_Vector* points[3] = { c1, c2, to };
+        int index = 1;
+        for (int i = 3 - degree; i < 3; ++i)
+        {
+            edge.p[index++] = msdfPoint(points[i]->x * shape->scale, points[i]->y * shape->scale);
+        }
+        shape->current = edge.p[degree];
+        if (!shape->contours.empty() && (edge.p[degree].x != edge.p[0].x || edge.p[degree].y != edge.p[0].y || degree > 1))
+        {
+            shape->contours.back().push_back(edge);
+        }
+        return 0;
+    }
+
+    int msdfLineTo(const FT_Vector* to, void* user) { return msdfAddEdge(static_cast<MSDFShape*>(user), 1, nullptr, nullptr, to); }
+    int msdfConicTo(const FT_Vector* control, const FT_Vector* to, void* user) { return msdfAddEdge(static_cast<MSDFShape*>(user), 2, nullptr, control, to); }
+    int msdfCubicTo(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to, void* user) { return msdfAddEdge(static_cast<MSDFShape*>(user), 3, control1, control2, to); }
+
+    void switchColor(int& color, int banned = EDGE_BLACK)
+    {
+        int combined = color & banned;
+        if (combined == EDGE_RED || combined == EDGE_GREEN || combined == EDGE_BLUE)
+        {
+            color = combined ^ EDGE_WHITE;
+        }
+        else if (color == EDGE_BLACK || color == EDGE_WHITE)
+        {
+            color = EDGE_CYAN;
+        }
+        else
+        {
+            int shifted = color << 1;
+            color = (shifted | shifted >> 3) & EDGE_WHITE;
+        }
+    }
+
+    // gives different colors to the edges meeting at a corner, so that each channel keeps the corner sharp
+    void colorEdges(std::vector<MSDFEdge>& edges)
+    {
+        const double crossThreshold = sin(3.0);
+        std::vector<int> corners;
+        int edgeCount = static_cast<int>(edges.size());
+        for (int i = 0; i < edgeCount; ++i)
+        {
+            auto previous = normalize(edges[(i + edgeCount - 1) % edgeCount].endDirection());
+            auto next = normalize(edges[i].startDirection());
+            if (dot(previous, next) <= 0 || fabs(cross(previous, next)) > crossThreshold)
+            {
+                corners.push_back(i);
+            }
+        }
+
+        if (corners.empty())
+        {
+            for (auto&& edge : edges)
+                edge.color = EDGE_WHITE;
+        }
+        else if (corners.size() == 1)
+        {
+            // teardrop: the colors change along the contour, a single edge keeps the single channel behavior
+            int colors[3] = { EDGE_WHITE, EDGE_WHITE, EDGE_WHITE };
+            switchColor(colors[0]);
+            colors[2] = colors[0];
+            switchColor(colors[2]);
+            for (int i = 0; i < edgeCount; ++i)
+            {
+                int index = edgeCount >= 3 ? static_cast<int>(3 + 2.875 * i / (edgeCount - 1) - 1.4375 + 0.5) - 3 : 0;
+                edges[(corners[0] + i) % edgeCount].color = colors[1 + index];
+            }
+        }
+        else
+        {
+            int cornerCount = static_cast<int>(corners.size());
+            int spline = 0;
+            int start = corners[0];
+            int color = EDGE_WHITE;
+            switchColor(color);
+            int initialColor = color;
+            for (int i = 0; i < edgeCount; ++i)
+            {
+                int index = (start + i) % edgeCount;
+                if (spline + 1 < cornerCount && corners[spline + 1] == index)
+                {
+                    ++spline;
+                    switchColor(color, spline == cornerCount - 1 ? initialColor : EDGE_BLACK);
+                }
+                edges[index].color = color;
+            }
+        }
+    }
+
+    struct MSDFDistance
+    {
+        double distance;
+        double dot;
+        const MSDFSegment* segment;
+        double param;
+
+        bool operator<(const MSDFDistance& other) const
+        {
+            return fabs(distance) < fabs(other.distance) || (fabs(distance) == fabs(other.distance) && dot < other.dot);
+        }
+    };
+
+    MSDFDistance segmentDistance(const MSDFSegment& segment, const MSDFPoint& p)
+    {
+        MSDFDistance ret;
+        ret.segment = &segment;
+
+        auto aq = p - segment.a;
+        auto ab = segment.b - segment.a;
+        double abLength2 = dot(ab, ab);
+        ret.param = abLength2 > 0 ? dot(aq, ab) / abLength2 : 0;
+
+        auto eq = (ret.param > 0.5 ? segment.b : segment.a) - p;
+        double endpointDistance = length(eq);
+        if (ret.param > 0 && ret.param < 1 && abLength2 > 0)
+        {
+            double orthoDistance = cross(aq, ab) / sqrt(abLength2);
+            if (fabs(orthoDistance) < endpointDistance)
+            {
+                ret.distance = orthoDistance;
+                ret.dot = 0;
+                return ret;
+            }
+        }
+
+        ret.distance = (cross(aq, ab) >= 0 ? 1 : -1) * endpointDistance;
+        ret.dot = fabs(dot(normalize(ab), normalize(eq)));
+        return ret;
+    }
+
+    double pseudoDistance(const MSDFDistance& nearest, const MSDFPoint& p)
+    {
+        double distance = nearest.distance;
+        auto segment = nearest.segment;
+        if (segment == nullptr)
+            return distance;
+
+        auto direction = normalize(segment->b - segment->a);
+        if (nearest.param < 0 && segment->edgeStart)
+        {
+            auto aq = p - segment->a;
+            if (dot(aq, direction) < 0)
+            {
+                double pseudo = cross(aq, direction);
+                if (fabs(pseudo) <= fabs(distance))
+                    distance = pseudo;
+            }
+        }
+        else if (nearest.param > 1 && segment->edgeEnd)
+        {
+            auto bq = p - segment->b;
+            if (dot(bq, direction) > 0)
+            {
+                double pseudo = cross(bq, direction);
+                if (fabs(pseudo) <= fabs(distance))
+                    distance = pseudo;
+            }
+        }
+        return distance;
+    }
+
+    // returns width * height RGB texels, the distances are stored like makeDistanceMap() does: 128 + 16 per pixel
+    unsigned char* makeMultiChannelDistanceMap(FT_Outline* outline, double originX, double originY, long width, long height)
+    {
+        MSDFShape shape;
+        shape.scale = 1.0 / 64;
+        shape.current = msdfPoint(0, 0);
+
+        FT_Outline_Funcs funcs;
+        funcs.move_to = msdfMoveTo;
+        funcs.line_to = msdfLineTo;
+        funcs.conic_to = msdfConicTo;
+        funcs.cubic_to = msdfCubicTo;
+        funcs.shift = 0;
+        funcs.delta = 0;
+        if (FT_Outline_Decompose(outline, &funcs, &shape))
+            return nullptr;
+
+        std::vector<MSDFSegment> segments;
+        for (auto&& contour : shape.contours)
+        {
+            if (contour.empty())
+                continue;
+
+            colorEdges(contour);
+            for (auto&& edge : contour)
+            {
+                // a few pixels per segment is enough at the sizes glyphs are rasterized
+                int steps = 1;
+                if (edge.degree > 1)
+                {
+                    double hull = 0;
+                    for (int i = 0; i < edge.degree; ++i)
+                        hull += length(edge.p[i + 1] - edge.p[i]);
+                    steps = std::max(2, std::min(16, static_cast<int>(hull / 2)));
+                }
+
+                auto previous = edge.p[0];
+                for (int i = 1; i <= steps; ++i)
+                {
+                    MSDFSegment segment;
+                    segment.a = previous;
+                    segment.b = (i == steps) ? edge.p[edge.degree] : edge.point(static_cast<double>(i) / steps);
+                    segment.color = edge.color;
+                    segment.edgeStart = (i == 1);
+                    segment.edgeEnd = (i == steps);
+                    segments.push_back(segment);
+                    previous = segment.b;
+                }
+            }
+        }
+
+        // FreeType outlines may turn either way, the distance must be positive inside
+        double orientation = FT_Outline_Get_Orientation(outline) == FT_ORIENTATION_TRUETYPE ? 1 : -1;
+
+        auto out = new unsigned char[width * height * 3];
+        for (long y = 0; y < height; ++y)
+        {
+            for (long x = 0; x < width; ++x)
+            {
+                auto p = msdfPoint(originX + x + 0.5, originY - y - 0.5);
+                MSDFDistance nearest[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    nearest[c].distance = -1e240;
+                    nearest[c].dot = 1;
+                    nearest[c].segment = nullptr;
+                    nearest[c].param = 0;
+                }
+
+                for (auto&& segment : segments)
+                {
+                    auto distance = segmentDistance(segment, p);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        if ((segment.color & (1 << c)) && distance < nearest[c])
+                            nearest[c] = distance;
+                    }
+                }
+
+                auto texel = out + (y * width + x) * 3;
+                for (int c = 0; c < 3; ++c)
+                {
+                    double value = 128.0 + orientation * pseudoDistance(nearest[c], p) * 16;
+                    texel[c] = static_cast<unsigned char>(std::max(0.0, std::min(255.0, value)));
+                }
+            }
+        }
+
+        return out;
+    }
+}
+
 unsigned char * makeDistanceMap( unsigned char *img, long width, long height)
 {
     long pixelAmount = (width + 2 * FontFreeType::DistanceMapSpread) * (height + 2 * FontFreeType::DistanceMapSpread);
@@ -522,12 +929,69 @@ unsigned char * makeDistanceMap( unsigned char *img, long width, long height)
     return out;
 }
 
+unsigned char* FontFreeType::getMultiChannelDistanceMap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance)
+{
+    unsigned char* ret = nullptr;
+    outWidth = 0;
+    outHeight = 0;
+    outRect.size.width = 0;
+    outRect.size.height = 0;
+    xAdvance = 0;
+
+    // the distances are computed from the outline, the rasterized glyph isn't needed
+    if (_fontRef == nullptr || FT_Load_Char(_fontRef, theChar, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT))
+        return nullptr;
+
+    xAdvance = (static_cast<int>(_fontRef->glyph->metrics.horiAdvance >> 6));
+    if (_fontRef->glyph->format != FT_GLYPH_FORMAT_OUTLINE || _fontRef->glyph->outline.n_points == 0)
+        return nullptr;
+
+    FT_BBox bbox;
+    FT_Outline_Get_CBox(&_fontRef->glyph->outline, &bbox);
+    long xMin = bbox.xMin >> 6;
+    long yMin = bbox.yMin >> 6;
+    long xMax = (bbox.xMax + 63) >> 6;
+    long yMax = (bbox.yMax + 63) >> 6;
+    if (xMax <= xMin || yMax <= yMin)
+        return nullptr;
+
+    outWidth = xMax - xMin;
+    outHeight = yMax - yMin;
+    outRect.origin.x = xMin;
+    outRect.origin.y = -yMax;
+    outRect.size.width = outWidth;
+    outRect.size.height = outHeight;
+
+    // the map covers the glyph and DistanceMapSpread pixels around it, like makeDistanceMap() does
+    ret = makeMultiChannelDistanceMap(&_fontRef->glyph->outline,
+        xMin - DistanceMapSpread, yMax + DistanceMapSpread,
+        outWidth + 2 * DistanceMapSpread, outHeight + 2 * DistanceMapSpread);
+    if (ret == nullptr)
+    {
+        outWidth = 0;
+        outHeight = 0;
+    }
+
+    return ret;
+}
+
 void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight)
 {
     int iX = posX;
     int iY = posY;
 
-    if (_distanceFieldEnabled)
+    if (_multiChannelDistanceFieldEnabled)
+    {
+        bitmapWidth += 2 * DistanceMapSpread;
+        bitmapHeight += 2 * DistanceMapSpread;
+
+        for (long y = 0; y < bitmapHeight; ++y)
+        {
+            memcpy(dest + (iX + (iY + y) * FontAtlas::CacheTextureWidth) * 3, bitmap + y * bitmapWidth * 3, bitmapWidth * 3);
+        }
+        delete [] bitmap;
+    }
+    else if (_distanceFieldEnabled)
     {
         auto distanceMap = makeDistanceMap(bitmap,bitmapWidth,bitmapHeight);
 
@@ -31,6 +31,7 @@
 #include "CCFont.h"
 
 #include <string>
+#include <mutex>
 #include <ft2build.h>
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
@@ -52,27 +53,56 @@ class CC_DLL FontFreeType : public Font
 {
 public:
     static const int DistanceMapSpread;
+    /** Multi-channel distance field glyphs are always generated at this size, labels scale them. */
+    static const float MultiChannelDistanceFieldFontSize;
 
     static FontFreeType* create(const std::string &fontName, float fontSize, GlyphCollection glyphs,
-        const char *customGlyphs,bool distanceFieldEnabled = false,int outline = 0);
+        const char *customGlyphs,bool distanceFieldEnabled = false,int outline = 0,bool multiChannelDistanceFieldEnabled = false);
 
     static void shutdownFreeType();
 
     bool isDistanceFieldEnabled() const { return _distanceFieldEnabled;}
 
+    /** Glyphs are rendered as 3 bytes per pixel multi-channel distance fields, isDistanceFieldEnabled() is true as well. */
+    bool isMultiChannelDistanceFieldEnabled() const { return _multiChannelDistanceFieldEnabled; }
+
     float getOutlineSize() const { return _outlineSize; }
 
     void renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight); 
 
+    /** True if the glyph bitmaps are allocated for each glyph, renderCharAt() deletes them then. */
+    bool isGlyphBitmapAllocated() const { return _outlineSize > 0 || _multiChannelDistanceFieldEnabled; }
+
     FT_Encoding getEncoding() const { return _encoding; }
 
     int* getHorizontalKerningForTextUTF16(const std::u16string& text, int &outNumLetters) const override;
     
+    /**
+     * Locks the face for the calling thread, the glyph loading of the other threads waits until the lock is released.
+     */
+    std::unique_lock<std::mutex> lockFace() const;
+
+    /**
+     * Returns the bitmap of a glyph. Unless isGlyphBitmapAllocated() is true the bitmap is the glyph slot of the face:
+     * keep the lock returned by lockFace() until the bitmap is not used any more.
+     */
     unsigned char* getGlyphBitmap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
+
+    /**
+     * Same as getGlyphBitmap() but the bitmap is always a copy allocated with new[] that the caller owns,
+     * so it can be called from a worker thread while the face is used by the main thread.
+     */
+    unsigned char* getGlyphBitmapCopy(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
     
     int getFontAscender() const;
 
     virtual FontAtlas* createFontAtlas() override;
+
+    /**
+     * The baked atlas (see FontAtlas::loadBakedAtlas()) createFontAtlas() loads before rasterizing the glyph collection,
+     * only the glyphs missing from it are rasterized then.
+     */
+    void setBakedAtlasFile(const std::string& filePath) { _bakedAtlasFile = filePath; }
     virtual int getFontMaxHeight() const override { return _lineHeight; }
 
     static void releaseFont(const std::string &fontName);
@@ -83,7 +113,7 @@ private:
     static FT_Library _FTlibrary;
     static bool _FTInitialized;
 
-    FontFreeType(bool distanceFieldEnabled = false, int outline = 0);
+    FontFreeType(bool distanceFieldEnabled = false, int outline = 0, bool multiChannelDistanceFieldEnabled = false);
     virtual ~FontFreeType();
 
     bool createFontObject(const std::string &fontName, float fontSize);
@@ -92,7 +122,9 @@ private:
     FT_Library getFTLibrary();
     
     int getHorizontalKerningForChars(unsigned short firstChar, unsigned short secondChar) const;
+    unsigned char* loadGlyphBitmap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
     unsigned char* getGlyphBitmapWithOutline(unsigned short code, FT_BBox &bbox);
+    unsigned char* getMultiChannelDistanceMap(unsigned short theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
 
     void setGlyphCollection(GlyphCollection glyphs, const char* customGlyphs = nullptr);
     const char* getGlyphCollection() const;
@@ -100,15 +132,19 @@ private:
     FT_Face _fontRef;
     FT_Stroker _stroker;
     FT_Encoding _encoding;
+    // a face can't be used by several threads at once
+    mutable std::mutex _faceMutex;
 
     std::string _fontName;
     bool _distanceFieldEnabled;
+    bool _multiChannelDistanceFieldEnabled;
     float _outlineSize;
     int _lineHeight;
     FontAtlas* _fontAtlas;
 
     GlyphCollection _usedGlyphs;
     std::string _customGlyphs;
+    std::string _bakedAtlasFile;
 };
 
 /// @endcond
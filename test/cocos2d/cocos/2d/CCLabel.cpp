@@ -24,6 +24,9 @@
  ****************************************************************************/
 
 #include "2d/CCLabel.h"
+
+#include <algorithm>
+
 #include "2d/CCFont.h"
 #include "2d/CCFontAtlasCache.h"
 #include "2d/CCFontAtlas.h"
@@ -366,6 +369,7 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
 , _fontAtlas(nullptr)
 , _reusedLetter(nullptr)
 , _horizontalKernings(nullptr)
+, _layoutCacheSize(0)
 {
     setAnchorPoint(Vec2::ANCHOR_MIDDLE);
     reset();
@@ -385,6 +389,7 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
                 it.second->setTexture(nullptr);
             }
             _batchNodes.clear();
+            clearLayoutCache();
 
             if (_fontAtlas)
             {
@@ -406,6 +411,15 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
         }
     });
     _eventDispatcher->addEventListenerWithFixedPriority(_resetTextureListener, 2);
+
+    _glyphsReadyListener = EventListenerCustom::create(FontAtlas::CMD_GLYPHS_READY, [this](EventCustom* event){
+        if (_fontAtlas && _currentLabelType == LabelType::TTF && event->getUserData() == _fontAtlas)
+        {
+            _contentDirty = true;
+            invalidateCachedAncestors();
+        }
+    });
+    _eventDispatcher->addEventListenerWithFixedPriority(_glyphsReadyListener, 3);
 }
 
 Label::~Label()
@@ -421,6 +435,7 @@ Label::~Label()
     }
     _eventDispatcher->removeEventListener(_purgeTextureListener);
     _eventDispatcher->removeEventListener(_resetTextureListener);
+    _eventDispatcher->removeEventListener(_glyphsReadyListener);
 
     CC_SAFE_RELEASE_NULL(_textSprite);
     CC_SAFE_RELEASE_NULL(_shadowNode);
@@ -435,6 +450,7 @@ void Label::reset()
     _letters.clear();
     _batchNodes.clear();
     _lettersInfo.clear();
+    clearLayoutCache();
     if (_fontAtlas)
     {
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
@@ -484,6 +500,8 @@ void Label::reset()
     _shadowBlurRadius = 0.f;
 
     _useDistanceField = false;
+    _useMultiChannelDistanceField = false;
+    _uniformSmoothing = -1;
     _useA8Shader = false;
     _clipEnabled = false;
     _blendFuncDirty = false;
@@ -503,7 +521,9 @@ void Label::updateShaderProgram()
     switch (_currLabelEffect)
     {
     case cocos2d::LabelEffect::NORMAL:
-        if (_useDistanceField)
+        if (_useMultiChannelDistanceField)
+            setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_MULTICHANNEL_DISTANCEFIELD_NORMAL));
+        else if (_useDistanceField)
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL));
         else if (_useA8Shader)
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_NORMAL));
@@ -529,6 +549,7 @@ void Label::updateShaderProgram()
     }
     
     _uniformTextColor = glGetUniformLocation(getGLProgram()->getProgram(), "u_textColor");
+    _uniformSmoothing = _useMultiChannelDistanceField ? glGetUniformLocation(getGLProgram()->getProgram(), "u_smoothing") : -1;
 }
 
 void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false */, bool useA8Shader /* = false */)
@@ -545,6 +566,7 @@ void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false *
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
         _fontAtlas = nullptr;
     }
+    clearLayoutCache();
 
     _fontAtlas = atlas;
     if (_reusedLetter == nullptr)
@@ -559,8 +581,10 @@ void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false *
     {
         _lineHeight = _fontAtlas->getLineHeight();
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
     _useDistanceField = distanceFieldEnabled;
+    _useMultiChannelDistanceField = false;
     _useA8Shader = useA8Shader;
 
     if (_currentLabelType != LabelType::TTF)
@@ -613,6 +637,7 @@ void Label::setString(const std::string& text)
     {
         _utf8Text = text;
         _contentDirty = true;
+        invalidateCachedAncestors();
 
         std::u16string utf16String;
         if (StringUtils::UTF8ToUTF16(_utf8Text, utf16String))
@@ -630,6 +655,7 @@ void Label::setAlignment(TextHAlignment hAlignment,TextVAlignment vAlignment)
         _vAlignment = vAlignment;
 
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -639,6 +665,7 @@ void Label::setMaxLineWidth(float maxLineWidth)
     {
         _maxLineWidth = maxLineWidth;
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -656,6 +683,7 @@ void Label::setDimensions(float width, float height)
 
         _maxLineWidth = width;
         _contentDirty = true;
+        invalidateCachedAncestors();
 
         if(_overflow == Overflow::SHRINK){
             if (_originalFontSize > 0) {
@@ -683,7 +711,8 @@ void Label::setLineBreakWithoutSpace(bool breakWithoutSpace)
     if (breakWithoutSpace != _lineBreakWithoutSpaces)
     {
         _lineBreakWithoutSpaces = breakWithoutSpace;
-        _contentDirty = true;     
+        _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -708,6 +737,14 @@ void Label::updateLabelLetters()
             else
             {
                 auto& letterInfo = _lettersInfo[letterIndex];
+                if (!letterInfo.valid)
+                {
+                    // e.g. a glyph that is still being rasterized
+                    letterSprite->setTextureAtlas(nullptr);
+                    ++it;
+                    continue;
+                }
+
                 auto& letterDef = _fontAtlas->_letterDefinitions[letterInfo.utf16Char];
                 uvRect.size.height = letterDef.height;
                 uvRect.size.width = letterDef.width;
@@ -771,7 +808,37 @@ bool Label::alignText()
             return true;
         }
         _reusedLetter->setBatchNode(_batchNodes.at(0));
-        
+
+        // a layout can be reused as long as the settings it was computed with didn't change
+        this->updateBMFontScale();
+        auto layoutSettings = getLayoutSettings();
+        if (layoutSettings.empty() || layoutSettings != _layoutSettings)
+        {
+            clearLayoutCache();
+        }
+        else if (applyCachedLayout())
+        {
+            updateLabelLetters();
+            updateColor();
+            break;
+        }
+
+        // if only digits changed, like for a counter, only the quads of these digits are updated
+        bool onlyDigitsChanged = !_layoutSettings.empty() && _layoutText.length() == _utf16Text.length();
+        for (size_t i = 0; onlyDigitsChanged && i < _utf16Text.length(); ++i)
+        {
+            auto previous = _layoutText[i];
+            auto current = _utf16Text[i];
+            onlyDigitsChanged = previous == current
+                || (previous >= u'0' && previous <= u'9' && current >= u'0' && current <= u'9');
+        }
+        LayoutCacheEntry previousLayout;
+        if (onlyDigitsChanged)
+        {
+            saveLayout(previousLayout, false);
+        }
+
+        computeHorizontalKernings(_utf16Text);
         _lengthOfString = 0;
         _textDesiredHeight = 0.f;
         _linesWidth.clear();
@@ -793,6 +860,14 @@ bool Label::alignText()
             }
         }
 
+        if (onlyDigitsChanged && updateChangedQuads(previousLayout))
+        {
+            _layoutSettings = layoutSettings;
+            _layoutText = _utf16Text;
+            updateLabelLetters();
+            break;
+        }
+
         if(!updateQuads()){
             ret = false;
             if(_overflow == Overflow::SHRINK){
@@ -800,6 +875,10 @@ bool Label::alignText()
             }
             break;
         }
+
+        _layoutSettings = layoutSettings;
+        _layoutText = _utf16Text;
+        addCachedLayout();
     
         updateLabelLetters();
         
@@ -809,6 +888,126 @@ bool Label::alignText()
     return ret;
 }
 
+std::string Label::getLayoutSettings() const
+{
+    // shrinking changes the letter definitions of the atlas, and missing letters are added later on
+    if (_overflow == Overflow::SHRINK || _fontAtlas->hasPendingLetters())
+    {
+        return "";
+    }
+
+    char settings[256];
+    snprintf(settings, sizeof(settings), "%p|%d|%d|%d|%d|%d|%d|%d|%d|%.3f|%.3f|%.3f|%.3f|%.3f|%.3f|%.3f|%.3f|%.3f",
+        _fontAtlas, (int)_currentLabelType, (int)_hAlignment, (int)_vAlignment, (int)_overflow,
+        _enableWrap, _lineBreakWithoutSpaces, _useDistanceField, _useMultiChannelDistanceField,
+        _labelWidth, _labelHeight, _maxLineWidth, _lineHeight, _lineSpacing, _additionalKerning,
+        _bmfontScale, _bmFontSize, CC_CONTENT_SCALE_FACTOR());
+    return settings;
+}
+
+void Label::setLayoutCacheSize(int size)
+{
+    _layoutCacheSize = MAX(size, 0);
+    while (static_cast<int>(_layoutCache.size()) > _layoutCacheSize)
+    {
+        _layoutCache.pop_back();
+    }
+}
+
+void Label::clearLayoutCache()
+{
+    _layoutSettings.clear();
+    _layoutText.clear();
+    _layoutCache.clear();
+}
+
+void Label::saveLayout(LayoutCacheEntry& entry, bool withQuads)
+{
+    entry.text = _utf16Text;
+    entry.lettersInfo.assign(_lettersInfo.begin(), _lettersInfo.begin() + MIN(_lengthOfString, (int)_lettersInfo.size()));
+    entry.linesWidth = _linesWidth;
+    entry.linesOffsetX = _linesOffsetX;
+    entry.contentSize = _contentSize;
+    entry.letterOffsetY = _letterOffsetY;
+    entry.textDesiredHeight = _textDesiredHeight;
+    entry.tailoredTopY = _tailoredTopY;
+    entry.tailoredBottomY = _tailoredBottomY;
+    entry.numberOfLines = _numberOfLines;
+
+    entry.quads.clear();
+    if (withQuads)
+    {
+        for (auto&& batchNode : _batchNodes)
+        {
+            auto textureAtlas = batchNode->getTextureAtlas();
+            auto quads = textureAtlas->getQuads();
+            entry.quads.push_back(std::vector<V3F_C4B_T2F_Quad>(quads, quads + textureAtlas->getTotalQuads()));
+        }
+    }
+}
+
+void Label::addCachedLayout()
+{
+    if (_layoutCacheSize <= 0 || _layoutSettings.empty())
+    {
+        return;
+    }
+
+    if (static_cast<int>(_layoutCache.size()) >= _layoutCacheSize)
+    {
+        _layoutCache.pop_back();
+    }
+    _layoutCache.emplace_front();
+    saveLayout(_layoutCache.front(), true);
+}
+
+bool Label::applyCachedLayout()
+{
+    auto it = std::find_if(_layoutCache.begin(), _layoutCache.end(), [this](const LayoutCacheEntry& entry) {
+        return entry.text == _utf16Text;
+    });
+    if (it == _layoutCache.end())
+    {
+        return false;
+    }
+    _layoutCache.splice(_layoutCache.begin(), _layoutCache, it);
+    auto& entry = _layoutCache.front();
+
+    _lengthOfString = static_cast<int>(entry.lettersInfo.size());
+    if (_lettersInfo.size() < entry.lettersInfo.size())
+    {
+        _lettersInfo.resize(entry.lettersInfo.size());
+    }
+    std::copy(entry.lettersInfo.begin(), entry.lettersInfo.end(), _lettersInfo.begin());
+    _linesWidth = entry.linesWidth;
+    _linesOffsetX = entry.linesOffsetX;
+    _letterOffsetY = entry.letterOffsetY;
+    _textDesiredHeight = entry.textDesiredHeight;
+    _tailoredTopY = entry.tailoredTopY;
+    _tailoredBottomY = entry.tailoredBottomY;
+    _numberOfLines = entry.numberOfLines;
+    setContentSize(entry.contentSize);
+
+    for (ssize_t index = 0; index < _batchNodes.size(); ++index)
+    {
+        auto batchNode = _batchNodes.at(index);
+        auto textureAtlas = batchNode->getTextureAtlas();
+        textureAtlas->removeAllQuads();
+        if (index < static_cast<ssize_t>(entry.quads.size()) && !entry.quads[index].empty())
+        {
+            auto& quads = entry.quads[index];
+            while (textureAtlas->getCapacity() < static_cast<ssize_t>(quads.size()))
+            {
+                batchNode->increaseAtlasCapacity();
+            }
+            textureAtlas->insertQuads(quads.data(), 0, quads.size());
+        }
+    }
+
+    _layoutText = _utf16Text;
+    return true;
+}
+
 bool Label::computeHorizontalKernings(const std::u16string& stringToRender)
 {
     if (_horizontalKernings)
@@ -837,6 +1036,52 @@ bool Label::isHorizontalClamped(float letterPositionX, int lineIndex)
     }
 }
 
+bool Label::computeLetterQuad(const LetterInfo& letterInfo, const FontLetterDefinition& letterDef, Rect& uvRect, Vec2& position)
+{
+    uvRect.size.height = letterDef.height;
+    uvRect.size.width  = letterDef.width;
+    uvRect.origin.x    = letterDef.U;
+    uvRect.origin.y    = letterDef.V;
+
+    auto py = letterInfo.positionY + _letterOffsetY;
+    if (_labelHeight > 0.f) {
+        if (py > _tailoredTopY)
+        {
+            auto clipTop = py - _tailoredTopY;
+            uvRect.origin.y += clipTop;
+            uvRect.size.height -= clipTop;
+            py -= clipTop;
+        }
+        if (py - letterDef.height * _bmfontScale < _tailoredBottomY)
+        {
+            uvRect.size.height = (py < _tailoredBottomY) ? 0.f : (py - _tailoredBottomY);
+        }
+    }
+
+    auto lineIndex = letterInfo.lineIndex;
+    auto px = letterInfo.positionX + letterDef.width/2 * _bmfontScale + _linesOffsetX[lineIndex];
+
+    if(_labelWidth > 0.f){
+        if (this->isHorizontalClamped(px, lineIndex)) {
+            if(_overflow == Overflow::CLAMP){
+                uvRect.size.width = 0;
+            }else if(_overflow == Overflow::SHRINK){
+                if (_contentSize.width > letterDef.width) {
+                    // the font has to be shrunk
+                    return false;
+                }else{
+                    uvRect.size.width = 0;
+                }
+
+            }
+        }
+    }
+
+    position.x = letterInfo.positionX + _linesOffsetX[lineIndex];
+    position.y = py;
+    return true;
+}
+
 bool Label::updateQuads()
 {
     bool ret = true;
@@ -845,59 +1090,22 @@ bool Label::updateQuads()
         batchNode->getTextureAtlas()->removeAllQuads();
     }
     
-    bool letterClamp = false;
+    Vec2 letterPosition;
     for (int ctr = 0; ctr < _lengthOfString; ++ctr)
     {
         if (_lettersInfo[ctr].valid)
         {
             auto& letterDef = _fontAtlas->_letterDefinitions[_lettersInfo[ctr].utf16Char];
-            
-            _reusedRect.size.height = letterDef.height;
-            _reusedRect.size.width  = letterDef.width;
-            _reusedRect.origin.x    = letterDef.U;
-            _reusedRect.origin.y    = letterDef.V;
-
-            auto py = _lettersInfo[ctr].positionY + _letterOffsetY;
-            if (_labelHeight > 0.f) {
-                if (py > _tailoredTopY)
-                {
-                    auto clipTop = py - _tailoredTopY;
-                    _reusedRect.origin.y += clipTop;
-                    _reusedRect.size.height -= clipTop;
-                    py -= clipTop;
-                }
-                if (py - letterDef.height * _bmfontScale < _tailoredBottomY)
-                {
-                    _reusedRect.size.height = (py < _tailoredBottomY) ? 0.f : (py - _tailoredBottomY);
-                }
-            }
-
-            auto lineIndex = _lettersInfo[ctr].lineIndex;
-            auto px = _lettersInfo[ctr].positionX + letterDef.width/2 * _bmfontScale + _linesOffsetX[lineIndex];
-
-            if(_labelWidth > 0.f){
-                if (this->isHorizontalClamped(px, lineIndex)) {
-                    if(_overflow == Overflow::CLAMP){
-                        _reusedRect.size.width = 0;
-                    }else if(_overflow == Overflow::SHRINK){
-                        if (_contentSize.width > letterDef.width) {
-                            letterClamp = true;
-                            ret = false;
-                            break;
-                        }else{
-                            _reusedRect.size.width = 0;
-                        }
-
-                    }
-                }
+            if (!computeLetterQuad(_lettersInfo[ctr], letterDef, _reusedRect, letterPosition))
+            {
+                ret = false;
+                break;
             }
 
-
             if (_reusedRect.size.height > 0.f && _reusedRect.size.width > 0.f)
             {
                 _reusedLetter->setTextureRect(_reusedRect, false, _reusedRect.size);
-                float letterPositionX = _lettersInfo[ctr].positionX + _linesOffsetX[_lettersInfo[ctr].lineIndex];
-                _reusedLetter->setPosition(letterPositionX, py);
+                _reusedLetter->setPosition(letterPosition);
                 auto index = static_cast<int>(_batchNodes.at(letterDef.textureID)->getTextureAtlas()->getTotalQuads());
                 _lettersInfo[ctr].atlasIndex = index;
 
@@ -912,6 +1120,74 @@ bool Label::updateQuads()
     return ret;
 }
 
+bool Label::updateChangedQuads(const LayoutCacheEntry& previousLayout)
+{
+    // the letters keep their quads only if the lines and the clipping didn't move
+    if (previousLayout.lettersInfo.size() != static_cast<size_t>(_lengthOfString)
+        || previousLayout.linesOffsetX != _linesOffsetX
+        || previousLayout.contentSize.width != _contentSize.width
+        || previousLayout.contentSize.height != _contentSize.height
+        || previousLayout.letterOffsetY != _letterOffsetY
+        || previousLayout.tailoredTopY != _tailoredTopY
+        || previousLayout.tailoredBottomY != _tailoredBottomY)
+    {
+        return false;
+    }
+
+    Rect uvRect;
+    Vec2 letterPosition;
+    std::vector<int> changedLetters;
+    for (int ctr = 0; ctr < _lengthOfString; ++ctr)
+    {
+        auto& letterInfo = _lettersInfo[ctr];
+        auto& previousInfo = previousLayout.lettersInfo[ctr];
+        if (letterInfo.valid != previousInfo.valid)
+        {
+            return false;
+        }
+        if (!letterInfo.valid
+            || (letterInfo.utf16Char == previousInfo.utf16Char && letterInfo.lineIndex == previousInfo.lineIndex
+                && letterInfo.positionX == previousInfo.positionX && letterInfo.positionY == previousInfo.positionY))
+        {
+            continue;
+        }
+
+        // the new letter must replace a visible quad of the same texture
+        auto& previousDef = _fontAtlas->_letterDefinitions[previousInfo.utf16Char];
+        auto& letterDef = _fontAtlas->_letterDefinitions[letterInfo.utf16Char];
+        if (previousDef.textureID != letterDef.textureID
+            || !computeLetterQuad(previousInfo, previousDef, uvRect, letterPosition) || uvRect.size.width <= 0.f || uvRect.size.height <= 0.f
+            || !computeLetterQuad(letterInfo, letterDef, uvRect, letterPosition) || uvRect.size.width <= 0.f || uvRect.size.height <= 0.f)
+        {
+            return false;
+        }
+        changedLetters.push_back(ctr);
+    }
+
+    for (auto ctr : changedLetters)
+    {
+        auto& letterInfo = _lettersInfo[ctr];
+        auto& letterDef = _fontAtlas->_letterDefinitions[letterInfo.utf16Char];
+        computeLetterQuad(letterInfo, letterDef, _reusedRect, letterPosition);
+
+        auto batchNode = _batchNodes.at(letterDef.textureID);
+        _reusedLetter->setTextureRect(_reusedRect, false, _reusedRect.size);
+        _reusedLetter->setPosition(letterPosition);
+        this->updateLetterSpriteScale(_reusedLetter);
+        // same as SpriteBatchNode::updateQuadFromSprite, the quad already exists
+        _reusedLetter->setBatchNode(batchNode);
+        _reusedLetter->setAtlasIndex(letterInfo.atlasIndex);
+        // the colors go with the quad, only its range of the atlas is uploaded again
+        _reusedLetter->setOpacityModifyRGB(_isOpacityModifyRGB);
+        _reusedLetter->setColor(_displayedColor);
+        _reusedLetter->setOpacity(_displayedOpacity);
+        _reusedLetter->setDirty(true);
+        _reusedLetter->updateTransform();
+    }
+
+    return true;
+}
+
 bool Label::setTTFConfigInternal(const TTFConfig& ttfConfig)
 {
     FontAtlas *newAtlas = FontAtlasCache::getFontAtlasTTF(&ttfConfig);
@@ -927,11 +1203,14 @@ bool Label::setTTFConfigInternal(const TTFConfig& ttfConfig)
     setFontAtlas(newAtlas,ttfConfig.distanceFieldEnabled,true);
 
     _fontConfig = ttfConfig;
+    _useMultiChannelDistanceField = _fontConfig.multiChannelDistanceFieldEnabled;
 
     if (_fontConfig.outlineSize > 0)
     {
         _fontConfig.distanceFieldEnabled = false;
+        _fontConfig.multiChannelDistanceFieldEnabled = false;
         _useDistanceField = false;
+        _useMultiChannelDistanceField = false;
         _useA8Shader = false;
         _currLabelEffect = LabelEffect::OUTLINE;
         updateShaderProgram();
@@ -949,6 +1228,7 @@ void Label::setBMFontSizeInternal(float fontSize)
     if(_currentLabelType == LabelType::BMFONT){
         this->setBMFontFilePath(_bmFontPath, Vec2::ZERO, fontSize);
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -978,11 +1258,13 @@ void Label::enableGlow(const Color4B& glowColor)
 {
     if (_currentLabelType == LabelType::TTF)
     {
-        if (_fontConfig.distanceFieldEnabled == false)
+        // the glow shader samples single channel distance fields
+        if (_fontConfig.distanceFieldEnabled == false || _fontConfig.multiChannelDistanceFieldEnabled)
         {
             auto config = _fontConfig;
             config.outlineSize = 0;
             config.distanceFieldEnabled = true;
+            config.multiChannelDistanceFieldEnabled = false;
             setTTFConfig(config);
             _contentDirty = true;
         }
@@ -992,6 +1274,7 @@ void Label::enableGlow(const Color4B& glowColor)
         _effectColorF.b = glowColor.b / 255.0f;
         _effectColorF.a = glowColor.a / 255.0f;
         updateShaderProgram();
+        invalidateCachedAncestors();
     }
 }
 
@@ -1022,6 +1305,7 @@ void Label::enableOutline(const Color4B& outlineColor,int outlineSize /* = -1 */
             _effectColorF.a = outlineColor.a / 255.f;
             _currLabelEffect = LabelEffect::OUTLINE;
             _contentDirty = true;
+            invalidateCachedAncestors();
         }
         _outlineSize = outlineSize;
     }
@@ -1031,6 +1315,7 @@ void Label::enableShadow(const Color4B& shadowColor /* = Color4B::BLACK */,const
 {
     _shadowEnabled = true;
     _shadowDirty = true;
+    invalidateCachedAncestors();
 
     _shadowOffset.width = offset.width;
     _shadowOffset.height = offset.height;
@@ -1105,6 +1390,7 @@ void Label::disableEffect(LabelEffect effect)
             
             _currLabelEffect = LabelEffect::NORMAL;
             _contentDirty = true;
+            invalidateCachedAncestors();
         }
         break;
     case cocos2d::LabelEffect::SHADOW:
@@ -1272,7 +1558,6 @@ void Label::updateContent()
             _utf16Text = utf16String;
         }
 
-        computeHorizontalKernings(_utf16Text);
         updateFinished = alignText();
     }
     else
@@ -1362,6 +1647,13 @@ void Label::onDraw(const Mat4& transform, bool transformUpdated)
     glprogram->use();
     GL::blendFunc(_blendFunc.src, _blendFunc.dst);
 
+    if (_useMultiChannelDistanceField && _uniformSmoothing != -1)
+    {
+        // the distances are stored as 16 levels per pixel of the atlas, smooth over about one pixel on screen
+        auto smoothing = 0.5f * 16.f / 255.f / std::max(_bmfontScale, 0.01f);
+        glprogram->setUniformLocationWith1f(_uniformSmoothing, std::min(smoothing, 0.5f));
+    }
+
     if (_shadowEnabled)
     {
         onDrawShadow(glprogram);
@@ -1632,6 +1924,7 @@ void Label::setLineHeight(float height)
     {
         _lineHeight = height;
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -1647,6 +1940,7 @@ void Label::setLineSpacing(float height)
     {
         _lineSpacing = height;
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -1662,6 +1956,7 @@ void Label::setAdditionalKerning(float space)
     {
         _additionalKerning = space;
         _contentDirty = true;
+        invalidateCachedAncestors();
     }
 }
 
@@ -1778,6 +2073,7 @@ void Label::setTextColor(const Color4B &color)
     _textColorF.g = _textColor.g / 255.0f;
     _textColorF.b = _textColor.b / 255.0f;
     _textColorF.a = _textColor.a / 255.0f;
+    invalidateCachedAncestors();
 }
 
 void Label::updateColor()
@@ -1846,6 +2142,7 @@ void Label::setBlendFunc(const BlendFunc &blendFunc)
 {
     _blendFunc = blendFunc;
     _blendFuncDirty = true;
+    invalidateCachedAncestors();
     if (_textSprite)
     {
         _textSprite->setBlendFunc(blendFunc);
@@ -1955,6 +2252,7 @@ void Label::enableWrap(bool enable)
     this->rescaleWithOriginalFontSize();
     
     _contentDirty = true;
+    invalidateCachedAncestors();
 }
 
 bool Label::isWrapEnabled()const
@@ -1989,6 +2287,7 @@ void Label::setOverflow(Overflow overflow)
     this->rescaleWithOriginalFontSize();
     
     _contentDirty = true;
+    invalidateCachedAncestors();
 }
 
 void Label::rescaleWithOriginalFontSize()
@@ -2006,7 +2305,7 @@ Label::Overflow Label::getOverflow()const
 
 void Label::updateLetterSpriteScale(Sprite* sprite)
 {
-    if (_currentLabelType == LabelType::BMFONT && _bmFontSize > 0)
+    if ((_currentLabelType == LabelType::BMFONT && _bmFontSize > 0) || _useMultiChannelDistanceField)
     {
         sprite->setScale(_bmfontScale);
     }
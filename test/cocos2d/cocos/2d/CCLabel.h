@@ -26,6 +26,8 @@
 #ifndef _COCOS2D_CCLABEL_H_
 #define _COCOS2D_CCLABEL_H_
 
+#include <list>
+
 #include "2d/CCNode.h"
 #include "renderer/CCCustomCommand.h"
 #include "renderer/CCQuadCommand.h"
@@ -55,18 +57,28 @@ typedef struct _ttfConfig
     bool distanceFieldEnabled;
     int outlineSize;
 
+    /**
+     * Renders the glyphs as multi-channel signed distance fields, which keep sharp corners when scaled.
+     * The glyphs are generated once at FontFreeType::MultiChannelDistanceFieldFontSize and every font size
+     * of the font file shares that atlas. Not compatible with outline and glow.
+     */
+    bool multiChannelDistanceFieldEnabled;
+
     _ttfConfig(const std::string& filePath = "",float size = 12, const GlyphCollection& glyphCollection = GlyphCollection::DYNAMIC,
-        const char *customGlyphCollection = nullptr, bool useDistanceField = false, int outline = 0)
+        const char *customGlyphCollection = nullptr, bool useDistanceField = false, int outline = 0,
+        bool useMultiChannelDistanceField = false)
         : fontFilePath(filePath)
         , fontSize(size)
         , glyphs(glyphCollection)
         , customGlyphs(customGlyphCollection)
         , distanceFieldEnabled(useDistanceField)
         , outlineSize(outline)
+        , multiChannelDistanceFieldEnabled(useMultiChannelDistanceField)
     {
         if(outline > 0)
         {
             distanceFieldEnabled = false;
+            multiChannelDistanceFieldEnabled = false;
         }
     }
 } TTFConfig;
@@ -305,6 +317,18 @@ public:
      */
     int getStringLength();
 
+    /**
+     * Sets how many layouts of recently displayed strings are kept by the label, so that displaying one
+     * of these strings again reuses the letter positions and quads instead of laying the text out again.
+     * Useful for labels cycling through a few values. Labels using Overflow::SHRINK are not cached.
+     *
+     * @param size The number of layouts to keep, 0 (the default) disables the cache.
+     */
+    void setLayoutCacheSize(int size);
+
+    /** Returns the number of layouts kept by the label. */
+    int getLayoutCacheSize() const { return _layoutCacheSize; }
+
     /**
      * Sets the text color of Label.
      *
@@ -593,6 +617,23 @@ protected:
         int lineIndex;
     };
 
+    // everything computed by alignText() for a string
+    struct LayoutCacheEntry
+    {
+        std::u16string text;
+        std::vector<LetterInfo> lettersInfo;
+        std::vector<float> linesWidth;
+        std::vector<float> linesOffsetX;
+        // quads of every batch node, before updateColor()
+        std::vector<std::vector<V3F_C4B_T2F_Quad>> quads;
+        Size contentSize;
+        float letterOffsetY;
+        float textDesiredHeight;
+        float tailoredTopY;
+        float tailoredBottomY;
+        int numberOfLines;
+    };
+
     enum class LabelType {
         TTF,
         BMFONT,
@@ -626,6 +667,14 @@ protected:
     void recordPlaceholderInfo(int letterIndex, char16_t utf16Char);
     
     bool updateQuads();
+    bool computeLetterQuad(const LetterInfo& letterInfo, const FontLetterDefinition& letterDef, Rect& uvRect, Vec2& position);
+    bool updateChangedQuads(const LayoutCacheEntry& previousLayout);
+
+    std::string getLayoutSettings() const;
+    bool applyCachedLayout();
+    void addCachedLayout();
+    void saveLayout(LayoutCacheEntry& entry, bool withQuads);
+    void clearLayoutCache();
 
     void createSpriteForSystemFont(const FontDefinition& fontDef);
     void createShadowSpriteForSystemFont(const FontDefinition& fontDef);
@@ -701,6 +750,8 @@ protected:
     GLuint _uniformEffectColor;
     GLuint _uniformTextColor;
     bool _useDistanceField;
+    bool _useMultiChannelDistanceField;
+    GLint _uniformSmoothing;
     bool _useA8Shader;
 
     bool _shadowDirty;
@@ -725,6 +776,7 @@ protected:
 
     EventListenerCustom* _purgeTextureListener;
     EventListenerCustom* _resetTextureListener;
+    EventListenerCustom* _glyphsReadyListener;
 
 #if CC_LABEL_DEBUG_DRAW
     DrawNode* _debugDrawNode;
@@ -735,6 +787,13 @@ protected:
     float _bmfontScale;
     Overflow _overflow;
     float _originalFontSize;
+
+    // settings the cached layouts and the current one were computed with, empty if they can't be reused
+    std::string _layoutSettings;
+    std::u16string _layoutText;
+    // most recently used first
+    std::list<LayoutCacheEntry> _layoutCache;
+    int _layoutCacheSize;
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Label);
 };
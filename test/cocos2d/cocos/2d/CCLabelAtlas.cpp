@@ -131,6 +131,7 @@ void LabelAtlas::updateAtlasValues()
     {
         return;
     }
+    invalidateCachedAncestors();
 
     ssize_t n = _string.length();
 
@@ -249,6 +250,7 @@ void LabelAtlas::updateColor()
             quads[index].tr.colors = color4;
             _textureAtlas->updateQuad(&quads[index], index);
         }
+        invalidateCachedAncestors();
     }
 }
 
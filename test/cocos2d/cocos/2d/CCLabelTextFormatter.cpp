@@ -29,6 +29,7 @@
 #include "base/CCDirector.h"
 #include "2d/CCFontAtlas.h"
 #include "2d/CCFontFNT.h"
+#include "2d/CCFontFreeType.h"
 
 NS_CC_BEGIN
 
@@ -106,6 +107,9 @@ void Label::updateBMFontScale()
         FontFNT *bmFont = (FontFNT*)font;
         float originalFontSize = bmFont->getOriginalFontSize();
         _bmfontScale = _bmFontSize * CC_CONTENT_SCALE_FACTOR() / originalFontSize;
+    }else if (_useMultiChannelDistanceField){
+        // the glyphs of the shared atlas are generated at a fixed size
+        _bmfontScale = _fontConfig.fontSize / FontFreeType::MultiChannelDistanceFieldFontSize;
     }else{
         _bmfontScale = 1.0f;
     }
@@ -186,7 +190,13 @@ bool Label::multilineTextWrap(std::function<int(const std::u16string&, int, int)
             recordLetterInfo(letterPosition, character, letterIndex, lineIndex);
             
             if (_horizontalKernings && letterIndex < textLen - 1)
-                nextLetterX += _horizontalKernings[letterIndex + 1];
+            {
+                // the kernings of the shared multi-channel distance field atlas are at its generation size
+                if (_useMultiChannelDistanceField)
+                    nextLetterX += _horizontalKernings[letterIndex + 1] * _bmfontScale;
+                else
+                    nextLetterX += _horizontalKernings[letterIndex + 1];
+            }
             nextLetterX += letterDef.xAdvance * _bmfontScale + _additionalKerning;
             
             tokenRight = letterPosition.x + letterDef.width * _bmfontScale;
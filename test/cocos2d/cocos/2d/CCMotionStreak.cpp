@@ -258,6 +258,9 @@ void MotionStreak::update(float delta)
         return;
     }
     
+    // the streak fades every frame, a CachedNode renders it again each time
+    invalidateCachedAncestors();
+    
     delta *= _fadeDelta;
 
     unsigned int newIdx, newIdx2, i, i2;
@@ -374,6 +377,7 @@ void MotionStreak::update(float delta)
 void MotionStreak::reset()
 {
     _nuPoints = 0;
+    invalidateCachedAncestors();
 }
 
 void MotionStreak::onDraw(const Mat4 &transform, uint32_t flags)
@@ -41,6 +41,8 @@ THE SOFTWARE.
 #include "2d/CCActionManager.h"
 #include "2d/CCScene.h"
 #include "2d/CCComponent.h"
+#include "2d/CCTransformSystem.h"
+#include "2d/CCCachedNode.h"
 #include "renderer/CCGLProgram.h"
 #include "renderer/CCGLProgramState.h"
 #include "renderer/CCMaterial.h"
@@ -88,6 +90,10 @@ Node::Node()
 , _inverseDirty(true)
 , _useAdditionalTransform(false)
 , _transformUpdated(true)
+, _transformSystem(nullptr)
+, _transformSystemIndex(-1)
+, _transformSystemApplied(false)
+, _cachesSubtree(false)
 // children (lazy allocs)
 // lazy alloc
 , _localZOrder(0)
@@ -175,6 +181,11 @@ Node::~Node()
         child->_parent = nullptr;
     }
 
+    if (_transformSystem)
+    {
+        _transformSystem->releaseNode(this);
+    }
+
     removeAllComponents();
     
     CC_SAFE_DELETE(_componentContainer);
@@ -241,6 +252,8 @@ void Node::setSkewX(float skewX)
     
     _skewX = skewX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 float Node::getSkewY() const
@@ -255,6 +268,8 @@ void Node::setSkewY(float skewY)
     
     _skewY = skewY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 void Node::setLocalZOrder(int z)
@@ -284,6 +299,7 @@ void Node::setGlobalZOrder(float globalZOrder)
     {
         _globalZOrder = globalZOrder;
         _eventDispatcher->setDirtyForNode(this);
+        invalidateCachedAncestors();
     }
 }
 
@@ -302,6 +318,8 @@ void Node::setRotation(float rotation)
     
     _rotationZ_X = _rotationZ_Y = rotation;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
     
     updateRotationQuat();
 }
@@ -319,6 +337,8 @@ void Node::setRotation3D(const Vec3& rotation)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 
     _rotationX = rotation.x;
     _rotationY = rotation.y;
@@ -370,6 +390,8 @@ void Node::setRotationQuat(const Quaternion& quat)
     _rotationQuat = quat;
     updateRotation3D();
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 Quaternion Node::getRotationQuat() const
@@ -384,6 +406,8 @@ void Node::setRotationSkewX(float rotationX)
     
     _rotationZ_X = rotationX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
     
     updateRotationQuat();
 }
@@ -400,6 +424,8 @@ void Node::setRotationSkewY(float rotationY)
     
     _rotationZ_Y = rotationY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
     
     updateRotationQuat();
 }
@@ -419,6 +445,8 @@ void Node::setScale(float scale)
     
     _scaleX = _scaleY = _scaleZ = scale;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 /// scaleX getter
@@ -436,6 +464,8 @@ void Node::setScale(float scaleX,float scaleY)
     _scaleX = scaleX;
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 /// scaleX setter
@@ -446,6 +476,8 @@ void Node::setScaleX(float scaleX)
     
     _scaleX = scaleX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 /// scaleY getter
@@ -462,6 +494,8 @@ void Node::setScaleZ(float scaleZ)
     
     _scaleZ = scaleZ;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 /// scaleY getter
@@ -478,6 +512,8 @@ void Node::setScaleY(float scaleY)
     
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 
@@ -508,6 +544,8 @@ void Node::setPosition(float x, float y)
     _position.y = y;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
     _usingNormalizedPosition = false;
 }
 
@@ -553,6 +591,8 @@ void Node::setPositionZ(float positionZ)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 
     _positionZ = positionZ;
 }
@@ -573,6 +613,8 @@ void Node::setNormalizedPosition(const Vec2& position)
     _usingNormalizedPosition = true;
     _normalizedPositionDirty = true;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 ssize_t Node::getChildrenCount() const
@@ -593,7 +635,11 @@ void Node::setVisible(bool visible)
     {
         _visible = visible;
         if(_visible)
+        {
             _transformUpdated = _transformDirty = _inverseDirty = true;
+            markTransformSystemDirty();
+        }
+        invalidateCachedAncestors();
     }
 }
 
@@ -615,6 +661,8 @@ void Node::setAnchorPoint(const Vec2& point)
         _anchorPoint = point;
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        markTransformSystemDirty();
+        invalidateCachedAncestors();
     }
 }
 
@@ -632,6 +680,8 @@ void Node::setContentSize(const Size & size)
 
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+        markTransformSystemDirty();
+        invalidateCachedAncestors();
     }
 }
 
@@ -644,8 +694,15 @@ bool Node::isRunning() const
 /// parent setter
 void Node::setParent(Node * parent)
 {
+    invalidateCachedAncestors();
+    // the subtree takes new slots after the one of its new parent in the arrays of the transform system
+    if (_transformSystem)
+        _transformSystem->releaseNode(this);
     _parent = parent;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    if (_parent && _parent->_transformSystem)
+        _parent->_transformSystem->attachNode(this);
+    invalidateCachedAncestors();
 }
 
 /// isRelativeAnchorPoint getter
@@ -660,6 +717,8 @@ void Node::ignoreAnchorPointForPosition(bool newValue)
     {
         _ignoreAnchorPointForPosition = newValue;
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        markTransformSystemDirty();
+        invalidateCachedAncestors();
     }
 }
 
@@ -726,6 +785,8 @@ void Node::setGLProgramState(cocos2d::GLProgramState* glProgramState)
 
         if (_glProgramState)
             _glProgramState->setNodeBinding(this);
+
+        invalidateCachedAncestors();
     }
 }
 
@@ -739,6 +800,8 @@ void Node::setGLProgram(GLProgram* glProgram)
         _glProgramState->retain();
 
         _glProgramState->setNodeBinding(this);
+
+        invalidateCachedAncestors();
     }
 }
 
@@ -1120,6 +1183,7 @@ void Node::reorderChild(Node *child, int zOrder)
     _reorderChildDirty = true;
     child->setOrderOfArrival(s_globalOrderOfArrival++);
     child->_localZOrder = zOrder;
+    child->invalidateCachedAncestors();
 }
 
 void Node::sortAllChildren()
@@ -1161,6 +1225,7 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
             _position.x = _normalizedPosition.x * s.width;
             _position.y = _normalizedPosition.y * s.height;
             _transformUpdated = _transformDirty = _inverseDirty = true;
+            markTransformSystemDirty();
             _normalizedPositionDirty = false;
         }
     }
@@ -1177,7 +1242,17 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
     
 
     if(flags & FLAGS_DIRTY_MASK)
-        _modelViewTransform = this->transform(parentTransform);
+    {
+        // use the world transform computed by the transform system of the scene when it is still valid
+        auto transformSystem = TransformSystem::getRunningSystem();
+        if (!transformSystem || !transformSystem->applyWorldTransform(this, parentTransform))
+        {
+            _modelViewTransform = this->transform(parentTransform);
+            _transformSystemApplied = false;
+            // the world transform of the system is stale, it is computed again by its next update
+            markTransformSystemDirty();
+        }
+    }
     
     _transformUpdated = false;
     _contentSizeDirty = false;
@@ -1245,6 +1320,25 @@ void Node::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t paren
     // _orderOfArrival = 0;
 }
 
+void Node::invalidateCachedAncestors()
+{
+    if (CachedNode::s_instanceCount == 0)
+        return;
+
+    for (auto node = _parent; node; node = node->_parent)
+    {
+        // stop at the first cache that was already invalidated, its ancestors were invalidated with it
+        if (node->_cachesSubtree && !static_cast<CachedNode*>(node)->invalidateBy(this))
+            break;
+    }
+}
+
+void Node::markTransformSystemDirty() const
+{
+    if (_transformSystem)
+        _transformSystem->markDirty(_transformSystemIndex);
+}
+
 Mat4 Node::transform(const Mat4& parentTransform)
 {
     return parentTransform * this->getNodeToParentTransform();
@@ -1639,6 +1733,9 @@ const Mat4& Node::getNodeToParentTransform() const
 {
     if (_transformDirty)
     {
+        // also catches the subclasses changing the transform without the setters
+        markTransformSystemDirty();
+        
         // Translate values
         float x = _position.x;
         float y = _position.y;
@@ -1744,6 +1841,8 @@ void Node::setNodeToParentTransform(const Mat4& transform)
     _transform = transform;
     _transformDirty = false;
     _transformUpdated = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 void Node::setAdditionalTransform(const AffineTransform& additionalTransform)
@@ -1765,6 +1864,8 @@ void Node::setAdditionalTransform(Mat4* additionalTransform)
         _useAdditionalTransform = true;
     }
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markTransformSystemDirty();
+    invalidateCachedAncestors();
 }
 
 
@@ -1933,6 +2034,7 @@ void Node::updateDisplayedOpacity(GLubyte parentOpacity)
 {
     _displayedOpacity = _realOpacity * parentOpacity/255.0;
     updateColor();
+    invalidateCachedAncestors();
     
     if (_cascadeOpacityEnabled)
     {
@@ -2012,6 +2114,7 @@ void Node::updateDisplayedColor(const Color3B& parentColor)
     _displayedColor.g = _realColor.g * parentColor.g/255.0;
     _displayedColor.b = _realColor.b * parentColor.b/255.0;
     updateColor();
+    invalidateCachedAncestors();
     
     if (_cascadeColorEnabled)
     {
@@ -50,6 +50,7 @@ class Component;
 class ComponentContainer;
 class EventDispatcher;
 class Scene;
+class TransformSystem;
 class Renderer;
 class Director;
 class GLProgram;
@@ -1153,6 +1154,13 @@ public:
     virtual void visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags);
     virtual void visit() final;
 
+    /**
+     * Tells the CachedNode ancestors of this node that the subtree they cached changed and must be rendered again.
+     * The transform, visibility, color, z order and hierarchy setters already call it,
+     * nodes that draw custom content must call it when this content changes.
+     */
+    void invalidateCachedAncestors();
+
 
     /** Returns the Scene that contains the Node.
      It returns `nullptr` if the node doesn't belong to any Scene.
@@ -1736,6 +1744,8 @@ protected:
 
     Mat4 transform(const Mat4 &parentTransform);
     uint32_t processParentFlags(const Mat4& parentTransform, uint32_t parentFlags);
+    /// Flags the local transform as changed for the TransformSystem owning a slot for the node.
+    void markTransformSystemDirty() const;
 
     virtual void updateCascadeOpacity();
     virtual void disableCascadeOpacity();
@@ -1797,6 +1807,10 @@ protected:
     mutable Mat4 _additionalTransform; ///< transform
     bool _useAdditionalTransform;   ///< The flag to check whether the additional transform is dirty
     bool _transformUpdated;         ///< Whether or not the Transform object was updated since the last frame
+    TransformSystem* _transformSystem; ///< weak reference to the TransformSystem owning a slot for the node, nullptr if none
+    int _transformSystemIndex;      ///< index of the slot of the node in the arrays of _transformSystem, -1 if none
+    bool _transformSystemApplied;   ///< whether or not _modelViewTransform was computed by the TransformSystem
+    bool _cachesSubtree;            ///< whether or not the node is a CachedNode
 
     int _localZOrder;               ///< Local order (relative to its siblings) used to sort the node
     float _globalZOrder;            ///< Global order used to sort the node
@@ -1871,6 +1885,9 @@ public:
     friend class PhysicsBody;
 #endif
 
+    friend class TransformSystem;
+    friend class CachedNode;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Node);
 };
@@ -832,6 +832,12 @@ void ParticleSystem::update(float dt)
 {
     CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 
+    // the particles move every frame, a CachedNode renders them again as long as the system runs
+    if (_isActive || _particleCount > 0)
+    {
+        invalidateCachedAncestors();
+    }
+
     if (_isActive && _emissionRate)
     {
         float rate = 1.0f / _emissionRate;
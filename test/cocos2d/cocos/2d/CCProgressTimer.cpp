@@ -108,6 +108,7 @@ void ProgressTimer::setSprite(Sprite *sprite)
         CC_SAFE_RELEASE(_sprite);
         _sprite = sprite;
         setContentSize(_sprite->getContentSize());
+        invalidateCachedAncestors();
 
         //    Every time we set a new sprite, we free the current vertex data
         if (_vertexData)
@@ -132,6 +133,7 @@ void ProgressTimer::setType(Type type)
         }
 
         _type = type;
+        invalidateCachedAncestors();
     }
 }
 
@@ -143,6 +145,7 @@ void ProgressTimer::setReverseProgress(bool reverse)
         //    release all previous information
         CC_SAFE_FREE(_vertexData);
         _vertexDataCount = 0;
+        invalidateCachedAncestors();
     }
 }
 
@@ -195,10 +198,12 @@ void ProgressTimer::updateColor(void)
             _vertexData[i].colors = sc;
         }            
     }
+    invalidateCachedAncestors();
 }
 
 void ProgressTimer::updateProgress(void)
 {
+    invalidateCachedAncestors();
     switch (_type)
     {
     case Type::RADIAL:
@@ -247,6 +252,7 @@ GLubyte ProgressTimer::getOpacity() const
 void ProgressTimer::setMidpoint(const Vec2& midPoint)
 {
     _midpoint = midPoint.getClampPoint(Vec2::ZERO, Vec2(1, 1));
+    invalidateCachedAncestors();
 }
 
 ///
@@ -144,7 +144,7 @@ public:
      *    Set the rate to be Vec2(0,1); and set the midpoint to = Vec2(0,.5f).
      * @param barChangeRate A Vec2.
      */
-    inline void setBarChangeRate(const Vec2& barChangeRate ) { _barChangeRate = barChangeRate; }
+    inline void setBarChangeRate(const Vec2& barChangeRate ) { _barChangeRate = barChangeRate; invalidateCachedAncestors(); }
     
     /** Returns the BarChangeRate.
      *
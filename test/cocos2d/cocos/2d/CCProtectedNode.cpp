@@ -243,6 +243,7 @@ void ProtectedNode::reorderProtectedChild(cocos2d::Node *child, int localZOrder)
     _reorderProtectedChildDirty = true;
     child->setOrderOfArrival(s_globalOrderOfArrival++);
     child->setLocalZOrder(localZOrder);
+    child->invalidateCachedAncestors();
 }
 
 void ProtectedNode::visit(Renderer* renderer, const Mat4 &parentTransform, uint32_t parentFlags)
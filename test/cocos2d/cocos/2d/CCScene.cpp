@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "2d/CCScene.h"
 #include "base/CCDirector.h"
 #include "2d/CCCamera.h"
+#include "2d/CCTransformSystem.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventListenerCustom.h"
 #include "renderer/CCRenderer.h"
@@ -66,6 +67,7 @@ Scene::Scene()
     setAnchorPoint(Vec2(0.5f, 0.5f));
     
     _cameraOrderDirty = true;
+    _transformSystem = nullptr;
     
     //create default camera
     _defaultCamera = Camera::create();
@@ -88,6 +90,7 @@ Scene::~Scene()
 #endif
     Director::getInstance()->getEventDispatcher()->removeEventListener(_event);
     CC_SAFE_RELEASE(_event);
+    CC_SAFE_RELEASE(_transformSystem);
     
 #if CC_USE_PHYSICS
     delete _physicsWorld;
@@ -182,6 +185,11 @@ void Scene::render(Renderer* renderer)
     Camera* defaultCamera = nullptr;
     const auto& transform = getNodeToParentTransform();
 
+    if (_transformSystem)
+    {
+        _transformSystem->begin(this, transform);
+    }
+
     for (const auto& camera : getCameras())
     {
         if (!camera->isVisible())
@@ -211,6 +219,11 @@ void Scene::render(Renderer* renderer)
         
         director->popMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION);
     }
+
+    if (_transformSystem)
+    {
+        _transformSystem->end();
+    }
     
 #if CC_USE_3D_PHYSICS && CC_ENABLE_BULLET_INTEGRATION
     if (_physics3DWorld && _physics3DWorld->isDebugDrawEnabled())
@@ -241,6 +254,19 @@ void Scene::removeAllChildren()
     }
 }
 
+void Scene::setTransformSystemEnabled(bool enabled)
+{
+    if (enabled && !_transformSystem)
+    {
+        _transformSystem = TransformSystem::create();
+        CC_SAFE_RETAIN(_transformSystem);
+    }
+    else if (!enabled)
+    {
+        CC_SAFE_RELEASE_NULL(_transformSystem);
+    }
+}
+
 #if CC_USE_3D_PHYSICS && CC_ENABLE_BULLET_INTEGRATION
 void Scene::setPhysics3DDebugCamera(Camera* camera)
 {
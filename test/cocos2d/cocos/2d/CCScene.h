@@ -38,6 +38,7 @@ class BaseLight;
 class Renderer;
 class EventListenerCustom;
 class EventCustom;
+class TransformSystem;
 #if CC_USE_PHYSICS
 class PhysicsWorld;
 #endif
@@ -113,6 +114,15 @@ public:
     
     /** override function */
     virtual void removeAllChildren() override;
+
+    /** Enables the TransformSystem of the scene.
+     The world transforms of the nodes are then computed in one pass over contiguous arrays before the scene is visited,
+     which is faster for large hierarchies whose nodes mostly don't move. Disabled by default.
+     */
+    void setTransformSystemEnabled(bool enabled);
+    bool isTransformSystemEnabled() const { return _transformSystem != nullptr; }
+    /** Gets the TransformSystem of the scene, nullptr if it is disabled. */
+    TransformSystem* getTransformSystem() const { return _transformSystem; }
     
 CC_CONSTRUCTOR_ACCESS:
     Scene();
@@ -139,6 +149,8 @@ protected:
     EventListenerCustom*       _event;
 
     std::vector<BaseLight *> _lights;
+
+    TransformSystem*     _transformSystem;
     
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Scene);
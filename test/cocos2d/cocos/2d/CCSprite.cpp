@@ -380,6 +380,7 @@ void Sprite::setTexture(Texture2D *texture)
         CC_SAFE_RELEASE(_texture);
         _texture = texture;
         updateBlendFunc();
+        invalidateCachedAncestors();
     }
 }
 
@@ -441,6 +442,7 @@ void Sprite::setTextureRect(const Rect& rect, bool rotated, const Size& untrimme
     }
     
     _polyInfo.setQuad(&_quad);
+    invalidateCachedAncestors();
 }
 
 // override this method to generate "double scale" sprites
@@ -919,6 +921,7 @@ void Sprite::setFlippedX(bool flippedX)
         if (_textureAtlas) {
             setDirty(true);
         }
+        invalidateCachedAncestors();
     }
 }
 
@@ -939,6 +942,7 @@ void Sprite::setFlippedY(bool flippedY)
         if (_textureAtlas) {
             setDirty(true);
         }
+        invalidateCachedAncestors();
     }
 }
 
@@ -992,6 +996,7 @@ void Sprite::setOpacityModifyRGB(bool modify)
     {
         _opacityModifyRGB = modify;
         updateColor();
+        invalidateCachedAncestors();
     }
 }
 
@@ -1148,6 +1153,7 @@ PolygonInfo& Sprite::getPolygonInfo()
 void Sprite::setPolygonInfo(const PolygonInfo& info)
 {
     _polyInfo = info;
+    invalidateCachedAncestors();
 }
 
 NS_CC_END
@@ -428,7 +428,7 @@ public:
     *In lua: local setBlendFunc(local src, local dst).
     *@endcode
     */
-    inline void setBlendFunc(const BlendFunc &blendFunc) override { _blendFunc = blendFunc; }
+    inline void setBlendFunc(const BlendFunc &blendFunc) override { _blendFunc = blendFunc; invalidateCachedAncestors(); }
     /**
     * @js  NA
     * @lua NA
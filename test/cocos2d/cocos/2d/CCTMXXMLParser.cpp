@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "base/base64.h"
 #include "base/CCDirector.h"
 #include "platform/CCFileUtils.h"
+#include "base/CCData.h"
+#include "xxhash.h"
 
 using namespace std;
 
@@ -100,6 +102,344 @@ Rect TMXTilesetInfo::getRectForGID(uint32_t gid)
     return rect;
 }
 
+// binary maps
+
+namespace
+{
+    const char BINARY_MAP_MAGIC[4] = { 'C', 'C', 'T', 'B' };
+    const uint32_t BINARY_MAP_VERSION = 2;
+    const char* BINARY_MAP_EXTENSION = ".tmxb";
+    const char* BINARY_CACHE_DIRECTORY = "tmxcache/";
+
+    bool s_binaryCacheEnabled = false;
+
+    class BinaryMapWriter
+    {
+    public:
+        template <typename T>
+        void write(T value)
+        {
+            auto bytes = reinterpret_cast<const unsigned char*>(&value);
+            _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+        }
+
+        void writeString(const std::string& str)
+        {
+            write<uint32_t>(static_cast<uint32_t>(str.size()));
+            _buffer.insert(_buffer.end(), str.begin(), str.end());
+        }
+
+        void writeSize(const Size& size)
+        {
+            write<float>(size.width);
+            write<float>(size.height);
+        }
+
+        void writeVec2(const Vec2& vec)
+        {
+            write<float>(vec.x);
+            write<float>(vec.y);
+        }
+
+        void writeValue(const Value& value)
+        {
+            write<uint8_t>(static_cast<uint8_t>(value.getType()));
+            switch (value.getType())
+            {
+                case Value::Type::BYTE:
+                    write<uint8_t>(value.asByte());
+                    break;
+                case Value::Type::INTEGER:
+                    write<int32_t>(value.asInt());
+                    break;
+                case Value::Type::FLOAT:
+                    write<float>(value.asFloat());
+                    break;
+                case Value::Type::DOUBLE:
+                    write<double>(value.asDouble());
+                    break;
+                case Value::Type::BOOLEAN:
+                    write<uint8_t>(value.asBool() ? 1 : 0);
+                    break;
+                case Value::Type::STRING:
+                    writeString(value.asString());
+                    break;
+                case Value::Type::VECTOR:
+                    writeValueVector(value.asValueVector());
+                    break;
+                case Value::Type::MAP:
+                    writeValueMap(value.asValueMap());
+                    break;
+                case Value::Type::INT_KEY_MAP:
+                    writeIntKeyMap(value.asIntKeyMap());
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void writeValueVector(const ValueVector& values)
+        {
+            write<uint32_t>(static_cast<uint32_t>(values.size()));
+            for (const auto& value : values)
+            {
+                writeValue(value);
+            }
+        }
+
+        void writeValueMap(const ValueMap& values)
+        {
+            write<uint32_t>(static_cast<uint32_t>(values.size()));
+            for (const auto& pair : values)
+            {
+                writeString(pair.first);
+                writeValue(pair.second);
+            }
+        }
+
+        void writeIntKeyMap(const ValueMapIntKey& values)
+        {
+            write<uint32_t>(static_cast<uint32_t>(values.size()));
+            for (const auto& pair : values)
+            {
+                write<int32_t>(pair.first);
+                writeValue(pair.second);
+            }
+        }
+
+        void writeBytes(const void* bytes, size_t size)
+        {
+            auto begin = static_cast<const unsigned char*>(bytes);
+            _buffer.insert(_buffer.end(), begin, begin + size);
+        }
+
+        const std::vector<unsigned char>& getBuffer() const { return _buffer; }
+
+    private:
+        std::vector<unsigned char> _buffer;
+    };
+
+    // every read fails once the end of the data is reached
+    class BinaryMapReader
+    {
+    public:
+        explicit BinaryMapReader(const Data& data)
+        : _bytes(data.getBytes())
+        , _size(static_cast<size_t>(data.getSize()))
+        , _offset(0)
+        {
+        }
+
+        const unsigned char* skip(size_t size)
+        {
+            if (size > _size - _offset)
+            {
+                _offset = _size;
+                return nullptr;
+            }
+            auto ret = _bytes + _offset;
+            _offset += size;
+            return ret;
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            auto bytes = skip(sizeof(T));
+            if (bytes)
+            {
+                memcpy(&value, bytes, sizeof(T));
+            }
+            return bytes != nullptr;
+        }
+
+        bool readString(std::string& str)
+        {
+            uint32_t length = 0;
+            if (!read(length))
+                return false;
+            auto bytes = skip(length);
+            if (bytes)
+            {
+                str.assign(reinterpret_cast<const char*>(bytes), length);
+            }
+            return bytes != nullptr;
+        }
+
+        bool readSize(Size& size)
+        {
+            return read(size.width) && read(size.height);
+        }
+
+        bool readVec2(Vec2& vec)
+        {
+            return read(vec.x) && read(vec.y);
+        }
+
+        bool readValue(Value& value)
+        {
+            uint8_t type = 0;
+            if (!read(type))
+                return false;
+
+            switch (static_cast<Value::Type>(type))
+            {
+                case Value::Type::NONE:
+                    value = Value::Null;
+                    return true;
+                case Value::Type::BYTE:
+                {
+                    uint8_t v = 0;
+                    if (!read(v))
+                        return false;
+                    value = Value(static_cast<unsigned char>(v));
+                    return true;
+                }
+                case Value::Type::INTEGER:
+                {
+                    int32_t v = 0;
+                    if (!read(v))
+                        return false;
+                    value = Value(static_cast<int>(v));
+                    return true;
+                }
+                case Value::Type::FLOAT:
+                {
+                    float v = 0;
+                    if (!read(v))
+                        return false;
+                    value = Value(v);
+                    return true;
+                }
+                case Value::Type::DOUBLE:
+                {
+                    double v = 0;
+                    if (!read(v))
+                        return false;
+                    value = Value(v);
+                    return true;
+                }
+                case Value::Type::BOOLEAN:
+                {
+                    uint8_t v = 0;
+                    if (!read(v))
+                        return false;
+                    value = Value(v != 0);
+                    return true;
+                }
+                case Value::Type::STRING:
+                {
+                    std::string v;
+                    if (!readString(v))
+                        return false;
+                    value = Value(v);
+                    return true;
+                }
+                case Value::Type::VECTOR:
+                {
+                    ValueVector v;
+                    if (!readValueVector(v))
+                        return false;
+                    value = Value(std::move(v));
+                    return true;
+                }
+                case Value::Type::MAP:
+                {
+                    ValueMap v;
+                    if (!readValueMap(v))
+                        return false;
+                    value = Value(std::move(v));
+                    return true;
+                }
+                case Value::Type::INT_KEY_MAP:
+                {
+                    ValueMapIntKey v;
+                    if (!readIntKeyMap(v))
+                        return false;
+                    value = Value(std::move(v));
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        bool readValueVector(ValueVector& values)
+        {
+            uint32_t count = 0;
+            if (!read(count))
+                return false;
+            // a value takes at least one byte
+            if (count > _size - _offset)
+                return false;
+            values.resize(count);
+            for (auto& value : values)
+            {
+                if (!readValue(value))
+                    return false;
+            }
+            return true;
+        }
+
+        bool readValueMap(ValueMap& values)
+        {
+            uint32_t count = 0;
+            if (!read(count))
+                return false;
+            values.reserve(std::min<size_t>(count, _size - _offset));
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                std::string key;
+                if (!readString(key) || !readValue(values[key]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool readIntKeyMap(ValueMapIntKey& values)
+        {
+            uint32_t count = 0;
+            if (!read(count))
+                return false;
+            values.reserve(std::min<size_t>(count, _size - _offset));
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                int32_t key = 0;
+                if (!read(key) || !readValue(values[key]))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        const unsigned char* _bytes;
+        size_t _size;
+        size_t _offset;
+    };
+
+    bool isBinaryMapFile(const std::string& filename)
+    {
+        size_t extensionLength = strlen(BINARY_MAP_EXTENSION);
+        return filename.size() > extensionLength
+            && filename.compare(filename.size() - extensionLength, extensionLength, BINARY_MAP_EXTENSION) == 0;
+    }
+
+    std::string getBinaryCachePath(const std::string& tmxFullPath)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "%08x", XXH32(tmxFullPath.c_str(), static_cast<int>(tmxFullPath.size()), 0));
+        return FileUtils::getInstance()->getWritablePath() + BINARY_CACHE_DIRECTORY + name + BINARY_MAP_EXTENSION;
+    }
+
+    // size and hash of a file the map was parsed from, both 0 if it can't be read
+    void getSourceSignature(const std::string& fullPath, uint32_t& size, uint32_t& hash)
+    {
+        Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+        size = static_cast<uint32_t>(data.getSize());
+        hash = data.isNull() ? 0 : XXH32(data.getBytes(), static_cast<int>(data.getSize()), 0);
+    }
+}
+
 // implementation TMXMapInfo
 
 TMXMapInfo * TMXMapInfo::create(const std::string& tmxFile)
@@ -114,6 +454,18 @@ TMXMapInfo * TMXMapInfo::create(const std::string& tmxFile)
     return nullptr;
 }
 
+TMXMapInfo * TMXMapInfo::createWithBinaryFile(const std::string& binaryFile)
+{
+    TMXMapInfo *ret = new (std::nothrow) TMXMapInfo();
+    if (ret->initWithBinaryFile(binaryFile))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
 TMXMapInfo * TMXMapInfo::createWithXML(const std::string& tmxString, const std::string& resourcePath)
 {
     TMXMapInfo *ret = new (std::nothrow) TMXMapInfo();
@@ -156,8 +508,307 @@ bool TMXMapInfo::initWithXML(const std::string& tmxString, const std::string& re
 
 bool TMXMapInfo::initWithTMXFile(const std::string& tmxFile)
 {
+    if (isBinaryMapFile(tmxFile))
+    {
+        return initWithBinaryFile(tmxFile);
+    }
+
     internalInit(tmxFile, "");
-    return parseXMLFile(_TMXFileName.c_str());
+    if (!s_binaryCacheEnabled)
+    {
+        return parseXMLFile(_TMXFileName.c_str());
+    }
+
+    auto fileUtils = FileUtils::getInstance();
+    Data tmxData = fileUtils->getDataFromFile(_TMXFileName);
+    if (tmxData.isNull())
+    {
+        return false;
+    }
+
+    auto sourceSize = static_cast<uint32_t>(tmxData.getSize());
+    auto sourceHash = XXH32(tmxData.getBytes(), static_cast<int>(tmxData.getSize()), 0);
+    std::string cachePath = getBinaryCachePath(_TMXFileName);
+    if (fileUtils->isFileExist(cachePath)
+        && readBinaryData(fileUtils->getDataFromFile(cachePath), true, sourceSize, sourceHash))
+    {
+        return true;
+    }
+
+    if (!parseXMLString(std::string(reinterpret_cast<const char*>(tmxData.getBytes()), tmxData.getSize())))
+    {
+        return false;
+    }
+
+    fileUtils->createDirectory(fileUtils->getWritablePath() + BINARY_CACHE_DIRECTORY);
+    if (!writeBinaryFile(cachePath, sourceSize, sourceHash))
+    {
+        CCLOG("cocos2d: TMXMapInfo: failed to write the binary cache of %s", _TMXFileName.c_str());
+    }
+    return true;
+}
+
+bool TMXMapInfo::initWithBinaryFile(const std::string& binaryFile)
+{
+    internalInit(binaryFile, "");
+    return readBinaryData(FileUtils::getInstance()->getDataFromFile(_TMXFileName), false, 0, 0);
+}
+
+bool TMXMapInfo::saveBinaryFile(const std::string& fullPath) const
+{
+    return writeBinaryFile(fullPath, 0, 0);
+}
+
+void TMXMapInfo::setBinaryCacheEnabled(bool enabled)
+{
+    s_binaryCacheEnabled = enabled;
+}
+
+bool TMXMapInfo::isBinaryCacheEnabled()
+{
+    return s_binaryCacheEnabled;
+}
+
+bool TMXMapInfo::writeBinaryFile(const std::string& fullPath, uint32_t sourceSize, uint32_t sourceHash) const
+{
+    BinaryMapWriter writer;
+    writer.writeBytes(BINARY_MAP_MAGIC, sizeof(BINARY_MAP_MAGIC));
+    writer.write<uint32_t>(BINARY_MAP_VERSION);
+    writer.write<uint32_t>(sourceSize);
+    writer.write<uint32_t>(sourceHash);
+
+    // the external tilesets are part of the source of the cache
+    writer.write<uint32_t>(static_cast<uint32_t>(_tilesetFiles.size()));
+    for (const auto& tilesetFile : _tilesetFiles)
+    {
+        uint32_t tilesetSize = 0;
+        uint32_t tilesetHash = 0;
+        getSourceSignature(tilesetFile, tilesetSize, tilesetHash);
+        writer.writeString(tilesetFile);
+        writer.write<uint32_t>(tilesetSize);
+        writer.write<uint32_t>(tilesetHash);
+    }
+
+    writer.write<int32_t>(_orientation);
+    writer.writeSize(_mapSize);
+    writer.writeSize(_tileSize);
+    writer.writeValueMap(_properties);
+    writer.writeIntKeyMap(_tileProperties);
+
+    writer.write<uint32_t>(static_cast<uint32_t>(_tilesets.size()));
+    for (const auto& tileset : _tilesets)
+    {
+        writer.writeString(tileset->_name);
+        writer.write<int32_t>(tileset->_firstGid);
+        writer.writeSize(tileset->_tileSize);
+        writer.write<int32_t>(tileset->_spacing);
+        writer.write<int32_t>(tileset->_margin);
+        // the full path of the image is rebuilt from the location of the loaded file
+        writer.writeString(tileset->_originSourceImage);
+        writer.writeSize(tileset->_imageSize);
+    }
+
+    writer.write<uint32_t>(static_cast<uint32_t>(_layers.size()));
+    for (const auto& layer : _layers)
+    {
+        writer.writeString(layer->_name);
+        writer.writeSize(layer->_layerSize);
+        writer.write<uint8_t>(layer->_visible ? 1 : 0);
+        writer.write<uint8_t>(layer->_opacity);
+        writer.writeVec2(layer->_offset);
+        writer.writeValueMap(layer->_properties);
+
+        uint32_t tileCount = layer->_tiles ? static_cast<uint32_t>(layer->_layerSize.width * layer->_layerSize.height) : 0;
+        writer.write<uint32_t>(tileCount);
+        writer.writeBytes(layer->_tiles, tileCount * sizeof(uint32_t));
+    }
+
+    writer.write<uint32_t>(static_cast<uint32_t>(_objectGroups.size()));
+    for (const auto& objectGroup : _objectGroups)
+    {
+        writer.writeString(objectGroup->getGroupName());
+        writer.writeVec2(objectGroup->getPositionOffset());
+        writer.writeValueMap(objectGroup->getProperties());
+        writer.writeValueVector(objectGroup->getObjects());
+    }
+
+    const auto& buffer = writer.getBuffer();
+    Data data;
+    data.copy(buffer.data(), buffer.size());
+    return FileUtils::getInstance()->writeDataToFile(data, fullPath);
+}
+
+bool TMXMapInfo::readBinaryData(const Data& data, bool checkSource, uint32_t sourceSize, uint32_t sourceHash)
+{
+    if (data.isNull())
+    {
+        return false;
+    }
+
+    BinaryMapReader reader(data);
+    auto magic = reader.skip(sizeof(BINARY_MAP_MAGIC));
+    uint32_t version = 0;
+    uint32_t fileSourceSize = 0;
+    uint32_t fileSourceHash = 0;
+    if (!magic || memcmp(magic, BINARY_MAP_MAGIC, sizeof(BINARY_MAP_MAGIC)) != 0
+        || !reader.read(version) || version != BINARY_MAP_VERSION
+        || !reader.read(fileSourceSize) || !reader.read(fileSourceHash))
+    {
+        CCLOG("cocos2d: TMXMapInfo: %s is not a binary map", _TMXFileName.c_str());
+        return false;
+    }
+    if (checkSource && (fileSourceSize != sourceSize || fileSourceHash != sourceHash))
+    {
+        return false;
+    }
+
+    uint32_t count = 0;
+    std::vector<std::string> tilesetFiles;
+    if (!reader.read(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        std::string tilesetFile;
+        uint32_t tilesetSize = 0;
+        uint32_t tilesetHash = 0;
+        if (!reader.readString(tilesetFile) || !reader.read(tilesetSize) || !reader.read(tilesetHash))
+        {
+            return false;
+        }
+        if (checkSource)
+        {
+            uint32_t currentSize = 0;
+            uint32_t currentHash = 0;
+            getSourceSignature(tilesetFile, currentSize, currentHash);
+            if (currentSize != tilesetSize || currentHash != tilesetHash)
+            {
+                return false;
+            }
+        }
+        tilesetFiles.push_back(tilesetFile);
+    }
+
+    std::string dir;
+    size_t pos = _TMXFileName.find_last_of("/");
+    if (pos != std::string::npos)
+    {
+        dir = _TMXFileName.substr(0, pos + 1);
+    }
+
+    // everything is read in locals so that a truncated file leaves the map info untouched
+    int32_t orientation = 0;
+    Size mapSize;
+    Size tileSize;
+    ValueMap properties;
+    ValueMapIntKey tileProperties;
+    if (!reader.read(orientation) || !reader.readSize(mapSize) || !reader.readSize(tileSize)
+        || !reader.readValueMap(properties) || !reader.readIntKeyMap(tileProperties))
+    {
+        return false;
+    }
+
+    Vector<TMXTilesetInfo*> tilesets;
+    if (!reader.read(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto tileset = new (std::nothrow) TMXTilesetInfo();
+        tilesets.pushBack(tileset);
+        tileset->release();
+
+        int32_t firstGid = 0;
+        if (!reader.readString(tileset->_name) || !reader.read(firstGid) || !reader.readSize(tileset->_tileSize)
+            || !reader.read(tileset->_spacing) || !reader.read(tileset->_margin)
+            || !reader.readString(tileset->_originSourceImage) || !reader.readSize(tileset->_imageSize))
+        {
+            return false;
+        }
+        tileset->_firstGid = firstGid;
+        if (!tileset->_originSourceImage.empty())
+        {
+            tileset->_sourceImage = dir + tileset->_originSourceImage;
+        }
+    }
+
+    Vector<TMXLayerInfo*> layers;
+    if (!reader.read(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto layer = new (std::nothrow) TMXLayerInfo();
+        layers.pushBack(layer);
+        layer->release();
+
+        uint8_t visible = 0;
+        uint32_t tileCount = 0;
+        if (!reader.readString(layer->_name) || !reader.readSize(layer->_layerSize)
+            || !reader.read(visible) || !reader.read(layer->_opacity) || !reader.readVec2(layer->_offset)
+            || !reader.readValueMap(layer->_properties) || !reader.read(tileCount))
+        {
+            return false;
+        }
+        layer->_visible = visible != 0;
+
+        // a stale or corrupted cache would make the layers read and write past the tiles
+        if (tileCount > 0 && (layer->_layerSize.width <= 0 || layer->_layerSize.height <= 0
+            || layer->_layerSize.width > tileCount || layer->_layerSize.height > tileCount
+            || static_cast<uint64_t>(layer->_layerSize.width) * static_cast<uint64_t>(layer->_layerSize.height) != tileCount))
+        {
+            CCLOG("cocos2d: TMXMapInfo: the tile count of layer %s doesn't match its size in %s", layer->_name.c_str(), _TMXFileName.c_str());
+            return false;
+        }
+
+        if (tileCount > 0)
+        {
+            auto tiles = reader.skip(tileCount * sizeof(uint32_t));
+            if (!tiles)
+            {
+                return false;
+            }
+            // the layers take ownership of the tiles and modify them
+            layer->_tiles = (uint32_t*) malloc(tileCount * sizeof(uint32_t));
+            memcpy(layer->_tiles, tiles, tileCount * sizeof(uint32_t));
+        }
+    }
+
+    Vector<TMXObjectGroup*> objectGroups;
+    if (!reader.read(count))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto objectGroup = new (std::nothrow) TMXObjectGroup();
+        objectGroups.pushBack(objectGroup);
+        objectGroup->release();
+
+        std::string groupName;
+        Vec2 positionOffset;
+        if (!reader.readString(groupName) || !reader.readVec2(positionOffset)
+            || !reader.readValueMap(objectGroup->getProperties()) || !reader.readValueVector(objectGroup->getObjects()))
+        {
+            return false;
+        }
+        objectGroup->setGroupName(groupName);
+        objectGroup->setPositionOffset(positionOffset);
+    }
+
+    _orientation = orientation;
+    _mapSize = mapSize;
+    _tileSize = tileSize;
+    _properties = std::move(properties);
+    _tileProperties = std::move(tileProperties);
+    _tilesets = tilesets;
+    _layers = layers;
+    _objectGroups = objectGroups;
+    _tilesetFiles = std::move(tilesetFiles);
+    return true;
 }
 
 TMXMapInfo::TMXMapInfo()
@@ -287,6 +938,7 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
             }
             _recordFirstGID = false;
             
+            _tilesetFiles.push_back(externalTilesetFilename);
             tmxMapInfo->parseXMLFile(externalTilesetFilename.c_str());
         }
         else
@@ -38,11 +38,13 @@ THE SOFTWARE.
 #include "2d/CCTMXObjectGroup.h" // needed for Vector<TMXObjectGroup*> for binding
 
 #include <string>
+#include <vector>
 
 NS_CC_BEGIN
 
 class TMXLayerInfo;
 class TMXTilesetInfo;
+class Data;
 
 /** @file
 * Internal TMX parser
@@ -175,6 +177,9 @@ public:
     /** creates a TMX Format with an XML string and a TMX resource path */
     static TMXMapInfo * createWithXML(const std::string& tmxString, const std::string& resourcePath);
     
+    /** creates a TMX Format from a binary map written by saveBinaryFile() */
+    static TMXMapInfo * createWithBinaryFile(const std::string& binaryFile);
+
     /** creates a TMX Format with a tmx file */
     CC_DEPRECATED_ATTRIBUTE static TMXMapInfo * formatWithTMXFile(const char *tmxFile) { return TMXMapInfo::create(tmxFile); };
     /** creates a TMX Format with an XML string and a TMX resource path */
@@ -197,6 +202,23 @@ public:
     bool parseXMLFile(const std::string& xmlFilename);
     /* initializes parsing of an XML string, either a tmx (Map) string or tsx (Tileset) string */
     bool parseXMLString(const std::string& xmlString);
+    /** initializes a TMX format with a binary map written by saveBinaryFile().
+     Image sources are resolved relative to the directory of the binary file.
+     */
+    bool initWithBinaryFile(const std::string& binaryFile);
+
+    /** Writes the parsed map (tilesets, layers with their decoded tiles, object groups and properties)
+     in a binary format that loads without XML parsing nor base64/zlib decoding.
+     Files with the ".tmxb" extension passed to create() are loaded as binary maps.
+     */
+    bool saveBinaryFile(const std::string& fullPath) const;
+
+    /** When enabled, initWithTMXFile() keeps a binary copy of every parsed map in the writable path
+     and loads it instead of the tmx file as long as the content of the tmx file and of its external tsx files doesn't change.
+     The size of the tileset images is taken from their textures, it doesn't have to be checked. Disabled by default.
+     */
+    static void setBinaryCacheEnabled(bool enabled);
+    static bool isBinaryCacheEnabled();
 
     ValueMapIntKey& getTileProperties() { return _tileProperties; };
     void setTileProperties(const ValueMapIntKey& tileProperties) {
@@ -285,6 +307,8 @@ public:
 
 protected:
     void internalInit(const std::string& tmxFileName, const std::string& resourcePath);
+    bool writeBinaryFile(const std::string& fullPath, uint32_t sourceSize, uint32_t sourceHash) const;
+    bool readBinaryData(const Data& data, bool checkSource, uint32_t sourceSize, uint32_t sourceHash);
 
     /// map orientation
     int    _orientation;
@@ -322,6 +346,8 @@ protected:
     int _currentFirstGID;
     bool _recordFirstGID;
     std::string _externalTilesetFilename;
+    // full paths of the external tilesets, a binary cache is stale when one of them changes
+    std::vector<std::string> _tilesetFiles;
 };
 
 // end of tilemap_parallax_nodes group
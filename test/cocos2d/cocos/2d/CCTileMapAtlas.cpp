@@ -165,6 +165,7 @@ Color3B TileMapAtlas::getTileAt(const Vec2& position) const
 void TileMapAtlas::updateAtlasValueAt(const Vec2& pos, const Color3B& value, int index)
 {
     CCASSERT( index >= 0 && index < _textureAtlas->getCapacity(), "updateAtlasValueAt: Invalid index");
+    invalidateCachedAncestors();
 
     V3F_C4B_T2F_Quad* quad = &((_textureAtlas->getQuads())[index]);
 
@@ -0,0 +1,258 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/CCTransformSystem.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "2d/CCNode.h"
+
+NS_CC_BEGIN
+
+TransformSystem* TransformSystem::s_runningSystem = nullptr;
+
+// the arrays are packed again when at least that many slots and half of them are free
+static const size_t MIN_PACKED_SLOTS = 64;
+
+TransformSystem* TransformSystem::create()
+{
+    auto ret = new (std::nothrow) TransformSystem();
+    if (ret)
+    {
+        ret->autorelease();
+    }
+    return ret;
+}
+
+TransformSystem::TransformSystem()
+: _root(nullptr)
+, _frame(0)
+, _updatedCount(0)
+, _freeCount(0)
+, _firstDirty(0)
+{
+}
+
+TransformSystem::~TransformSystem()
+{
+    if (s_runningSystem == this)
+    {
+        s_runningSystem = nullptr;
+    }
+    reset();
+}
+
+void TransformSystem::reset()
+{
+    // the nodes of the slots are alive, the destroyed ones released theirs
+    for (auto node : _nodes)
+    {
+        if (node)
+        {
+            node->_transformSystem = nullptr;
+            node->_transformSystemIndex = -1;
+        }
+    }
+    _root = nullptr;
+    _freeCount = 0;
+    _firstDirty = 0;
+    _nodes.clear();
+    _parents.clear();
+    _localTransforms.clear();
+    _worldTransforms.clear();
+    _localDirty.clear();
+    _updateFrames.clear();
+}
+
+void TransformSystem::rebuild(Node* root)
+{
+    reset();
+    _root = root;
+    appendSubtree(root, -1);
+}
+
+void TransformSystem::appendSubtree(Node* node, int parent)
+{
+    _firstDirty = std::min(_firstDirty, _nodes.size());
+
+    // breadth first, so that the nodes are stored by depth and the parents before their children
+    _queue.clear();
+    _queue.push_back(node);
+    for (size_t i = 0; i < _queue.size(); ++i)
+    {
+        Node* current = _queue[i];
+        if (current->_transformSystem)
+        {
+            current->_transformSystem->releaseNode(current);
+        }
+
+        current->_transformSystem = this;
+        current->_transformSystemIndex = static_cast<int>(_nodes.size());
+        _nodes.push_back(current);
+        _parents.push_back(i == 0 ? parent : current->_parent->_transformSystemIndex);
+        _localTransforms.push_back(Mat4::IDENTITY);
+        _worldTransforms.push_back(Mat4::IDENTITY);
+        _localDirty.push_back(1);
+        _updateFrames.push_back(0);
+
+        for (const auto& child : current->getChildren())
+        {
+            _queue.push_back(child);
+        }
+    }
+    _queue.clear();
+}
+
+void TransformSystem::attachNode(Node* node)
+{
+    CCASSERT(node->_parent && node->_parent->_transformSystem == this, "the parent of node must own a slot");
+    appendSubtree(node, node->_parent->_transformSystemIndex);
+}
+
+void TransformSystem::releaseNode(Node* node)
+{
+    if (node->_transformSystem != this)
+        return;
+
+    int index = node->_transformSystemIndex;
+    _nodes[index] = nullptr;
+    _localDirty[index] = 0;
+    _firstDirty = std::min(_firstDirty, static_cast<size_t>(index));
+    ++_freeCount;
+    node->_transformSystem = nullptr;
+    node->_transformSystemIndex = -1;
+    if (node == _root)
+    {
+        _root = nullptr;
+    }
+
+    for (const auto& child : node->getChildren())
+    {
+        releaseNode(child);
+    }
+}
+
+void TransformSystem::begin(Node* root, const Mat4& rootTransform)
+{
+    CCASSERT(root, "root can't be nullptr");
+
+    bool rootChanged = false;
+    if (root != _root || root->_transformSystem != this
+        || (_freeCount >= MIN_PACKED_SLOTS && _freeCount * 2 >= _nodes.size()))
+    {
+        rebuild(root);
+        rootChanged = true;
+    }
+    else if (memcmp(&rootTransform, &_rootTransform, sizeof(Mat4)) != 0)
+    {
+        rootChanged = true;
+    }
+    _rootTransform = rootTransform;
+
+    ++_frame;
+    _updatedCount = 0;
+
+    // one linear pass over the arrays, the parents are updated before their children
+    size_t count = _nodes.size();
+    size_t first = rootChanged ? 0 : _firstDirty;
+    for (size_t i = first; i < count; ++i)
+    {
+        Node* node = _nodes[i];
+        if (!node)
+            continue;
+
+        int parent = _parents[i];
+        if (parent >= 0 && !_nodes[parent])
+        {
+            // the parent was released without the node, which isn't one of its children (a protected child for instance)
+            releaseNode(node);
+            continue;
+        }
+
+        bool parentChanged = parent < 0 ? rootChanged : _updateFrames[parent] == _frame;
+        if (_localDirty[i])
+        {
+            // reading a dirty transform flags the slot again
+            _localTransforms[i] = node->getNodeToParentTransform();
+            _localDirty[i] = 0;
+        }
+        else if (!parentChanged)
+        {
+            continue;
+        }
+
+        const Mat4& parentWorld = parent < 0 ? _rootTransform : _worldTransforms[parent];
+        Mat4::multiply(parentWorld, _localTransforms[i], &_worldTransforms[i]);
+        _updateFrames[i] = _frame;
+        ++_updatedCount;
+    }
+    _firstDirty = count;
+
+    s_runningSystem = this;
+}
+
+void TransformSystem::end()
+{
+    if (s_runningSystem == this)
+    {
+        s_runningSystem = nullptr;
+    }
+}
+
+bool TransformSystem::applyWorldTransform(Node* node, const Mat4& parentTransform) const
+{
+    if (node->_transformSystem != this || !_root)
+        return false;
+
+    // changed after begin(), by the visit of its parent for instance
+    int index = node->_transformSystemIndex;
+    if (_localDirty[index])
+        return false;
+
+    // changed without the setters of Node (a subclass writing _transformUpdated directly), the system didn't see it
+    if (node->_transformUpdated && _updateFrames[index] != _frame)
+        return false;
+
+    // the transform is only valid if the node is visited with the transform its parent got from the system
+    int parent = _parents[index];
+    if (parent < 0)
+    {
+        if (memcmp(&parentTransform, &_rootTransform, sizeof(Mat4)) != 0)
+            return false;
+    }
+    else
+    {
+        auto parentNode = _nodes[parent];
+        if (parentNode != node->_parent || !parentNode->_transformSystemApplied || &parentTransform != &parentNode->_modelViewTransform)
+            return false;
+    }
+
+    node->_modelViewTransform = _worldTransforms[index];
+    node->_transformSystemApplied = true;
+    return true;
+}
+
+NS_CC_END
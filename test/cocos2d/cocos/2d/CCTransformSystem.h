@@ -0,0 +1,140 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CCTRANSFORMSYSTEM_H__
+#define __CCTRANSFORMSYSTEM_H__
+
+#include <vector>
+
+#include "base/CCRef.h"
+#include "math/CCMath.h"
+
+NS_CC_BEGIN
+
+class Node;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** @class TransformSystem
+ * @brief Computes the world transforms of a node hierarchy in one linear pass over contiguous arrays before it is visited.
+ *
+ * The local and world matrices of the nodes are stored in arrays ordered by depth, a parent always before its children.
+ * Node::setParent() appends the slots of an added subtree and frees the ones of a removed subtree, the arrays are packed
+ * again in depth order when half of the slots are free. The transform setters of Node and Node::getNodeToParentTransform()
+ * flag the slot of the node, begin() then walks the arrays once from the first flagged slot, reading again the local
+ * transform of the flagged nodes and multiplying the world transform of the nodes whose local transform or parent changed.
+ * Node::visit() copies the result instead of multiplying it, for the nodes it would compute again.
+ * Nodes that are visited with a transform the system doesn't know (custom visit, transform changed after begin()
+ * or by a subclass without the setters...) fall back to the usual computation, so the result is the same with or without it.
+ * It is enabled per scene with Scene::setTransformSystemEnabled().
+ */
+class CC_DLL TransformSystem : public Ref
+{
+public:
+    /** Creates a transform system. */
+    static TransformSystem* create();
+
+    /** Returns the system which is computing the transforms of the scene being rendered, nullptr if there is none. */
+    static TransformSystem* getRunningSystem() { return s_runningSystem; }
+
+    /** Updates the world transforms of the changed nodes of the hierarchy of root, and makes the system the running one until end().
+     @param root the root of the hierarchy, usually the scene.
+     @param rootTransform the transform root is visited with.
+     */
+    void begin(Node* root, const Mat4& rootTransform);
+
+    /** Stops using the system for the nodes visited afterwards. */
+    void end();
+
+    /** Sets the model view transform of a node being visited with parentTransform from the computed arrays.
+     Returns false if the node is not part of the hierarchy or its transform can't be used.
+     */
+    bool applyWorldTransform(Node* node, const Mat4& parentTransform) const;
+
+    /** Gives slots to a node just added to a parent of the hierarchy, and to its descendants. */
+    void attachNode(Node* node);
+
+    /** Frees the slots of a node and of its descendants, called when it is removed from its parent or destroyed. */
+    void releaseNode(Node* node);
+
+    /** Number of nodes which own a slot in the arrays. */
+    size_t getNodeCount() const { return _nodes.size() - _freeCount; }
+
+    /** Number of world transforms computed by the last begin(). */
+    size_t getUpdatedNodeCount() const { return _updatedCount; }
+
+CC_CONSTRUCTOR_ACCESS:
+    TransformSystem();
+    virtual ~TransformSystem();
+
+protected:
+    void reset();
+    void rebuild(Node* root);
+    // appends the slots of node and its descendants, breadth first
+    void appendSubtree(Node* node, int parent);
+
+    // called by Node when the local transform of the node of the slot changes
+    void markDirty(int index)
+    {
+        _localDirty[index] = 1;
+        if (static_cast<size_t>(index) < _firstDirty)
+        {
+            _firstDirty = index;
+        }
+    }
+
+    Node* _root;                        // weak reference
+    unsigned int _frame;
+    size_t _updatedCount;
+    size_t _freeCount;
+    // slots before it have neither their local transform nor their parent changed
+    size_t _firstDirty;
+
+    std::vector<Node*> _nodes;          // weak references, nullptr for the free slots
+    std::vector<int> _parents;          // slot of the parent, -1 for the root
+    std::vector<Mat4> _localTransforms;
+    std::vector<Mat4> _worldTransforms;
+    std::vector<unsigned char> _localDirty;     // whether or not the local transform of the slot has to be read again
+    std::vector<unsigned int> _updateFrames;    // frame of the last update of the world transform of every slot
+    std::vector<Node*> _queue;          // breadth first traversal of appendSubtree
+    Mat4 _rootTransform;
+
+    static TransformSystem* s_runningSystem;
+
+    friend class Node;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(TransformSystem);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CCTRANSFORMSYSTEM_H__
@@ -11,12 +11,14 @@ CCAABB.cpp \
 CCOBB.cpp \
 CCAnimate3D.cpp \
 CCAnimation3D.cpp \
+CCAnimation3DSampler.cpp \
 CCAttachNode.cpp \
 CCBillBoard.cpp \
 CCBundle3D.cpp \
 CCBundleReader.cpp \
 CCMesh.cpp \
 CCMeshSkin.cpp \
+CCMeshSimplifier.cpp \
 CCMeshVertexIndexData.cpp \
 CCMotionStreak3D.cpp \
 CCSprite3DMaterial.cpp \
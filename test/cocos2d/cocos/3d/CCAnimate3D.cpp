@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include "3d/CCAnimate3D.h"
+#include "3d/CCAnimation3DSampler.h"
 #include "3d/CCSprite3D.h"
 #include "3d/CCSkeleton3D.h"
 #include "platform/CCFileUtils.h"
@@ -153,6 +154,9 @@ void Animate3D::startWithTarget(Node *target)
     {
         _boneCurves.clear();
         _nodeCurves.clear();
+        _sampledBones.clear();
+        _sampledTracks.clear();
+        _sampledKeys.clear();
         
         bool hasCurve = false;
         Sprite3D* sprite = dynamic_cast<Sprite3D*>(target);
@@ -162,8 +166,11 @@ void Animate3D::startWithTarget(Node *target)
             if (_animation)
             {
                 const std::unordered_map<std::string, Animation3D::Curve*>& boneCurves = _animation->getBoneCurves();
+                // the packed curves are stored in the iteration order of the bone curves
+                int track = -1;
                 for (const auto& iter: boneCurves)
                 {
+                    track++;
                     const std::string& boneName = iter.first;
                     auto skin = sprite->getSkeleton();
                     if(skin)
@@ -173,6 +180,8 @@ void Animate3D::startWithTarget(Node *target)
                         {
                             auto curve = _animation->getBoneCurveByName(boneName);
                             _boneCurves[bone] = curve;
+                            _sampledBones.push_back(bone);
+                            _sampledTracks.push_back(track);
                             hasCurve = true;
                         }
                         else
@@ -222,6 +231,8 @@ void Animate3D::startWithTarget(Node *target)
             }
         }
         
+        _sampledKeys.resize(_sampledBones.size() * 3, 0);
+        
         if (!hasCurve)
         {
             CCLOG("warning: no animation found for the skeleton");
@@ -283,6 +294,16 @@ void Animate3D::step(float dt)
     ActionInterval::step(dt);
 }
 
+static bool isDeeperThan(Bone3D* bone, int depth)
+{
+    for (auto parent = bone->getParentBone(); parent; parent = parent->getParentBone())
+    {
+        if (--depth < 0)
+            return true;
+    }
+    return false;
+}
+
 bool cmpEventInfoAsc(Animate3D::Animate3DDisplayedEventInfo* info1, Animate3D::Animate3DDisplayedEventInfo* info2)
 {
     return info1->frame < info2->frame;
@@ -343,49 +364,71 @@ void Animate3D::update(float t)
                 t = _start + t * _last;
                 lastTime = _start + lastTime * _last;
                 
-                for (const auto& it : _boneCurves) {
-                    auto bone = it.first;
-                    auto curve = it.second;
-                    if (curve->translateCurve)
-                    {
-                        curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
-                        trans = &transDst[0];
-                    }
-                    if (curve->rotCurve)
-                    {
-                        curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
-                        rot = &rotDst[0];
-                    }
-                    if (curve->scaleCurve)
-                    {
-                        curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
-                        scale = &scaleDst[0];
+                // the level of detail of the sprite may skip the evaluation of this frame, or of the deepest bones
+                int maxBoneDepth = -1;
+                bool evaluate = _boneCurves.empty() || static_cast<Sprite3D*>(_target)->checkAnimationLOD(&maxBoneDepth);
+                
+                auto sampler = Animation3DSampler::getInstance();
+                bool batched = evaluate && maxBoneDepth < 0 && sampler->isEnabled() && !_sampledBones.empty() && _sampledBones.size() == _boneCurves.size()
+                    && _translateEvaluate != EvaluateType::INT_USER_FUNCTION && _roteEvaluate != EvaluateType::INT_USER_FUNCTION && _scaleEvaluate != EvaluateType::INT_USER_FUNCTION;
+                if (batched)
+                {
+                    // the bones are set after the scheduler update, with the bones of the other animates
+                    sampler->addJob(this, t);
+                }
+                else if (evaluate)
+                {
+                    for (const auto& it : _boneCurves) {
+                        auto bone = it.first;
+                        auto curve = it.second;
+                        if (maxBoneDepth >= 0 && isDeeperThan(bone, maxBoneDepth))
+                            continue;
+                        // a channel without curve must not get the value of the previous bone
+                        trans = rot = scale = nullptr;
+                        if (curve->translateCurve)
+                        {
+                            curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
+                            trans = &transDst[0];
+                        }
+                        if (curve->rotCurve)
+                        {
+                            curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
+                            rot = &rotDst[0];
+                        }
+                        if (curve->scaleCurve)
+                        {
+                            curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
+                            scale = &scaleDst[0];
+                        }
+                        bone->setAnimationValue(trans, rot, scale, this, _weight);
                     }
-                    bone->setAnimationValue(trans, rot, scale, this, _weight);
                 }
                 
-                for (const auto& it : _nodeCurves)
+                if (evaluate)
                 {
-                    auto node = it.first;
-                    auto curve = it.second;
-                    Mat4 transform;
-                    if (curve->translateCurve)
-                    {
-                        curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
-                        transform.translate(transDst[0], transDst[1], transDst[2]);
-                    }
-                    if (curve->rotCurve)
+                    for (const auto& it : _nodeCurves)
                     {
-                        curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
-                        Quaternion qua(rotDst[0], rotDst[1], rotDst[2], rotDst[3]);
-                        transform.rotate(qua);
-                    }
-                    if (curve->scaleCurve)
-                    {
-                        curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
-                        transform.scale(scaleDst[0], scaleDst[1], scaleDst[2]);
+                        auto node = it.first;
+                        auto curve = it.second;
+                        Mat4 transform;
+                        if (curve->translateCurve)
+                        {
+                            curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
+                            transform.translate(transDst[0], transDst[1], transDst[2]);
+                        }
+                        if (curve->rotCurve)
+                        {
+                            curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
+                            Quaternion qua(rotDst[0], rotDst[1], rotDst[2], rotDst[3]);
+                            transform.rotate(qua);
+                        }
+                        if (curve->scaleCurve)
+                        {
+                            curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
+                            transform.scale(scaleDst[0], scaleDst[1], scaleDst[2]);
+                        }
+                        node->setAdditionalTransform(&transform);
                     }
-                    node->setAdditionalTransform(&transform);
                 }
                 if (!_keyFrameUserInfos.empty()){
                     float prekeyTime = lastTime * getDuration() * _frameRate;
@@ -175,6 +175,12 @@ protected:
     std::unordered_map<Bone3D*, Animation3D::Curve*> _boneCurves; //weak ref
     std::unordered_map<Node*, Animation3D::Curve*> _nodeCurves;
     
+    // bones of _boneCurves and their index in _animation->getPackedCurves(), sampled by Animation3DSampler
+    std::vector<Bone3D*> _sampledBones; //weak ref
+    std::vector<int> _sampledTracks;
+    // last key found in the translation, rotation and scale channels of each sampled bone
+    std::vector<int> _sampledKeys;
+    
     std::unordered_map<int, ValueMap> _keyFrameUserInfos;
     std::unordered_map<int, EventCustom*> _keyFrameEvent;
     std::unordered_map<int, Animate3DDisplayedEventInfo> _displayedEventInfo;
@@ -183,6 +189,8 @@ protected:
     static std::unordered_map<Node*, Animate3D*> s_fadeInAnimates;
     static std::unordered_map<Node*, Animate3D*> s_fadeOutAnimates;
     static std::unordered_map<Node*, Animate3D*> s_runningAnimates;
+    
+    friend class Animation3DSampler;
 };
 
 // end of 3d group
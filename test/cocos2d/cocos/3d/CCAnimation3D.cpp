@@ -105,6 +105,20 @@ Animation3D::Curve::~Curve()
     CC_SAFE_RELEASE_NULL(scaleCurve);
 }
 
+template <int componentSize>
+static void packCurve(const AnimationCurve<componentSize>* curve, std::vector<Animation3D::PackedCurves::Range>& ranges, std::vector<float>& times, std::vector<float>& values)
+{
+    Animation3D::PackedCurves::Range range;
+    range.offset = static_cast<int>(times.size());
+    range.count = curve ? curve->getKeyCount() : 0;
+    if (range.count)
+    {
+        times.insert(times.end(), curve->getKeyTimes(), curve->getKeyTimes() + range.count);
+        values.insert(values.end(), curve->getKeyValues(), curve->getKeyValues() + range.count * componentSize);
+    }
+    ranges.push_back(range);
+}
+
 bool Animation3D::init(const Animation3DData &data)
 {
     _duration = data._totalTime;
@@ -182,6 +196,14 @@ bool Animation3D::init(const Animation3DData &data)
         if(curve->scaleCurve) curve->scaleCurve->retain();
     }
     
+    for (const auto& iter : _boneCurves)
+    {
+        auto curve = iter.second;
+        packCurve(curve->translateCurve, _packedCurves.translateRanges, _packedCurves.translateTimes, _packedCurves.translateValues);
+        packCurve(curve->rotCurve, _packedCurves.rotRanges, _packedCurves.rotTimes, _packedCurves.rotValues);
+        packCurve(curve->scaleCurve, _packedCurves.scaleRanges, _packedCurves.scaleTimes, _packedCurves.scaleValues);
+    }
+    
     return true;
 }
 
@@ -86,6 +86,38 @@ public:
     /**get the bone Curves set*/
     const std::unordered_map<std::string, Curve*>& getBoneCurves() const {return _boneCurves;}
     
+    /**
+     * keys of all the bone curves packed in contiguous arrays, one set of arrays per channel, used by Animation3DSampler
+     */
+    struct PackedCurves
+    {
+        /**keys of a channel of one bone, count is 0 if the bone has no curve for this channel*/
+        struct Range
+        {
+            int offset;
+            int count;
+        };
+        /**one range per bone, in the iteration order of getBoneCurves()*/
+        std::vector<Range> translateRanges;
+        std::vector<Range> rotRanges;
+        std::vector<Range> scaleRanges;
+        /**key times, between 0 and 1*/
+        std::vector<float> translateTimes;
+        std::vector<float> rotTimes;
+        std::vector<float> scaleTimes;
+        /**key values, 3 floats per translation and scale key, 4 per rotation key*/
+        std::vector<float> translateValues;
+        std::vector<float> rotValues;
+        std::vector<float> scaleValues;
+    };
+    
+    /**
+     * get the packed curves
+     *
+     * @lua NA
+     */
+    const PackedCurves& getPackedCurves() const { return _packedCurves; }
+    
 CC_CONSTRUCTOR_ACCESS:
     Animation3D();
     virtual ~Animation3D();  
@@ -97,6 +129,7 @@ CC_CONSTRUCTOR_ACCESS:
     
 protected:
     std::unordered_map<std::string, Curve*> _boneCurves;//bone curves map, key bone name, value AnimationCurve
+    PackedCurves _packedCurves;//copy of the keys of _boneCurves in contiguous arrays
 
     float _duration; //animation duration
 };
@@ -0,0 +1,560 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+
+#include "3d/CCAnimation3DSampler.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#include "3d/CCAnimate3D.h"
+#include "3d/CCAnimation3D.h"
+#include "3d/CCSkeleton3D.h"
+#include "base/CCDirector.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+
+//#define INCLUDE_NEON  : neon code included, only when the compiler targets it
+//#define INCLUDE_SSE2  : sse2 code included
+
+#if defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (__arm64__) || defined (__aarch64__)
+#define INCLUDE_NEON
+#include <arm_neon.h>
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INCLUDE_SSE2
+#include <emmintrin.h>
+#endif
+
+NS_CC_BEGIN
+
+namespace
+{
+    enum SampledChannel
+    {
+        CHANNEL_TRANSLATE = 1,
+        CHANNEL_ROTATE = 2,
+        CHANNEL_SCALE = 4,
+    };
+
+    const int MAX_THREADS = 3;
+
+    // Finds the keys around time, from the key found by the previous sample of the channel.
+    // Returns the first key, next is set to the second one and factor to the interpolation between them.
+    // Out of the key range, both keys are the first or last one, like AnimationCurve::evaluate does.
+    int findKeys(const float* times, int count, float time, int& cursor, int& next, float& factor)
+    {
+        factor = 0.f;
+        if (count == 1 || time <= times[0])
+        {
+            next = 0;
+            return 0;
+        }
+        if (time >= times[count - 1])
+        {
+            next = count - 1;
+            return count - 1;
+        }
+
+        int index = cursor;
+        if (index < 0 || index >= count - 1 || time < times[index])
+        {
+            // the animation looped or jumped, binary search like AnimationCurve::determineIndex
+            int low = 0;
+            int high = count - 2;
+            while (low < high)
+            {
+                int mid = (low + high + 1) >> 1;
+                if (times[mid] <= time)
+                    low = mid;
+                else
+                    high = mid - 1;
+            }
+            index = low;
+        }
+        else
+        {
+            // playing forward, the key is the same one or one of the next ones
+            while (time > times[index + 1])
+                index++;
+        }
+
+        cursor = index;
+        next = index + 1;
+        factor = (time - times[index]) / (times[index + 1] - times[index]);
+        return index;
+    }
+
+    void sampleVec3(const Animation3D::PackedCurves::Range& range, const std::vector<float>& times, const std::vector<float>& values, float time, EvaluateType type, int& cursor, float* dst)
+    {
+        int next;
+        float factor;
+        int key = findKeys(&times[range.offset], range.count, time, cursor, next, factor);
+        const float* from = &values[(range.offset + key) * 3];
+        const float* to = &values[(range.offset + next) * 3];
+
+        if (type == EvaluateType::INT_NEAR)
+        {
+            const float* src = fabs(factor) > 0.5f ? to : from;
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+        else
+        {
+            dst[0] = from[0] + (to[0] - from[0]) * factor;
+            dst[1] = from[1] + (to[1] - from[1]) * factor;
+            dst[2] = from[2] + (to[2] - from[2]) * factor;
+        }
+    }
+
+#if defined (INCLUDE_SSE2) || defined (INCLUDE_NEON)
+
+#ifdef INCLUDE_SSE2
+    typedef __m128 Lanes;
+    inline Lanes lanesLoad(const float* p) { return _mm_loadu_ps(p); }
+    inline void lanesStore(float* p, Lanes a) { _mm_storeu_ps(p, a); }
+    inline Lanes lanesSet(float f) { return _mm_set1_ps(f); }
+    inline Lanes lanesAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+    inline Lanes lanesSub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+    inline Lanes lanesMul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+    inline Lanes lanesAbs(Lanes a) { return _mm_max_ps(a, _mm_sub_ps(_mm_setzero_ps(), a)); }
+    inline Lanes lanesGreaterEqual(Lanes a, Lanes b) { return _mm_cmpge_ps(a, b); }
+    inline Lanes lanesEqual(Lanes a, Lanes b) { return _mm_cmpeq_ps(a, b); }
+    inline Lanes lanesAnd(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+    inline Lanes lanesOr(Lanes a, Lanes b) { return _mm_or_ps(a, b); }
+    // mask ? a : b
+    inline Lanes lanesSelect(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#else
+    typedef float32x4_t Lanes;
+    inline Lanes lanesLoad(const float* p) { return vld1q_f32(p); }
+    inline void lanesStore(float* p, Lanes a) { vst1q_f32(p, a); }
+    inline Lanes lanesSet(float f) { return vdupq_n_f32(f); }
+    inline Lanes lanesAdd(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+    inline Lanes lanesSub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+    inline Lanes lanesMul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+    inline Lanes lanesAbs(Lanes a) { return vabsq_f32(a); }
+    inline Lanes lanesGreaterEqual(Lanes a, Lanes b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+    inline Lanes lanesEqual(Lanes a, Lanes b) { return vreinterpretq_f32_u32(vceqq_f32(a, b)); }
+    inline Lanes lanesAnd(Lanes a, Lanes b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    inline Lanes lanesOr(Lanes a, Lanes b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    // mask ? a : b
+    inline Lanes lanesSelect(Lanes mask, Lanes a, Lanes b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+#endif
+
+    // Quaternion::slerp on four pairs of quaternions, stored as 4 x, 4 y, 4 z then 4 w.
+    void slerp4(const float* q1, const float* q2, const float* t, float* dst)
+    {
+        Lanes q1x = lanesLoad(q1), q1y = lanesLoad(q1 + 4), q1z = lanesLoad(q1 + 8), q1w = lanesLoad(q1 + 12);
+        Lanes q2x = lanesLoad(q2), q2y = lanesLoad(q2 + 4), q2z = lanesLoad(q2 + 8), q2w = lanesLoad(q2 + 12);
+        Lanes vt = lanesLoad(t);
+        Lanes one = lanesSet(1.0f);
+
+        Lanes cosTheta = lanesAdd(lanesAdd(lanesMul(q1w, q2w), lanesMul(q1x, q2x)), lanesAdd(lanesMul(q1y, q2y), lanesMul(q1z, q2z)));
+
+        // fold theta
+        Lanes alpha = lanesSelect(lanesGreaterEqual(cosTheta, lanesSet(0.0f)), one, lanesSet(-1.0f));
+        Lanes halfY = lanesAdd(one, lanesMul(alpha, cosTheta));
+
+        // bisect the interval and fold t
+        Lanes f2b = lanesSub(vt, lanesSet(0.5f));
+        Lanes u = lanesAbs(f2b);
+        Lanes f2a = lanesSub(u, f2b);
+        f2b = lanesAdd(f2b, u);
+        u = lanesAdd(u, u);
+        Lanes f1 = lanesSub(one, u);
+
+        // one iteration of Newton to get 1-cos(theta / 2)
+        Lanes halfSecHalfTheta = lanesSub(lanesSet(1.09f), lanesMul(lanesSub(lanesSet(0.476537f), lanesMul(lanesSet(0.0903321f), halfY)), halfY));
+        halfSecHalfTheta = lanesMul(halfSecHalfTheta, lanesSub(lanesSet(1.5f), lanesMul(lanesMul(halfY, halfSecHalfTheta), halfSecHalfTheta)));
+        Lanes versHalfTheta = lanesSub(one, lanesMul(halfY, halfSecHalfTheta));
+
+        // series expansions of the coefficients
+        Lanes sqNotU = lanesMul(f1, f1);
+        Lanes ratio2 = lanesMul(lanesSet(0.0000440917108f), versHalfTheta);
+        Lanes ratio1 = lanesAdd(lanesSet(-0.00158730159f), lanesMul(lanesSub(sqNotU, lanesSet(16.0f)), ratio2));
+        ratio1 = lanesAdd(lanesSet(0.0333333333f), lanesMul(lanesMul(ratio1, lanesSub(sqNotU, lanesSet(9.0f))), versHalfTheta));
+        ratio1 = lanesAdd(lanesSet(-0.333333333f), lanesMul(lanesMul(ratio1, lanesSub(sqNotU, lanesSet(4.0f))), versHalfTheta));
+        ratio1 = lanesAdd(one, lanesMul(lanesMul(ratio1, lanesSub(sqNotU, one)), versHalfTheta));
+
+        Lanes sqU = lanesMul(u, u);
+        ratio2 = lanesAdd(lanesSet(-0.00158730159f), lanesMul(lanesSub(sqU, lanesSet(16.0f)), ratio2));
+        ratio2 = lanesAdd(lanesSet(0.0333333333f), lanesMul(lanesMul(ratio2, lanesSub(sqU, lanesSet(9.0f))), versHalfTheta));
+        ratio2 = lanesAdd(lanesSet(-0.333333333f), lanesMul(lanesMul(ratio2, lanesSub(sqU, lanesSet(4.0f))), versHalfTheta));
+        ratio2 = lanesAdd(one, lanesMul(lanesMul(ratio2, lanesSub(sqU, one)), versHalfTheta));
+
+        // bisection and folding
+        f1 = lanesMul(f1, lanesMul(ratio1, halfSecHalfTheta));
+        f2a = lanesMul(f2a, ratio2);
+        f2b = lanesMul(f2b, ratio2);
+        alpha = lanesMul(alpha, lanesAdd(f1, f2a));
+        Lanes beta = lanesAdd(f1, f2b);
+
+        Lanes w = lanesAdd(lanesMul(alpha, q1w), lanesMul(beta, q2w));
+        Lanes x = lanesAdd(lanesMul(alpha, q1x), lanesMul(beta, q2x));
+        Lanes y = lanesAdd(lanesMul(alpha, q1y), lanesMul(beta, q2y));
+        Lanes z = lanesAdd(lanesMul(alpha, q1z), lanesMul(beta, q2z));
+
+        // correct the length
+        f1 = lanesSub(lanesSet(1.5f), lanesMul(lanesSet(0.5f), lanesAdd(lanesAdd(lanesMul(w, w), lanesMul(x, x)), lanesAdd(lanesMul(y, y), lanesMul(z, z)))));
+        w = lanesMul(w, f1);
+        x = lanesMul(x, f1);
+        y = lanesMul(y, f1);
+        z = lanesMul(z, f1);
+
+        // Quaternion::slerp returns the inputs unchanged for t == 0, t == 1 and equal quaternions
+        Lanes equal = lanesAnd(lanesAnd(lanesEqual(q1x, q2x), lanesEqual(q1y, q2y)), lanesAnd(lanesEqual(q1z, q2z), lanesEqual(q1w, q2w)));
+        Lanes useQ1 = lanesOr(lanesEqual(vt, lanesSet(0.0f)), equal);
+        Lanes useQ2 = lanesEqual(vt, one);
+        x = lanesSelect(useQ1, q1x, lanesSelect(useQ2, q2x, x));
+        y = lanesSelect(useQ1, q1y, lanesSelect(useQ2, q2y, y));
+        z = lanesSelect(useQ1, q1z, lanesSelect(useQ2, q2z, z));
+        w = lanesSelect(useQ1, q1w, lanesSelect(useQ2, q2w, w));
+
+        lanesStore(dst, x);
+        lanesStore(dst + 4, y);
+        lanesStore(dst + 8, z);
+        lanesStore(dst + 12, w);
+    }
+
+#else
+
+    void slerp4(const float* q1, const float* q2, const float* t, float* dst)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            Quaternion::slerp(q1[i], q1[i + 4], q1[i + 8], q1[i + 12], q2[i], q2[i + 4], q2[i + 8], q2[i + 12], t[i],
+                              &dst[i], &dst[i + 4], &dst[i + 8], &dst[i + 12]);
+        }
+    }
+
+#endif
+
+    // slerps gathered four at a time
+    class SlerpBatch
+    {
+    public:
+        SlerpBatch()
+        : _size(0)
+        {
+        }
+
+        void add(const float* q1, const float* q2, float t, float* dst)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                _q1[i * 4 + _size] = q1[i];
+                _q2[i * 4 + _size] = q2[i];
+            }
+            _t[_size] = t;
+            _dst[_size] = dst;
+            if (++_size == 4)
+                flush();
+        }
+
+        void flush()
+        {
+            if (_size == 0)
+                return;
+
+            // unused lanes slerp identities
+            for (int lane = _size; lane < 4; lane++)
+            {
+                _q1[lane] = _q1[4 + lane] = _q1[8 + lane] = 0.0f;
+                _q2[lane] = _q2[4 + lane] = _q2[8 + lane] = 0.0f;
+                _q1[12 + lane] = _q2[12 + lane] = 1.0f;
+                _t[lane] = 0.0f;
+            }
+
+            float result[16];
+            slerp4(_q1, _q2, _t, result);
+            for (int lane = 0; lane < _size; lane++)
+            {
+                for (int i = 0; i < 4; i++)
+                    _dst[lane][i] = result[i * 4 + lane];
+            }
+            _size = 0;
+        }
+
+    private:
+        float _q1[16];
+        float _q2[16];
+        float _t[4];
+        float* _dst[4];
+        int _size;
+    };
+}
+
+Animation3DSampler* Animation3DSampler::s_instance = nullptr;
+
+Animation3DSampler* Animation3DSampler::getInstance()
+{
+    if (s_instance == nullptr)
+        s_instance = new (std::nothrow) Animation3DSampler();
+
+    return s_instance;
+}
+
+void Animation3DSampler::destroyInstance()
+{
+    CC_SAFE_DELETE(s_instance);
+}
+
+Animation3DSampler::Animation3DSampler()
+: _sampledBoneCount(0)
+, _afterUpdateListener(nullptr)
+, _threadCount(0)
+, _batch(0)
+, _runningThreads(0)
+, _quit(false)
+, _nextJob(0)
+{
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    _threadCount = std::max(0, std::min(cores - 1, MAX_THREADS));
+}
+
+Animation3DSampler::~Animation3DSampler()
+{
+    setEnabled(false);
+    stopThreads();
+}
+
+void Animation3DSampler::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled())
+        return;
+
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    if (enabled)
+    {
+        _afterUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom*){
+            this->flush();
+        });
+        _afterUpdateListener->retain();
+    }
+    else
+    {
+        flush();
+        dispatcher->removeEventListener(_afterUpdateListener);
+        CC_SAFE_RELEASE_NULL(_afterUpdateListener);
+    }
+}
+
+void Animation3DSampler::setThreadCount(int count)
+{
+    count = std::max(0, count);
+    if (count == _threadCount)
+        return;
+
+    stopThreads();
+    _threadCount = count;
+}
+
+void Animation3DSampler::addJob(Animate3D* animate, float time)
+{
+    Job job;
+    job.animate = animate;
+    job.time = time;
+    job.weight = animate->getWeight();
+    job.firstBone = _jobs.empty() ? 0 : _jobs.back().firstBone + _jobs.back().animate->_sampledBones.size();
+    _jobs.push_back(job);
+
+    // the animate may be stopped before the flush, the bones belong to the target
+    animate->retain();
+    animate->getTarget()->retain();
+}
+
+void Animation3DSampler::flush()
+{
+    if (_jobs.empty())
+    {
+        _sampledBoneCount = 0;
+        return;
+    }
+
+    size_t boneCount = _jobs.back().firstBone + _jobs.back().animate->_sampledBones.size();
+    _translations.resize(boneCount * 3);
+    _rotations.resize(boneCount * 4);
+    _scales.resize(boneCount * 3);
+    _channels.resize(boneCount);
+
+    if (_threadCount > 0 && _jobs.size() > 1)
+    {
+        if (_threads.empty())
+            startThreads();
+
+        _nextJob = 0;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _runningThreads = static_cast<int>(_threads.size());
+            _batch++;
+        }
+        _startCondition.notify_all();
+
+        runJobs();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _doneCondition.wait(lock, [this]{ return _runningThreads == 0; });
+    }
+    else
+    {
+        for (const auto& job : _jobs)
+            sample(job);
+    }
+
+    // Bone3D::setAnimationValue isn't thread safe, several animates blend the same bones
+    for (const auto& job : _jobs)
+    {
+        auto animate = job.animate;
+        for (size_t i = 0, count = animate->_sampledBones.size(); i < count; i++)
+        {
+            size_t bone = job.firstBone + i;
+            unsigned char channels = _channels[bone];
+            animate->_sampledBones[i]->setAnimationValue((channels & CHANNEL_TRANSLATE) ? &_translations[bone * 3] : nullptr,
+                                                         (channels & CHANNEL_ROTATE) ? &_rotations[bone * 4] : nullptr,
+                                                         (channels & CHANNEL_SCALE) ? &_scales[bone * 3] : nullptr,
+                                                         animate, job.weight);
+        }
+    }
+
+    _sampledBoneCount = static_cast<unsigned int>(boneCount);
+
+    for (const auto& job : _jobs)
+    {
+        job.animate->getTarget()->release();
+        job.animate->release();
+    }
+    _jobs.clear();
+}
+
+void Animation3DSampler::runJobs()
+{
+    int count = static_cast<int>(_jobs.size());
+    for (int index = _nextJob++; index < count; index = _nextJob++)
+        sample(_jobs[index]);
+}
+
+void Animation3DSampler::sample(const Job& job)
+{
+    auto animate = job.animate;
+    const auto& curves = animate->_animation->getPackedCurves();
+    SlerpBatch slerps;
+
+    for (size_t i = 0, count = animate->_sampledBones.size(); i < count; i++)
+    {
+        int track = animate->_sampledTracks[i];
+        int* cursors = &animate->_sampledKeys[i * 3];
+        size_t bone = job.firstBone + i;
+        unsigned char channels = 0;
+
+        const auto& translateRange = curves.translateRanges[track];
+        if (translateRange.count)
+        {
+            sampleVec3(translateRange, curves.translateTimes, curves.translateValues, job.time, animate->_translateEvaluate, cursors[0], &_translations[bone * 3]);
+            channels |= CHANNEL_TRANSLATE;
+        }
+
+        const auto& rotRange = curves.rotRanges[track];
+        if (rotRange.count)
+        {
+            int next;
+            float factor;
+            int key = findKeys(&curves.rotTimes[rotRange.offset], rotRange.count, job.time, cursors[1], next, factor);
+            const float* from = &curves.rotValues[(rotRange.offset + key) * 4];
+            const float* to = &curves.rotValues[(rotRange.offset + next) * 4];
+            float* dst = &_rotations[bone * 4];
+
+            if (animate->_roteEvaluate == EvaluateType::INT_QUAT_SLERP)
+            {
+                slerps.add(from, to, factor, dst);
+            }
+            else if (animate->_roteEvaluate == EvaluateType::INT_NEAR)
+            {
+                memcpy(dst, fabs(factor) > 0.5f ? to : from, 4 * sizeof(float));
+            }
+            else
+            {
+                for (int c = 0; c < 4; c++)
+                    dst[c] = from[c] + (to[c] - from[c]) * factor;
+            }
+            channels |= CHANNEL_ROTATE;
+        }
+
+        const auto& scaleRange = curves.scaleRanges[track];
+        if (scaleRange.count)
+        {
+            sampleVec3(scaleRange, curves.scaleTimes, curves.scaleValues, job.time, animate->_scaleEvaluate, cursors[2], &_scales[bone * 3]);
+            channels |= CHANNEL_SCALE;
+        }
+
+        _channels[bone] = channels;
+    }
+
+    slerps.flush();
+}
+
+void Animation3DSampler::startThreads()
+{
+    _quit = false;
+    unsigned int batch = _batch;
+    for (int i = 0; i < _threadCount; i++)
+    {
+        _threads.push_back(std::thread([this, batch]{
+            unsigned int lastBatch = batch;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _startCondition.wait(lock, [this, lastBatch]{ return _quit || _batch != lastBatch; });
+                    if (_quit)
+                        return;
+                    lastBatch = _batch;
+                }
+
+                runJobs();
+
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _runningThreads--;
+                }
+                _doneCondition.notify_one();
+            }
+        }));
+    }
+}
+
+void Animation3DSampler::stopThreads()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _startCondition.notify_all();
+    for (auto& thread : _threads)
+        thread.join();
+    _threads.clear();
+}
+
+NS_CC_END
@@ -0,0 +1,137 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+
+#ifndef __CCANIMATION3DSAMPLER_H__
+#define __CCANIMATION3DSAMPLER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+class Animate3D;
+class EventListenerCustom;
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+/**
+ * @brief Samples the bone curves of all the running Animate3D in one batch per frame.
+ *
+ * When it is enabled, Animate3D::update() only queues the time to sample. After the scheduler
+ * update of the frame, the queued animations are sampled in parallel from the keys packed by
+ * Animation3D::getPackedCurves(), four quaternion slerps at a time with SSE or NEON, then the
+ * results are applied to the bones on the main thread, in the order the animations were updated.
+ * The bones get the same values as with the per curve evaluation, up to the float rounding.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL Animation3DSampler
+{
+public:
+    /**get and destroy instance, destroying it applies the queued animations and stops the worker threads*/
+    static Animation3DSampler* getInstance();
+    static void destroyInstance();
+    
+    /**
+     * enable or disable the batch sampling, disabled by default.
+     * Director::reset destroys the sampler, the batch sampling must be enabled again after a restart.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return _afterUpdateListener != nullptr; }
+    
+    /**
+     * set the number of worker threads sampling along with the main thread, 0 samples on the main thread only.
+     * The default is the number of cores minus one, at most 3.
+     */
+    void setThreadCount(int count);
+    int getThreadCount() const { return _threadCount; }
+    
+    /**queue the sampling of the bones of an animate at time, between 0 and 1, called by Animate3D::update()*/
+    void addJob(Animate3D* animate, float time);
+    
+    /**sample the queued animations and apply them to the bones, called after each scheduler update*/
+    void flush();
+    
+    /**number of bones sampled by the last flush*/
+    unsigned int getSampledBoneCount() const { return _sampledBoneCount; }
+    
+protected:
+    Animation3DSampler();
+    ~Animation3DSampler();
+    
+    struct Job
+    {
+        Animate3D* animate;
+        float time;
+        float weight;
+        // index of the first bone of the animate in the result arrays
+        size_t firstBone;
+    };
+    
+    void startThreads();
+    void stopThreads();
+    void runJobs();
+    void sample(const Job& job);
+    
+    std::vector<Job> _jobs;
+    // sampled values, 3 floats per bone for translations and scales, 4 for rotations
+    std::vector<float> _translations;
+    std::vector<float> _rotations;
+    std::vector<float> _scales;
+    // channels sampled for each bone
+    std::vector<unsigned char> _channels;
+    unsigned int _sampledBoneCount;
+    
+    EventListenerCustom* _afterUpdateListener;
+    
+    int _threadCount;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _startCondition;
+    std::condition_variable _doneCondition;
+    // incremented for each batch the workers must run
+    unsigned int _batch;
+    int _runningThreads;
+    bool _quit;
+    std::atomic<int> _nextJob;
+    
+    static Animation3DSampler* s_instance;
+};
+
+// end of 3d group
+/// @}
+
+NS_CC_END
+
+#endif // __CCANIMATION3DSAMPLER_H__
@@ -82,6 +82,15 @@ public:
     /**get end time*/
     float getEndTime() const;
     
+    /**get the number of keys*/
+    int getKeyCount() const { return _count; }
+    
+    /**get the key times, between 0 and 1*/
+    const float* getKeyTimes() const { return _keytime; }
+    
+    /**get the key values, componentSize floats per key*/
+    const float* getKeyValues() const { return _value; }
+    
 CC_CONSTRUCTOR_ACCESS:
     
     AnimationCurve();
@@ -76,6 +76,8 @@ const Mat4& AttachNode::getNodeToParentTransform() const
 
 void AttachNode::visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags)
 {
+    // the transform follows the bone, the one computed by the TransformSystem of the scene can't be used
+    markTransformSystemDirty();
     Node::visit(renderer, parentTransform, Node::FLAGS_DIRTY_MASK);
 }
 NS_CC_END
@@ -27,11 +27,14 @@ THE SOFTWARE.
 
 #include "base/ccMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCFileArchive.h"
 #include "renderer/CCGLProgram.h"
 #include "CCBundleReader.h"
 #include "base/CCData.h"
 #include "json/document.h"
 
+#include <set>
+
 #define BUNDLE_TYPE_SCENE               1
 #define BUNDLE_TYPE_NODE                2
 #define BUNDLE_TYPE_ANIMATIONS          3
@@ -89,6 +92,11 @@ static const char* SCALE =  "scale";
 static const char* KEYTIME =  "keytime";
 static const char* AABBS = "aabb";
 
+static const char MAPPED_IDENTIFIER[4] = { 'C', '3', 'M', '\0' };
+static const unsigned char MAPPED_VERSION_MAJOR = 1;
+static const unsigned char MAPPED_VERSION_MINOR = 0;
+static const unsigned int MAPPED_ALIGNMENT = 16;
+
 NS_CC_BEGIN
 
 void getChildMap(std::map<int, std::vector<int> >& map, SkinData* skinData, const rapidjson::Value& val)
@@ -169,6 +177,8 @@ void Bundle3D::clear()
     {
         CC_SAFE_DELETE_ARRAY(_jsonBuffer);
     }
+    CC_SAFE_RELEASE_NULL(_mappedArchive);
+    _isMapped = false;
 }
 
 bool Bundle3D::load(const std::string& path)
@@ -193,6 +203,11 @@ bool Bundle3D::load(const std::string& path)
         _isBinary = true;
         ret = loadBinary(path);
     }
+    else if (ext == ".c3m")
+    {
+        _isBinary = true;
+        ret = loadMapped(path);
+    }
     else 
     {
         CCLOG("warning: %s is invalid file formate", path.c_str());
@@ -335,7 +350,12 @@ bool Bundle3D::loadSkinData(const std::string& id, SkinData* skindata)
 {
     skindata->resetData();
 
-    if (_isBinary)
+    // the skins of c3m files are stored in their nodes
+    if (_isMapped)
+    {
+        return false;
+    }
+    else if (_isBinary)
     {
         return loadSkinDataBinary(skindata);
     }
@@ -349,7 +369,11 @@ bool Bundle3D::loadAnimationData(const std::string& id, Animation3DData* animati
 {
     animationdata->resetData();
 
-    if (_isBinary)
+    if (_isMapped)
+    {
+        return loadAnimationDataMapped(id, animationdata);
+    }
+    else if (_isBinary)
     {
         return loadAnimationDataBinary(id,animationdata);
     }
@@ -363,7 +387,11 @@ bool Bundle3D::loadAnimationData(const std::string& id, Animation3DData* animati
 bool Bundle3D::loadMeshDatas(MeshDatas& meshdatas)
 {
     meshdatas.resetData();
-    if (_isBinary)
+    if (_isMapped)
+    {
+        return loadMeshDatasMapped(meshdatas);
+    }
+    else if (_isBinary)
     {
         if (_version == "0.1" || _version == "0.2")
         {
@@ -810,7 +838,11 @@ bool  Bundle3D::loadMeshDatasJson(MeshDatas& meshdatas)
 }
 bool Bundle3D::loadNodes(NodeDatas& nodedatas)
 {
-    if (_version == "0.1" || _version == "1.2" || _version == "0.2")
+    if (_isMapped)
+    {
+        return loadNodesMapped(nodedatas);
+    }
+    else if (_version == "0.1" || _version == "1.2" || _version == "0.2")
     {
         SkinData   skinData;
         if (!loadSkinData("", &skinData))
@@ -877,7 +909,11 @@ bool Bundle3D::loadNodes(NodeDatas& nodedatas)
 bool Bundle3D::loadMaterials(MaterialDatas& materialdatas)
 {
     materialdatas.resetData();
-    if (_isBinary)
+    if (_isMapped)
+    {
+        return loadMaterialsMapped(materialdatas);
+    }
+    else if (_isBinary)
     {
         if (_version == "0.1")
         {
@@ -2203,7 +2239,9 @@ _jsonBuffer(nullptr),
 _binaryBuffer(nullptr),
 _referenceCount(0),
 _references(nullptr),
-_isBinary(false)
+_isBinary(false),
+_isMapped(false),
+_mappedArchive(nullptr)
 {
 
 }
@@ -2225,4 +2263,670 @@ cocos2d::AABB Bundle3D::calculateAABB( const std::vector<float>& vertex, int str
     return aabb;
 }
 
+// c3m bundles
+
+namespace
+{
+    static_assert(sizeof(Mat4) == 16 * sizeof(float), "matrices are stored as 16 floats");
+    static_assert(sizeof(Animation3DData::Vec3Key) == 4 * sizeof(float), "vec3 keys are stored as time, x, y, z");
+    static_assert(sizeof(Animation3DData::QuatKey) == 5 * sizeof(float), "quaternion keys are stored as time, x, y, z, w");
+    
+    class MappedBundleWriter
+    {
+    public:
+        template <typename T>
+        void write(T value)
+        {
+            writeBytes(&value, sizeof(T));
+        }
+        
+        void writeBytes(const void* bytes, size_t size)
+        {
+            auto begin = static_cast<const unsigned char*>(bytes);
+            _buffer.insert(_buffer.end(), begin, begin + size);
+        }
+        
+        void writeString(const std::string& str)
+        {
+            write<unsigned int>(static_cast<unsigned int>(str.size()));
+            writeBytes(str.data(), str.size());
+        }
+        
+        // the count, then the elements, starting at a multiple of the alignment if aligned is true
+        template <typename T>
+        void writeArray(const std::vector<T>& values, bool aligned)
+        {
+            write<unsigned int>(static_cast<unsigned int>(values.size()));
+            if (aligned)
+                align();
+            if (!values.empty())
+                writeBytes(&values[0], values.size() * sizeof(T));
+        }
+        
+        void align()
+        {
+            _buffer.resize((_buffer.size() + MAPPED_ALIGNMENT - 1) / MAPPED_ALIGNMENT * MAPPED_ALIGNMENT, 0);
+        }
+        
+        template <typename T>
+        void patch(size_t offset, T value)
+        {
+            memcpy(&_buffer[offset], &value, sizeof(T));
+        }
+        
+        size_t tell() const { return _buffer.size(); }
+        const std::vector<unsigned char>& getBuffer() const { return _buffer; }
+        
+    private:
+        std::vector<unsigned char> _buffer;
+    };
+    
+    void writeMappedNode(MappedBundleWriter& writer, const NodeData* node)
+    {
+        writer.writeString(node->id);
+        writer.writeBytes(node->transform.m, sizeof(node->transform.m));
+        writer.write<unsigned int>(static_cast<unsigned int>(node->modelNodeDatas.size()));
+        for (const auto& model : node->modelNodeDatas)
+        {
+            writer.writeString(model->subMeshId);
+            writer.writeString(model->matrialId);
+            writer.write<unsigned int>(static_cast<unsigned int>(model->bones.size()));
+            for (const auto& bone : model->bones)
+            {
+                writer.writeString(bone);
+            }
+            writer.writeArray(model->invBindPose, false);
+        }
+        writer.write<unsigned int>(static_cast<unsigned int>(node->children.size()));
+        for (const auto& child : node->children)
+        {
+            writeMappedNode(writer, child);
+        }
+    }
+    
+    // whether count elements of size bytes are left to read
+    bool hasMappedBytes(BundleReader& reader, unsigned int count, size_t size)
+    {
+        return static_cast<size_t>(reader.length() - reader.tell()) / size >= count;
+    }
+    
+    bool alignMappedReader(BundleReader& reader)
+    {
+        long int padding = static_cast<long int>((MAPPED_ALIGNMENT - reader.tell() % MAPPED_ALIGNMENT) % MAPPED_ALIGNMENT);
+        return padding <= reader.length() - reader.tell() && reader.seek(padding, SEEK_CUR);
+    }
+    
+    // reads an array written by MappedBundleWriter::writeArray() with a single copy
+    template <typename T>
+    bool readMappedArray(BundleReader& reader, std::vector<T>& values, bool aligned)
+    {
+        unsigned int count = 0;
+        if (!reader.read(&count) || (aligned && !alignMappedReader(reader)) || !hasMappedBytes(reader, count, sizeof(T)))
+            return false;
+        
+        values.resize(count);
+        return count == 0 || reader.read(&values[0], sizeof(T), count) == count;
+    }
+}
+
+bool Bundle3D::convertToMapped(const std::string& srcPath, const std::string& dstFullPath)
+{
+    auto fileUtils = FileUtils::getInstance();
+    std::string fullPath = fileUtils->fullPathForFilename(srcPath);
+    if (fullPath.empty())
+    {
+        CCLOG("warning: Failed to find %s", srcPath.c_str());
+        return false;
+    }
+    // the loaders prefix the texture paths with the directory of the model
+    std::string modelPath = fullPath.substr(0, fullPath.find_last_of('/') + 1);
+    
+    MeshDatas meshdatas;
+    NodeDatas nodedatas;
+    MaterialDatas materialdatas;
+    std::vector<std::pair<std::string, Animation3DData>> animations;
+    
+    std::string ext = fileUtils->getFileExtension(fullPath);
+    if (ext == ".obj")
+    {
+        if (!loadObj(meshdatas, materialdatas, nodedatas, fullPath))
+            return false;
+    }
+    else if (ext == ".c3b" || ext == ".c3t")
+    {
+        Bundle3D bundle;
+        if (!bundle.load(fullPath) || !bundle.loadMeshDatas(meshdatas) || !bundle.loadMaterials(materialdatas) || !bundle.loadNodes(nodedatas))
+            return false;
+        
+        for (const auto& id : bundle.getAnimationIds())
+        {
+            Animation3DData animation;
+            if (bundle.loadAnimationData(id, &animation))
+                animations.push_back(std::make_pair(id, animation));
+        }
+    }
+    else
+    {
+        CCLOG("warning: %s can't be converted to c3m", srcPath.c_str());
+        return false;
+    }
+    
+    MappedBundleWriter writer;
+    writer.writeBytes(MAPPED_IDENTIFIER, sizeof(MAPPED_IDENTIFIER));
+    writer.write<unsigned char>(MAPPED_VERSION_MAJOR);
+    writer.write<unsigned char>(MAPPED_VERSION_MINOR);
+    writer.write<unsigned short>(0);
+    
+    // section table: type, offset and size of each section
+    const unsigned int sectionTypes[] = { BUNDLE_TYPE_MESH, BUNDLE_TYPE_NODE, BUNDLE_TYPE_MATERIAL, BUNDLE_TYPE_ANIMATIONS };
+    const unsigned int sectionCount = sizeof(sectionTypes) / sizeof(sectionTypes[0]);
+    writer.write<unsigned int>(sectionCount);
+    size_t sectionTable = writer.tell();
+    for (unsigned int i = 0; i < sectionCount * 3; i++)
+    {
+        writer.write<unsigned int>(0);
+    }
+    
+    for (unsigned int section = 0; section < sectionCount; section++)
+    {
+        writer.align();
+        size_t start = writer.tell();
+        
+        switch (sectionTypes[section])
+        {
+            case BUNDLE_TYPE_MESH:
+                writer.write<unsigned int>(static_cast<unsigned int>(meshdatas.meshDatas.size()));
+                for (const auto& meshdata : meshdatas.meshDatas)
+                {
+                    writer.write<unsigned int>(static_cast<unsigned int>(meshdata->attribs.size()));
+                    for (const auto& attrib : meshdata->attribs)
+                    {
+                        writer.write<int>(attrib.size);
+                        writer.write<unsigned int>(attrib.type);
+                        writer.write<int>(attrib.vertexAttrib);
+                        writer.write<int>(attrib.attribSizeBytes);
+                    }
+                    writer.writeArray(meshdata->vertex, true);
+                    
+                    bool hasAABB = meshdata->subMeshAABB.size() == meshdata->subMeshIndices.size();
+                    writer.write<unsigned int>(static_cast<unsigned int>(meshdata->subMeshIndices.size()));
+                    for (size_t i = 0; i < meshdata->subMeshIndices.size(); i++)
+                    {
+                        const auto& indices = meshdata->subMeshIndices[i];
+                        writer.writeString(i < meshdata->subMeshIds.size() ? meshdata->subMeshIds[i] : "");
+                        AABB aabb = hasAABB ? meshdata->subMeshAABB[i] : calculateAABB(meshdata->vertex, meshdata->getPerVertexSize(), indices);
+                        float minMax[6] = { aabb._min.x, aabb._min.y, aabb._min.z, aabb._max.x, aabb._max.y, aabb._max.z };
+                        writer.writeBytes(minMax, sizeof(minMax));
+                        writer.writeArray(indices, true);
+                    }
+                }
+                break;
+                
+            case BUNDLE_TYPE_NODE:
+                writer.write<unsigned int>(static_cast<unsigned int>(nodedatas.skeleton.size()));
+                for (const auto& node : nodedatas.skeleton)
+                {
+                    writeMappedNode(writer, node);
+                }
+                writer.write<unsigned int>(static_cast<unsigned int>(nodedatas.nodes.size()));
+                for (const auto& node : nodedatas.nodes)
+                {
+                    writeMappedNode(writer, node);
+                }
+                break;
+                
+            case BUNDLE_TYPE_MATERIAL:
+                writer.write<unsigned int>(static_cast<unsigned int>(materialdatas.materials.size()));
+                for (const auto& material : materialdatas.materials)
+                {
+                    writer.writeString(material.id);
+                    writer.write<unsigned int>(static_cast<unsigned int>(material.textures.size()));
+                    for (const auto& texture : material.textures)
+                    {
+                        std::string filename = texture.filename;
+                        if (filename.compare(0, modelPath.size(), modelPath) == 0)
+                            filename = filename.substr(modelPath.size());
+                        writer.writeString(texture.id);
+                        writer.writeString(filename);
+                        writer.write<unsigned int>(static_cast<unsigned int>(texture.type));
+                        writer.write<unsigned int>(texture.wrapS);
+                        writer.write<unsigned int>(texture.wrapT);
+                    }
+                }
+                break;
+                
+            case BUNDLE_TYPE_ANIMATIONS:
+                writer.write<unsigned int>(static_cast<unsigned int>(animations.size()));
+                for (const auto& it : animations)
+                {
+                    const auto& animation = it.second;
+                    std::set<std::string> boneNames;
+                    for (const auto& keys : animation._translationKeys)
+                        boneNames.insert(keys.first);
+                    for (const auto& keys : animation._rotationKeys)
+                        boneNames.insert(keys.first);
+                    for (const auto& keys : animation._scaleKeys)
+                        boneNames.insert(keys.first);
+                    
+                    writer.writeString(it.first);
+                    writer.write<float>(animation._totalTime);
+                    writer.write<unsigned int>(static_cast<unsigned int>(boneNames.size()));
+                    for (const auto& boneName : boneNames)
+                    {
+                        static const std::vector<Animation3DData::Vec3Key> noVec3Keys;
+                        static const std::vector<Animation3DData::QuatKey> noQuatKeys;
+                        auto translation = animation._translationKeys.find(boneName);
+                        auto rotation = animation._rotationKeys.find(boneName);
+                        auto scale = animation._scaleKeys.find(boneName);
+                        
+                        writer.writeString(boneName);
+                        writer.writeArray(translation != animation._translationKeys.end() ? translation->second : noVec3Keys, false);
+                        writer.writeArray(rotation != animation._rotationKeys.end() ? rotation->second : noQuatKeys, false);
+                        writer.writeArray(scale != animation._scaleKeys.end() ? scale->second : noVec3Keys, false);
+                    }
+                }
+                break;
+                
+            default:
+                break;
+        }
+        
+        size_t entry = sectionTable + section * 3 * sizeof(unsigned int);
+        writer.patch<unsigned int>(entry, sectionTypes[section]);
+        writer.patch<unsigned int>(entry + sizeof(unsigned int), static_cast<unsigned int>(start));
+        writer.patch<unsigned int>(entry + 2 * sizeof(unsigned int), static_cast<unsigned int>(writer.tell() - start));
+    }
+    
+    Data data;
+    data.copy(&writer.getBuffer()[0], writer.getBuffer().size());
+    if (!fileUtils->writeDataToFile(data, dstFullPath))
+    {
+        CCLOG("warning: Failed to write %s", dstFullPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> Bundle3D::getAnimationIds()
+{
+    std::vector<std::string> ids;
+    if (_isMapped)
+    {
+        // not needed to convert the bundle
+        return ids;
+    }
+    else if (_isBinary)
+    {
+        if (_version == "0.1" || _version == "0.2" || _version == "0.3" || _version == "0.4")
+        {
+            // the first animation is loaded with an empty id
+            if (seekToFirstType(BUNDLE_TYPE_ANIMATIONS))
+                ids.push_back("");
+            return ids;
+        }
+        
+        // the references of the animations are suffixed with "animation"
+        const std::string suffix = "animation";
+        for (unsigned int i = 0; i < _referenceCount; ++i)
+        {
+            const auto& id = _references[i].id;
+            if (_references[i].type == BUNDLE_TYPE_ANIMATIONS && id.size() >= suffix.size()
+                && id.compare(id.size() - suffix.size(), suffix.size(), suffix) == 0)
+                ids.push_back(id.substr(0, id.size() - suffix.size()));
+        }
+    }
+    else
+    {
+        const char* anim = (_version == "1.2" || _version == "0.2") ? ANIMATION : ANIMATIONS;
+        if (!_jsonReader.HasMember(anim))
+            return ids;
+        
+        const rapidjson::Value& animations = _jsonReader[anim];
+        for (rapidjson::SizeType i = 0; i < animations.Size(); i++)
+        {
+            ids.push_back(animations[i][ID].GetString());
+        }
+    }
+    return ids;
+}
+
+bool Bundle3D::loadMapped(const std::string& path)
+{
+    clear();
+    _isMapped = true;
+    
+    auto fileUtils = FileUtils::getInstance();
+    const unsigned char* bytes = nullptr;
+    ssize_t size = 0;
+    
+    // a file stored uncompressed in a mapped archive is read in place
+    std::string entryName;
+    auto archive = fileUtils->getArchiveForFullPath(path, &entryName);
+    if (archive && archive->getMappedData(entryName, &bytes, &size))
+    {
+        _mappedArchive = archive;
+        _mappedArchive->retain();
+    }
+    else
+    {
+        _binaryBuffer = new (std::nothrow) Data();
+        *_binaryBuffer = fileUtils->getDataFromFile(path);
+        if (_binaryBuffer->isNull())
+        {
+            clear();
+            CCLOG("warning: Failed to read file: %s", path.c_str());
+            return false;
+        }
+        bytes = _binaryBuffer->getBytes();
+        size = _binaryBuffer->getSize();
+    }
+    
+    _binaryReader.init(reinterpret_cast<char*>(const_cast<unsigned char*>(bytes)), size);
+    
+    char sig[4];
+    unsigned char ver[2];
+    unsigned short reserved;
+    if (_binaryReader.read(sig, 1, 4) != 4 || memcmp(sig, MAPPED_IDENTIFIER, 4) != 0
+        || _binaryReader.read(ver, 1, 2) != 2 || !_binaryReader.read(&reserved))
+    {
+        clear();
+        CCLOG("warning: Invalid identifier: %s", path.c_str());
+        return false;
+    }
+    
+    // the minor versions only add data the older readers can skip
+    if (ver[0] != MAPPED_VERSION_MAJOR)
+    {
+        clear();
+        CCLOG("warning: Unsupported c3m version %d.%d: %s", ver[0], ver[1], path.c_str());
+        return false;
+    }
+    
+    char version[20] = {0};
+    sprintf(version, "%d.%d", ver[0], ver[1]);
+    _version = version;
+    
+    if (!_binaryReader.read(&_referenceCount) || !hasMappedBytes(_binaryReader, _referenceCount, 3 * sizeof(unsigned int)))
+    {
+        clear();
+        CCLOG("warning: Failed to read section table size '%s'.", path.c_str());
+        return false;
+    }
+    
+    // the sections are found as the references of c3b files
+    CC_SAFE_DELETE_ARRAY(_references);
+    _references = new (std::nothrow) Reference[_referenceCount];
+    for (unsigned int i = 0; i < _referenceCount; ++i)
+    {
+        unsigned int sectionSize = 0;
+        _binaryReader.read(&_references[i].type);
+        _binaryReader.read(&_references[i].offset);
+        _binaryReader.read(&sectionSize);
+        if (_references[i].offset > static_cast<size_t>(size) || sectionSize > static_cast<size_t>(size) - _references[i].offset)
+        {
+            CCLOG("warning: Invalid section %u in bundle '%s'.", i, path.c_str());
+            clear();
+            _referenceCount = 0;
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool Bundle3D::loadMeshDatasMapped(MeshDatas& meshdatas)
+{
+    if (!seekToFirstType(BUNDLE_TYPE_MESH))
+        return false;
+    
+    unsigned int meshCount = 0;
+    if (!_binaryReader.read(&meshCount))
+    {
+        CCLOG("warning: Failed to read meshdata: meshCount '%s'.", _path.c_str());
+        return false;
+    }
+    
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        auto meshData = new (std::nothrow) MeshData();
+        meshdatas.meshDatas.push_back(meshData);
+        
+        unsigned int attribCount = 0;
+        if (!_binaryReader.read(&attribCount) || attribCount == 0 || !hasMappedBytes(_binaryReader, attribCount, 4 * sizeof(int)))
+        {
+            CCLOG("warning: Failed to read meshdata: attribCount '%s'.", _path.c_str());
+            meshdatas.resetData();
+            return false;
+        }
+        meshData->attribCount = attribCount;
+        meshData->attribs.resize(attribCount);
+        for (auto& attrib : meshData->attribs)
+        {
+            _binaryReader.read(&attrib.size);
+            _binaryReader.read(&attrib.type);
+            _binaryReader.read(&attrib.vertexAttrib);
+            _binaryReader.read(&attrib.attribSizeBytes);
+        }
+        
+        // vertices in the layout of the attributes
+        if (!readMappedArray(_binaryReader, meshData->vertex, true) || meshData->vertex.empty())
+        {
+            CCLOG("warning: Failed to read meshdata: vertex '%s'.", _path.c_str());
+            meshdatas.resetData();
+            return false;
+        }
+        meshData->vertexSizeInFloat = static_cast<int>(meshData->vertex.size());
+        
+        unsigned int subMeshCount = 0;
+        if (!_binaryReader.read(&subMeshCount) || !hasMappedBytes(_binaryReader, subMeshCount, 2 * sizeof(unsigned int) + 6 * sizeof(float)))
+        {
+            CCLOG("warning: Failed to read meshdata: subMeshCount '%s'.", _path.c_str());
+            meshdatas.resetData();
+            return false;
+        }
+        for (unsigned int k = 0; k < subMeshCount; k++)
+        {
+            meshData->subMeshIds.push_back(_binaryReader.readString());
+            
+            float minMax[6];
+            MeshData::IndexArray indices;
+            if (_binaryReader.read(minMax, sizeof(float), 6) != 6 || !readMappedArray(_binaryReader, indices, true))
+            {
+                CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
+                meshdatas.resetData();
+                return false;
+            }
+            meshData->subMeshAABB.push_back(AABB(Vec3(minMax[0], minMax[1], minMax[2]), Vec3(minMax[3], minMax[4], minMax[5])));
+            meshData->subMeshIndices.push_back(std::move(indices));
+        }
+        meshData->numIndex = static_cast<int>(meshData->subMeshIndices.size());
+    }
+    return true;
+}
+
+bool Bundle3D::loadNodesMapped(NodeDatas& nodedatas)
+{
+    if (!seekToFirstType(BUNDLE_TYPE_NODE))
+        return false;
+    
+    for (auto nodes : { &nodedatas.skeleton, &nodedatas.nodes })
+    {
+        unsigned int nodeCount = 0;
+        if (!_binaryReader.read(&nodeCount))
+        {
+            CCLOG("warning: Failed to read nodes '%s'.", _path.c_str());
+            nodedatas.resetData();
+            return false;
+        }
+        for (unsigned int i = 0; i < nodeCount; i++)
+        {
+            NodeData* nodedata = parseNodesRecursivelyMapped();
+            if (!nodedata)
+            {
+                nodedatas.resetData();
+                return false;
+            }
+            nodes->push_back(nodedata);
+        }
+    }
+    return true;
+}
+
+NodeData* Bundle3D::parseNodesRecursivelyMapped()
+{
+    auto nodedata = new (std::nothrow) NodeData();
+    nodedata->id = _binaryReader.readString();
+    
+    unsigned int modelCount = 0;
+    if (!_binaryReader.readMatrix(nodedata->transform.m) || !_binaryReader.read(&modelCount))
+    {
+        CCLOG("warning: Failed to read node '%s'.", _path.c_str());
+        delete nodedata;
+        return nullptr;
+    }
+    
+    for (unsigned int i = 0; i < modelCount; i++)
+    {
+        auto modelnode = new (std::nothrow) ModelData();
+        nodedata->modelNodeDatas.push_back(modelnode);
+        modelnode->subMeshId = _binaryReader.readString();
+        modelnode->matrialId = _binaryReader.readString();
+        
+        unsigned int boneCount = 0;
+        if (!_binaryReader.read(&boneCount) || !hasMappedBytes(_binaryReader, boneCount, sizeof(unsigned int)))
+        {
+            CCLOG("warning: Failed to read node bones '%s'.", _path.c_str());
+            delete nodedata;
+            return nullptr;
+        }
+        modelnode->bones.reserve(boneCount);
+        for (unsigned int j = 0; j < boneCount; j++)
+        {
+            modelnode->bones.push_back(_binaryReader.readString());
+        }
+        
+        if (!readMappedArray(_binaryReader, modelnode->invBindPose, false))
+        {
+            CCLOG("warning: Failed to read node bind poses '%s'.", _path.c_str());
+            delete nodedata;
+            return nullptr;
+        }
+    }
+    
+    unsigned int childCount = 0;
+    if (!_binaryReader.read(&childCount))
+    {
+        CCLOG("warning: Failed to read node children '%s'.", _path.c_str());
+        delete nodedata;
+        return nullptr;
+    }
+    for (unsigned int i = 0; i < childCount; i++)
+    {
+        NodeData* child = parseNodesRecursivelyMapped();
+        if (!child)
+        {
+            delete nodedata;
+            return nullptr;
+        }
+        nodedata->children.push_back(child);
+    }
+    return nodedata;
+}
+
+bool Bundle3D::loadMaterialsMapped(MaterialDatas& materialdatas)
+{
+    if (!seekToFirstType(BUNDLE_TYPE_MATERIAL))
+        return false;
+    
+    unsigned int materialCount = 0;
+    if (!_binaryReader.read(&materialCount) || !hasMappedBytes(_binaryReader, materialCount, 2 * sizeof(unsigned int)))
+    {
+        CCLOG("warning: Failed to read Materialdata: materialCount '%s'.", _path.c_str());
+        return false;
+    }
+    
+    materialdatas.materials.resize(materialCount);
+    for (auto& materialData : materialdatas.materials)
+    {
+        materialData.id = _binaryReader.readString();
+        
+        unsigned int textureCount = 0;
+        if (!_binaryReader.read(&textureCount) || !hasMappedBytes(_binaryReader, textureCount, 5 * sizeof(unsigned int)))
+        {
+            CCLOG("warning: Failed to read Materialdata: textureCount '%s'.", _path.c_str());
+            materialdatas.resetData();
+            return false;
+        }
+        materialData.textures.resize(textureCount);
+        for (auto& textureData : materialData.textures)
+        {
+            textureData.id = _binaryReader.readString();
+            std::string filename = _binaryReader.readString();
+            textureData.filename = filename.empty() ? filename : _modelPath + filename;
+            
+            unsigned int type = 0;
+            _binaryReader.read(&type);
+            _binaryReader.read(&textureData.wrapS);
+            _binaryReader.read(&textureData.wrapT);
+            textureData.type = static_cast<NTextureData::Usage>(type);
+        }
+    }
+    return true;
+}
+
+bool Bundle3D::loadAnimationDataMapped(const std::string& id, Animation3DData* animationdata)
+{
+    if (!seekToFirstType(BUNDLE_TYPE_ANIMATIONS))
+        return false;
+    
+    unsigned int animationCount = 0;
+    if (!_binaryReader.read(&animationCount))
+    {
+        CCLOG("warning: Failed to read AnimationData: animNum '%s'.", _path.c_str());
+        return false;
+    }
+    
+    for (unsigned int i = 0; i < animationCount; i++)
+    {
+        animationdata->resetData();
+        std::string animId = _binaryReader.readString();
+        
+        unsigned int boneCount = 0;
+        if (!_binaryReader.read(&animationdata->_totalTime) || !_binaryReader.read(&boneCount))
+        {
+            CCLOG("warning: Failed to read AnimationData: totalTime '%s'.", _path.c_str());
+            break;
+        }
+        
+        bool failed = false;
+        for (unsigned int j = 0; j < boneCount && !failed; j++)
+        {
+            std::string boneName = _binaryReader.readString();
+            std::vector<Animation3DData::Vec3Key> translationKeys, scaleKeys;
+            std::vector<Animation3DData::QuatKey> rotationKeys;
+            failed = !readMappedArray(_binaryReader, translationKeys, false)
+                || !readMappedArray(_binaryReader, rotationKeys, false)
+                || !readMappedArray(_binaryReader, scaleKeys, false);
+            
+            if (!translationKeys.empty())
+                animationdata->_translationKeys[boneName] = std::move(translationKeys);
+            if (!rotationKeys.empty())
+                animationdata->_rotationKeys[boneName] = std::move(rotationKeys);
+            if (!scaleKeys.empty())
+                animationdata->_scaleKeys[boneName] = std::move(scaleKeys);
+        }
+        if (failed)
+        {
+            CCLOG("warning: Failed to read AnimationData: keyframes '%s'.", _path.c_str());
+            break;
+        }
+        
+        if (id == animId || id.empty())
+            return true;
+    }
+    
+    animationdata->resetData();
+    return false;
+}
+
 NS_CC_END
@@ -38,12 +38,14 @@ NS_CC_BEGIN
 
 class Animation3D;
 class Data;
+class FileArchive;
 
 /**
  * @brief Defines a bundle file that contains a collection of assets. Mesh, Material, MeshSkin, Animation
- * There are two types of bundle files, c3t and c3b.
+ * There are three types of bundle files, c3t, c3b and c3m.
  * c3t text file
  * c3b binary file
+ * c3m binary file with the vertices and indices ready for upload, written by convertToMapped()
  * @js NA
  * @lua NA
  */
@@ -96,6 +98,16 @@ public:
     
     //calculate aabb
     static AABB calculateAABB(const std::vector<float>& vertex, int stride, const std::vector<unsigned short>& index);
+    
+    /**
+     * convert a .c3b, .c3t or .obj file to a .c3m file, loaded without parsing the vertices and the indices.
+     * The meshes, nodes, materials and animations are kept, the texture paths stay relative to the model.
+     * Only the first animation of c3b files older than 0.5 is kept.
+     * @param srcPath the model to convert
+     * @param dstFullPath full path of the .c3m file to write
+     * @return result of the conversion
+     */
+    static bool convertToMapped(const std::string& srcPath, const std::string& dstFullPath);
   
 protected:
 
@@ -123,6 +135,22 @@ protected:
     bool loadMaterialDataJson_0_2(MaterialData* materialdata){return true;}
     bool loadAnimationDataJson(const std::string& id,Animation3DData* animationdata);
     bool loadAnimationDataBinary(const std::string& id,Animation3DData* animationdata);
+    
+    /**
+     * load a c3m file. It starts with the "C3M" identifier, the version and a table of sections (type, offset, size),
+     * and stores the mesh, node, material and animation sections. Vertices and indices are stored as arrays
+     * aligned to 16 bytes, in the layout of MeshData. The file is read in place when it is memory mapped by
+     * a FileArchive, see FileUtils::addArchive().
+     */
+    bool loadMapped(const std::string& path);
+    bool loadMeshDatasMapped(MeshDatas& meshdatas);
+    bool loadNodesMapped(NodeDatas& nodedatas);
+    NodeData* parseNodesRecursivelyMapped();
+    bool loadMaterialsMapped(MaterialDatas& materialdatas);
+    bool loadAnimationDataMapped(const std::string& id, Animation3DData* animationdata);
+    
+    /** ids of all the animations of the loaded bundle */
+    std::vector<std::string> getAnimationIds();
 
     /**
      * load nodes of json
@@ -186,6 +214,10 @@ protected:
     unsigned int _referenceCount;
     Reference* _references;
     bool  _isBinary;
+    
+    // for c3m reading, the binary reader reads the archive mapping when there is no buffer
+    bool  _isMapped;
+    FileArchive* _mappedArchive;
 };
 
 // end of 3d group
@@ -149,6 +149,7 @@ struct MeshData
     std::vector<IndexArray> subMeshIndices;
     std::vector<std::string> subMeshIds; //subMesh Names (since 3.3)
     std::vector<AABB> subMeshAABB;
+    std::vector<std::vector<IndexArray>> subMeshLODIndices; //simplified levels of each subMesh, see Sprite3D::setMeshLODRatios
     int numIndex;
     std::vector<MeshVertexAttrib> attribs;
     int attribCount;
@@ -176,6 +177,7 @@ public:
         vertex.clear();
         subMeshIndices.clear();
         subMeshAABB.clear();
+        subMeshLODIndices.clear();
         attribs.clear();
         vertexSizeInFloat = 0;
         numIndex = 0;
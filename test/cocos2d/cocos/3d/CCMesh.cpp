@@ -126,6 +126,7 @@ Mesh::Mesh()
 , _visible(true)
 , _isTransparent(false)
 , _meshIndexData(nullptr)
+, _lodLevel(0)
 , _material(nullptr)
 , _glProgramState(nullptr)
 , _blend(BlendFunc::ALPHA_NON_PREMULTIPLIED)
@@ -351,7 +352,7 @@ void Mesh::setMaterial(Material* material)
         {
             for (auto pass: technique->getPasses())
             {
-                auto vertexAttribBinding = VertexAttribBinding::create(_meshIndexData, pass->getGLProgramState());
+                auto vertexAttribBinding = VertexAttribBinding::create(getDrawnIndexData(), pass->getGLProgramState());
                 pass->setVertexAttribBinding(vertexAttribBinding);
             }
         }
@@ -441,6 +442,7 @@ void Mesh::setMeshIndexData(MeshIndexData* subMesh)
         CC_SAFE_RETAIN(subMesh);
         CC_SAFE_RELEASE(_meshIndexData);
         _meshIndexData = subMesh;
+        _lodLevel = 0;
         calculateAABB();
         bindMeshCommand();
     }
@@ -511,7 +513,7 @@ void Mesh::bindMeshCommand()
 //        auto blend = pass->getStateBlock()->getBlendFunc();
         auto blend = BlendFunc::ALPHA_PREMULTIPLIED;
 
-        _meshCommand.genMaterialID(textureid, glprogramstate, _meshIndexData->getVertexBuffer()->getVBO(), _meshIndexData->getIndexBuffer()->getVBO(), blend);
+        _meshCommand.genMaterialID(textureid, glprogramstate, _meshIndexData->getVertexBuffer()->getVBO(), getIndexBuffer(), blend);
         _material->getStateBlock()->setCullFace(true);
         _material->getStateBlock()->setDepthTest(true);
     }
@@ -691,7 +693,7 @@ GLenum Mesh::getPrimitiveType() const
 
 ssize_t Mesh::getIndexCount() const
 {
-    return _meshIndexData->getIndexBuffer()->getIndexNumber();
+    return getDrawnIndexData()->getIndexBuffer()->getIndexNumber();
 }
 
 GLenum Mesh::getIndexFormat() const
@@ -701,6 +703,38 @@ GLenum Mesh::getIndexFormat() const
 
 GLuint Mesh::getIndexBuffer() const
 {
-    return _meshIndexData->getIndexBuffer()->getVBO();
+    return getDrawnIndexData()->getIndexBuffer()->getVBO();
+}
+
+void Mesh::setLODLevel(int level)
+{
+    level = std::min(std::max(level, 0), (int)getLODCount());
+    if (level == _lodLevel)
+        return;
+    
+    _lodLevel = level;
+    if (_material)
+    {
+        // the vertex attrib bindings hold the index buffer
+        auto indexData = getDrawnIndexData();
+        for (auto technique: _material->getTechniques())
+        {
+            for (auto pass: technique->getPasses())
+            {
+                pass->setVertexAttribBinding(VertexAttribBinding::create(indexData, pass->getGLProgramState()));
+            }
+        }
+    }
+    bindMeshCommand();
+}
+
+ssize_t Mesh::getLODCount() const
+{
+    return _meshIndexData ? _meshIndexData->getLODCount() : 0;
+}
+
+MeshIndexData* Mesh::getDrawnIndexData() const
+{
+    return _lodLevel > 0 ? _meshIndexData->getLOD(_lodLevel - 1) : _meshIndexData;
 }
 NS_CC_END
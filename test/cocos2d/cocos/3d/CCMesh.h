@@ -188,6 +188,15 @@ public:
     
     /**get AABB*/
     const AABB& getAABB() const { return _aabb; }
+    
+    /**
+     * set the level of detail drawn, 0 draws the mesh index data, level i + 1 its level of detail i.
+     * It is clamped to the levels of the mesh index data, see MeshIndexData::addLOD()
+     */
+    void setLODLevel(int level);
+    int getLODLevel() const { return _lodLevel; }
+    /** get the count of levels of detail, not counting the full one */
+    ssize_t getLODCount() const;
 
     /**  Sets a new GLProgramState for the Mesh
      * A new Material will be created for it
@@ -236,6 +245,8 @@ protected:
     void resetLightUniformValues();
     void setLightUniforms(Pass* pass, Scene* scene, const Vec4& color, unsigned int lightmask);
     void bindMeshCommand();
+    /** the index data of the level of detail drawn */
+    MeshIndexData* getDrawnIndexData() const;
 
     std::map<NTextureData::Usage, Texture2D*> _textures; //textures that submesh is using
     MeshSkin*           _skin;     //skin
@@ -246,6 +257,7 @@ protected:
     std::string         _name;
     MeshCommand         _meshCommand;
     MeshIndexData*      _meshIndexData;
+    int                 _lodLevel;
     GLProgramState*     _glProgramState;
     BlendFunc           _blend;
     bool                _blendDirty;
@@ -0,0 +1,368 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+
+#include "3d/CCMeshSimplifier.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <queue>
+
+NS_CC_BEGIN
+
+namespace
+{
+    // symmetric 4x4 matrix of the squared distance to a set of planes
+    struct Quadric
+    {
+        double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+
+        Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0) {}
+
+        void addPlane(double a, double b, double c, double d, double weight)
+        {
+            a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+            a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+            a22 += weight * c * c; a23 += weight * c * d;
+            a33 += weight * d * d;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+        }
+
+        double evaluate(const float* p) const
+        {
+            double x = p[0], y = p[1], z = p[2];
+            return x * (a00 * x + 2 * (a01 * y + a02 * z + a03))
+                 + y * (a11 * y + 2 * (a12 * z + a13))
+                 + z * (a22 * z + 2 * a23)
+                 + a33;
+        }
+    };
+
+    struct Collapse
+    {
+        float cost;
+        int from;
+        int to;
+        unsigned int fromVersion;
+        unsigned int toVersion;
+
+        bool operator<(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    void triangleNormal(const float* p0, const float* p1, const float* p2, float* normal)
+    {
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const std::vector<float>& vertices, int perVertexSizeInFloat, int positionOffsetInFloat, const std::vector<unsigned short>& indices)
+        : _vertices(vertices)
+        , _stride(perVertexSizeInFloat)
+        , _offset(positionOffsetInFloat)
+        , _indices(indices)
+        , _vertexCount(static_cast<int>(vertices.size() / perVertexSizeInFloat))
+        , _aliveTriangles(0)
+        , _maxError(0.f)
+        {
+        }
+
+        float run(float ratio, std::vector<unsigned short>& result)
+        {
+            build();
+
+            size_t target = static_cast<size_t>(_aliveTriangles * std::min(std::max(ratio, 0.f), 1.f));
+            while (_aliveTriangles > target && !_queue.empty())
+            {
+                Collapse collapse = _queue.top();
+                _queue.pop();
+                if (_removed[collapse.from] || _removed[collapse.to]
+                    || _versions[collapse.from] != collapse.fromVersion || _versions[collapse.to] != collapse.toVersion)
+                    continue;
+                if (!canCollapse(collapse.from, collapse.to))
+                    continue;
+
+                _maxError = std::max(_maxError, collapse.cost);
+                apply(collapse.from, collapse.to);
+            }
+
+            result.clear();
+            result.reserve(_aliveTriangles * 3);
+            for (size_t i = 0, count = _triangles.size() / 3; i < count; i++)
+            {
+                if (_aliveTriangle[i])
+                    result.insert(result.end(), _triangles.begin() + i * 3, _triangles.begin() + i * 3 + 3);
+            }
+            return _maxError;
+        }
+
+    private:
+        const float* position(int vertex) const { return &_vertices[vertex * _stride + _offset]; }
+
+        void build()
+        {
+            size_t triangleCount = _indices.size() / 3;
+            _triangles.assign(_indices.begin(), _indices.begin() + triangleCount * 3);
+            _aliveTriangle.assign(triangleCount, true);
+            _aliveTriangles = triangleCount;
+            _quadrics.assign(_vertexCount, Quadric());
+            _vertexTriangles.assign(_vertexCount, std::vector<int>());
+            _removed.assign(_vertexCount, false);
+            _locked.assign(_vertexCount, false);
+            _versions.assign(_vertexCount, 0);
+
+            std::vector<std::pair<unsigned int, int>> edges;
+            edges.reserve(triangleCount * 3);
+            for (size_t i = 0; i < triangleCount; i++)
+            {
+                int v[3] = { _triangles[i * 3], _triangles[i * 3 + 1], _triangles[i * 3 + 2] };
+                if (v[0] >= _vertexCount || v[1] >= _vertexCount || v[2] >= _vertexCount
+                    || v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+                {
+                    // kept as is
+                    for (int k = 0; k < 3; k++)
+                    {
+                        if (v[k] < _vertexCount)
+                            _locked[v[k]] = true;
+                    }
+                    continue;
+                }
+
+                float normal[3];
+                triangleNormal(position(v[0]), position(v[1]), position(v[2]), normal);
+                double length = sqrt((double)normal[0] * normal[0] + (double)normal[1] * normal[1] + (double)normal[2] * normal[2]);
+                if (length > 0)
+                {
+                    double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+                    const float* p = position(v[0]);
+                    double d = -(a * p[0] + b * p[1] + c * p[2]);
+                    // weighted by the area, the small triangles don't pull the large ones
+                    for (int k = 0; k < 3; k++)
+                        _quadrics[v[k]].addPlane(a, b, c, d, length * 0.5);
+                }
+
+                for (int k = 0; k < 3; k++)
+                {
+                    _vertexTriangles[v[k]].push_back(static_cast<int>(i));
+                    unsigned int a = v[k], b = v[(k + 1) % 3];
+                    edges.push_back(std::make_pair(std::min(a, b) << 16 | std::max(a, b), 0));
+                }
+            }
+
+            // the edges of a border or a seam have one triangle, the non manifold ones more than two
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size();)
+            {
+                size_t j = i;
+                while (j < edges.size() && edges[j].first == edges[i].first)
+                    j++;
+                if (j - i != 2)
+                {
+                    _locked[edges[i].first >> 16] = true;
+                    _locked[edges[i].first & 0xffff] = true;
+                }
+                i = j;
+            }
+
+            for (int vertex = 0; vertex < _vertexCount; vertex++)
+                pushCollapses(vertex);
+        }
+
+        void neighbours(int vertex, std::vector<int>& result) const
+        {
+            result.clear();
+            for (auto triangle : _vertexTriangles[vertex])
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    int other = _triangles[triangle * 3 + k];
+                    if (other != vertex && std::find(result.begin(), result.end(), other) == result.end())
+                        result.push_back(other);
+                }
+            }
+        }
+
+        // queues the collapses of the edges around a vertex, in both directions
+        void pushCollapses(int vertex)
+        {
+            std::vector<int> others;
+            neighbours(vertex, others);
+            for (auto other : others)
+            {
+                pushCollapse(vertex, other);
+                pushCollapse(other, vertex);
+            }
+        }
+
+        void pushCollapse(int from, int to)
+        {
+            if (_locked[from])
+                return;
+
+            Quadric quadric = _quadrics[from];
+            quadric.add(_quadrics[to]);
+            Collapse collapse;
+            collapse.cost = static_cast<float>(std::max(0.0, quadric.evaluate(position(to))));
+            collapse.from = from;
+            collapse.to = to;
+            collapse.fromVersion = _versions[from];
+            collapse.toVersion = _versions[to];
+            _queue.push(collapse);
+        }
+
+        bool canCollapse(int from, int to)
+        {
+            // the vertices shared by both ends must be the ones of the triangles on the edge, or the surface pinches
+            int shared = 0;
+            for (auto triangle : _vertexTriangles[from])
+            {
+                const unsigned short* v = &_triangles[triangle * 3];
+                if (v[0] == to || v[1] == to || v[2] == to)
+                    shared++;
+            }
+            if (shared == 0)
+                return false;
+
+            neighbours(from, _fromNeighbours);
+            neighbours(to, _toNeighbours);
+            int common = 0;
+            for (auto vertex : _fromNeighbours)
+            {
+                if (std::find(_toNeighbours.begin(), _toNeighbours.end(), vertex) != _toNeighbours.end())
+                    common++;
+            }
+            if (common != shared)
+                return false;
+
+            // the triangles left around the removed vertex mustn't turn over
+            const float* target = position(to);
+            for (auto triangle : _vertexTriangles[from])
+            {
+                const unsigned short* v = &_triangles[triangle * 3];
+                if (v[0] == to || v[1] == to || v[2] == to)
+                    continue;
+
+                const float* before[3] = { position(v[0]), position(v[1]), position(v[2]) };
+                const float* after[3] = { before[0], before[1], before[2] };
+                for (int k = 0; k < 3; k++)
+                {
+                    if (v[k] == from)
+                        after[k] = target;
+                }
+                float n0[3], n1[3];
+                triangleNormal(before[0], before[1], before[2], n0);
+                triangleNormal(after[0], after[1], after[2], n1);
+                if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.f)
+                    return false;
+            }
+            return true;
+        }
+
+        void apply(int from, int to)
+        {
+            for (auto triangle : _vertexTriangles[from])
+            {
+                unsigned short* v = &_triangles[triangle * 3];
+                if (v[0] == to || v[1] == to || v[2] == to)
+                {
+                    // the triangles of the edge disappear
+                    _aliveTriangle[triangle] = false;
+                    _aliveTriangles--;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        if (v[k] != from)
+                        {
+                            auto& list = _vertexTriangles[v[k]];
+                            list.erase(std::find(list.begin(), list.end(), triangle));
+                        }
+                    }
+                }
+                else
+                {
+                    for (int k = 0; k < 3; k++)
+                    {
+                        if (v[k] == from)
+                            v[k] = static_cast<unsigned short>(to);
+                    }
+                    _vertexTriangles[to].push_back(triangle);
+                }
+            }
+            _vertexTriangles[from].clear();
+            _removed[from] = true;
+            _quadrics[to].add(_quadrics[from]);
+
+            // the queued costs of the edges around the kept vertex are outdated
+            _versions[to]++;
+            pushCollapses(to);
+        }
+
+        const std::vector<float>& _vertices;
+        int _stride;
+        int _offset;
+        const std::vector<unsigned short>& _indices;
+        int _vertexCount;
+
+        std::vector<unsigned short> _triangles;
+        std::vector<bool> _aliveTriangle;
+        size_t _aliveTriangles;
+        std::vector<Quadric> _quadrics;
+        std::vector<std::vector<int>> _vertexTriangles;
+        std::vector<bool> _removed;
+        std::vector<bool> _locked;
+        std::vector<unsigned int> _versions;
+        std::priority_queue<Collapse> _queue;
+        std::vector<int> _fromNeighbours;
+        std::vector<int> _toNeighbours;
+        float _maxError;
+    };
+}
+
+float MeshSimplifier::simplify(const std::vector<float>& vertices, int perVertexSizeInFloat, int positionOffsetInFloat,
+                               const std::vector<unsigned short>& indices, float ratio, std::vector<unsigned short>& result)
+{
+    if (perVertexSizeInFloat < positionOffsetInFloat + 3 || positionOffsetInFloat < 0)
+    {
+        result = indices;
+        return 0.f;
+    }
+
+    Simplifier simplifier(vertices, perVertexSizeInFloat, positionOffsetInFloat, indices);
+    return simplifier.run(ratio, result);
+}
+
+NS_CC_END
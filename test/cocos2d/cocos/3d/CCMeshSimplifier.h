@@ -0,0 +1,73 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+
+#ifndef __CCMESHSIMPLIFIER_H__
+#define __CCMESHSIMPLIFIER_H__
+
+#include <vector>
+
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+/**
+ * @brief Reduces the triangles of a mesh by collapsing its edges in the order of the quadric error metric (Garland and Heckbert).
+ *
+ * An edge is collapsed onto one of its vertices, so the simplified indices still refer to the vertices
+ * of the original mesh and can share its vertex buffer. The vertices on the borders, on the texture
+ * or normal seams, and on the non manifold edges aren't removed, and no collapse flips a triangle.
+ * It is run when a model is loaded for the levels of detail set by Sprite3D::setMeshLODRatios(), tools can run it offline.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL MeshSimplifier
+{
+public:
+    /**
+     * Simplifies a list of triangles.
+     * @param vertices the interleaved vertices.
+     * @param perVertexSizeInFloat the size of a vertex.
+     * @param positionOffsetInFloat the offset of the position, 3 floats, in a vertex.
+     * @param indices the triangles to simplify.
+     * @param ratio the part of the triangles to keep, from 0 to 1.
+     * @param result the kept triangles, it may have more than ratio of the triangles when no edge can be collapsed any more.
+     * @return the largest error of the collapsed edges, as a squared distance to the original surface.
+     */
+    static float simplify(const std::vector<float>& vertices, int perVertexSizeInFloat, int positionOffsetInFloat,
+                          const std::vector<unsigned short>& indices, float ratio, std::vector<unsigned short>& result);
+};
+
+// end of 3d group
+/// @}
+
+NS_CC_END
+
+#endif // __CCMESHSIMPLIFIER_H__
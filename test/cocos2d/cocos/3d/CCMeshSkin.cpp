@@ -35,6 +35,7 @@ MeshSkin::MeshSkin()
 : _rootBone(nullptr)
 , _skeleton(nullptr)
 , _matrixPalette(nullptr)
+, _paletteUpdateCount(0)
 {
     
 }
@@ -99,10 +100,17 @@ int MeshSkin::getBoneIndex(Bone3D* bone) const
 //compute matrix palette used by gpu skin
 Vec4* MeshSkin::getMatrixPalette()
 {
+    _skeleton->updateBoneMatrix();
     if (_matrixPalette == nullptr)
     {
         _matrixPalette = new (std::nothrow) Vec4[_skinBones.size() * PALETTE_ROWS];
     }
+    else if (_paletteUpdateCount == _skeleton->getUpdateCount())
+    {
+        // every pass of every mesh asks for it, the bones didn't move since it was computed
+        return _matrixPalette;
+    }
+    _paletteUpdateCount = _skeleton->getUpdateCount();
     int i = 0, paletteIndex = 0;
     static Mat4 t;
     for (auto it : _skinBones )
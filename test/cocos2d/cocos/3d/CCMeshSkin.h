@@ -67,7 +67,7 @@ public:
     /**get bone index*/
     int getBoneIndex(Bone3D* bone) const;
     
-    /**compute matrix palette used by gpu skin*/
+    /**compute matrix palette used by gpu skin, it is only rebuilt when the skeleton was updated since the last call*/
     Vec4* getMatrixPalette();
     
     /**getSkinBoneCount() * 3*/
@@ -104,6 +104,8 @@ protected:
     // Each 4x3 row-wise matrix is represented as 3 Vec4's.
     // The number of Vec4's is (_skinBones.size() * 3).
     Vec4* _matrixPalette;
+    // Skeleton3D::getUpdateCount() when _matrixPalette was computed
+    unsigned int _paletteUpdateCount;
 };
 
 // end of 3d group
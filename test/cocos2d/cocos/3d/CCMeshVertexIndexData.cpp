@@ -62,6 +62,12 @@ MeshIndexData* MeshIndexData::create(const std::string& id, MeshVertexData* vert
     return meshindex;
 }
 
+void MeshIndexData::addLOD(MeshIndexData* lod)
+{
+    CCASSERT(lod && lod->_vertexData == _vertexData, "a level of detail must use the same vertex data");
+    _lods.pushBack(lod);
+}
+
 const VertexBuffer* MeshIndexData::getVertexBuffer() const
 {
     return _vertexData->getVertexBuffer();
@@ -117,6 +123,17 @@ MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
         else
             indexdata = MeshIndexData::create(id, vertexdata, indexBuffer, meshdata.subMeshAABB[i]);
         
+        // the levels of detail share the vertices of the full mesh
+        if (i < meshdata.subMeshLODIndices.size())
+        {
+            for (const auto& lodIndex : meshdata.subMeshLODIndices[i])
+            {
+                auto lodBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)(lodIndex.size()));
+                lodBuffer->updateIndices(&lodIndex[0], (int)lodIndex.size(), 0);
+                indexdata->addLOD(MeshIndexData::create(id, vertexdata, lodBuffer, indexdata->getAABB()));
+            }
+        }
+        
         vertexdata->_indexs.pushBack(indexdata);
     }
     
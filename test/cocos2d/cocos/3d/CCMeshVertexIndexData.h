@@ -80,6 +80,16 @@ public:
     GLenum getPrimitiveType() const { return _primitiveType; }
     void   setPrimitiveType(GLenum primitive) { _primitiveType = primitive; }
     
+    /**
+     * add a level of detail, simplified indices of the same vertex data, from the most detailed one.
+     * Mesh::setLODLevel() draws level i + 1 with the index data added at i
+     */
+    void addLOD(MeshIndexData* lod);
+    /** get the count of levels of detail, not counting this index data */
+    ssize_t getLODCount() const { return _lods.size(); }
+    /** get a level of detail by index */
+    MeshIndexData* getLOD(int index) const { return _lods.at(index); }
+    
 CC_CONSTRUCTOR_ACCESS:
     MeshIndexData();
     virtual ~MeshIndexData();
@@ -90,6 +100,7 @@ protected:
     AABB           _aabb; // original aabb of the submesh
     std::string    _id; //id
     GLenum         _primitiveType;
+    Vector<MeshIndexData*> _lods; //simplified levels
     
     friend class MeshVertexData;
     friend class Sprite3D;
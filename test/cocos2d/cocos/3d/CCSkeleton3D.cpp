@@ -50,6 +50,8 @@ void Bone3D::setOriPose(const Mat4& m)
 void Bone3D::resetPose()
 {
     _local =_oriPose;
+    if (_skeleton)
+        _skeleton->_bonesDirty = true;
     
     for (auto it : _children) {
         it->resetPose();
@@ -93,6 +95,9 @@ const Mat4& Bone3D::getWorldMat()
 
 void Bone3D::setAnimationValue(float* trans, float* rot, float* scale, void* tag, float weight)
 {
+    if (_skeleton)
+        _skeleton->_bonesDirty = true;
+    
     for (auto& it : _blendStates) {
         if (it.tag == tag)
         {
@@ -166,23 +171,32 @@ void Bone3D::addChildBone(Bone3D* bone)
 {
     if (_children.find(bone) == _children.end())
        _children.pushBack(bone);
+    if (_skeleton)
+        _skeleton->_boneOrderDirty = _skeleton->_bonesDirty = true;
 }
 void Bone3D::removeChildBoneByIndex(int index)
 {
     _children.erase(index);
+    if (_skeleton)
+        _skeleton->_boneOrderDirty = _skeleton->_bonesDirty = true;
 }
 void Bone3D::removeChildBone(Bone3D* bone)
 {
     _children.eraseObject(bone);
+    if (_skeleton)
+        _skeleton->_boneOrderDirty = _skeleton->_bonesDirty = true;
 }
 void Bone3D::removeAllChildBone()
 {
     _children.clear();
+    if (_skeleton)
+        _skeleton->_boneOrderDirty = _skeleton->_bonesDirty = true;
 }
 
 Bone3D::Bone3D(const std::string& id)
 : _name(id)
 , _parent(nullptr)
+, _skeleton(nullptr)
 , _worldDirty(true)
 {
     
@@ -246,12 +260,18 @@ void Bone3D::updateLocalMat()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Skeleton3D::Skeleton3D()
+: _bonesDirty(true)
+, _boneOrderDirty(true)
+, _updateCount(0)
 {
     
 }
 
 Skeleton3D::~Skeleton3D()
 {
+    for (const auto& it : _bones) {
+        it->_skeleton = nullptr;
+    }
     removeAllBones();
 }
 
@@ -315,26 +335,60 @@ int Skeleton3D::getBoneIndex(Bone3D* bone) const
 //refresh bone world matrix
 void Skeleton3D::updateBoneMatrix()
 {
+    // several meshes and cameras draw the same skeleton in a frame, the bones only change when animated
+    if (!_bonesDirty)
+        return;
+    
+    if (_boneOrderDirty)
+        sortBones();
+    
+    // one linear pass, the world matrix of the parent is always computed first
+    for (auto bone : _sortedBones) {
+        bone->updateLocalMat();
+        if (bone->_parent)
+            Mat4::multiply(bone->_parent->_world, bone->_local, &bone->_world);
+        else
+            bone->_world = bone->_local;
+        bone->_worldDirty = false;
+    }
+    
+    _bonesDirty = false;
+    _updateCount++;
+}
+
+void Skeleton3D::sortBones()
+{
+    _sortedBones.clear();
     for (const auto& it : _rootBones) {
-        it->setWorldMatDirty(true);
-        it->updateWorldMat();
+        _sortedBones.push_back(it);
+    }
+    for (size_t i = 0; i < _sortedBones.size(); i++) {
+        for (const auto& child : _sortedBones[i]->_children) {
+            _sortedBones.push_back(child);
+        }
     }
+    _boneOrderDirty = false;
 }
 
 void Skeleton3D::removeAllBones()
 {
     _bones.clear();
     _rootBones.clear();
+    _sortedBones.clear();
+    _boneOrderDirty = _bonesDirty = true;
 }
 
 void Skeleton3D::addBone(Bone3D* bone)
 {
     _bones.pushBack(bone);
+    bone->_skeleton = this;
+    _boneOrderDirty = _bonesDirty = true;
 }
 
 Bone3D* Skeleton3D::createBone3D(const NodeData& nodedata)
 {
     auto bone = Bone3D::create(nodedata.id);
+    bone->_skeleton = this;
     for (const auto& it : nodedata.children) {
         auto child = createBone3D(*it);
         bone->addChildBone(child);
@@ -37,6 +37,8 @@ NS_CC_BEGIN
  * @{
  */
 
+class Skeleton3D;
+
 /**
  * @brief Defines a basic hierarchical structure of transformation spaces.
  * @lua NA
@@ -172,6 +174,8 @@ protected:
     
     Bone3D* _parent; //parent bone
     
+    Skeleton3D* _skeleton; //skeleton owning the bone, weak ref
+    
     Vector<Bone3D*> _children;
     
     bool          _worldDirty;
@@ -208,9 +212,12 @@ public:
     /**get bone index*/
     int getBoneIndex(Bone3D* bone) const;
     
-    /**refresh bone world matrix*/
+    /**refresh bone world matrix, does nothing if no bone changed since the last refresh*/
     void updateBoneMatrix();
     
+    /**number of times the bone world matrices were refreshed, the matrix palettes are rebuilt when it changes*/
+    unsigned int getUpdateCount() const { return _updateCount; }
+    
 CC_CONSTRUCTOR_ACCESS:
     
     Skeleton3D();
@@ -228,9 +235,19 @@ CC_CONSTRUCTOR_ACCESS:
     
 protected:
     
+    /**sort the bones so that parents come before their children*/
+    void sortBones();
+    
     Vector<Bone3D*> _bones; // bones
 
     Vector<Bone3D*> _rootBones;
+    
+    std::vector<Bone3D*> _sortedBones; // bones reachable from the roots, parents first
+    bool _bonesDirty; // a bone changed since the last updateBoneMatrix
+    bool _boneOrderDirty; // the hierarchy changed since the last sortBones
+    unsigned int _updateCount;
+    
+    friend class Bone3D;
 };
 
 // end of 3d group
@@ -29,15 +29,19 @@
 #include "3d/CCSprite3DMaterial.h"
 #include "3d/CCAttachNode.h"
 #include "3d/CCMesh.h"
+#include "3d/CCMeshSimplifier.h"
 #include "3d/CCSprite3DMaterial.h"
 
 #include "base/CCDirector.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCScheduler.h"
+#include "base/ccUtils.h"
 #include "2d/CCLight.h"
 #include "2d/CCCamera.h"
 #include "base/ccMacros.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
 #include "renderer/CCTextureCache.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCGLProgramState.h"
@@ -48,9 +52,12 @@
 
 #include "deprecated/CCString.h" // For StringUtils::format
 
+#include <deque>
+
 NS_CC_BEGIN
 
 static Sprite3DMaterial* getSprite3DMaterialForAttribs(MeshVertexData* meshVertexData, bool usesLight);
+static float getProjectedSize(const AABB& aabb, const Camera* camera);
 
 Sprite3D* Sprite3D::create()
 {
@@ -114,66 +121,211 @@ void Sprite3D::createAsync(const std::string& modelPath, const std::string& text
     sprite->_asyncLoadParam.materialdatas = new (std::nothrow) MaterialDatas();
     sprite->_asyncLoadParam.meshdatas = new (std::nothrow) MeshDatas();
     sprite->_asyncLoadParam.nodeDatas = new (std::nothrow) NodeDatas();
+    sprite->_asyncLoadParam.uploadStep = 0;
+    sprite->_asyncLoadParam.meshLODRatios = getMeshLODRatios(modelPath);
     AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_IO, CC_CALLBACK_1(Sprite3D::afterAsyncLoad, sprite), (void*)(&sprite->_asyncLoadParam), [sprite]()
     {
         sprite->_asyncLoadParam.result = sprite->loadFromFile(sprite->_asyncLoadParam.modlePath, sprite->_asyncLoadParam.nodeDatas, sprite->_asyncLoadParam.meshdatas, sprite->_asyncLoadParam.materialdatas);
+        if (sprite->_asyncLoadParam.result)
+            sprite->prepareAsyncLoad();
     });
     
 }
 
+// sprites loaded by createAsync, waiting for their uploads
+static std::deque<Sprite3D*> s_asyncUploads;
+static float s_asyncUploadBudget = 0.002f;
+
+void Sprite3D::setAsyncUploadBudget(float seconds)
+{
+    s_asyncUploadBudget = seconds;
+}
+
+float Sprite3D::getAsyncUploadBudget()
+{
+    return s_asyncUploadBudget;
+}
+
+void Sprite3D::prepareAsyncLoad()
+{
+    // MeshVertexData::create computes the missing bounding boxes otherwise
+    for (auto meshdata : _asyncLoadParam.meshdatas->meshDatas)
+    {
+        if (meshdata && meshdata->subMeshAABB.size() != meshdata->subMeshIndices.size())
+        {
+            meshdata->subMeshAABB.clear();
+            for (const auto& indices : meshdata->subMeshIndices)
+            {
+                meshdata->subMeshAABB.push_back(Bundle3D::calculateAABB(meshdata->vertex, meshdata->getPerVertexSize(), indices));
+            }
+        }
+    }
+    generateMeshLODs(*_asyncLoadParam.meshdatas, _asyncLoadParam.meshLODRatios);
+    
+    // the textures the meshes are going to use, keyed by full path in the texture cache
+    std::vector<std::string> textures;
+    for (const auto& material : _asyncLoadParam.materialdatas->materials)
+    {
+        for (const auto& texture : material.textures)
+        {
+            if (!texture.filename.empty() && (texture.type == NTextureData::Usage::Diffuse || texture.type == NTextureData::Usage::Normal))
+                textures.push_back(texture.filename);
+        }
+    }
+    if (!_asyncLoadParam.texPath.empty())
+        textures.push_back(_asyncLoadParam.texPath);
+    
+    auto fileUtils = FileUtils::getInstance();
+    for (const auto& texture : textures)
+    {
+        std::string fullPath = fileUtils->fullPathForFilename(texture);
+        bool decoded = false;
+        for (const auto& it : _asyncLoadParam.images)
+        {
+            decoded = decoded || it.first == fullPath;
+        }
+        if (fullPath.empty() || decoded)
+            continue;
+        
+        auto image = new (std::nothrow) Image();
+        if (image && image->initWithImageFile(fullPath))
+            _asyncLoadParam.images.push_back(std::make_pair(fullPath, image));
+        else
+            CC_SAFE_RELEASE(image);
+    }
+}
+
+bool Sprite3D::uploadAsyncStep()
+{
+    auto& step = _asyncLoadParam.uploadStep;
+    auto& images = _asyncLoadParam.images;
+    if (step < images.size())
+    {
+        auto textureCache = Director::getInstance()->getTextureCache();
+        auto& image = images[step++];
+        if (!textureCache->getTextureForKey(image.first))
+            textureCache->addImage(image.second, image.first);
+        CC_SAFE_RELEASE_NULL(image.second);
+        return false;
+    }
+    
+    const auto& meshdatas = _asyncLoadParam.meshdatas->meshDatas;
+    while (step - images.size() < meshdatas.size())
+    {
+        auto meshdata = meshdatas[step++ - images.size()];
+        if (meshdata)
+        {
+            _meshVertexDatas.pushBack(MeshVertexData::create(*meshdata));
+            return false;
+        }
+    }
+    return true;
+}
+
+void Sprite3D::updateAsyncUploads(float dt)
+{
+    CC_UNUSED_PARAM(dt);
+    // at least one upload per frame, then as many as the budget allows
+    double start = utils::gettime();
+    do
+    {
+        auto sprite = s_asyncUploads.front();
+        if (sprite->uploadAsyncStep())
+        {
+            s_asyncUploads.pop_front();
+            sprite->finishAsyncLoad();
+        }
+    } while (!s_asyncUploads.empty() && utils::gettime() - start < s_asyncUploadBudget);
+    
+    if (s_asyncUploads.empty())
+        Director::getInstance()->getScheduler()->unschedule("Sprite3D::updateAsyncUploads", &s_asyncUploads);
+}
+
+void Sprite3D::purgeAsyncUploads()
+{
+    Director::getInstance()->getScheduler()->unschedule("Sprite3D::updateAsyncUploads", &s_asyncUploads);
+    for (auto sprite : s_asyncUploads)
+    {
+        auto& asyncParam = sprite->_asyncLoadParam;
+        for (auto& image : asyncParam.images)
+        {
+            CC_SAFE_RELEASE_NULL(image.second);
+        }
+        asyncParam.images.clear();
+        CC_SAFE_DELETE(asyncParam.meshdatas);
+        CC_SAFE_DELETE(asyncParam.materialdatas);
+        CC_SAFE_DELETE(asyncParam.nodeDatas);
+        // retained by createAsync
+        sprite->release();
+    }
+    s_asyncUploads.clear();
+}
+
 void Sprite3D::afterAsyncLoad(void* param)
 {
     Sprite3D::AsyncLoadParam* asyncParam = (Sprite3D::AsyncLoadParam*)param;
+    if (asyncParam && asyncParam->result)
+    {
+        _meshes.clear();
+        _meshVertexDatas.clear();
+        CC_SAFE_RELEASE_NULL(_skeleton);
+        removeAllAttachNode();
+        
+        // the GPU objects are created across the next frames
+        s_asyncUploads.push_back(this);
+        auto scheduler = Director::getInstance()->getScheduler();
+        if (!scheduler->isScheduled("Sprite3D::updateAsyncUploads", &s_asyncUploads))
+            scheduler->schedule(&Sprite3D::updateAsyncUploads, &s_asyncUploads, 0, false, "Sprite3D::updateAsyncUploads");
+        return;
+    }
+    finishAsyncLoad();
+}
+
+void Sprite3D::finishAsyncLoad()
+{
+    Sprite3D::AsyncLoadParam* asyncParam = &_asyncLoadParam;
     autorelease();
-    if (asyncParam)
+    if (asyncParam->result)
     {
-        if (asyncParam->result)
+        //create in the main thread, the mesh vertex datas and the textures are already uploaded
+        auto& meshdatas = asyncParam->meshdatas;
+        auto& materialdatas = asyncParam->materialdatas;
+        auto&   nodeDatas = asyncParam->nodeDatas;
+        if (initNodes(*nodeDatas, *materialdatas))
         {
-            _meshes.clear();
-            _meshVertexDatas.clear();
-            CC_SAFE_RELEASE_NULL(_skeleton);
-            removeAllAttachNode();
-            
-            //create in the main thread
-            auto& meshdatas = asyncParam->meshdatas;
-            auto& materialdatas = asyncParam->materialdatas;
-            auto&   nodeDatas = asyncParam->nodeDatas;
-            if (initFrom(*nodeDatas, *meshdatas, *materialdatas))
+            auto spritedata = Sprite3DCache::getInstance()->getSpriteData(asyncParam->modlePath);
+            if (spritedata == nullptr)
             {
-                auto spritedata = Sprite3DCache::getInstance()->getSpriteData(asyncParam->modlePath);
-                if (spritedata == nullptr)
-                {
-                    //add to cache
-                    auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
-                    data->materialdatas = materialdatas;
-                    data->nodedatas = nodeDatas;
-                    data->meshVertexDatas = _meshVertexDatas;
-                    for (const auto mesh : _meshes) {
-                        data->glProgramStates.pushBack(mesh->getGLProgramState());
-                    }
-                    
-                    Sprite3DCache::getInstance()->addSprite3DData(asyncParam->modlePath, data);
-                    
-                    CC_SAFE_DELETE(meshdatas);
-                    materialdatas = nullptr;
-                    nodeDatas = nullptr;
+                //add to cache
+                auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
+                data->materialdatas = materialdatas;
+                data->nodedatas = nodeDatas;
+                data->meshVertexDatas = _meshVertexDatas;
+                for (const auto mesh : _meshes) {
+                    data->glProgramStates.pushBack(mesh->getGLProgramState());
                 }
-            }
-            CC_SAFE_DELETE(meshdatas);
-            CC_SAFE_DELETE(materialdatas);
-            CC_SAFE_DELETE(nodeDatas);
-            
-            if (asyncParam->texPath != "")
-            {
-                setTexture(asyncParam->texPath);
+                
+                Sprite3DCache::getInstance()->addSprite3DData(asyncParam->modlePath, data);
+                
+                CC_SAFE_DELETE(meshdatas);
+                materialdatas = nullptr;
+                nodeDatas = nullptr;
             }
         }
-        else
+        CC_SAFE_DELETE(meshdatas);
+        CC_SAFE_DELETE(materialdatas);
+        CC_SAFE_DELETE(nodeDatas);
+        
+        if (asyncParam->texPath != "")
         {
-            CCLOG("file load failed: %s ", asyncParam->modlePath.c_str());
+            setTexture(asyncParam->texPath);
         }
-        asyncParam->afterLoadCallback(this, asyncParam->callbackParam);
     }
+    else
+    {
+        CCLOG("file load failed: %s ", asyncParam->modlePath.c_str());
+    }
+    asyncParam->afterLoadCallback(this, asyncParam->callbackParam);
 }
 
 AABB Sprite3D::getAABBRecursivelyImp(Node *node)
@@ -237,9 +389,9 @@ bool Sprite3D::loadFromFile(const std::string& path, NodeDatas* nodedatas, MeshD
     {
         return Bundle3D::loadObj(*meshdatas, *materialdatas, *nodedatas, fullPath);
     }
-    else if (ext == ".c3b" || ext == ".c3t")
+    else if (ext == ".c3b" || ext == ".c3t" || ext == ".c3m")
     {
-        //load from .c3b or .c3t
+        //load from .c3b, .c3t or .c3m
         auto bundle = Bundle3D::createBundle();
         if (!bundle->load(fullPath))
         {
@@ -264,7 +416,24 @@ Sprite3D::Sprite3D()
 , _shaderUsingLight(false)
 , _forceDepthWrite(false)
 , _usingAutogeneratedGLProgram(true)
+, _animationLODFrame(0)
+, _animationLODLevel(-1)
+, _animationLODMaxBoneDepth(-1)
+, _animationLODEvaluate(true)
+, _animationCulled(false)
+, _animationLODPhase(0)
+, _lodDrawFrame(0)
+, _lodDrawn(false)
+, _lodVisible(false)
+, _lodMetric(0.f)
+, _evaluatedAnimationCount(0)
+, _skippedAnimationCount(0)
+, _culledAnimationCount(0)
+, _drawnTriangleCount(0)
+, _savedTriangleCount(0)
 {
+    static unsigned int s_animationLODPhase = 0;
+    _animationLODPhase = s_animationLODPhase++;
 }
 
 Sprite3D::~Sprite3D()
@@ -300,6 +469,7 @@ bool Sprite3D::initWithFile(const std::string& path)
     NodeDatas* nodeDatas = new (std::nothrow) NodeDatas();
     if (loadFromFile(path, nodeDatas, meshdatas, materialdatas))
     {
+        generateMeshLODs(*meshdatas, getMeshLODRatios(path));
         if (initFrom(*nodeDatas, *meshdatas, *materialdatas))
         {
             //add to cache
@@ -336,6 +506,11 @@ bool Sprite3D::initFrom(const NodeDatas& nodeDatas, const MeshDatas& meshdatas,
             _meshVertexDatas.pushBack(meshvertex);
         }
     }
+    return initNodes(nodeDatas, materialdatas);
+}
+
+bool Sprite3D::initNodes(const NodeDatas& nodeDatas, const MaterialDatas& materialdatas)
+{
     _skeleton = Skeleton3D::create(nodeDatas.skeleton);
     CC_SAFE_RETAIN(_skeleton);
     
@@ -753,12 +928,18 @@ void Sprite3D::visit(cocos2d::Renderer *renderer, const cocos2d::Mat4 &parentTra
 
 void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
+    if (_animationLODPolicy.enabled && Camera::getVisitingCamera())
+        recordAnimationLOD(Camera::getVisitingCamera());
+    
 #if CC_USE_CULLING
     // camera clipping
     if(_children.size() == 0 && Camera::getVisitingCamera() && !Camera::getVisitingCamera()->isVisibleInFrustum(&getAABB()))
         return;
 #endif
     
+    if (!_meshLODScreenSizes.empty() && Camera::getVisitingCamera())
+        selectMeshLOD(Camera::getVisitingCamera());
+    
     if (_skeleton)
         _skeleton->updateBoneMatrix();
     
@@ -794,6 +975,13 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
                    Vec4(color.r, color.g, color.b, color.a),
                    _forceDepthWrite);
 
+        if (mesh->isVisible() && mesh->getPrimitiveType() == GL_TRIANGLES)
+        {
+            auto drawnTriangles = (unsigned int)mesh->getIndexCount() / 3;
+            auto fullTriangles = (unsigned int)mesh->getMeshIndexData()->getIndexBuffer()->getIndexNumber() / 3;
+            _drawnTriangleCount += drawnTriangles;
+            _savedTriangleCount += fullTriangles - drawnTriangles;
+        }
     }
 }
 
@@ -861,6 +1049,247 @@ const AABB& Sprite3D::getAABB() const
     return _aabb;
 }
 
+void Sprite3D::setAnimationLODPolicy(const AnimationLODPolicy& policy)
+{
+    _animationLODPolicy = policy;
+    _animationLODFrame = 0;
+    _animationLODLevel = -1;
+    _animationLODMaxBoneDepth = -1;
+    _animationLODEvaluate = true;
+    _animationCulled = false;
+    _lodDrawn = false;
+}
+
+void Sprite3D::resetAnimationLODStats()
+{
+    _evaluatedAnimationCount = 0;
+    _skippedAnimationCount = 0;
+    _culledAnimationCount = 0;
+}
+
+// levels of detail to generate, by model path
+static std::unordered_map<std::string, std::vector<float>> s_meshLODRatios;
+
+void Sprite3D::setMeshLODRatios(const std::string& modelPath, const std::vector<float>& ratios)
+{
+    if (ratios.empty())
+        s_meshLODRatios.erase(modelPath);
+    else
+        s_meshLODRatios[modelPath] = ratios;
+}
+
+const std::vector<float>& Sprite3D::getMeshLODRatios(const std::string& modelPath)
+{
+    static const std::vector<float> noRatios;
+    auto it = s_meshLODRatios.find(modelPath);
+    return it != s_meshLODRatios.end() ? it->second : noRatios;
+}
+
+void Sprite3D::generateMeshLODs(MeshDatas& meshdatas, const std::vector<float>& ratios)
+{
+    if (ratios.empty())
+        return;
+    
+    for (auto meshdata : meshdatas.meshDatas)
+    {
+        if (!meshdata)
+            continue;
+        
+        int positionOffset = -1;
+        int offset = 0;
+        for (const auto& attrib : meshdata->attribs)
+        {
+            if (attrib.vertexAttrib == GLProgram::VERTEX_ATTRIB_POSITION)
+            {
+                positionOffset = offset / 4;
+                break;
+            }
+            offset += attrib.attribSizeBytes;
+        }
+        if (positionOffset < 0)
+            continue;
+        
+        int perVertexSize = meshdata->getPerVertexSize() / 4;
+        meshdata->subMeshLODIndices.resize(meshdata->subMeshIndices.size());
+        for (size_t i = 0; i < meshdata->subMeshIndices.size(); i++)
+        {
+            const MeshData::IndexArray& source = meshdata->subMeshIndices[i];
+            if (source.empty())
+                continue;
+            
+            // each level is simplified from the full mesh, so the ratios aren't compounded
+            auto& levels = meshdata->subMeshLODIndices[i];
+            levels.resize(ratios.size());
+            for (size_t level = 0; level < ratios.size(); level++)
+            {
+                MeshSimplifier::simplify(meshdata->vertex, perVertexSize, positionOffset, source, ratios[level], levels[level]);
+                if (levels[level].empty())
+                    levels[level] = source;
+            }
+        }
+    }
+}
+
+void Sprite3D::setMeshLODScreenSizes(const std::vector<float>& screenSizes)
+{
+    _meshLODScreenSizes = screenSizes;
+    if (screenSizes.empty())
+    {
+        for (auto mesh : _meshes)
+            mesh->setLODLevel(0);
+    }
+    
+    for (auto child : _children)
+    {
+        auto sprite = dynamic_cast<Sprite3D*>(child);
+        if (sprite)
+            sprite->setMeshLODScreenSizes(screenSizes);
+    }
+}
+
+void Sprite3D::resetMeshLODStats()
+{
+    _drawnTriangleCount = 0;
+    _savedTriangleCount = 0;
+}
+
+void Sprite3D::selectMeshLOD(const Camera* camera)
+{
+    const AABB& aabb = getAABB();
+    if (aabb.isEmpty())
+        return;
+    
+    float size = getProjectedSize(aabb, camera);
+    int level = 0;
+    for (size_t i = 0; i < _meshLODScreenSizes.size() && size <= _meshLODScreenSizes[i]; i++)
+        level = (int)i + 1;
+    
+    for (auto mesh : _meshes)
+        mesh->setLODLevel(level);
+}
+
+bool Sprite3D::checkAnimationLOD(int* maxBoneDepth)
+{
+    if (!_animationLODPolicy.enabled)
+    {
+        *maxBoneDepth = -1;
+        _evaluatedAnimationCount++;
+        return true;
+    }
+    
+    // decided once per frame, for all the animates blended on the sprite
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    if (frame != _animationLODFrame || !_lodDrawn)
+    {
+        _animationLODFrame = frame;
+        _animationLODLevel = -1;
+        _animationLODMaxBoneDepth = -1;
+        _animationLODEvaluate = true;
+        _animationCulled = false;
+        
+        // nothing is known before the sprite is drawn
+        if (_lodDrawn)
+        {
+            // the draws of this frame come after the scheduler update, the sprite wasn't visited in the previous frame if it has no measure of it
+            bool visible = _lodVisible && _lodDrawFrame + 1 >= frame;
+            if (!visible && _animationLODPolicy.skipWhenCulled)
+            {
+                _animationCulled = true;
+                _animationLODEvaluate = false;
+            }
+            else
+            {
+                bool byDistance = _animationLODPolicy.metric == AnimationLODPolicy::Metric::DISTANCE;
+                const auto& levels = _animationLODPolicy.levels;
+                for (int i = 0, count = static_cast<int>(levels.size()); i < count; i++)
+                {
+                    if (byDistance ? _lodMetric >= levels[i].threshold : _lodMetric <= levels[i].threshold)
+                        _animationLODLevel = i;
+                    else
+                        break;
+                }
+                
+                if (_animationLODLevel >= 0)
+                {
+                    const auto& level = levels[_animationLODLevel];
+                    unsigned int interval = std::max(1u, level.updateInterval);
+                    _animationLODEvaluate = (frame + _animationLODPhase) % interval == 0;
+                    _animationLODMaxBoneDepth = level.maxBoneDepth;
+                }
+            }
+        }
+    }
+    
+    *maxBoneDepth = _animationLODMaxBoneDepth;
+    if (_animationLODEvaluate)
+        _evaluatedAnimationCount++;
+    else if (_animationCulled)
+        _culledAnimationCount++;
+    else
+        _skippedAnimationCount++;
+    
+    return _animationLODEvaluate;
+}
+
+// the part of the viewport covered by an AABB
+static float getProjectedSize(const AABB& aabb, const Camera* camera)
+{
+    Vec3 corners[8];
+    aabb.getCorners(corners);
+    const Mat4& viewProjection = camera->getViewProjectionMatrix();
+    Vec2 ndcMin(FLT_MAX, FLT_MAX), ndcMax(-FLT_MAX, -FLT_MAX);
+    for (int i = 0; i < 8; i++)
+    {
+        Vec4 clip;
+        viewProjection.transformVector(Vec4(corners[i].x, corners[i].y, corners[i].z, 1.f), &clip);
+        if (clip.w <= 0.f)
+        {
+            // crosses the camera plane, as large as the viewport
+            return 1.f;
+        }
+        float x = clip.x / clip.w, y = clip.y / clip.w;
+        ndcMin.set(std::min(ndcMin.x, x), std::min(ndcMin.y, y));
+        ndcMax.set(std::max(ndcMax.x, x), std::max(ndcMax.y, y));
+    }
+    return std::min(1.f, std::max(ndcMax.x - ndcMin.x, ndcMax.y - ndcMin.y) * 0.5f);
+}
+
+void Sprite3D::recordAnimationLOD(const Camera* camera)
+{
+    // the meshes of a model with several nodes belong to the child sprites
+    AABB aabb = _children.empty() ? getAABB() : getAABBRecursively();
+    bool visible = aabb.isEmpty() || camera->isVisibleInFrustum(&aabb);
+    bool byDistance = _animationLODPolicy.metric == AnimationLODPolicy::Metric::DISTANCE;
+    
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    if (!_lodDrawn || frame != _lodDrawFrame)
+    {
+        _lodDrawn = true;
+        _lodDrawFrame = frame;
+        _lodVisible = false;
+        // the farthest or the smallest, for the sprites no camera sees
+        _lodMetric = byDistance ? FLT_MAX : 0.f;
+    }
+    
+    if (!visible)
+        return;
+    
+    _lodVisible = true;
+    float metric;
+    if (byDistance)
+    {
+        const Mat4& cameraTransform = camera->getNodeToWorldTransform();
+        Vec3 cameraPosition(cameraTransform.m[12], cameraTransform.m[13], cameraTransform.m[14]);
+        metric = aabb.isEmpty() ? 0.f : cameraPosition.distance(aabb.getCenter());
+        _lodMetric = std::min(_lodMetric, metric);
+    }
+    else
+    {
+        metric = aabb.isEmpty() ? 1.f : getProjectedSize(aabb, camera);
+        _lodMetric = std::max(_lodMetric, metric);
+    }
+}
+
 Action* Sprite3D::runAction(Action *action)
 {
     setForceDepthWrite(true);
@@ -48,6 +48,7 @@ NS_CC_BEGIN
 
 class Mesh;
 class Texture2D;
+class Image;
 class MeshSkin;
 class AttachNode;
 struct NodeData;
@@ -80,6 +81,18 @@ public:
     
     static void createAsync(const std::string &modelPath, const std::string &texturePath, const std::function<void(Sprite3D*, void*)>& callback, void* callbackparam);
     
+    /**
+     * set the time, in seconds, spent each frame creating the GPU buffers and textures of the sprites loaded by createAsync.
+     * The model files are parsed and the textures are decoded in a loading thread, then every frame the vertex buffers and
+     * the textures of the loaded sprites are uploaded one at a time until the budget is spent, at least one per frame.
+     * The callback is called when all the uploads of the sprite are done. Default is 0.002.
+     */
+    static void setAsyncUploadBudget(float seconds);
+    static float getAsyncUploadBudget();
+    
+    /** releases the sprites loaded by createAsync which are still waiting for their uploads, without calling their callbacks. Called by Director::reset. */
+    static void purgeAsyncUploads();
+    
     /**set diffuse texture, set the first if multiple textures exist*/
     void setTexture(const std::string& texFile);
     void setTexture(Texture2D* texture);
@@ -205,6 +218,93 @@ public:
     */
     const Vector<Mesh*>& getMeshes() const { return _meshes; }
 
+    /** Level of detail of the skeletal animations, see AnimationLODPolicy */
+    struct AnimationLODLevel
+    {
+        /**
+         * The level is used when the sprite is at least threshold away from the camera with Metric::DISTANCE,
+         * or when it covers at most threshold of the viewport, from 0 to 1, with Metric::SCREEN_SIZE.
+         */
+        float threshold;
+        /** the animations are evaluated once every updateInterval frames */
+        unsigned int updateInterval;
+        /** only the bones at most maxBoneDepth parents below a root bone are animated, the others keep their pose. -1 animates all the bones */
+        int maxBoneDepth;
+    };
+    
+    /**
+     * Reduces the cost of the animations run by Animate3D on the sprite, depending on how it was drawn by the cameras in the previous frame.
+     * The events of the animations are still sent when their evaluation is skipped.
+     */
+    struct AnimationLODPolicy
+    {
+        enum class Metric
+        {
+            DISTANCE,
+            SCREEN_SIZE,
+        };
+        
+        AnimationLODPolicy()
+        : enabled(false)
+        , skipWhenCulled(true)
+        , metric(Metric::DISTANCE)
+        {
+        }
+        
+        bool enabled;
+        /**
+         * skip the animations while the AABB of the sprite is outside of the frustum of all the cameras.
+         * The pose is updated one frame after the sprite gets visible again.
+         */
+        bool skipWhenCulled;
+        Metric metric;
+        /** sorted from the nearest or the largest level, the sprite is animated at full rate before the first one */
+        std::vector<AnimationLODLevel> levels;
+    };
+    
+    /** set the level of detail of the animations of this sprite, disabled by default */
+    void setAnimationLODPolicy(const AnimationLODPolicy& policy);
+    const AnimationLODPolicy& getAnimationLODPolicy() const { return _animationLODPolicy; }
+    
+    /** index of the level used in this frame, -1 when the sprite is animated at full detail */
+    int getAnimationLODLevel() const { return _animationLODLevel; }
+    /** whether the animations are skipped in this frame because the sprite wasn't visible */
+    bool isAnimationCulled() const { return _animationCulled; }
+    
+    /** counters of the animation evaluations of this sprite, since it was created or the last reset */
+    unsigned int getEvaluatedAnimationCount() const { return _evaluatedAnimationCount; }
+    unsigned int getSkippedAnimationCount() const { return _skippedAnimationCount; }
+    unsigned int getCulledAnimationCount() const { return _culledAnimationCount; }
+    void resetAnimationLODStats();
+    
+    /**
+     * Returns whether the animations of the sprite are evaluated in this frame, and the deepest bone to animate. Called by Animate3D::update().
+     * @js NA
+     * @lua NA
+     */
+    bool checkAnimationLOD(int* maxBoneDepth);
+    
+    /**
+     * Sets the simplified levels of detail to generate with MeshSimplifier when the model is loaded, level i + 1 keeping about
+     * ratios[i] of the triangles of the full mesh. They are simplified from the loaded mesh datas, in the loading thread for createAsync,
+     * and kept with the mesh index datas, so the sprites of the same model share them. Set it before the model is loaded,
+     * the models already in Sprite3DCache keep their levels. Empty generates no level, the default.
+     */
+    static void setMeshLODRatios(const std::string& modelPath, const std::vector<float>& ratios);
+    static const std::vector<float>& getMeshLODRatios(const std::string& modelPath);
+    /**
+     * Selects the level of detail of the meshes from the size of the sprite on the screen: level i + 1 is drawn when its AABB
+     * covers at most screenSizes[i] of the viewport, from 0 to 1, sorted from the largest. Empty draws the full meshes, the default.
+     * It is set on the child sprites of a model with several nodes too.
+     */
+    void setMeshLODScreenSizes(const std::vector<float>& screenSizes);
+    const std::vector<float>& getMeshLODScreenSizes() const { return _meshLODScreenSizes; }
+    
+    /** counters of the triangles drawn by the meshes of this sprite, and of the ones the levels of detail saved, since it was created or the last reset */
+    unsigned int getDrawnTriangleCount() const { return _drawnTriangleCount; }
+    unsigned int getSavedTriangleCount() const { return _savedTriangleCount; }
+    void resetMeshLODStats();
+
 CC_CONSTRUCTOR_ACCESS:
     
     Sprite3D();
@@ -216,6 +316,9 @@ CC_CONSTRUCTOR_ACCESS:
     
     bool initFrom(const NodeDatas& nodedatas, const MeshDatas& meshdatas, const MaterialDatas& materialdatas);
     
+    /** create the skeleton, the meshes and the attachments, once the mesh vertex datas are created */
+    bool initNodes(const NodeDatas& nodedatas, const MaterialDatas& materialdatas);
+    
     /**load sprite3d from cache, return true if succeed, false otherwise*/
     bool loadFromCache(const std::string& path);
     
@@ -243,9 +346,25 @@ CC_CONSTRUCTOR_ACCESS:
     void onAABBDirty() { _aabbDirty = true; }
     
     void afterAsyncLoad(void* param);
+    
+    /** computes the mesh bounding boxes and levels of detail and decodes the textures, in the loading thread */
+    void prepareAsyncLoad();
+    /** creates one texture or vertex buffer of the loaded sprite, returns true when there is nothing left to upload */
+    bool uploadAsyncStep();
+    void finishAsyncLoad();
+    static void updateAsyncUploads(float dt);
 
     static AABB getAABBRecursivelyImp(Node *node);
     
+    /** simplifies the triangles of the loaded meshes into their subMeshLODIndices, see setMeshLODRatios */
+    static void generateMeshLODs(MeshDatas& meshdatas, const std::vector<float>& ratios);
+    
+    /** measure the sprite for the animation level of detail, for each camera drawing it */
+    void recordAnimationLOD(const Camera* camera);
+    
+    /** select the level of detail of the meshes for the camera drawing the sprite */
+    void selectMeshLOD(const Camera* camera);
+    
 protected:
 
     Skeleton3D*                  _skeleton; //skeleton
@@ -276,8 +395,33 @@ protected:
         MeshDatas* meshdatas;
         MaterialDatas* materialdatas;
         NodeDatas*   nodeDatas;
+        std::vector<std::pair<std::string, Image*>> images; // textures decoded in the loading thread, with their full path
+        std::vector<float> meshLODRatios; // copied from setMeshLODRatios, simplified in the loading thread
+        size_t uploadStep; // textures, then mesh vertex datas uploaded
     };
     AsyncLoadParam             _asyncLoadParam;
+    
+    AnimationLODPolicy         _animationLODPolicy;
+    // decision of the current frame
+    unsigned int               _animationLODFrame;
+    int                        _animationLODLevel;
+    int                        _animationLODMaxBoneDepth;
+    bool                       _animationLODEvaluate;
+    bool                       _animationCulled;
+    // staggers the throttled updates of the sprites
+    unsigned int               _animationLODPhase;
+    // measures of the draws of the last frame drawn
+    unsigned int               _lodDrawFrame;
+    bool                       _lodDrawn;
+    bool                       _lodVisible;
+    float                      _lodMetric;
+    unsigned int               _evaluatedAnimationCount;
+    unsigned int               _skippedAnimationCount;
+    unsigned int               _culledAnimationCount;
+    
+    std::vector<float>         _meshLODScreenSizes;
+    unsigned int               _drawnTriangleCount;
+    unsigned int               _savedTriangleCount;
 };
 
 ///////////////////////////////////////////////////////
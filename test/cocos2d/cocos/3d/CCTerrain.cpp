@@ -29,6 +29,7 @@ USING_NS_CC;
 #include <CCImage.h>
 #include <float.h>
 #include <set>
+#include <array>
 #include "renderer/CCGLProgram.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramState.h"
@@ -38,10 +39,14 @@ USING_NS_CC;
 #include "renderer/CCRenderState.h"
 #include "base/CCDirector.h"
 #include "base/CCEventType.h"
+#include "base/CCAsyncTaskPool.h"
 #include "2d/CCCamera.h"
 
 NS_CC_BEGIN
 
+// the chunks built at the same time in the loading thread
+static const int MAX_STREAMING_REQUESTS = 4;
+
 // check a number is power of two.
 static bool isPOT(int number)
 {
@@ -199,6 +204,12 @@ void Terrain::onDraw(const Mat4 &transform, uint32_t flags)
         setChunksLOD(Vec3(m.m[12], m.m[13], m.m[14]));
     }
 
+    if(_isStreaming && (_isCameraViewChanged || _isStreamingDirty))
+    {
+        auto m = camera->getNodeToWorldTransform();
+        updateStreaming(Vec3(m.m[12], m.m[13], m.m[14]));
+    }
+
     if(_isCameraViewChanged )
     {
         _quadRoot->resetNeedDraw(true);//reset it 
@@ -236,8 +247,14 @@ bool Terrain::initHeightMap(const std::string& heightMap)
     {
         int chunk_amount_y = _imageHeight/_chunkSize.height;
         int chunk_amount_x = _imageWidth/_chunkSize.width;
-        loadVertices();
-        calculateNormal();
+        _isStreaming = _terrainData._streamingDistance > 0;
+        _isStreamingDirty = true;
+        _streamingGeneration++;
+        if(!_isStreaming)
+        {
+            loadVertices();
+            calculateNormal();
+        }
         memset(_chunkesArray, 0, sizeof(_chunkesArray));
 
         for(int m =0;m<chunk_amount_y;m++)
@@ -247,9 +264,22 @@ bool Terrain::initHeightMap(const std::string& heightMap)
                 _chunkesArray[m][n] = new Chunk();
                 _chunkesArray[m][n]->_terrain = this;
                 _chunkesArray[m][n]->_size = _chunkSize;
-                _chunkesArray[m][n]->generate(_imageWidth,_imageHeight,m,n,_data);
+                if(_isStreaming)
+                {
+                    // the vertices are built once the camera gets close
+                    _chunkesArray[m][n]->_posY = m;
+                    _chunkesArray[m][n]->_posX = n;
+                }
+                else
+                {
+                    _chunkesArray[m][n]->generate(_imageWidth,_imageHeight,m,n,_data);
+                }
             }
         }
+        if(_isStreaming)
+        {
+            calculateChunksAABBFromHeights();
+        }
 
         //calculate the neighbor
         for(int m =0;m<chunk_amount_y;m++)
@@ -264,6 +294,7 @@ bool Terrain::initHeightMap(const std::string& heightMap)
         }
         _quadRoot = new QuadTree(0,0,_imageWidth,_imageHeight,this);
         setLODDistance(_chunkSize.width,2*_chunkSize.width,3*_chunkSize.width);
+        setLODHysteresis(_chunkSize.width*0.25f);
         return true;
     }else
     {
@@ -273,7 +304,12 @@ bool Terrain::initHeightMap(const std::string& heightMap)
 }
 
 Terrain::Terrain()
-: _alphaMap(nullptr)
+: _lodHysteresis(0)
+, _isStreaming(false)
+, _isStreamingDirty(false)
+, _streamingRequests(0)
+, _streamingGeneration(0)
+, _alphaMap(nullptr)
 , _stateBlock(nullptr)
 , _lightMap(nullptr)
 , _lightDir(-1.f, -1.f, 0.f)
@@ -304,15 +340,13 @@ void Terrain::setChunksLOD(Vec3 cameraPos)
             AABB aabb = _chunkesArray[m][n]->_parent->_worldSpaceAABB;
             auto center = aabb.getCenter();
             float dist = Vec2(center.x, center.z).distance(Vec2(cameraPos.x, cameraPos.z));
-            _chunkesArray[m][n]->_currentLod = 3;
-            for(int i =0;i<3;i++)
-            {
-                if(dist<=_lodDistance[i])
-                {
-                    _chunkesArray[m][n]->_currentLod = i;
-                    break;
-                }
-            }
+            // a chunk only changes its LOD once it is past the threshold by the hysteresis distance
+            int lod = _chunkesArray[m][n]->_currentLod;
+            while(lod < 3 && dist > _lodDistance[lod] + _lodHysteresis)
+                lod++;
+            while(lod > 0 && dist <= _lodDistance[lod - 1] - _lodHysteresis)
+                lod--;
+            _chunkesArray[m][n]->_currentLod = lod;
         }
 }
 
@@ -469,6 +503,164 @@ void Terrain::setLODDistance(float lod_1, float lod_2, float lod_3)
     _lodDistance[2] = lod_3;
 }
 
+void Terrain::setLODHysteresis(float distance)
+{
+    _lodHysteresis = distance;
+}
+
+int Terrain::getLoadedChunkCount() const
+{
+    int count = 0;
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    for(int m =0;m<chunk_amount_y;m++)
+    {
+        for(int n =0; n<chunk_amount_x;n++)
+        {
+            if(_chunkesArray[m][n]->_loaded)
+                count++;
+        }
+    }
+    return count;
+}
+
+void Terrain::updateStreaming(const Vec3& cameraPos)
+{
+    _isStreamingDirty = false;
+    float loadDistance = _terrainData._streamingDistance;
+    float unloadDistance = _terrainData._streamingUnloadDistance > 0 ? _terrainData._streamingUnloadDistance : loadDistance * 1.5f;
+
+    std::vector<std::pair<float, Chunk *>> candidates;
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    for(int m =0;m<chunk_amount_y;m++)
+    {
+        for(int n =0; n<chunk_amount_x;n++)
+        {
+            auto chunk = _chunkesArray[m][n];
+            auto center = chunk->_parent->_worldSpaceAABB.getCenter();
+            float dist = Vec2(center.x, center.z).distance(Vec2(cameraPos.x, cameraPos.z));
+            if(chunk->_loaded && dist > unloadDistance)
+            {
+                chunk->unload();
+            }
+            else if(!chunk->_loaded && !chunk->_loading && dist <= loadDistance)
+            {
+                candidates.push_back(std::make_pair(dist, chunk));
+            }
+        }
+    }
+
+    // the nearest first, a few at a time so the closer chunks aren't queued after the far ones when the camera moves
+    std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, Chunk *>& a, const std::pair<float, Chunk *>& b) {
+        return a.first < b.first;
+    });
+    for(size_t i = 0; i < candidates.size() && _streamingRequests < MAX_STREAMING_REQUESTS; i++)
+    {
+        loadChunkAsync(candidates[i].second);
+    }
+}
+
+void Terrain::loadChunkAsync(Chunk * chunk)
+{
+    chunk->_loading = true;
+    _streamingRequests++;
+
+    // the loading thread reads a copy of the heights, with the pixels around the chunk for the normals
+    auto source = std::make_shared<ChunkSource>();
+    source->_m = chunk->_posY;
+    source->_n = chunk->_posX;
+    source->_firstRow = std::max(0, (int)_chunkSize.height*chunk->_posY - 1);
+    source->_firstColumn = std::max(0, (int)_chunkSize.width*chunk->_posX - 1);
+    source->_rows = std::min(_imageHeight - 1, (int)_chunkSize.height*(chunk->_posY + 1) + 1) - source->_firstRow + 1;
+    source->_columns = std::min(_imageWidth - 1, (int)_chunkSize.width*(chunk->_posX + 1) + 1) - source->_firstColumn + 1;
+    source->_heights.resize(source->_rows * source->_columns);
+    for(int r = 0; r < source->_rows; r++)
+    {
+        for(int c = 0; c < source->_columns; c++)
+        {
+            source->_heights[r * source->_columns + c] = getImageHeight(source->_firstColumn + c, source->_firstRow + r);
+        }
+    }
+    source->_size = _chunkSize;
+    source->_imageWidth = _imageWidth;
+    source->_imageHeight = _imageHeight;
+    source->_mapScale = _terrainData._mapScale;
+    source->_crackFixedType = _crackFixedType;
+    source->_skirtHeight = _skirtRatio *_terrainData._mapScale*8;
+
+    auto vertices = std::make_shared<std::vector<TerrainVertexData>>();
+    auto triangles = std::make_shared<std::vector<Triangle>>();
+    auto skirtVerticesOffset = std::make_shared<std::array<int, 4>>();
+    auto generation = _streamingGeneration;
+    int m = chunk->_posY, n = chunk->_posX;
+
+    // the terrain stays alive until the vertices are back on the main thread
+    this->retain();
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, [this, m, n, generation, vertices, triangles, skirtVerticesOffset](void*) {
+        _streamingRequests--;
+        _isStreamingDirty = true;
+        if (generation == _streamingGeneration)
+        {
+            auto chunk = _chunkesArray[m][n];
+            chunk->_loading = false;
+            chunk->_originalVertices.swap(*vertices);
+            chunk->_trianglesList.swap(*triangles);
+            if (_crackFixedType == CrackFixedType::SKIRT)
+            {
+                // the skirt layout is the same for every chunk, as in Chunk::generate
+                std::copy(skirtVerticesOffset->begin(), skirtVerticesOffset->end(), _skirtVerticesOffset);
+            }
+            for (auto & triangle : chunk->_trianglesList)
+            {
+                triangle.transform(getNodeToWorldTransform());
+            }
+            chunk->finish();
+        }
+        this->release();
+    }, nullptr, [source, vertices, triangles, skirtVerticesOffset]() {
+        Chunk::buildFromSource(*source, *vertices, *triangles, skirtVerticesOffset->data());
+    });
+}
+
+void Terrain::calculateChunksAABBFromHeights()
+{
+    _maxHeight = -99999;
+    _minHeight = 99999;
+    float skirtHeight = _crackFixedType == CrackFixedType::SKIRT ? _skirtRatio *_terrainData._mapScale*8 : 0;
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    for(int m =0;m<chunk_amount_y;m++)
+    {
+        for(int n =0; n<chunk_amount_x;n++)
+        {
+            int lastRow = std::min(_imageHeight - 1, (int)_chunkSize.height*(m + 1));
+            int lastColumn = std::min(_imageWidth - 1, (int)_chunkSize.width*(n + 1));
+            float minHeight = FLT_MAX, maxHeight = -FLT_MAX;
+            for(int i = _chunkSize.height*m; i <= lastRow; i++)
+            {
+                for(int j = _chunkSize.width*n; j <= lastColumn; j++)
+                {
+                    float height = getImageHeight(j, i);
+                    minHeight = std::min(minHeight, height);
+                    maxHeight = std::max(maxHeight, height);
+                }
+            }
+            _minHeight = std::min(_minHeight, minHeight);
+            _maxHeight = std::max(_maxHeight, maxHeight);
+
+            // the same bounds as the vertices of the chunk
+            Vec3 corners[2] = {
+                Vec3(_chunkSize.width*n*_terrainData._mapScale - _imageWidth/2*_terrainData._mapScale, minHeight - skirtHeight,
+                     _chunkSize.height*m*_terrainData._mapScale - _imageHeight/2*_terrainData._mapScale),
+                Vec3(lastColumn*_terrainData._mapScale - _imageWidth/2*_terrainData._mapScale, maxHeight,
+                     lastRow*_terrainData._mapScale - _imageHeight/2*_terrainData._mapScale),
+            };
+            _chunkesArray[m][n]->_aabb.updateMinMax(corners, 2);
+        }
+    }
+}
+
 void Terrain::setIsEnableFrustumCull(bool bool_value)
 {
     _isEnableFrustumCull = bool_value;
@@ -677,7 +869,7 @@ std::vector<float> Terrain::getHeightData() const
     for (int i = 0; i < _imageHeight; i++) {
         for (int j = 0; j < _imageWidth; j++) {
             int idx = i * _imageWidth + j;
-            data[idx] = (_vertices[idx]._position.y);
+            data[idx] = _vertices.empty() ? getImageHeight(j, i) : _vertices[idx]._position.y;
         }
     }
     return data;
@@ -913,7 +1105,8 @@ void Terrain::reload()
     {
         for(int n =0; n<chunk_amount_x;n++)
         {
-            _chunkesArray[m][n]->finish();
+            if(_chunkesArray[m][n]->_loaded)
+                _chunkesArray[m][n]->finish();
         }
     }
 
@@ -935,6 +1128,7 @@ void Terrain::Chunk::finish()
     glBindBuffer(GL_ARRAY_BUFFER,0);
 
     calculateSlope();
+    _loaded = true;
 
     for(int i =0;i<4;i++)
     {
@@ -945,26 +1139,26 @@ void Terrain::Chunk::finish()
         _lod[i]._indices.reserve(indicesAmount);
     }
     _oldLod = -1;
+    _indicesLod = -1;
 }
 
 void Terrain::Chunk::bindAndDraw()
 {
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    if(_terrain->_isCameraViewChanged || _oldLod <0)
+    // the updates compare the LODs of the chunk and its neighbors with the ones it was last built with,
+    // a chunk culled when its LOD changed is rebuilt when it is drawn again
+    switch (_terrain->_crackFixedType)
     {
-        switch (_terrain->_crackFixedType)
-        {
-        case CrackFixedType::SKIRT:
+    case CrackFixedType::SKIRT:
 
-            updateIndicesLODSkirt();
-            break;
-        case CrackFixedType::INCREASE_LOWER:
-            updateVerticesForLOD();
-            updateIndicesLOD();
-            break;
-        default:
-            break;
-        }
+        updateIndicesLODSkirt();
+        break;
+    case CrackFixedType::INCREASE_LOWER:
+        updateVerticesForLOD();
+        updateIndicesLOD();
+        break;
+    default:
+        break;
     }
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,_chunkIndices._indices);
     unsigned long offset = 0;
@@ -984,102 +1178,184 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
 {
     _posY = m;
     _posX = n;
-    switch (_terrain->_crackFixedType)
+    float skirtHeight =  _terrain->_skirtRatio *_terrain->_terrainData._mapScale*8;
+    auto& terrainVertices = _terrain->_vertices;
+    fillVertices(_size, m, n, imgWidth, imageHei, _terrain->_crackFixedType, skirtHeight,
+                 [&terrainVertices, imgWidth](int i, int j) { return terrainVertices[i*imgWidth + j]; },
+                 _originalVertices, _trianglesList, _terrain->_skirtVerticesOffset);
+
+    calculateAABB();
+    finish();
+}
+
+void Terrain::Chunk::fillVertices(const Size& size, int m, int n, int imgWidth, int imageHei, CrackFixedType crackFixedType, float skirtHeight,
+                                  const std::function<TerrainVertexData(int, int)>& getVertex,
+                                  std::vector<TerrainVertexData>& vertices, std::vector<Triangle>& triangles, int* skirtVerticesOffset)
+{
+    switch (crackFixedType)
     {
     case CrackFixedType::SKIRT:
         {
-            for(int i=_size.height*m;i<=_size.height*(m+1);i++)
+            for(int i=size.height*m;i<=size.height*(m+1);i++)
             {
                 if(i>=imageHei) break;
-                for(int j=_size.width*n;j<=_size.width*(n+1);j++)
+                for(int j=size.width*n;j<=size.width*(n+1);j++)
                 {
                     if(j>=imgWidth)break;
-                    auto v =_terrain->_vertices[i*imgWidth + j];
-                    _originalVertices.push_back (v);
+                    auto v =getVertex(i, j);
+                    vertices.push_back (v);
                 }
             }
             // add four skirts
-           
-            float skirtHeight =  _terrain->_skirtRatio *_terrain->_terrainData._mapScale*8;
+
             //#1
-            _terrain->_skirtVerticesOffset[0] = (int)_originalVertices.size();
-            for(int i =_size.height*m;i<=_size.height*(m+1);i++)
+            skirtVerticesOffset[0] = (int)vertices.size();
+            for(int i =size.height*m;i<=size.height*(m+1);i++)
             {
-                auto v = _terrain->_vertices[i*imgWidth +_size.width*(n+1)];
+                auto v = getVertex(i, size.width*(n+1));
                 v._position.y -= skirtHeight;
-                _originalVertices.push_back (v);
+                vertices.push_back (v);
             }
 
             //#2
-            _terrain->_skirtVerticesOffset[1] = (int)_originalVertices.size();
-            for(int j =_size.width*n;j<=_size.width*(n+1);j++)
+            skirtVerticesOffset[1] = (int)vertices.size();
+            for(int j =size.width*n;j<=size.width*(n+1);j++)
             {
-                auto v = _terrain->_vertices[_size.height*(m+1)*imgWidth + j];
+                auto v = getVertex(size.height*(m+1), j);
                 v._position.y -=skirtHeight;
-                _originalVertices.push_back (v);
+                vertices.push_back (v);
             }
 
             //#3
-            _terrain->_skirtVerticesOffset[2] = (int)_originalVertices.size();
-            for(int i =_size.height*m;i<=_size.height*(m+1);i++)
+            skirtVerticesOffset[2] = (int)vertices.size();
+            for(int i =size.height*m;i<=size.height*(m+1);i++)
             {
-                auto v = _terrain->_vertices[i*imgWidth + _size.width*n];
+                auto v = getVertex(i, size.width*n);
                 v._position.y -= skirtHeight;
-                _originalVertices.push_back (v);
+                vertices.push_back (v);
             }
 
             //#4
-            _terrain->_skirtVerticesOffset[3] = (int)_originalVertices.size();
-            for(int j =_size.width*n;j<=_size.width*(n+1);j++)
+            skirtVerticesOffset[3] = (int)vertices.size();
+            for(int j =size.width*n;j<=size.width*(n+1);j++)
             {
-                auto v = _terrain->_vertices[_size.height*m*imgWidth+j];
+                auto v = getVertex(size.height*m, j);
                 v._position.y -= skirtHeight;
                 //v.position.y = -5;
-                _originalVertices.push_back (v);
+                vertices.push_back (v);
             }
         }
         break;
     case CrackFixedType::INCREASE_LOWER:
         {
-            for(int i=_size.height*m;i<=_size.height*(m+1);i++)
+            for(int i=size.height*m;i<=size.height*(m+1);i++)
             {
                 if(i>=imageHei) break;
-                for(int j=_size.width*n;j<=_size.width*(n+1);j++)
+                for(int j=size.width*n;j<=size.width*(n+1);j++)
                 {
                     if(j>=imgWidth)break;
-                    auto v =_terrain->_vertices[i*imgWidth + j];
-                    _originalVertices.push_back (v);
+                    auto v =getVertex(i, j);
+                    vertices.push_back (v);
                 }
             }
         }
         break;
     }
     //store triangle:
-    for (int i = 0; i < _size.height; i++)
+    for (int i = 0; i < size.height; i++)
     {
-        for (int j = 0; j < _size.width; j++)
+        for (int j = 0; j < size.width; j++)
         {
-             int nLocIndex = i * (_size.width + 1) + j;
-             Triangle a(_originalVertices[nLocIndex]._position, _originalVertices[nLocIndex + 1 * (_size.width + 1)]._position, _originalVertices[nLocIndex + 1]._position);
-             Triangle b(_originalVertices[nLocIndex + 1]._position, _originalVertices[nLocIndex + 1 * (_size.width + 1)]._position, _originalVertices[nLocIndex + 1 * (_size.width + 1) + 1]._position);
+             int nLocIndex = i * (size.width + 1) + j;
+             Triangle a(vertices[nLocIndex]._position, vertices[nLocIndex + 1 * (size.width + 1)]._position, vertices[nLocIndex + 1]._position);
+             Triangle b(vertices[nLocIndex + 1]._position, vertices[nLocIndex + 1 * (size.width + 1)]._position, vertices[nLocIndex + 1 * (size.width + 1) + 1]._position);
 
-            _trianglesList.push_back(a);
-            _trianglesList.push_back(b);
+            triangles.push_back(a);
+            triangles.push_back(b);
         }
     }
+}
 
-    calculateAABB();
-    finish();
+void Terrain::Chunk::buildFromSource(const ChunkSource& source, std::vector<TerrainVertexData>& vertices, std::vector<Triangle>& triangles,
+                                     int* skirtVerticesOffset)
+{
+    // the vertices of the window, with the normals of the whole terrain mesh: the faces around a pixel are in the window
+    std::vector<TerrainVertexData> window(source._rows * source._columns);
+    for(int r = 0; r < source._rows; r++)
+    {
+        for(int c = 0; c < source._columns; c++)
+        {
+            int i = source._firstRow + r;
+            int j = source._firstColumn + c;
+            auto& v = window[r * source._columns + c];
+            v._position = Vec3(j*source._mapScale- source._imageWidth/2*source._mapScale,
+                source._heights[r * source._columns + c],
+                i*source._mapScale - source._imageHeight/2*source._mapScale);
+            v._texcoord = Tex2F(j*1.0/source._imageWidth,i*1.0/source._imageHeight);
+        }
+    }
+    for(int r = 0; r < source._rows - 1; r++)
+    {
+        for(int c = 0; c < source._columns - 1; c++)
+        {
+            int nLocIndex = r * source._columns + c;
+            int faces[6] = { nLocIndex, nLocIndex + source._columns, nLocIndex + 1,
+                nLocIndex + 1, nLocIndex + source._columns, nLocIndex + source._columns + 1 };
+            for(int k = 0; k < 6; k += 3)
+            {
+                Vec3 v1 = window[faces[k + 1]]._position - window[faces[k]]._position;
+                Vec3 v2 = window[faces[k + 2]]._position - window[faces[k]]._position;
+                Vec3 normal;
+                Vec3::cross(v1,v2,&normal);
+                normal.normalize();
+                window[faces[k]]._normal += normal;
+                window[faces[k + 1]]._normal += normal;
+                window[faces[k + 2]]._normal += normal;
+            }
+        }
+    }
+    for(auto& v : window)
+    {
+        v._normal.normalize();
+    }
+
+    fillVertices(source._size, source._m, source._n, source._imageWidth, source._imageHeight, source._crackFixedType, source._skirtHeight,
+                 [&source, &window](int i, int j) {
+                     int r = std::min(std::max(i - source._firstRow, 0), source._rows - 1);
+                     int c = std::min(std::max(j - source._firstColumn, 0), source._columns - 1);
+                     return window[r * source._columns + c];
+                 },
+                 vertices, triangles, skirtVerticesOffset);
+}
+
+void Terrain::Chunk::unload()
+{
+    glDeleteBuffers(1,&_vbo);
+    _vbo = 0;
+    std::vector<TerrainVertexData>().swap(_originalVertices);
+    std::vector<TerrainVertexData>().swap(_currentVertices);
+    std::vector<Triangle>().swap(_trianglesList);
+    for(int i =0;i<4;i++)
+    {
+        std::vector<GLushort>().swap(_lod[i]._indices);
+    }
+    _oldLod = -1;
+    _indicesLod = -1;
+    _loaded = false;
 }
 
 Terrain::Chunk::Chunk()
 {
     _currentLod = 0;
+    _loaded = false;
+    _loading = false;
+    _vbo = 0;
     _left = nullptr;
     _right = nullptr;
     _back = nullptr;
     _front = nullptr;
     _oldLod = -1;
+    _indicesLod = -1;
     for(int i =0;i<4;i++)
     {
         _neighborOldLOD[i] = -1;
@@ -1106,18 +1382,18 @@ void Terrain::Chunk::updateIndicesLOD()
         currentNeighborLOD[3] = _front->_currentLod;
     }else{currentNeighborLOD[3] = -1;}
 
-    if(_oldLod == _currentLod &&(memcmp(currentNeighborLOD,_neighborOldLOD,sizeof(currentNeighborLOD))==0) )
+    if(_indicesLod == _currentLod &&(memcmp(currentNeighborLOD,_neighborOldLOD,sizeof(currentNeighborLOD))==0) )
     {
         return;// no need to update
     }
+    memcpy(_neighborOldLOD,currentNeighborLOD,sizeof(currentNeighborLOD)); 
+    _indicesLod = _currentLod;
     bool isOk;
     _chunkIndices = _terrain->lookForIndicesLOD(currentNeighborLOD,_currentLod,&isOk);
     if(isOk)
     {
         return;
     }
-    memcpy(_neighborOldLOD,currentNeighborLOD,sizeof(currentNeighborLOD)); 
-    _oldLod = _currentLod;
     int gridY = _size.height;
     int gridX = _size.width;
 
@@ -1522,7 +1798,8 @@ void Terrain::QuadTree::draw()
 {
     if(!_needDraw)return;
     if(_isTerminal){
-        this->_chunk->bindAndDraw();
+        if(_chunk->_loaded)
+            this->_chunk->bindAndDraw();
     }else
     {
         this->_tl->draw();
@@ -1590,6 +1867,8 @@ Terrain::TerrainData::TerrainData(const std::string& heightMapsrc , const std::s
     this->_mapHeight = height;
     this->_mapScale = scale; 
     _skirtHeightRatio = 1;
+    _streamingDistance = 0;
+    _streamingUnloadDistance = 0;
 }
 
 Terrain::TerrainData::TerrainData(const std::string& heightMapsrc, const std::string& alphamap, const DetailMap& detail1, const DetailMap& detail2, const DetailMap& detail3, const DetailMap& detail4, const Size & chunksize, float height, float scale)
@@ -1605,6 +1884,8 @@ Terrain::TerrainData::TerrainData(const std::string& heightMapsrc, const std::st
     this->_mapScale = scale;
     _detailMapAmount = 4;
     _skirtHeightRatio = 1;
+    _streamingDistance = 0;
+    _streamingUnloadDistance = 0;
 }
 
 Terrain::TerrainData::TerrainData(const std::string& heightMapsrc, const std::string& alphamap, const DetailMap& detail1, const DetailMap& detail2, const DetailMap& detail3, const Size & chunksize /*= Size(32,32)*/, float height /*= 2*/, float scale /*= 0.1*/)
@@ -1619,9 +1900,13 @@ Terrain::TerrainData::TerrainData(const std::string& heightMapsrc, const std::st
     this->_mapScale = scale;
     _detailMapAmount = 3;
     _skirtHeightRatio = 1;
+    _streamingDistance = 0;
+    _streamingUnloadDistance = 0;
 }
 
 Terrain::TerrainData::TerrainData()
+: _streamingDistance(0)
+, _streamingUnloadDistance(0)
 {
 
 }
@@ -24,6 +24,7 @@ THE SOFTWARE.
 #ifndef CC_TERRAIN_H
 #define CC_TERRAIN_H
 
+#include <functional>
 #include <vector>
 
 #include "2d/CCNode.h"
@@ -81,6 +82,10 @@ NS_CC_BEGIN
     * different LOD levels. An acceptable solution might be to simply reduce the lower LOD(high detail,smooth) chunks border,
     * And let the higher LOD(rough) chunks to seamlessly connect it.
     * 
+    * For very large height maps, the chunks can be streamed (see TerrainData::_streamingDistance): only the height map
+    * stays in memory, the vertices of the chunks around the camera are built in a loading thread and the far ones are released.
+    * Only the chunks with vertices are drawn and hit by the ray-terrain intersection.
+    * 
     * We can use ray-terrain intersection to pick a point of the terrain;
     * Also we can get an arbitrary point of the terrain's height and normal vector for convenience .
     **/
@@ -153,6 +158,13 @@ public:
         int _detailMapAmount;
         /**the skirt height ratio, only effect when terrain use skirt to fix crack*/
         float _skirtHeightRatio;
+        /**
+        *when greater than 0, the chunks are streamed: only the chunks closer to the camera than this distance
+        *have vertices, they are built in a loading thread. 0 builds every chunk up front
+        */
+        float _streamingDistance;
+        /**the streamed chunks farther than this distance are released, 0 means 1.5 times the streaming distance*/
+        float _streamingUnloadDistance;
     };
 private:
 
@@ -193,6 +205,28 @@ private:
     };
 
     struct CC_DLL QuadTree;
+
+    /*
+    *the heights a streamed chunk is built from, copied for the loading thread
+    **/
+    struct ChunkSource
+    {
+        /*the chunk index*/
+        int _m;
+        int _n;
+        /*the window of pixels copied, the pixels of the chunk and the ones around it for the normals*/
+        int _firstRow;
+        int _firstColumn;
+        int _rows;
+        int _columns;
+        std::vector<float> _heights;
+        Size _size;
+        int _imageWidth;
+        int _imageHeight;
+        float _mapScale;
+        CrackFixedType _crackFixedType;
+        float _skirtHeight;
+    };
     /*
     *the terminal node of quad, use to subdivision terrain mesh and LOD
     **/
@@ -216,6 +250,15 @@ private:
         AABB _aabb;
         /**setup Chunk data*/
         void generate(int map_width, int map_height, int m, int n, const unsigned char * data);
+        /**fill the vertices and the triangles of a chunk, getVertex returns the vertex of a pixel (row, column)*/
+        static void fillVertices(const Size& size, int m, int n, int imgWidth, int imgHeight, CrackFixedType crackFixedType, float skirtHeight,
+                                 const std::function<TerrainVertexData(int, int)>& getVertex,
+                                 std::vector<TerrainVertexData>& vertices, std::vector<Triangle>& triangles, int* skirtVerticesOffset);
+        /**build the vertices of a streamed chunk, in the loading thread*/
+        static void buildFromSource(const ChunkSource& source, std::vector<TerrainVertexData>& vertices, std::vector<Triangle>& triangles,
+                                    int* skirtVerticesOffset);
+        /**release the vertices of a streamed chunk*/
+        void unload();
         /**calculateAABB*/
         void calculateAABB();
         /**internal use draw function*/
@@ -236,9 +279,16 @@ private:
 
         /**current LOD of the chunk*/
         int _currentLod;
+        /**whether the chunk has vertices, always with no streaming*/
+        bool _loaded;
+        /**whether the vertices of a streamed chunk are being built*/
+        bool _loading;
 
         int _oldLod;
 
+        /**the LOD the indices were built for*/
+        int _indicesLod;
+
         int _neighborOldLOD[4];
         /*the left,right,front,back neighbors*/
         Chunk * _left;
@@ -353,6 +403,23 @@ public:
      */
     void setLODDistance(float lod1, float lod2, float lod3);
 
+    /**
+     * Set the distance the camera has to move past a LOD threshold before a chunk changes its LOD,
+     * so the chunks around a threshold don't switch back and forth. It is a quarter of the chunk size by default.
+     */
+    void setLODHysteresis(float distance);
+    float getLODHysteresis() const { return _lodHysteresis; }
+
+    /**
+     * get the count of the chunks with vertices, all of them with no streaming
+     */
+    int getLoadedChunkCount() const;
+
+    /**
+     * get the count of the streamed chunks being built in the loading thread
+     */
+    int getLoadingChunkCount() const { return _streamingRequests; }
+
     /**Switch frustum Culling Flag
      * @Note frustum culling will remarkable improve your terrain rendering performance. 
      */
@@ -444,6 +511,22 @@ protected:
      **/
     void setChunksLOD(Vec3 cameraPos);
 
+    /**
+     * load the streamed chunks close to the camera and release the far ones
+     * @param cameraPos the camera position in world space
+     **/
+    void updateStreaming(const Vec3& cameraPos);
+
+    /**
+     * build the vertices of a streamed chunk in the loading thread
+     **/
+    void loadChunkAsync(Chunk * chunk);
+
+    /**
+     * compute the AABB of each chunk from the height map, before the streamed chunks have vertices
+     **/
+    void calculateChunksAABBFromHeights();
+
     /**
      * load Vertices from height filed for the whole terrain.
      **/
@@ -482,6 +565,11 @@ protected:
     bool _isDrawWire;
     unsigned char * _data;
     float _lodDistance[3];
+    float _lodHysteresis;
+    bool _isStreaming;
+    bool _isStreamingDirty;
+    int _streamingRequests;
+    unsigned int _streamingGeneration;
     Texture2D * _detailMapTextures[4];
     Texture2D * _alphaMap;
     Texture2D * _lightMap;
@@ -12,8 +12,10 @@ endif
 
 ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
 MATHNEONFILE := math/MathUtil.cpp.neon
+PIXELNEONFILE := renderer/CCPixelConverter.cpp.neon
 else
 MATHNEONFILE := math/MathUtil.cpp
+PIXELNEONFILE := renderer/CCPixelConverter.cpp
 endif
 
 LOCAL_SRC_FILES := \
@@ -74,10 +76,13 @@ cocos2d.cpp \
 2d/CCProtectedNode.cpp \
 2d/CCRenderTexture.cpp \
 2d/CCScene.cpp \
+2d/CCTransformSystem.cpp \
+2d/CCCachedNode.cpp \
 2d/CCSprite.cpp \
 2d/CCSpriteBatchNode.cpp \
 2d/CCSpriteFrame.cpp \
 2d/CCSpriteFrameCache.cpp \
+2d/CCDynamicAtlas.cpp \
 2d/CCTMXLayer.cpp \
 2d/CCTMXObjectGroup.cpp \
 2d/CCTMXTiledMap.cpp \
@@ -91,9 +96,11 @@ cocos2d.cpp \
 2d/CCAutoPolygon.cpp \
 3d/CCFrustum.cpp \
 3d/CCPlane.cpp \
+platform/CCFileArchive.cpp \
 platform/CCFileUtils.cpp \
 platform/CCGLView.cpp \
 platform/CCImage.cpp \
+platform/CCImageStreamDecoder.cpp \
 platform/CCSAXParser.cpp \
 platform/CCThread.cpp \
 $(MATHNEONFILE) \
@@ -172,6 +179,7 @@ renderer/CCGroupCommand.cpp \
 renderer/CCMaterial.cpp \
 renderer/CCMeshCommand.cpp \
 renderer/CCPass.cpp \
+$(PIXELNEONFILE) \
 renderer/CCPrimitive.cpp \
 renderer/CCPrimitiveCommand.cpp \
 renderer/CCQuadCommand.cpp \
@@ -206,6 +214,7 @@ physics3d/CCPhysics3DWorld.cpp \
 physics3d/CCPhysics3DComponent.cpp \
 physics3d/CCPhysics3DDebugDrawer.cpp \
 physics3d/CCPhysics3DObject.cpp \
+physics3d/CCPhysics3DParallel.cpp \
 physics3d/CCPhysics3DShape.cpp \
 physics3d/CCPhysicsSprite3D.cpp \
 physics3d/CCPhysics3DConstraint.cpp \
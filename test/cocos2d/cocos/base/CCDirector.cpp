@@ -50,6 +50,8 @@ THE SOFTWARE.
 #include "renderer/CCRenderState.h"
 #include "renderer/CCFrameBuffer.h"
 #include "2d/CCCamera.h"
+#include "3d/CCAnimation3DSampler.h"
+#include "3d/CCSprite3D.h"
 #include "base/CCUserDefault.h"
 #include "base/ccFPSImages.h"
 #include "base/CCScheduler.h"
@@ -933,6 +935,12 @@ void Director::reset()
     // cleanup scheduler
     getScheduler()->unscheduleAll();
     
+    // the sprites waiting for their uploads are not updated anymore
+    Sprite3D::purgeAsyncUploads();
+    
+    // applies the queued animations and joins the sampling threads, before its listener is removed below
+    Animation3DSampler::destroyInstance();
+    
     // Remove all events
     if (_eventDispatcher)
     {
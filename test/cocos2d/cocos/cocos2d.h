@@ -132,6 +132,8 @@ THE SOFTWARE.
 #include "2d/CCProtectedNode.h"
 #include "2d/CCRenderTexture.h"
 #include "2d/CCScene.h"
+#include "2d/CCTransformSystem.h"
+#include "2d/CCCachedNode.h"
 #include "2d/CCTransition.h"
 #include "2d/CCTransitionPageTurn.h"
 #include "2d/CCTransitionProgress.h"
@@ -190,8 +192,10 @@ THE SOFTWARE.
 // platform
 #include "platform/CCCommon.h"
 #include "platform/CCDevice.h"
+#include "platform/CCFileArchive.h"
 #include "platform/CCFileUtils.h"
 #include "platform/CCImage.h"
+#include "platform/CCImageStreamDecoder.h"
 #include "platform/CCPlatformConfig.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCSAXParser.h"
@@ -260,6 +264,7 @@ THE SOFTWARE.
 #include "2d/CCSpriteBatchNode.h"
 #include "2d/CCSpriteFrame.h"
 #include "2d/CCSpriteFrameCache.h"
+#include "2d/CCDynamicAtlas.h"
 
 // text_input_node
 #include "2d/CCTextFieldTTF.h"
@@ -285,11 +290,13 @@ THE SOFTWARE.
 #include "3d/CCAABB.h"
 #include "3d/CCAnimate3D.h"
 #include "3d/CCAnimation3D.h"
+#include "3d/CCAnimation3DSampler.h"
 #include "3d/CCAttachNode.h"
 #include "3d/CCBillBoard.h"
 #include "3d/CCFrustum.h"
 #include "3d/CCMesh.h"
 #include "3d/CCMeshSkin.h"
+#include "3d/CCMeshSimplifier.h"
 #include "3d/CCMotionStreak3D.h"
 #include "3d/CCMeshVertexIndexData.h"
 #include "3d/CCOBB.h"
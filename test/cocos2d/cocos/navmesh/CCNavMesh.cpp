@@ -83,6 +83,10 @@ static unsigned char* parseRow(unsigned char* buf, unsigned char* bufEnd, char*
 static const int TILECACHESET_MAGIC = 'T' << 24 | 'S' << 16 | 'E' << 8 | 'T'; //'TSET';
 static const int TILECACHESET_VERSION = 1;
 static const int MAX_AGENTS = 128;
+static const int MAX_PATH_POLYS = 256;
+static const int MAX_SMOOTH_PATH = 2048;
+static const int DEFAULT_PATH_QUERY_BUDGET = 256;
+static const float PATH_QUERY_EXTENTS[3] = { 2.0f, 4.0f, 2.0f };
 
 NavMesh* NavMesh::create(const std::string &navFilePath, const std::string &geomFilePath)
 {
@@ -106,16 +110,26 @@ NavMesh::NavMesh()
     , _meshProcess(nullptr)
     , _geomData(nullptr)
     , _isDebugDrawEnabled(false)
+    , _pathQuery(nullptr)
+    , _pathQueryBudget(DEFAULT_PATH_QUERY_BUDGET)
+    , _frontAgentStates(0)
+    , _crowdDelta(0.0f)
+    , _crowdStepRequested(false)
+    , _crowdStepPending(false)
+    , _quitCrowdThread(false)
 {
 
 }
 
 NavMesh::~NavMesh()
 {
+    setCrowdThreadEnabled(false);
+
     dtFreeTileCache(_tileCache);
     dtFreeCrowd(_crowed);
     dtFreeNavMesh(_navMesh);
     dtFreeNavMeshQuery(_navMeshQuery);
+    dtFreeNavMeshQuery(_pathQuery);
     CC_SAFE_DELETE(_allocator);
     CC_SAFE_DELETE(_compressor);
     CC_SAFE_DELETE(_meshProcess);
@@ -221,7 +235,13 @@ bool NavMesh::loadNavMeshFile()
     _navMeshQuery = dtAllocNavMeshQuery();
     _navMeshQuery->init(_navMesh, 2048);
 
+    //the async path queries have their own query, the sliced search keeps its state in it
+    _pathQuery = dtAllocNavMeshQuery();
+    _pathQuery->init(_navMesh, 2048);
+
     _agentList.assign(MAX_AGENTS, nullptr);
+    _agentStates[0].resize(MAX_AGENTS);
+    _agentStates[1].resize(MAX_AGENTS);
     _obstacleList.assign(header.cacheParams.maxObstacles, nullptr);
     //duDebugDrawNavMesh(&_debugDraw, *_navMesh, DU_DRAWNAVMESH_OFFMESHCONS);
     return true;
@@ -415,8 +435,10 @@ void NavMesh::removeNavMeshAgent(NavMeshAgent *agent)
 {
     auto iter = std::find(_agentList.begin(), _agentList.end(), agent);
     if (iter != _agentList.end()){
+        waitForCrowd();
         agent->removeFrom(_crowed);
         agent->setNavMeshQuery(nullptr);
+        agent->setNavMesh(nullptr);
         agent->release();
         _agentList[iter - _agentList.begin()] = nullptr;
     }
@@ -426,8 +448,15 @@ void NavMesh::addNavMeshAgent(NavMeshAgent *agent)
 {
     auto iter = std::find(_agentList.begin(), _agentList.end(), nullptr);
     if (iter != _agentList.end()){
+        waitForCrowd();
         agent->addTo(_crowed);
         agent->setNavMeshQuery(_navMeshQuery);
+        agent->setNavMesh(this);
+        if (agent->_agentID != -1){
+            //both copies, the step running next writes the back one only
+            captureAgentState(agent->_agentID, _agentStates[0][agent->_agentID]);
+            captureAgentState(agent->_agentID, _agentStates[1][agent->_agentID]);
+        }
         agent->retain();
         _agentList[iter - _agentList.begin()] = agent;
     }
@@ -446,6 +475,8 @@ void NavMesh::setDebugDrawEnable(bool enable)
 void NavMesh::debugDraw(Renderer* renderer)
 {
     if (_isDebugDrawEnabled){
+        //the agents are drawn from the crowd itself
+        waitForCrowd();
         _debugDraw.clear();
         dtDraw();
         _debugDraw.draw(renderer);
@@ -454,6 +485,45 @@ void NavMesh::debugDraw(Renderer* renderer)
 
 void NavMesh::update(float dt)
 {
+    if (_crowdThread.joinable()){
+        //sync the step started by the last update, then start the next one once the tile cache is done with the navmesh
+        waitForCrowd();
+
+        for (auto iter : _agentList){
+            if (iter)
+                iter->postUpdate(dt);
+        }
+
+        for (auto iter : _obstacleList){
+            if (iter)
+                iter->preUpdate(dt);
+        }
+
+        if (_tileCache)
+            _tileCache->update(dt, _navMesh);
+
+        for (auto iter : _obstacleList){
+            if (iter)
+                iter->postUpdate(dt);
+        }
+
+        for (auto iter : _agentList){
+            if (iter)
+                iter->preUpdate(dt);
+        }
+
+        if (_crowed){
+            {
+                std::lock_guard<std::mutex> lock(_crowdMutex);
+                _crowdDelta = dt;
+                _crowdStepRequested = true;
+            }
+            _crowdStepPending = true;
+            _crowdCondition.notify_all();
+        }
+        return;
+    }
+
     for (auto iter : _agentList){
         if (iter)
             iter->preUpdate(dt);
@@ -464,8 +534,10 @@ void NavMesh::update(float dt)
             iter->preUpdate(dt);
     }
 
-    if (_crowed)
-        _crowed->update(dt, nullptr);
+    if (_crowed){
+        stepCrowd(dt);
+        _frontAgentStates = 1 - _frontAgentStates;
+    }
 
     if (_tileCache)
         _tileCache->update(dt, _navMesh);
@@ -481,30 +553,173 @@ void NavMesh::update(float dt)
     }
 }
 
+void NavMesh::stepCrowd(float dt)
+{
+    _crowed->update(dt, nullptr);
+    updatePathRequests();
+
+    auto &states = _agentStates[1 - _frontAgentStates];
+    for (int i = 0; i < _crowed->getAgentCount(); ++i){
+        if (_crowed->getAgent(i)->active)
+            captureAgentState(i, states[i]);
+    }
+}
+
+void NavMesh::captureAgentState(int agentID, AgentState &state) const
+{
+    auto agent = _crowed->getAgent(agentID);
+    state.position.set(agent->npos);
+    state.velocity.set(agent->vel);
+    state.state = agent->state;
+}
+
+void NavMesh::waitForCrowd()
+{
+    if (!_crowdStepPending) return;
+
+    std::unique_lock<std::mutex> lock(_crowdMutex);
+    _crowdCondition.wait(lock, [this]{ return !_crowdStepRequested; });
+    _frontAgentStates = 1 - _frontAgentStates;
+    _crowdStepPending = false;
+}
+
+void NavMesh::crowdThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(_crowdMutex);
+    while (true)
+    {
+        _crowdCondition.wait(lock, [this]{ return _crowdStepRequested || _quitCrowdThread; });
+        if (_quitCrowdThread)
+            return;
+
+        float dt = _crowdDelta;
+        lock.unlock();
+        stepCrowd(dt);
+        lock.lock();
+
+        _crowdStepRequested = false;
+        _crowdCondition.notify_all();
+    }
+}
+
+void NavMesh::setCrowdThreadEnabled(bool enable)
+{
+    if (enable == _crowdThread.joinable()) return;
+
+    if (enable){
+        _quitCrowdThread = false;
+        _crowdThread = std::thread(&NavMesh::crowdThreadLoop, this);
+    }
+    else{
+        waitForCrowd();
+        {
+            std::lock_guard<std::mutex> lock(_crowdMutex);
+            _quitCrowdThread = true;
+        }
+        _crowdCondition.notify_all();
+        _crowdThread.join();
+    }
+}
+
+bool NavMesh::isCrowdThreadEnabled() const
+{
+    return _crowdThread.joinable();
+}
+
+std::future<std::vector<Vec3>> NavMesh::findPathAsync(const Vec3 &start, const Vec3 &end)
+{
+    //the worker may be reading the front request, pushing back leaves it in place
+    std::lock_guard<std::mutex> lock(_pathRequestMutex);
+    _pathRequests.emplace_back();
+    auto &request = _pathRequests.back();
+    request.start = start;
+    request.end = end;
+    request.started = false;
+    request.startRef = 0;
+    return request.promise.get_future();
+}
+
+void NavMesh::setPathQueryBudget(int maxIterations)
+{
+    _pathQueryBudget = std::max(1, maxIterations);
+}
+
+int NavMesh::getPathQueryBudget() const
+{
+    return _pathQueryBudget;
+}
+
+void NavMesh::updatePathRequests()
+{
+    int budget = _pathQueryBudget;
+    while (budget > 0)
+    {
+        PathRequest *request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_pathRequestMutex);
+            if (_pathRequests.empty()) break;
+            request = &_pathRequests.front();
+        }
+
+        dtStatus status = DT_IN_PROGRESS;
+        if (!request->started){
+            request->started = true;
+            dtPolyRef endRef = 0;
+            _pathQuery->findNearestPoly(&request->start.x, PATH_QUERY_EXTENTS, &_pathFilter, &request->startRef, 0);
+            _pathQuery->findNearestPoly(&request->end.x, PATH_QUERY_EXTENTS, &_pathFilter, &endRef, 0);
+            status = _pathQuery->initSlicedFindPath(request->startRef, endRef, &request->start.x, &request->end.x, &_pathFilter);
+        }
+
+        if (dtStatusInProgress(status)){
+            int iterations = 0;
+            status = _pathQuery->updateSlicedFindPath(budget, &iterations);
+            budget -= iterations;
+        }
+
+        //out of budget, go on with this request in the next update
+        if (dtStatusInProgress(status)) break;
+
+        std::vector<Vec3> pathPoints;
+        if (dtStatusSucceed(status)){
+            dtPolyRef polys[MAX_PATH_POLYS];
+            int npolys = 0;
+            _pathQuery->finalizeSlicedFindPath(polys, &npolys, MAX_PATH_POLYS);
+            budget -= smoothPath(_pathQuery, &_pathFilter, request->startRef, request->start, request->end, polys, npolys, pathPoints);
+        }
+        request->promise.set_value(std::move(pathPoints));
+
+        std::lock_guard<std::mutex> lock(_pathRequestMutex);
+        _pathRequests.pop_front();
+    }
+}
+
 void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<Vec3> &pathPoints)
 {
-    static const int MAX_POLYS = 256;
-    static const int MAX_SMOOTH = 2048;
-    float ext[3];
-    ext[0] = 2; ext[1] = 4; ext[2] = 2;
     dtQueryFilter filter;
     dtPolyRef startRef, endRef;
-    dtPolyRef polys[MAX_POLYS];
+    dtPolyRef polys[MAX_PATH_POLYS];
     int npolys = 0;
-    _navMeshQuery->findNearestPoly(&start.x, ext, &filter, &startRef, 0);
-    _navMeshQuery->findNearestPoly(&end.x, ext, &filter, &endRef, 0);
-    _navMeshQuery->findPath(startRef, endRef, &start.x, &end.x, &filter, polys, &npolys, MAX_POLYS);
+    _navMeshQuery->findNearestPoly(&start.x, PATH_QUERY_EXTENTS, &filter, &startRef, 0);
+    _navMeshQuery->findNearestPoly(&end.x, PATH_QUERY_EXTENTS, &filter, &endRef, 0);
+    _navMeshQuery->findPath(startRef, endRef, &start.x, &end.x, &filter, polys, &npolys, MAX_PATH_POLYS);
+
+    smoothPath(_navMeshQuery, &filter, startRef, start, end, polys, npolys, pathPoints);
+}
 
+int NavMesh::smoothPath(dtNavMeshQuery *query, const dtQueryFilter *filter, dtPolyRef startRef, const Vec3 &start, const Vec3 &end,
+    dtPolyRef *polys, int npolys, std::vector<Vec3> &pathPoints)
+{
+    int steps = 0;
     if (npolys)
     {
         //// Iterate over the path to find smooth path on the detail mesh surface.
-        //dtPolyRef polys[MAX_POLYS];
+        //dtPolyRef polys[MAX_PATH_POLYS];
         //memcpy(polys, polys, sizeof(dtPolyRef)*npolys);
         //int npolys = npolys;
 
         float iterPos[3], targetPos[3];
-        _navMeshQuery->closestPointOnPoly(startRef, &start.x, iterPos, 0);
-        _navMeshQuery->closestPointOnPoly(polys[npolys - 1], &end.x, targetPos, 0);
+        query->closestPointOnPoly(startRef, &start.x, iterPos, 0);
+        query->closestPointOnPoly(polys[npolys - 1], &end.x, targetPos, 0);
 
         static const float STEP_SIZE = 0.5f;
         static const float SLOP = 0.01f;
@@ -518,14 +733,15 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
 
         // Move towards target a small advancement at a time until target reached or
         // when ran out of memory to store the path.
-        while (npolys && nsmoothPath < MAX_SMOOTH)
+        while (npolys && nsmoothPath < MAX_SMOOTH_PATH)
         {
+            ++steps;
             // Find location to steer towards.
             float steerPos[3];
             unsigned char steerPosFlag;
             dtPolyRef steerPosRef;
 
-            if (!getSteerTarget(_navMeshQuery, iterPos, targetPos, SLOP,
+            if (!getSteerTarget(query, iterPos, targetPos, SLOP,
                 polys, npolys, steerPos, steerPosFlag, steerPosRef))
                 break;
 
@@ -548,14 +764,14 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
             float result[3];
             dtPolyRef visited[16];
             int nvisited = 0;
-            _navMeshQuery->moveAlongSurface(polys[0], iterPos, moveTgt, &filter,
+            query->moveAlongSurface(polys[0], iterPos, moveTgt, filter,
                 result, visited, &nvisited, 16);
 
-            npolys = fixupCorridor(polys, npolys, MAX_POLYS, visited, nvisited);
-            npolys = fixupShortcuts(polys, npolys, _navMeshQuery);
+            npolys = fixupCorridor(polys, npolys, MAX_PATH_POLYS, visited, nvisited);
+            npolys = fixupShortcuts(polys, npolys, query);
 
             float h = 0;
-            _navMeshQuery->getPolyHeight(polys[0], result, &h);
+            query->getPolyHeight(polys[0], result, &h);
             result[1] = h;
             dtVcopy(iterPos, result);
 
@@ -564,7 +780,7 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
             {
                 // Reached end of path.
                 dtVcopy(iterPos, targetPos);
-                if (nsmoothPath < MAX_SMOOTH)
+                if (nsmoothPath < MAX_SMOOTH_PATH)
                 {
                     //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
                     //m_nsmoothPath++;
@@ -595,7 +811,7 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
                 dtStatus status = _navMesh->getOffMeshConnectionPolyEndPoints(prevRef, polyRef, startPos, endPos);
                 if (dtStatusSucceed(status))
                 {
-                    if (nsmoothPath < MAX_SMOOTH)
+                    if (nsmoothPath < MAX_SMOOTH_PATH)
                     {
                         //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], startPos);
                         //m_nsmoothPath++;
@@ -613,13 +829,13 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
                     // Move position at the other side of the off-mesh link.
                     dtVcopy(iterPos, endPos);
                     float eh = 0.0f;
-                    _navMeshQuery->getPolyHeight(polys[0], iterPos, &eh);
+                    query->getPolyHeight(polys[0], iterPos, &eh);
                     iterPos[1] = eh;
                 }
             }
 
             // Store results.
-            if (nsmoothPath < MAX_SMOOTH)
+            if (nsmoothPath < MAX_SMOOTH_PATH)
             {
                 //dtVcopy(&m_smoothPath[m_nsmoothPath * 3], iterPos);
                 //m_nsmoothPath++;
@@ -629,6 +845,7 @@ void cocos2d::NavMesh::findPath(const Vec3 &start, const Vec3 &end, std::vector<
             }
         }
     }
+    return steps;
 }
 
 NS_CC_END
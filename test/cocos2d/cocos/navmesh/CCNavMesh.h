@@ -34,7 +34,13 @@
 #include "recast/Detour/DetourNavMeshQuery.h"
 #include "recast/DetourCrowd/DetourCrowd.h"
 #include "recast/DetourTileCache/DetourTileCache.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "navmesh/CCNavMeshAgent.h"
@@ -53,6 +59,7 @@ class Renderer;
 /** @brief NavMesh: The NavMesh information container, include mesh, tileCache, and so on. */
 class CC_DLL NavMesh : public Ref
 {
+    friend class NavMeshAgent;
 public:
 
     /**
@@ -96,6 +103,37 @@ public:
     */
     void findPath(const Vec3 &start, const Vec3 &end, std::vector<Vec3> &pathPoints);
 
+    /**
+    find a path on navmesh without blocking, the search runs a slice at a time in update()
+
+    @param start The start search position in world coordinate system.
+    @param end The end search position in world coordinate system.
+    @return The key points of path when the search is done, empty if no path was found.
+    A future still pending when the navmesh is destroyed throws std::future_error (broken_promise) from get().
+    */
+    std::future<std::vector<Vec3>> findPathAsync(const Vec3 &start, const Vec3 &end);
+
+    /**
+    set the number of search iterations the queued path queries can use in each update, default is 256.
+    The steps smoothing a found path count against it too, so an update can go over by the smoothing of one path.
+    Values less than 1 are clamped to 1.
+    */
+    void setPathQueryBudget(int maxIterations);
+
+    /** get the number of search iterations the queued path queries can use in each update. */
+    int getPathQueryBudget() const;
+
+    /**
+    Run the crowd update and the queued path queries on a worker thread.
+
+    An update starts the crowd step and the next update syncs its result to the nodes, so agents lag one frame.
+    Agent positions and velocities read in between come from a copy taken at the end of the last step.
+    */
+    void setCrowdThreadEnabled(bool enable);
+
+    /** Check the crowd is updated on a worker thread. */
+    bool isCrowdThreadEnabled() const;
+
 CC_CONSTRUCTOR_ACCESS:
     NavMesh();
     virtual ~NavMesh();
@@ -111,6 +149,31 @@ protected:
     void drawObstacles();
     void drawOffMeshConnections();
 
+    struct AgentState
+    {
+        Vec3 position;
+        Vec3 velocity;
+        unsigned char state;
+    };
+
+    struct PathRequest
+    {
+        Vec3 start;
+        Vec3 end;
+        bool started;
+        dtPolyRef startRef;
+        std::promise<std::vector<Vec3>> promise;
+    };
+
+    int smoothPath(dtNavMeshQuery *query, const dtQueryFilter *filter, dtPolyRef startRef, const Vec3 &start, const Vec3 &end,
+        dtPolyRef *polys, int npolys, std::vector<Vec3> &pathPoints);
+    void stepCrowd(float dt);
+    void updatePathRequests();
+    void captureAgentState(int agentID, AgentState &state) const;
+    const AgentState& getAgentState(int agentID) const { return _agentStates[_frontAgentStates][agentID]; }
+    void waitForCrowd();
+    void crowdThreadLoop();
+
 protected:
 
     dtNavMesh *_navMesh;
@@ -128,6 +191,26 @@ protected:
     std::string _navFilePath;
     std::string _geomFilePath;
     bool _isDebugDrawEnabled;
+
+    dtNavMeshQuery *_pathQuery;
+    dtQueryFilter _pathFilter;
+    std::deque<PathRequest> _pathRequests;
+    std::mutex _pathRequestMutex;
+    std::atomic<int> _pathQueryBudget;
+
+    // agents read _agentStates[_frontAgentStates] while a crowd step writes the other one
+    std::vector<AgentState> _agentStates[2];
+    int _frontAgentStates;
+
+    std::thread _crowdThread;
+    std::mutex _crowdMutex;
+    std::condition_variable _crowdCondition;
+    float _crowdDelta;
+    // set to start a step on the worker, cleared by the worker when done
+    bool _crowdStepRequested;
+    // a step was started and its agent states aren't in front yet
+    bool _crowdStepPending;
+    bool _quitCrowdThread;
 };
 
 /** @} */
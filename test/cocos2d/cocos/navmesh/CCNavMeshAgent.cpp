@@ -73,6 +73,7 @@ cocos2d::NavMeshAgent::NavMeshAgent()
     , _needUpdateAgent(true)
     , _needMove(false)
     , _navMeshQuery(nullptr)
+    , _navMesh(nullptr)
     , _rotRefAxes(Vec3::UNIT_Z)
     , _totalTimeAfterMove(0.0f)
     , _userData(nullptr)
@@ -98,6 +99,11 @@ void cocos2d::NavMeshAgent::setNavMeshQuery(dtNavMeshQuery *query)
     _navMeshQuery = query;
 }
 
+void NavMeshAgent::setNavMesh(NavMesh *navMesh)
+{
+    _navMesh = navMesh;
+}
+
 void cocos2d::NavMeshAgent::removeFrom(dtCrowd *crowed)
 {
     crowed->removeAgent(_agentID);
@@ -179,13 +185,7 @@ unsigned char NavMeshAgent::getObstacleAvoidanceType() const
 
 Vec3 NavMeshAgent::getCurrentVelocity() const
 {
-    if (_crowd){
-        auto agent = _crowd->getAgent(_agentID);
-        if (agent){
-            return Vec3(agent->vel[0], agent->vel[1], agent->vel[2]);
-        }
-    }
-    return Vec3::ZERO;
+    return getVelocity();
 }
 
 void NavMeshAgent::setMaxSpeed(float maxSpeed)
@@ -239,6 +239,7 @@ OffMeshLinkData NavMeshAgent::getCurrentOffMeshLinkData()
 {
     OffMeshLinkData data;
     if (_crowd && isOnOffMeshLink()){
+        _navMesh->waitForCrowd();
         auto agentAnim = _crowd->getEditableAgentAnim(_agentID);
         if (agentAnim){
             Mat4 mat;
@@ -267,6 +268,7 @@ void cocos2d::NavMeshAgent::completeOffMeshLink()
 void NavMeshAgent::setAutoTraverseOffMeshLink(bool isAuto)
 {
     if (_crowd && isOnOffMeshLink()){
+        _navMesh->waitForCrowd();
         auto agentAnim = _crowd->getEditableAgentAnim(_agentID);
         if (agentAnim){
             agentAnim->active = isAuto;
@@ -335,26 +337,23 @@ void NavMeshAgent::postUpdate(float delta)
 
 void NavMeshAgent::syncToNode()
 {
-    const dtCrowdAgent *agent = nullptr;
-    if (_crowd){
-        agent = _crowd->getAgent(_agentID);
-    }
-
-    if (agent){
+    //the copy of the agent taken by the last crowd step, the crowd may be stepping on its thread
+    if (_crowd && _navMesh && _agentID != -1){
+        auto &agent = _navMesh->getAgentState(_agentID);
         Mat4 wtop;
         Vec3 pos;
         if (_owner->getParent())
             wtop = _owner->getParent()->getWorldToNodeTransform();
-        wtop.transformPoint(Vec3(agent->npos[0], agent->npos[1], agent->npos[2]), &pos);
+        wtop.transformPoint(agent.position, &pos);
         _owner->setPosition3D(pos);
-        _state = agent->state;
+        _state = agent.state;
         if (_needAutoOrientation){
-            if ( fabs(agent->vel[0]) > 0.3f || fabs(agent->vel[1]) > 0.3f || fabs(agent->vel[2]) > 0.3f)
+            if ( fabs(agent.velocity.x) > 0.3f || fabs(agent.velocity.y) > 0.3f || fabs(agent.velocity.z) > 0.3f)
             {
                 Vec3 axes(_rotRefAxes);
                 axes.normalize();
                 Vec3 dir;
-                wtop.transformVector(Vec3(agent->vel[0], agent->vel[1], agent->vel[2]), &dir);
+                wtop.transformVector(agent.velocity, &dir);
                 dir.normalize();
                 float cosTheta = Vec3::dot(axes, dir);
                 Vec3 rotAxes;
@@ -392,13 +391,9 @@ void NavMeshAgent::syncToAgent()
 
 Vec3 NavMeshAgent::getVelocity() const
 {
-    const dtCrowdAgent *agent = nullptr;
-    if (_crowd){
-        agent = _crowd->getAgent(_agentID);
-    }
-    if (agent)
+    if (_crowd && _navMesh && _agentID != -1)
     {
-        return Vec3(agent->vel[0], agent->vel[1], agent->vel[2]);
+        return _navMesh->getAgentState(_agentID).velocity;
     }
     return Vec3::ZERO;
 }
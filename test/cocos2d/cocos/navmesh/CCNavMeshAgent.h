@@ -36,6 +36,8 @@
 class dtNavMeshQuery;
 NS_CC_BEGIN
 
+class NavMesh;
+
 /**
  * @addtogroup 3d
  * @{
@@ -207,6 +209,7 @@ private:
     void addTo(dtCrowd *crowed);
     void removeFrom(dtCrowd *crowed);
     void setNavMeshQuery(dtNavMeshQuery *query);
+    void setNavMesh(NavMesh *navMesh);
     void preUpdate(float delta);
     void postUpdate(float delta);
     static void convertTodtAgentParam(const NavMeshAgentParam &inParam, dtCrowdAgentParams &outParam);
@@ -228,6 +231,7 @@ private:
     void *_userData;
     dtCrowd *_crowd;
     dtNavMeshQuery *_navMeshQuery;
+    NavMesh *_navMesh;
 };
 
 /** @} */
@@ -26,6 +26,7 @@
 
 #include <climits>
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 
 #include "chipmunk.h"
@@ -50,6 +51,12 @@ namespace
 {
     static const float MASS_DEFAULT = 1.0;
     static const float MOMENT_DEFAULT = 200;
+
+    // a node transform turned into world space and back differs from the body by a few ulps
+    inline bool isNearlyEqual(float a, float b)
+    {
+        return std::abs(a - b) <= 8 * FLT_EPSILON * std::max(1.0f, std::abs(a));
+    }
 }
 
 PhysicsBody::PhysicsBody()
@@ -75,6 +82,8 @@ PhysicsBody::PhysicsBody()
 , _momentSetByUser(false)
 , _recordScaleX(1.f)
 , _recordScaleY(1.f)
+, _recordPosX(0.f)
+, _recordPosY(0.f)
 {
     _name = COMPONENT_NAME;
 }
@@ -886,18 +895,26 @@ void PhysicsBody::beforeSimulation(const Mat4& parentToWorldTransform, const Mat
     }
 
     // set rotation
-    if (_recordedRotation != rotation)
+    if (!isNearlyEqual(_recordedRotation, rotation))
     {
         setRotation(rotation);
     }
 
-    // set position
+    // set position, only when the node moved since setting it wakes the body up
     auto worldPosition = _ownerCenterOffset;
     nodeToWorldTransform.transformVector(worldPosition.x, worldPosition.y, worldPosition.z, 1.f, &worldPosition);
-    setPosition(worldPosition.x, worldPosition.y);
-
-    _recordPosX = worldPosition.x;
-    _recordPosY = worldPosition.y;
+    auto position = getPosition();
+    if (isNearlyEqual(position.x, worldPosition.x) && isNearlyEqual(position.y, worldPosition.y))
+    {
+        _recordPosX = position.x;
+        _recordPosY = position.y;
+    }
+    else
+    {
+        setPosition(worldPosition.x, worldPosition.y);
+        _recordPosX = worldPosition.x;
+        _recordPosY = worldPosition.y;
+    }
 
     if (_owner->getAnchorPoint() != Vec2::ANCHOR_MIDDLE)
     {
@@ -907,18 +924,22 @@ void PhysicsBody::beforeSimulation(const Mat4& parentToWorldTransform, const Mat
     }
 }
 
-void PhysicsBody::afterSimulation(const Mat4& parentToWorldTransform, float parentRotation)
+bool PhysicsBody::isMovedBySimulation() const
+{
+    auto position = getPosition();
+    return _recordPosX != position.x || _recordPosY != position.y || _recordedAngle != cpBodyGetAngle(_cpBody);
+}
+
+void PhysicsBody::applySimulation(const Mat4& worldToParentTransform, float parentRotation)
 {
-    // set Node position   
     auto tmp = getPosition();
     Vec3 positionInParent(tmp.x, tmp.y, 0.f);
     if (_recordPosX != positionInParent.x || _recordPosY != positionInParent.y)
     {
-        parentToWorldTransform.getInversed().transformVector(positionInParent.x, positionInParent.y, positionInParent.z, 1.f, &positionInParent);
+        worldToParentTransform.transformVector(positionInParent.x, positionInParent.y, positionInParent.z, 1.f, &positionInParent);
         _owner->setPosition(positionInParent.x - _offset.x, positionInParent.y - _offset.y);
     }
 
-    // set Node rotation
     _owner->setRotation(getRotation() - parentRotation);
 }
 
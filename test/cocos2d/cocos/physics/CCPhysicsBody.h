@@ -508,7 +508,10 @@ protected:
     void removeFromPhysicsWorld();
 
     void beforeSimulation(const Mat4& parentToWorldTransform, const Mat4& nodeToWorldTransform, float scaleX, float scaleY, float rotation);
-    void afterSimulation(const Mat4& parentToWorldTransform, float parentRotation);
+    // whether the last step moved or turned the body, sleeping bodies never do
+    bool isMovedBySimulation() const;
+    // write the simulated position and rotation back to the owner, in the space of its parent
+    void applySimulation(const Mat4& worldToParentTransform, float parentRotation);
 protected:
     std::vector<PhysicsJoint*> _joints;
     Vector<PhysicsShape*> _shapes;
@@ -847,9 +847,35 @@ void PhysicsWorld::update(float delta, bool userCall/* = false*/)
         debugDraw();
     }
 
-    // Update physics position, should loop as the same sequence as node tree.
-    // PhysicsWorld::afterSimulation() will depend on the sequence.
-    afterSimulation(_scene, sceneToWorldTransform, 0.f);
+    syncBodiesToNodes(sceneToWorldTransform);
+}
+
+void PhysicsWorld::useSpatialHash(float cellSize, int count)
+{
+    CCASSERT(!cpSpaceIsLocked(_cpSpace), "can't change the broadphase during a step");
+    CCASSERT(cellSize > 0 && count > 0, "the cell size and count must be positive");
+
+    cpSpaceUseSpatialHash(_cpSpace, cellSize, count);
+}
+
+void PhysicsWorld::setSleepTimeThreshold(float time)
+{
+    cpSpaceSetSleepTimeThreshold(_cpSpace, time);
+}
+
+float PhysicsWorld::getSleepTimeThreshold() const
+{
+    return PhysicsHelper::cpfloat2float(cpSpaceGetSleepTimeThreshold(_cpSpace));
+}
+
+void PhysicsWorld::setIdleSpeedThreshold(float speed)
+{
+    cpSpaceSetIdleSpeedThreshold(_cpSpace, speed);
+}
+
+float PhysicsWorld::getIdleSpeedThreshold() const
+{
+    return PhysicsHelper::cpfloat2float(cpSpaceGetIdleSpeedThreshold(_cpSpace));
 }
 
 PhysicsWorld* PhysicsWorld::construct(Scene* scene)
@@ -913,21 +939,56 @@ void PhysicsWorld::beforeSimulation(Node *node, const Mat4& parentToWorldTransfo
         beforeSimulation(child, nodeToWorldTransform, scaleX, scaleY, rotation);
 }
 
-void PhysicsWorld::afterSimulation(Node *node, const Mat4& parentToWorldTransform, float parentRotation)
+void PhysicsWorld::syncBodiesToNodes(const Mat4& sceneToWorldTransform)
 {
-    auto nodeToWorldTransform = parentToWorldTransform * node->getNodeToParentTransform();
-    auto nodeRotation = parentRotation + node->getRotation();
+    _syncParents.clear();
+    _syncBodies.clear();
 
-    auto physicsBody = node->getPhysicsBody();
-    if (physicsBody)
+    // the scene is the child of the null node, so its parent transform is the scene to world transform
+    auto& root = _syncParents[nullptr];
+    root.nodeToWorldTransform = sceneToWorldTransform;
+    root.rotation = 0.f;
+    root.inversed = false;
+
+    // every parent transform is taken before writing any node, so the children of a moved body
+    // see their parent where it was during the step
+    for (auto& body : _bodies)
     {
-        physicsBody->afterSimulation(parentToWorldTransform, parentRotation);
+        if (body->isMovedBySimulation())
+        {
+            _syncBodies.push_back(std::make_pair(body, &getSyncParent(body->getNode()->getParent())));
+        }
     }
 
-    for (auto child : node->getChildren())
-        afterSimulation(child, nodeToWorldTransform, nodeRotation);
+    // bodies under the same parent share the inverse of its transform
+    for (auto& item : _syncBodies)
+    {
+        auto parent = item.second;
+        if (!parent->inversed)
+        {
+            parent->worldToNodeTransform = parent->nodeToWorldTransform.getInversed();
+            parent->inversed = true;
+        }
+        item.first->applySimulation(parent->worldToNodeTransform, parent->rotation);
+    }
 }
 
+PhysicsWorld::SyncParent& PhysicsWorld::getSyncParent(Node* node)
+{
+    auto it = _syncParents.find(node);
+    if (it != _syncParents.end())
+    {
+        return it->second;
+    }
+
+    // references to the map elements stay valid when it grows
+    auto& parent = getSyncParent(node->getParent());
+    SyncParent syncParent;
+    syncParent.nodeToWorldTransform = parent.nodeToWorldTransform * node->getNodeToParentTransform();
+    syncParent.rotation = parent.rotation + node->getRotation();
+    syncParent.inversed = false;
+    return _syncParents.emplace(node, syncParent).first->second;
+}
 
 PhysicsDebugDraw::PhysicsDebugDraw(PhysicsWorld& world)
 : _drawNode(nullptr)
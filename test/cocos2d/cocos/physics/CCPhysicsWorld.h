@@ -29,6 +29,8 @@
 #if CC_USE_PHYSICS
 
 #include <list>
+#include <unordered_map>
+#include <vector>
 #include "base/CCVector.h"
 #include "math/CCGeometry.h"
 #include "physics/CCPhysicsBody.h"
@@ -285,6 +287,45 @@ public:
     */
     inline int getSubsteps() const { return _substeps; }
 
+    /**
+     * Use a spatial hash as the broadphase instead of the default bounding box tree.
+     *
+     * The spatial hash is faster for levels made of many shapes of about the same size.
+     * @attention Chipmunk can't go back to the bounding box tree, and this can't be called during a step.
+     * @param cellSize A float number, the size of a hash cell. About the size of the average shape works best.
+     * @param count An integer number, the minimum number of cells. About 10 times the number of shapes works well.
+     */
+    void useSpatialHash(float cellSize, int count);
+
+    /**
+     * Set the time a group of bodies has to stay idle before falling asleep.
+     *
+     * Sleeping bodies are neither simulated nor synced to their nodes until something touches or moves them.
+     * @param time A float number in seconds, default value is PHYSICS_INFINITY which disables sleeping.
+     */
+    void setSleepTimeThreshold(float time);
+
+    /**
+    * Get the time a group of bodies has to stay idle before falling asleep.
+    *
+    * @return A float number in seconds.
+    */
+    float getSleepTimeThreshold() const;
+
+    /**
+     * Set the speed under which a body is considered idle.
+     *
+     * @param speed A float number, default value is 0 which estimates it from the gravity.
+     */
+    void setIdleSpeedThreshold(float speed);
+
+    /**
+    * Get the speed under which a body is considered idle.
+    *
+    * @return A float number.
+    */
+    float getIdleSpeedThreshold() const;
+
     /**
     * Set the debug draw mask of this physics world.
     * 
@@ -375,13 +416,26 @@ protected:
     Vector<PhysicsBody*> _delayRemoveBodies;
     std::vector<PhysicsJoint*> _delayAddJoints;
     std::vector<PhysicsJoint*> _delayRemoveJoints;
+
+    struct SyncParent
+    {
+        Mat4 nodeToWorldTransform;
+        Mat4 worldToNodeTransform;
+        float rotation;
+        bool inversed;
+    };
+    // transforms of the parents of the bodies updated by the last step, keyed by parent node
+    std::unordered_map<Node*, SyncParent> _syncParents;
+    std::vector<std::pair<PhysicsBody*, SyncParent*>> _syncBodies;
     
 protected:
     PhysicsWorld();
     virtual ~PhysicsWorld();
     
     void beforeSimulation(Node *node, const Mat4& parentToWorldTransform, float nodeParentScaleX, float nodeParentScaleY, float parentRotation);
-    void afterSimulation(Node* node, const Mat4& parentToWorldTransform, float parentRotation);
+    // write the simulated positions and rotations back to the nodes, skipping the bodies the step didn't move
+    void syncBodiesToNodes(const Mat4& sceneToWorldTransform);
+    SyncParent& getSyncParent(Node* node);
 
     friend class Node;
     friend class Sprite;
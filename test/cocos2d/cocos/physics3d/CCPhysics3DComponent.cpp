@@ -183,31 +183,55 @@ void Physics3DComponent::syncPhysicsToNode()
         if (_owner->getParent())
             parentMat = _owner->getParent()->getNodeToWorldTransform();
         
-        auto mat = parentMat.getInversed() * _physics3DObj->getWorldTransform();
-        //remove scale, no scale support for physics
-        float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
-        mat.m[0] *= oneOverLen;
-        mat.m[1] *= oneOverLen;
-        mat.m[2] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
-        mat.m[4] *= oneOverLen;
-        mat.m[5] *= oneOverLen;
-        mat.m[6] *= oneOverLen;
-        oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
-        mat.m[8] *= oneOverLen;
-        mat.m[9] *= oneOverLen;
-        mat.m[10] *= oneOverLen;
-        
-        mat *= _transformInPhysics;
-        static Vec3 scale, translation;
-        static Quaternion quat;
-        mat.decompose(&scale, &quat, &translation);
+        Vec3 translation;
+        Quaternion quat;
+        computeNodeTransform(parentMat, &translation, &quat);
         _owner->setPosition3D(translation);
-        quat.normalize();
         _owner->setRotationQuat(quat);
     }
 }
 
+bool Physics3DComponent::needPhysicsToNodeSync() const
+{
+    return ((int)_syncFlag & (int)Physics3DComponent::PhysicsSyncFlag::PHYSICS_TO_NODE) && _physics3DObj && _owner
+        && (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY
+         || _physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::COLLIDER);
+}
+
+void Physics3DComponent::computeNodeTransform(const cocos2d::Mat4& parentMat, cocos2d::Vec3* translation, cocos2d::Quaternion* quat) const
+{
+    auto mat = parentMat.getInversed() * _physics3DObj->getWorldTransform();
+    //remove scale, no scale support for physics
+    float oneOverLen = 1.f / sqrtf(mat.m[0] * mat.m[0] + mat.m[1] * mat.m[1] + mat.m[2] * mat.m[2]);
+    mat.m[0] *= oneOverLen;
+    mat.m[1] *= oneOverLen;
+    mat.m[2] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[4] * mat.m[4] + mat.m[5] * mat.m[5] + mat.m[6] * mat.m[6]);
+    mat.m[4] *= oneOverLen;
+    mat.m[5] *= oneOverLen;
+    mat.m[6] *= oneOverLen;
+    oneOverLen = 1.f / sqrtf(mat.m[8] * mat.m[8] + mat.m[9] * mat.m[9] + mat.m[10] * mat.m[10]);
+    mat.m[8] *= oneOverLen;
+    mat.m[9] *= oneOverLen;
+    mat.m[10] *= oneOverLen;
+    
+    mat *= _transformInPhysics;
+    Vec3 scale;
+    mat.decompose(&scale, quat, translation);
+    quat->normalize();
+}
+
+void Physics3DComponent::applyNodeTransform(const cocos2d::Vec3& translation, const cocos2d::Quaternion& quat)
+{
+    if (_owner->getPosition3D() != translation)
+        _owner->setPosition3D(translation);
+    
+    // setRotationQuat dirties the transform even when the rotation is the same
+    Quaternion current = _owner->getRotationQuat();
+    if (current.x != quat.x || current.y != quat.y || current.z != quat.z || current.w != quat.w)
+        _owner->setRotationQuat(quat);
+}
+
 void Physics3DComponent::syncNodeToPhysics()
 {
     if (_physics3DObj->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY
@@ -127,6 +127,14 @@ protected:
     
     void postSimulate();
     
+    bool needPhysicsToNodeSync() const;
+    
+    /** computes the node position and rotation matching the physics object under a parent transform, thread safe */
+    void computeNodeTransform(const cocos2d::Mat4& parentMat, cocos2d::Vec3* translation, cocos2d::Quaternion* quat) const;
+    
+    /** sets the computed transform, skipping the setters when the node didn't move */
+    void applyNodeTransform(const cocos2d::Vec3& translation, const cocos2d::Quaternion& quat);
+    
     cocos2d::Mat4             _transformInPhysics; //transform in physics space
     cocos2d::Mat4             _invTransformInPhysics;
     
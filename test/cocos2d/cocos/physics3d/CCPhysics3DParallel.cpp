@@ -0,0 +1,427 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "CCPhysics3DParallel.h"
+
+#include <algorithm>
+
+#if CC_USE_3D_PHYSICS
+
+#if (CC_ENABLE_BULLET_INTEGRATION)
+
+#include "bullet/BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "bullet/BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "bullet/BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // overlapping pairs handed to a thread at once
+    const int PAIRS_PER_RANGE = 32;
+
+    // a convex-convex algorithm with its own simplex solver, the GJK state lives in the simplex solver
+    class ThreadSafeConvexConvexAlgorithm : public btConvexConvexAlgorithm
+    {
+    public:
+        ThreadSafeConvexConvexAlgorithm(btPersistentManifold* manifold, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, btConvexPenetrationDepthSolver* pdSolver, int numPerturbationIterations, int minimumPointsPerturbationThreshold)
+        : btConvexConvexAlgorithm(manifold, ci, body0Wrap, body1Wrap, &_simplexSolver, pdSolver, numPerturbationIterations, minimumPointsPerturbationThreshold)
+        {
+        }
+
+        // derives from btConvexConvexAlgorithm::CreateFunc so setConvexConvexMultipointIterations() still applies
+        struct CreateFunc : public btConvexConvexAlgorithm::CreateFunc
+        {
+            CreateFunc(btConvexPenetrationDepthSolver* pdSolver)
+            : btConvexConvexAlgorithm::CreateFunc(nullptr, pdSolver)
+            {
+            }
+
+            virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) override
+            {
+                void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(ThreadSafeConvexConvexAlgorithm));
+                return new(mem) ThreadSafeConvexConvexAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, m_pdSolver, m_numPerturbationIterations, m_minimumPointsPerturbationThreshold);
+            }
+        };
+
+    protected:
+        btVoronoiSimplexSolver _simplexSolver;
+    };
+
+    btDefaultCollisionConstructionInfo getParallelConstructionInfo()
+    {
+        btDefaultCollisionConstructionInfo info;
+        info.m_customCollisionAlgorithmMaxElementSize = sizeof(ThreadSafeConvexConvexAlgorithm);
+        return info;
+    }
+
+    int getConstraintIslandId(const btTypedConstraint* constraint)
+    {
+        const btCollisionObject& bodyA = constraint->getRigidBodyA();
+        const btCollisionObject& bodyB = constraint->getRigidBodyB();
+        return bodyA.getIslandTag() >= 0 ? bodyA.getIslandTag() : bodyB.getIslandTag();
+    }
+}
+
+Physics3DWorkerPool::Physics3DWorkerPool(int threadCount)
+: _batch(0)
+, _runningThreads(0)
+, _quit(false)
+, _func(nullptr)
+, _count(0)
+, _grainSize(1)
+, _nextItem(0)
+{
+    for (int i = 1; i < threadCount; i++)
+    {
+        _threads.push_back(std::thread([this, i]{
+            unsigned int lastBatch = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _startCondition.wait(lock, [this, lastBatch]{ return _quit || _batch != lastBatch; });
+                    if (_quit)
+                        return;
+                    lastBatch = _batch;
+                }
+
+                runRanges(i);
+
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _runningThreads--;
+                }
+                _doneCondition.notify_one();
+            }
+        }));
+    }
+}
+
+Physics3DWorkerPool::~Physics3DWorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _startCondition.notify_all();
+    for (auto& thread : _threads)
+        thread.join();
+}
+
+void Physics3DWorkerPool::parallelFor(int count, int grainSize, const std::function<void(int, int, int)>& func)
+{
+    if (count <= 0)
+        return;
+
+    grainSize = std::max(1, grainSize);
+    if (_threads.empty() || count <= grainSize)
+    {
+        func(0, count, 0);
+        return;
+    }
+
+    _func = &func;
+    _count = count;
+    _grainSize = grainSize;
+    _nextItem = 0;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _runningThreads = static_cast<int>(_threads.size());
+        _batch++;
+    }
+    _startCondition.notify_all();
+
+    runRanges(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this]{ return _runningThreads == 0; });
+    _func = nullptr;
+}
+
+void Physics3DWorkerPool::runRanges(int threadIndex)
+{
+    for (int begin = _nextItem.fetch_add(_grainSize); begin < _count; begin = _nextItem.fetch_add(_grainSize))
+        (*_func)(begin, std::min(begin + _grainSize, _count), threadIndex);
+}
+
+Physics3DParallelCollisionConfiguration::Physics3DParallelCollisionConfiguration()
+: btDefaultCollisionConfiguration(getParallelConstructionInfo())
+{
+    m_convexConvexCreateFunc->~btCollisionAlgorithmCreateFunc();
+    btAlignedFree(m_convexConvexCreateFunc);
+
+    void* mem = btAlignedAlloc(sizeof(ThreadSafeConvexConvexAlgorithm::CreateFunc), 16);
+    m_convexConvexCreateFunc = new(mem) ThreadSafeConvexConvexAlgorithm::CreateFunc(m_pdSolver);
+}
+
+Physics3DParallelCollisionDispatcher::Physics3DParallelCollisionDispatcher(Physics3DParallelCollisionConfiguration* collisionConfiguration, Physics3DWorkerPool* pool)
+: btCollisionDispatcher(collisionConfiguration)
+, _pool(pool)
+{
+}
+
+btPersistentManifold* Physics3DParallelCollisionDispatcher::getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1)
+{
+    std::lock_guard<std::mutex> lock(_allocationMutex);
+    return btCollisionDispatcher::getNewManifold(body0, body1);
+}
+
+void Physics3DParallelCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
+{
+    std::lock_guard<std::mutex> lock(_allocationMutex);
+    btCollisionDispatcher::releaseManifold(manifold);
+}
+
+void* Physics3DParallelCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+    std::lock_guard<std::mutex> lock(_allocationMutex);
+    return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}
+
+void Physics3DParallelCollisionDispatcher::freeCollisionAlgorithm(void* ptr)
+{
+    std::lock_guard<std::mutex> lock(_allocationMutex);
+    btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}
+
+void Physics3DParallelCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher)
+{
+    btBroadphasePairArray& pairs = pairCache->getOverlappingPairArray();
+    if (_pool->getThreadCount() <= 1 || pairs.size() <= PAIRS_PER_RANGE)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+        return;
+    }
+
+    // the pair callback of btCollisionDispatcher never removes a pair, the array doesn't change while dispatching
+    btNearCallback nearCallback = getNearCallback();
+    _pool->parallelFor(pairs.size(), PAIRS_PER_RANGE, [&](int begin, int end, int){
+        for (int i = begin; i < end; i++)
+            nearCallback(pairs[i], *this, dispatchInfo);
+    });
+}
+
+struct Physics3DParallelDynamicsWorld::IslandCollector : public btSimulationIslandManager::IslandCallback
+{
+    Physics3DParallelDynamicsWorld* world;
+
+    explicit IslandCollector(Physics3DParallelDynamicsWorld* collectingWorld)
+    : world(collectingWorld)
+    {
+    }
+
+    virtual void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId) override
+    {
+        // the bodies array is reused by the island manager for the next island, copy it
+        Island island;
+        island.firstBody = static_cast<int>(world->_islandBodies.size());
+        island.bodyCount = numBodies;
+        world->_islandBodies.insert(world->_islandBodies.end(), bodies, bodies + numBodies);
+        island.firstManifold = static_cast<int>(world->_islandManifolds.size());
+        island.manifoldCount = numManifolds;
+        world->_islandManifolds.insert(world->_islandManifolds.end(), manifolds, manifolds + numManifolds);
+
+        auto& constraints = world->_sortedConstraints;
+        auto range = std::equal_range(constraints.begin(), constraints.end(), islandId, IslandIdLess());
+        island.firstConstraint = static_cast<int>(range.first - constraints.begin());
+        island.constraintCount = static_cast<int>(range.second - range.first);
+        island.group = static_cast<int>(world->_islands.size());
+        world->_islands.push_back(island);
+    }
+
+    struct IslandIdLess
+    {
+        bool operator()(const btTypedConstraint* constraint, int islandId) const { return getConstraintIslandId(constraint) < islandId; }
+        bool operator()(int islandId, const btTypedConstraint* constraint) const { return islandId < getConstraintIslandId(constraint); }
+    };
+};
+
+Physics3DParallelDynamicsWorld::Physics3DParallelDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, Physics3DWorkerPool* pool)
+: btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+, _pool(pool)
+{
+    for (int i = 1; i < pool->getThreadCount(); i++)
+        _threadSolvers.push_back(new btSequentialImpulseConstraintSolver());
+}
+
+Physics3DParallelDynamicsWorld::~Physics3DParallelDynamicsWorld()
+{
+    for (auto solver : _threadSolvers)
+        delete solver;
+}
+
+void Physics3DParallelDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+    if (_pool->getThreadCount() <= 1 || !m_islandManager->getSplitIslands())
+    {
+        btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+        return;
+    }
+
+    BT_PROFILE("solveConstraints");
+
+    _sortedConstraints.resize(m_constraints.size());
+    for (int i = 0; i < m_constraints.size(); i++)
+        _sortedConstraints[i] = m_constraints[i];
+    std::sort(_sortedConstraints.begin(), _sortedConstraints.end(), [](const btTypedConstraint* a, const btTypedConstraint* b){
+        return getConstraintIslandId(a) < getConstraintIslandId(b);
+    });
+
+    _islands.clear();
+    _islandBodies.clear();
+    _islandManifolds.clear();
+
+    m_constraintSolver->prepareSolve(getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds());
+
+    // the island manager only reports the awake islands
+    IslandCollector collector(this);
+    m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(), getCollisionWorld(), &collector);
+
+    groupIslandsByKinematicBody();
+    buildBatches(solverInfo.m_minimumSolverBatchSize);
+
+    btDispatcher* dispatcher = getCollisionWorld()->getDispatcher();
+    _pool->parallelFor(static_cast<int>(_batches.size()), 1, [&](int begin, int end, int threadIndex){
+        btConstraintSolver* solver = threadIndex == 0 ? m_constraintSolver : _threadSolvers[threadIndex - 1];
+        for (int i = begin; i < end; i++)
+        {
+            const Batch& batch = _batches[i];
+            solver->solveGroup(batch.bodyCount ? &_batchBodies[batch.firstBody] : nullptr, batch.bodyCount,
+                               batch.manifoldCount ? &_batchManifolds[batch.firstManifold] : nullptr, batch.manifoldCount,
+                               batch.constraintCount ? &_batchConstraints[batch.firstConstraint] : nullptr, batch.constraintCount,
+                               solverInfo, m_debugDrawer, dispatcher);
+        }
+    });
+
+    m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+    for (auto solver : _threadSolvers)
+        solver->allSolved(solverInfo, m_debugDrawer);
+}
+
+void Physics3DParallelDynamicsWorld::groupIslandsByKinematicBody()
+{
+    int islandCount = static_cast<int>(_islands.size());
+    _groupParents.resize(islandCount);
+    for (int i = 0; i < islandCount; i++)
+        _groupParents[i] = i;
+
+    auto findGroup = [this](int island) {
+        while (_groupParents[island] != island)
+        {
+            _groupParents[island] = _groupParents[_groupParents[island]];
+            island = _groupParents[island];
+        }
+        return island;
+    };
+
+    // a solver gives a kinematic body a solver body of its own and writes its velocity back,
+    // so all the islands in contact with it must be solved by the same solver
+    _kinematicIslands.clear();
+    auto shareKinematicBody = [&](const btCollisionObject* object, int island) {
+        if (object->getIslandTag() >= 0 || !object->isKinematicObject() || !btRigidBody::upcast(object))
+            return;
+
+        auto result = _kinematicIslands.insert(std::make_pair(object, island));
+        if (!result.second)
+        {
+            int groupA = findGroup(result.first->second);
+            int groupB = findGroup(island);
+            if (groupA != groupB)
+                _groupParents[std::max(groupA, groupB)] = std::min(groupA, groupB);
+        }
+    };
+
+    for (int i = 0; i < islandCount; i++)
+    {
+        const Island& island = _islands[i];
+        for (int m = 0; m < island.manifoldCount; m++)
+        {
+            const btPersistentManifold* manifold = _islandManifolds[island.firstManifold + m];
+            shareKinematicBody(manifold->getBody0(), i);
+            shareKinematicBody(manifold->getBody1(), i);
+        }
+        for (int c = 0; c < island.constraintCount; c++)
+        {
+            const btTypedConstraint* constraint = _sortedConstraints[island.firstConstraint + c];
+            shareKinematicBody(&constraint->getRigidBodyA(), i);
+            shareKinematicBody(&constraint->getRigidBodyB(), i);
+        }
+    }
+
+    for (int i = 0; i < islandCount; i++)
+        _islands[i].group = findGroup(i);
+}
+
+void Physics3DParallelDynamicsWorld::buildBatches(int minimumBatchSize)
+{
+    int islandCount = static_cast<int>(_islands.size());
+    _islandOrder.resize(islandCount);
+    for (int i = 0; i < islandCount; i++)
+        _islandOrder[i] = i;
+    std::stable_sort(_islandOrder.begin(), _islandOrder.end(), [this](int a, int b){
+        return _islands[a].group < _islands[b].group;
+    });
+
+    _batches.clear();
+    _batchBodies.clear();
+    _batchManifolds.clear();
+    _batchConstraints.clear();
+
+    Batch batch = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < islandCount; i++)
+    {
+        const Island& island = _islands[_islandOrder[i]];
+        _batchBodies.insert(_batchBodies.end(), _islandBodies.begin() + island.firstBody, _islandBodies.begin() + island.firstBody + island.bodyCount);
+        _batchManifolds.insert(_batchManifolds.end(), _islandManifolds.begin() + island.firstManifold, _islandManifolds.begin() + island.firstManifold + island.manifoldCount);
+        _batchConstraints.insert(_batchConstraints.end(), _sortedConstraints.begin() + island.firstConstraint, _sortedConstraints.begin() + island.firstConstraint + island.constraintCount);
+        batch.bodyCount += island.bodyCount;
+        batch.manifoldCount += island.manifoldCount;
+        batch.constraintCount += island.constraintCount;
+
+        // same batching rule as btDiscreteDynamicsWorld, a group is never split between batches
+        bool groupEnds = i + 1 == islandCount || _islands[_islandOrder[i + 1]].group != island.group;
+        if (groupEnds && batch.manifoldCount + batch.constraintCount > minimumBatchSize)
+        {
+            _batches.push_back(batch);
+            batch.firstBody = static_cast<int>(_batchBodies.size());
+            batch.firstManifold = static_cast<int>(_batchManifolds.size());
+            batch.firstConstraint = static_cast<int>(_batchConstraints.size());
+            batch.bodyCount = batch.manifoldCount = batch.constraintCount = 0;
+        }
+    }
+    if (batch.manifoldCount + batch.constraintCount > 0)
+        _batches.push_back(batch);
+
+    // the largest batches first, the small ones fill the gaps at the end
+    std::sort(_batches.begin(), _batches.end(), [](const Batch& a, const Batch& b){
+        return a.manifoldCount + a.constraintCount > b.manifoldCount + b.constraintCount;
+    });
+}
+
+NS_CC_END
+
+#endif // CC_ENABLE_BULLET_INTEGRATION
+
+#endif //CC_USE_3D_PHYSICS
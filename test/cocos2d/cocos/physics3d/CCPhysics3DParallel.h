@@ -0,0 +1,205 @@
+/****************************************************************************
+ Copyright (c) 2015 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PHYSICS_3D_PARALLEL_H__
+#define __PHYSICS_3D_PARALLEL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "base/ccConfig.h"
+#include "base/ccMacros.h"
+
+#if CC_USE_3D_PHYSICS
+
+#if (CC_ENABLE_BULLET_INTEGRATION)
+
+#include "bullet/btBulletCollisionCommon.h"
+#include "bullet/btBulletDynamicsCommon.h"
+
+NS_CC_BEGIN
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+/**
+ * @brief A fork-join pool running the parallel parts of a Physics3DWorld step.
+ *
+ * The calling thread works along with the workers and parallelFor() returns once every item is done.
+ * The thread index passed to the function is 0 for the calling thread and 1 to getThreadCount() - 1
+ * for the workers, so per thread scratch data can be indexed by it.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL Physics3DWorkerPool
+{
+public:
+    /** threadCount counts the calling thread, 1 runs everything on the calling thread */
+    explicit Physics3DWorkerPool(int threadCount);
+    ~Physics3DWorkerPool();
+
+    int getThreadCount() const { return static_cast<int>(_threads.size()) + 1; }
+
+    /**
+     * calls func(begin, end, threadIndex) on ranges of at most grainSize items until count items are done.
+     * Runs on the calling thread only when the items fit in one range.
+     */
+    void parallelFor(int count, int grainSize, const std::function<void(int, int, int)>& func);
+
+protected:
+    void runRanges(int threadIndex);
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _startCondition;
+    std::condition_variable _doneCondition;
+    // incremented for each parallelFor the workers must run
+    unsigned int _batch;
+    int _runningThreads;
+    bool _quit;
+
+    const std::function<void(int, int, int)>* _func;
+    int _count;
+    int _grainSize;
+    std::atomic<int> _nextItem;
+};
+
+/**
+ * @brief A collision configuration whose convex-convex algorithms own their simplex solver.
+ *
+ * btDefaultCollisionConfiguration shares one simplex solver between all the convex-convex pairs,
+ * which keeps them from running their narrow phase at the same time.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL Physics3DParallelCollisionConfiguration : public btDefaultCollisionConfiguration
+{
+public:
+    Physics3DParallelCollisionConfiguration();
+};
+
+/**
+ * @brief A collision dispatcher running the narrow phase of the overlapping pairs on a Physics3DWorkerPool.
+ *
+ * The algorithm and manifold pools are shared, their allocations are serialized, the contacts of each pair
+ * are computed in parallel. Needs a Physics3DParallelCollisionConfiguration.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL Physics3DParallelCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    Physics3DParallelCollisionDispatcher(Physics3DParallelCollisionConfiguration* collisionConfiguration, Physics3DWorkerPool* pool);
+
+    virtual btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) override;
+    virtual void releaseManifold(btPersistentManifold* manifold) override;
+    virtual void* allocateCollisionAlgorithm(int size) override;
+    virtual void freeCollisionAlgorithm(void* ptr) override;
+    virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher) override;
+
+protected:
+    Physics3DWorkerPool* _pool;
+    std::mutex _allocationMutex;
+};
+
+/**
+ * @brief A dynamics world solving its simulation islands in parallel on a Physics3DWorkerPool.
+ *
+ * Each thread solves whole islands with its own btSequentialImpulseConstraintSolver, small islands are
+ * batched like btDiscreteDynamicsWorld does with btContactSolverInfo::m_minimumSolverBatchSize.
+ * Islands touching the same kinematic body are solved by the same thread, the solvers write its velocity.
+ * The contacts of an island are the same as in the serial world, only the order the islands are
+ * solved in changes, so a step isn't bitwise deterministic across runs.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL Physics3DParallelDynamicsWorld : public btDiscreteDynamicsWorld
+{
+public:
+    Physics3DParallelDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, Physics3DWorkerPool* pool);
+    virtual ~Physics3DParallelDynamicsWorld();
+
+protected:
+    struct Island
+    {
+        int firstBody;
+        int bodyCount;
+        int firstManifold;
+        int manifoldCount;
+        int firstConstraint;
+        int constraintCount;
+        int group;
+    };
+
+    struct Batch
+    {
+        int firstBody;
+        int bodyCount;
+        int firstManifold;
+        int manifoldCount;
+        int firstConstraint;
+        int constraintCount;
+    };
+
+    struct IslandCollector;
+
+    virtual void solveConstraints(btContactSolverInfo& solverInfo) override;
+
+    void groupIslandsByKinematicBody();
+    void buildBatches(int minimumBatchSize);
+
+    Physics3DWorkerPool* _pool;
+    // solvers of the worker threads, the main thread uses the world solver
+    std::vector<btSequentialImpulseConstraintSolver*> _threadSolvers;
+
+    std::vector<Island> _islands;
+    std::vector<btCollisionObject*> _islandBodies;
+    std::vector<btPersistentManifold*> _islandManifolds;
+    // the constraints sorted by island, like btDiscreteDynamicsWorld does
+    std::vector<btTypedConstraint*> _sortedConstraints;
+    std::vector<int> _groupParents;
+    std::unordered_map<const btCollisionObject*, int> _kinematicIslands;
+    std::vector<int> _islandOrder;
+
+    std::vector<Batch> _batches;
+    std::vector<btCollisionObject*> _batchBodies;
+    std::vector<btPersistentManifold*> _batchManifolds;
+    std::vector<btTypedConstraint*> _batchConstraints;
+};
+
+// end of 3d group
+/// @}
+NS_CC_END
+
+#endif // CC_ENABLE_BULLET_INTEGRATION
+
+#endif //CC_USE_3D_PHYSICS
+
+#endif // __PHYSICS_3D_PARALLEL_H__
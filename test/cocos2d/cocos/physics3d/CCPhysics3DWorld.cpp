@@ -23,14 +23,159 @@
  ****************************************************************************/
 
 #include "CCPhysics3D.h"
+#include "CCPhysics3DParallel.h"
+#include "2d/CCNode.h"
 #include "renderer/CCRenderer.h"
 
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
 #if CC_USE_3D_PHYSICS
 
 #if (CC_ENABLE_BULLET_INTEGRATION)
 
+#include "bullet/LinearMath/btTransformUtil.h"
+
 NS_CC_BEGIN
 
+namespace
+{
+    // rays and sweeps handed to a thread at once
+    const int RAYS_PER_RANGE = 16;
+    const int SWEEPS_PER_RANGE = 4;
+    
+    // the ray setup of btSingleRayCallback and btSingleSweepCallback
+    struct QueryRay
+    {
+        btVector3 rayDirectionInverse;
+        unsigned int signs[3];
+        btScalar lambdaMax;
+        
+        QueryRay(const btVector3& from, const btVector3& to)
+        {
+            btVector3 rayDir = to - from;
+            rayDir.normalize();
+            rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+            rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+            rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+            signs[0] = rayDirectionInverse[0] < 0.0;
+            signs[1] = rayDirectionInverse[1] < 0.0;
+            signs[2] = rayDirectionInverse[2] < 0.0;
+            lambdaMax = rayDir.dot(to - from);
+        }
+    };
+    
+    // btDbvt::rayTestInternal with a caller owned stack, the one of btDbvt is shared by all the callers.
+    // The traversal only uses the stack above its current size, so processLeaf can traverse another tree with it.
+    template <typename ProcessLeaf>
+    void rayTestTree(const btDbvtNode* root, const btVector3& from, const QueryRay& ray, const btVector3& aabbMin, const btVector3& aabbMax, std::vector<const btDbvtNode*>& stack, const ProcessLeaf& processLeaf)
+    {
+        if (!root)
+            return;
+        
+        size_t base = stack.size();
+        stack.push_back(root);
+        btVector3 bounds[2];
+        unsigned int signs[3] = { ray.signs[0], ray.signs[1], ray.signs[2] };
+        while (stack.size() > base)
+        {
+            const btDbvtNode* node = stack.back();
+            stack.pop_back();
+            bounds[0] = node->volume.Mins() - aabbMax;
+            bounds[1] = node->volume.Maxs() - aabbMin;
+            btScalar tmin = 1.f;
+            if (btRayAabb2(from, ray.rayDirectionInverse, signs, bounds, tmin, 0.f, ray.lambdaMax))
+            {
+                if (node->isinternal())
+                {
+                    stack.push_back(node->childs[0]);
+                    stack.push_back(node->childs[1]);
+                }
+                else if (!processLeaf(node))
+                {
+                    stack.resize(base);
+                    return;
+                }
+            }
+        }
+    }
+    
+    // btCollisionWorld::rayTestSingle, except that the children of compound shapes are found with the caller owned stack
+    // instead of btDbvt::rayTest, which allocates its own stack on every call
+    void rayTestShape(const btTransform& rayFromTrans, const btTransform& rayToTrans, btCollisionObject* object, const btCollisionShape* shape,
+                      const btTransform& worldTransform, btCollisionWorld::RayResultCallback& resultCallback, std::vector<const btDbvtNode*>& stack)
+    {
+        if (!shape->isCompound())
+        {
+            btCollisionWorld::rayTestSingle(rayFromTrans, rayToTrans, object, shape, worldTransform, resultCallback);
+            return;
+        }
+        
+        auto compound = static_cast<const btCompoundShape*>(shape);
+        auto testChild = [&](int index) {
+            btTransform childTransform = worldTransform * compound->getChildTransform(index);
+            rayTestShape(rayFromTrans, rayToTrans, object, compound->getChildShape(index), childTransform, resultCallback, stack);
+        };
+        
+        const btDbvt* tree = compound->getDynamicAabbTree();
+        if (tree)
+        {
+            // the tree is in the space of the compound
+            btTransform worldToCompound = worldTransform.inverse();
+            btVector3 localFrom = worldToCompound * rayFromTrans.getOrigin();
+            btVector3 localTo = worldToCompound * rayToTrans.getOrigin();
+            QueryRay ray(localFrom, localTo);
+            btVector3 zero(0.f, 0.f, 0.f);
+            rayTestTree(tree->m_root, localFrom, ray, zero, zero, stack, [&](const btDbvtNode* leaf) {
+                testChild(leaf->dataAsInt);
+                return resultCallback.m_closestHitFraction != btScalar(0.f);
+            });
+        }
+        else
+        {
+            for (int i = 0; i < compound->getNumChildShapes(); i++)
+            {
+                testChild(i);
+            }
+        }
+    }
+}
+
+Physics3DWorld::RayQuery::RayQuery()
+: collisionFilterGroup(btBroadphaseProxy::DefaultFilter)
+, collisionFilterMask(btBroadphaseProxy::AllFilter)
+{
+    
+}
+
+Physics3DWorld::RayQuery::RayQuery(const cocos2d::Vec3& start, const cocos2d::Vec3& end, short filterGroup, short filterMask)
+: startPos(start)
+, endPos(end)
+, collisionFilterGroup(filterGroup)
+, collisionFilterMask(filterMask)
+{
+    
+}
+
+Physics3DWorld::SweepQuery::SweepQuery()
+: shape(nullptr)
+, collisionFilterGroup(btBroadphaseProxy::DefaultFilter)
+, collisionFilterMask(btBroadphaseProxy::AllFilter)
+{
+    
+}
+
+Physics3DWorld::SweepQuery::SweepQuery(Physics3DShape* sweptShape, const cocos2d::Mat4& start, const cocos2d::Mat4& end, short filterGroup, short filterMask)
+: shape(sweptShape)
+, startTransform(start)
+, endTransform(end)
+, collisionFilterGroup(filterGroup)
+, collisionFilterMask(filterMask)
+{
+    
+}
+
 Physics3DWorld::Physics3DWorld()
 : _btPhyiscsWorld(nullptr)
 , _collisionConfiguration(nullptr)
@@ -39,6 +184,7 @@ Physics3DWorld::Physics3DWorld()
 , _solver(nullptr)
 , _ghostCallback(nullptr)
 , _debugDrawer(nullptr)
+, _workerPool(nullptr)
 , _needCollisionChecking(false)
 , _collisionCheckingFlag(false)
 , _needGhostPairCallbackChecking(false)
@@ -57,6 +203,7 @@ Physics3DWorld::~Physics3DWorld()
     CC_SAFE_DELETE(_solver);
     CC_SAFE_DELETE(_btPhyiscsWorld);
     CC_SAFE_DELETE(_debugDrawer);
+    CC_SAFE_DELETE(_workerPool);
     for (auto it : _physicsComponents)
         it->setPhysics3DObject(nullptr);
     _physicsComponents.clear();
@@ -82,23 +229,41 @@ Vec3 Physics3DWorld::getGravity() const
 
 bool Physics3DWorld::init(Physics3DWorldDes* info)
 {
-    ///collision configuration contains default setup for memory, collision setup
-    _collisionConfiguration = new (std::nothrow) btDefaultCollisionConfiguration();
-    //_collisionConfiguration->setConvexConvexMultipointIterations();
-    
-    ///use the default collision dispatcher. For parallel processing you can use a different dispatcher (see Extras/BulletMultiThreaded)
-    _dispatcher = new (std::nothrow) btCollisionDispatcher(_collisionConfiguration);
+    int numThreads = info->numThreads > 0 ? info->numThreads : static_cast<int>(std::thread::hardware_concurrency());
+    if (numThreads > 1)
+    {
+        _workerPool = new (std::nothrow) Physics3DWorkerPool(numThreads);
+        
+        ///the convex-convex algorithms own their simplex solver, so that pairs can be processed in parallel
+        auto collisionConfiguration = new (std::nothrow) Physics3DParallelCollisionConfiguration();
+        _collisionConfiguration = collisionConfiguration;
+        
+        ///runs the narrow phase of the overlapping pairs on the worker pool
+        _dispatcher = new (std::nothrow) Physics3DParallelCollisionDispatcher(collisionConfiguration, _workerPool);
+    }
+    else
+    {
+        ///collision configuration contains default setup for memory, collision setup
+        _collisionConfiguration = new (std::nothrow) btDefaultCollisionConfiguration();
+        //_collisionConfiguration->setConvexConvexMultipointIterations();
+        
+        ///use the default collision dispatcher. For parallel processing you can use a different dispatcher (see Extras/BulletMultiThreaded)
+        _dispatcher = new (std::nothrow) btCollisionDispatcher(_collisionConfiguration);
+    }
     
     _broadphase = new (std::nothrow) btDbvtBroadphase();
     
-    ///the default constraint solver. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded)
+    ///the default constraint solver, the parallel world solves the islands with one solver per thread
     btSequentialImpulseConstraintSolver* sol = new btSequentialImpulseConstraintSolver();
     _solver = sol;
 
     btGhostPairCallback *ghostCallback = new btGhostPairCallback();
     _ghostCallback = ghostCallback;
     
-    _btPhyiscsWorld = new btDiscreteDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration);
+    if (_workerPool)
+        _btPhyiscsWorld = new Physics3DParallelDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration,_workerPool);
+    else
+        _btPhyiscsWorld = new btDiscreteDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration);
     _btPhyiscsWorld->setGravity(convertVec3TobtVector3(info->gravity));
     if (info->isDebugDrawEnabled)
     {
@@ -118,6 +283,11 @@ void Physics3DWorld::setDebugDrawEnable(bool enableDebugDraw)
     enableDebugDraw ? _btPhyiscsWorld->setDebugDrawer(_debugDrawer) : _btPhyiscsWorld->setDebugDrawer(nullptr);
 }
 
+int Physics3DWorld::getNumThreads() const
+{
+    return _workerPool ? _workerPool->getThreadCount() : 1;
+}
+
 bool Physics3DWorld::isDebugDrawEnabled() const
 {
     return _btPhyiscsWorld->getDebugDrawer() != nullptr;
@@ -237,15 +407,82 @@ void Physics3DWorld::stepSimulate(float dt)
         }
         _btPhyiscsWorld->stepSimulation(dt, 3);
         //sync dynamic node after simulation
-        for (auto it : _physicsComponents)
+        if (_workerPool)
         {
-            it->postSimulate();
+            syncPhysicsToNodes();
+        }
+        else
+        {
+            for (auto it : _physicsComponents)
+            {
+                it->postSimulate();
+            }
         }
         if (needCollisionChecking())
             collisionChecking();
     }
 }
 
+void Physics3DWorld::syncPhysicsToNodes()
+{
+    std::unordered_set<Node*> syncedNodes;
+    for (auto it : _physicsComponents)
+    {
+        if (it->needPhysicsToNodeSync())
+            syncedNodes.insert(it->getOwner());
+    }
+    
+    _syncComponents.clear();
+    _syncParentTransforms.clear();
+    _syncNestedComponents.clear();
+    for (auto it : _physicsComponents)
+    {
+        if (!it->needPhysicsToNodeSync())
+            continue;
+        
+        // a node under another synced node needs the new transform of its ancestor, it is synced afterwards
+        auto parent = it->getOwner()->getParent();
+        bool nested = false;
+        for (auto ancestor = parent; ancestor && !nested; ancestor = ancestor->getParent())
+            nested = syncedNodes.find(ancestor) != syncedNodes.end();
+        
+        if (nested)
+        {
+            _syncNestedComponents.push_back(it);
+        }
+        else
+        {
+            _syncComponents.push_back(it);
+            _syncParentTransforms.push_back(parent ? parent->getNodeToWorldTransform() : Mat4::IDENTITY);
+        }
+    }
+    
+    int count = static_cast<int>(_syncComponents.size());
+    _syncPositions.resize(count);
+    _syncRotations.resize(count);
+    _workerPool->parallelFor(count, 64, [this](int begin, int end, int){
+        for (int i = begin; i < end; i++)
+            _syncComponents[i]->computeNodeTransform(_syncParentTransforms[i], &_syncPositions[i], &_syncRotations[i]);
+    });
+    
+    // the node setters aren't thread safe
+    for (int i = 0; i < count; i++)
+        _syncComponents[i]->applyNodeTransform(_syncPositions[i], _syncRotations[i]);
+    
+    // parents before children
+    auto depth = [](Node* node) {
+        int result = 0;
+        for (auto parent = node->getParent(); parent; parent = parent->getParent())
+            result++;
+        return result;
+    };
+    std::stable_sort(_syncNestedComponents.begin(), _syncNestedComponents.end(), [&depth](Physics3DComponent* a, Physics3DComponent* b){
+        return depth(a->getOwner()) < depth(b->getOwner());
+    });
+    for (auto it : _syncNestedComponents)
+        it->syncPhysicsToNode();
+}
+
 void Physics3DWorld::debugDraw(Renderer* renderer)
 {
     if (_debugDrawer)
@@ -291,8 +528,144 @@ bool Physics3DWorld::sweepShape(Physics3DShape* shape, const cocos2d::Mat4& star
     return false;
 }
 
+int Physics3DWorld::rayCastBatch(const RayQuery* rays, int count, Physics3DWorld::HitResult* results)
+{
+    runQueries(count, RAYS_PER_RANGE, [&](int begin, int end, int threadIndex){
+        auto& stack = _queryStacks[threadIndex];
+        for (int i = begin; i < end; i++)
+        {
+            const RayQuery& query = rays[i];
+            auto btStart = convertVec3TobtVector3(query.startPos);
+            auto btEnd = convertVec3TobtVector3(query.endPos);
+            btTransform startTrans, endTrans;
+            startTrans.setIdentity();
+            startTrans.setOrigin(btStart);
+            endTrans.setIdentity();
+            endTrans.setOrigin(btEnd);
+            
+            btCollisionWorld::ClosestRayResultCallback btResult(btStart, btEnd);
+            btResult.m_collisionFilterGroup = query.collisionFilterGroup;
+            btResult.m_collisionFilterMask = query.collisionFilterMask;
+            auto process = [&](const btDbvtNode* leaf) {
+                //stop once a hit at the start of the ray was found
+                if (btResult.m_closestHitFraction == btScalar(0.f))
+                    return false;
+                auto object = static_cast<btCollisionObject*>(static_cast<btBroadphaseProxy*>(leaf->data)->m_clientObject);
+                if (btResult.needsCollision(object->getBroadphaseHandle()))
+                    rayTestShape(startTrans, endTrans, object, object->getCollisionShape(), object->getWorldTransform(), btResult, stack);
+                return true;
+            };
+            
+            QueryRay ray(btStart, btEnd);
+            btVector3 zero(0.f, 0.f, 0.f);
+            rayTestTree(_broadphase->m_sets[0].m_root, btStart, ray, zero, zero, stack, process);
+            rayTestTree(_broadphase->m_sets[1].m_root, btStart, ray, zero, zero, stack, process);
+            
+            HitResult& result = results[i];
+            if (btResult.hasHit())
+            {
+                result.hitObj = getPhysicsObject(btResult.m_collisionObject);
+                result.hitPosition = convertbtVector3ToVec3(btResult.m_hitPointWorld);
+                result.hitNormal = convertbtVector3ToVec3(btResult.m_hitNormalWorld);
+            }
+            else
+            {
+                result.hitObj = nullptr;
+            }
+        }
+    });
+    
+    int hits = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (results[i].hitObj)
+            hits++;
+    }
+    return hits;
+}
+
+int Physics3DWorld::sweepShapeBatch(const SweepQuery* sweeps, int count, Physics3DWorld::HitResult* results)
+{
+    runQueries(count, SWEEPS_PER_RANGE, [&](int begin, int end, int threadIndex){
+        auto& stack = _queryStacks[threadIndex];
+        for (int i = begin; i < end; i++)
+        {
+            const SweepQuery& query = sweeps[i];
+            CC_ASSERT(query.shape->getShapeType() != Physics3DShape::ShapeType::HEIGHT_FIELD && query.shape->getShapeType() != Physics3DShape::ShapeType::MESH);
+            auto castShape = static_cast<btConvexShape*>(query.shape->getbtShape());
+            auto btStart = convertMat4TobtTransform(query.startTransform);
+            auto btEnd = convertMat4TobtTransform(query.endTransform);
+            
+            //the aabb of the shape over its rotation, like btCollisionWorld::convexSweepTest
+            btVector3 castShapeAabbMin, castShapeAabbMax;
+            {
+                btVector3 linVel, angVel;
+                btTransformUtil::calculateVelocity(btStart, btEnd, 1.0f, linVel, angVel);
+                btVector3 zeroLinVel(0.f, 0.f, 0.f);
+                btTransform R;
+                R.setIdentity();
+                R.setRotation(btStart.getRotation());
+                castShape->calculateTemporalAabb(R, zeroLinVel, angVel, 1.0f, castShapeAabbMin, castShapeAabbMax);
+            }
+            
+            btCollisionWorld::ClosestConvexResultCallback btResult(btStart.getOrigin(), btEnd.getOrigin());
+            btResult.m_collisionFilterGroup = query.collisionFilterGroup;
+            btResult.m_collisionFilterMask = query.collisionFilterMask;
+            auto process = [&](const btDbvtNode* leaf) {
+                if (btResult.m_closestHitFraction == btScalar(0.f))
+                    return false;
+                auto object = static_cast<btCollisionObject*>(static_cast<btBroadphaseProxy*>(leaf->data)->m_clientObject);
+                if (btResult.needsCollision(object->getBroadphaseHandle()))
+                    btCollisionWorld::objectQuerySingle(castShape, btStart, btEnd, object, object->getCollisionShape(), object->getWorldTransform(), btResult, 0.f);
+                return true;
+            };
+            
+            QueryRay ray(btStart.getOrigin(), btEnd.getOrigin());
+            rayTestTree(_broadphase->m_sets[0].m_root, btStart.getOrigin(), ray, castShapeAabbMin, castShapeAabbMax, stack, process);
+            rayTestTree(_broadphase->m_sets[1].m_root, btStart.getOrigin(), ray, castShapeAabbMin, castShapeAabbMax, stack, process);
+            
+            HitResult& result = results[i];
+            if (btResult.hasHit())
+            {
+                result.hitObj = getPhysicsObject(btResult.m_hitCollisionObject);
+                result.hitPosition = convertbtVector3ToVec3(btResult.m_hitPointWorld);
+                result.hitNormal = convertbtVector3ToVec3(btResult.m_hitNormalWorld);
+            }
+            else
+            {
+                result.hitObj = nullptr;
+            }
+        }
+    });
+    
+    int hits = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (results[i].hitObj)
+            hits++;
+    }
+    return hits;
+}
+
+void Physics3DWorld::runQueries(int count, int grainSize, const std::function<void(int, int, int)>& func)
+{
+    int threadCount = getNumThreads();
+    if (static_cast<int>(_queryStacks.size()) < threadCount)
+        _queryStacks.resize(threadCount);
+    
+    if (_workerPool)
+        _workerPool->parallelFor(count, grainSize, func);
+    else if (count > 0)
+        func(0, count, 0);
+}
+
 Physics3DObject* Physics3DWorld::getPhysicsObject(const btCollisionObject* btObj)
 {
+    //the bullet objects of Physics3DRigidBody and Physics3DCollider point to them
+    auto physicsObj = static_cast<Physics3DObject*>(btObj->getUserPointer());
+    if (physicsObj)
+        return physicsObj;
+    
     for(auto it : _objects)
     {
         if (it->getObjType() == Physics3DObject::PhysicsObjType::RIGID_BODY)
@@ -29,6 +29,9 @@
 #include "base/CCRef.h"
 #include "base/ccConfig.h"
 
+#include <functional>
+#include <vector>
+
 #if CC_USE_3D_PHYSICS
 
 #if (CC_ENABLE_BULLET_INTEGRATION)
@@ -41,6 +44,7 @@ class btSequentialImpulseConstraintSolver;
 class btGhostPairCallback;
 class btRigidBody;
 class btCollisionObject;
+struct btDbvtNode;
 
 NS_CC_BEGIN
 /**
@@ -53,6 +57,8 @@ class Physics3DConstraint;
 class Physics3DDebugDrawer;
 class Physics3DComponent;
 class Physics3DShape;
+class Physics3DWorkerPool;
+class Node;
 class Renderer;
 
 /**
@@ -62,10 +68,12 @@ struct CC_DLL Physics3DWorldDes
 {
     bool           isDebugDrawEnabled; //using physics debug draw?, false by default
     cocos2d::Vec3  gravity;//gravity, (0, -9.8, 0)
+    int            numThreads; //threads stepping the simulation, counting the main thread, 0 uses all the cores, 1 (single-threaded) by default
     Physics3DWorldDes()
     {
         isDebugDrawEnabled = false;
         gravity = cocos2d::Vec3(0.f, -9.8f, 0.f);
+        numThreads = 1;
     }
 };
 
@@ -84,6 +92,35 @@ public:
         Physics3DObject* hitObj;
     };
     
+    /**
+     * A ray of rayCastBatch().
+     * It only hits the objects whose group is in collisionFilterMask and whose mask contains collisionFilterGroup,
+     * the defaults hit everything like rayCast().
+     */
+    struct RayQuery
+    {
+        cocos2d::Vec3 startPos;
+        cocos2d::Vec3 endPos;
+        short collisionFilterGroup;
+        short collisionFilterMask;
+        
+        RayQuery();
+        RayQuery(const cocos2d::Vec3& start, const cocos2d::Vec3& end, short filterGroup = 1, short filterMask = -1);
+    };
+    
+    /** A swept shape of sweepShapeBatch(), filtered like RayQuery. The shape can't be a height field or a mesh. */
+    struct SweepQuery
+    {
+        Physics3DShape* shape;
+        cocos2d::Mat4 startTransform;
+        cocos2d::Mat4 endTransform;
+        short collisionFilterGroup;
+        short collisionFilterMask;
+        
+        SweepQuery();
+        SweepQuery(Physics3DShape* sweptShape, const cocos2d::Mat4& start, const cocos2d::Mat4& end, short filterGroup = 1, short filterMask = -1);
+    };
+    
     /**
      * Creates a Physics3DWorld with Physics3DWorldDes. 
      *
@@ -115,9 +152,16 @@ public:
     /** Remove all Physics3DConstraint. */
     void removeAllPhysics3DConstraints();
     
-    /** Simulate one frame. */
+    /**
+     * Simulate one frame.
+     * With more than one thread, the narrow phase of the collision detection and the simulation islands
+     * run on a worker pool and the node transforms are computed in parallel, then set on the main thread.
+     */
     void stepSimulate(float dt);
     
+    /** Get the number of threads stepping the simulation, 1 when it is single-threaded. */
+    int getNumThreads() const;
+    
     /** Enable or disable debug drawing. */
     void setDebugDrawEnable(bool enableDebugDraw);
     
@@ -141,6 +185,20 @@ public:
     /** Performs a swept shape cast on all objects in the Physics3DWorld. */
     bool sweepShape(Physics3DShape* shape, const cocos2d::Mat4& startTransform, const cocos2d::Mat4& endTransform, HitResult* result);
     
+    /**
+     * Casts count rays, the closest hit of rays[i] is written to results[i], its hitObj is nullptr when the ray hits nothing.
+     * The rays are cast in parallel on the threads of the world, see Physics3DWorldDes::numThreads,
+     * and no memory is allocated once the traversal stacks, shared by the broadphase and the compound shapes, have grown.
+     * @return The number of rays which hit an object.
+     */
+    int rayCastBatch(const RayQuery* rays, int count, HitResult* results);
+    
+    /**
+     * Performs count swept shape casts like rayCastBatch(), the closest hit of sweeps[i] is written to results[i].
+     * The compound shapes hit by a sweep are tested by Bullet, which allocates its own traversal stack for them.
+     */
+    int sweepShapeBatch(const SweepQuery* sweeps, int count, HitResult* results);
+    
 CC_CONSTRUCTOR_ACCESS:
     
     Physics3DWorld();
@@ -153,6 +211,8 @@ CC_CONSTRUCTOR_ACCESS:
     void collisionChecking();
     bool needCollisionChecking();
     void setGhostPairCallback();
+    void syncPhysicsToNodes();
+    void runQueries(int count, int grainSize, const std::function<void(int, int, int)>& func);
     
 protected:
     std::vector<Physics3DObject*>      _objects;
@@ -169,6 +229,17 @@ protected:
     btSequentialImpulseConstraintSolver* _solver;
     btGhostPairCallback *_ghostCallback;
     Physics3DDebugDrawer*                _debugDrawer;
+    Physics3DWorkerPool*                 _workerPool;
+    
+    // node transforms computed on the worker pool after a parallel step
+    std::vector<Physics3DComponent*>     _syncComponents;
+    std::vector<Mat4>                    _syncParentTransforms;
+    std::vector<Vec3>                    _syncPositions;
+    std::vector<Quaternion>              _syncRotations;
+    std::vector<Physics3DComponent*>     _syncNestedComponents;
+    
+    // broadphase traversal stack of each thread running batched queries
+    std::vector<std::vector<const btDbvtNode*>> _queryStacks;
 #endif // CC_ENABLE_BULLET_INTEGRATION
 };
 
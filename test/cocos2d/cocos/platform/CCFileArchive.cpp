@@ -0,0 +1,376 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCFileArchive.h"
+
+#include <algorithm>
+#include <string.h>
+#include <zlib.h>
+
+#include "base/ccMacros.h"
+#include "platform/CCFileUtils.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+#include "platform/android/CCFileUtils-android.h"
+#include <android/asset_manager.h>
+#endif
+
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT)
+#define CC_FILEARCHIVE_USE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char ARCHIVE_MAGIC[4] = { 'C', 'C', 'P', 'K' };
+    const uint32_t ARCHIVE_VERSION = 1;
+
+    struct ArchiveHeader
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t alignment;
+        uint64_t indexOffset;
+        uint64_t namesOffset;
+    };
+
+    static_assert(sizeof(ArchiveHeader) == 32, "archive header must be 32 bytes");
+}
+
+FileArchive* FileArchive::create(const std::string& fullPath)
+{
+    auto ret = new (std::nothrow) FileArchive();
+    if (ret && ret->initWithFile(fullPath))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+uint64_t FileArchive::hashName(const char* name, size_t length)
+{
+    // 64 bits FNV-1a, must match tools/archive-packer/pack-archive.py
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+FileArchive::FileArchive()
+: _fileSize(0)
+, _mappedBase(nullptr)
+, _mapHandle(nullptr)
+, _fp(nullptr)
+{
+}
+
+FileArchive::~FileArchive()
+{
+    close();
+}
+
+bool FileArchive::initWithFile(const std::string& fullPath)
+{
+    CCASSERT(!fullPath.empty(), "Invalid archive path");
+    _path = fullPath;
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    if (fullPath[0] != '/')
+    {
+        // Files inside the APK. If the archive is stored uncompressed (aapt -0 cpk)
+        // the asset manager hands out a mapping of the APK.
+        std::string relativePath = fullPath;
+        if (relativePath.find("assets/") == 0)
+        {
+            relativePath = relativePath.substr(strlen("assets/"));
+        }
+
+        AAssetManager* assetManager = FileUtilsAndroid::getAssetManager();
+        AAsset* asset = assetManager ? AAssetManager_open(assetManager, relativePath.c_str(), AASSET_MODE_BUFFER) : nullptr;
+        if (asset)
+        {
+            _mappedBase = static_cast<const unsigned char*>(AAsset_getBuffer(asset));
+            if (_mappedBase)
+            {
+                _mapHandle = asset;
+                _fileSize = AAsset_getLength(asset);
+            }
+            else
+            {
+                AAsset_close(asset);
+            }
+        }
+    }
+#endif
+
+#if CC_FILEARCHIVE_USE_MMAP
+    if (!_mappedBase && fullPath[0] == '/')
+    {
+        int fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (base != MAP_FAILED)
+                {
+                    _mappedBase = static_cast<const unsigned char*>(base);
+                    _fileSize = st.st_size;
+                }
+            }
+            // the mapping stays valid after the descriptor is closed
+            ::close(fd);
+        }
+    }
+#endif
+
+    if (!_mappedBase)
+    {
+        _fp = fopen(FileUtils::getInstance()->getSuitableFOpen(fullPath).c_str(), "rb");
+        if (_fp)
+        {
+            fseek(_fp, 0, SEEK_END);
+            _fileSize = ftell(_fp);
+            fseek(_fp, 0, SEEK_SET);
+        }
+        else
+        {
+            // Last resort, e.g. a compressed APK asset: keep the whole archive in memory.
+            _buffer = FileUtils::getInstance()->getDataFromFile(fullPath);
+            if (_buffer.isNull())
+            {
+                CCLOG("FileArchive: can't open %s", fullPath.c_str());
+                return false;
+            }
+            _mappedBase = _buffer.getBytes();
+            _fileSize = _buffer.getSize();
+        }
+    }
+
+    if (!readIndex())
+    {
+        CCLOG("FileArchive: %s is not a valid archive", fullPath.c_str());
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool FileArchive::readIndex()
+{
+    ArchiveHeader header;
+    if (_fileSize < sizeof(header) || !readRange(0, &header, sizeof(header)))
+        return false;
+
+    if (memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION)
+        return false;
+
+    const uint64_t indexSize = static_cast<uint64_t>(header.entryCount) * sizeof(Entry);
+    if (header.indexOffset + indexSize > _fileSize || header.namesOffset > _fileSize)
+        return false;
+
+    _entries.resize(header.entryCount);
+    if (header.entryCount > 0 && !readRange(header.indexOffset, _entries.data(), indexSize))
+        return false;
+
+    uint64_t namesSize = 0;
+    for (const auto& entry : _entries)
+    {
+        if (entry.offset + entry.compressedSize > _fileSize)
+            return false;
+        namesSize = std::max(namesSize, static_cast<uint64_t>(entry.nameOffset) + entry.nameLength);
+    }
+
+    if (header.namesOffset + namesSize > _fileSize)
+        return false;
+
+    _names.resize(namesSize);
+    if (namesSize > 0 && !readRange(header.namesOffset, &_names[0], namesSize))
+        return false;
+
+    return true;
+}
+
+void FileArchive::close()
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    if (_mapHandle)
+    {
+        AAsset_close(static_cast<AAsset*>(_mapHandle));
+        _mapHandle = nullptr;
+        _mappedBase = nullptr;
+    }
+#endif
+
+#if CC_FILEARCHIVE_USE_MMAP
+    if (_mappedBase && _buffer.isNull())
+    {
+        munmap(const_cast<unsigned char*>(_mappedBase), _fileSize);
+    }
+#endif
+    _mappedBase = nullptr;
+    _buffer.clear();
+
+    if (_fp)
+    {
+        fclose(_fp);
+        _fp = nullptr;
+    }
+
+    _entries.clear();
+    _names.clear();
+    _fileSize = 0;
+}
+
+bool FileArchive::readRange(uint64_t offset, void* buffer, size_t size) const
+{
+    if (offset + size > _fileSize)
+        return false;
+
+    if (_mappedBase)
+    {
+        memcpy(buffer, _mappedBase + offset, size);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(_fileMutex);
+    if (fseek(_fp, static_cast<long>(offset), SEEK_SET) != 0)
+        return false;
+
+    return fread(buffer, 1, size, _fp) == size;
+}
+
+const FileArchive::Entry* FileArchive::findEntry(const std::string& entryName) const
+{
+    const uint64_t hash = hashName(entryName.c_str(), entryName.length());
+
+    auto iter = std::lower_bound(_entries.begin(), _entries.end(), hash, [](const Entry& entry, uint64_t value) {
+        return entry.hash < value;
+    });
+
+    // several names may share a hash, compare the names to find the right one
+    for (; iter != _entries.end() && iter->hash == hash; ++iter)
+    {
+        if (iter->nameLength == entryName.length()
+            && _names.compare(iter->nameOffset, iter->nameLength, entryName) == 0)
+        {
+            return &(*iter);
+        }
+    }
+    return nullptr;
+}
+
+bool FileArchive::containsEntry(const std::string& entryName) const
+{
+    return findEntry(entryName) != nullptr;
+}
+
+ssize_t FileArchive::getEntrySize(const std::string& entryName) const
+{
+    const Entry* entry = findEntry(entryName);
+    return entry ? static_cast<ssize_t>(entry->size) : -1;
+}
+
+Data FileArchive::getData(const std::string& entryName, bool forString) const
+{
+    Data ret;
+    const Entry* entry = findEntry(entryName);
+    if (!entry)
+        return ret;
+
+    const size_t size = entry->size;
+    unsigned char* buffer = static_cast<unsigned char*>(malloc(forString ? size + 1 : size));
+    if (!buffer)
+        return ret;
+
+    bool succeeded = false;
+    if (static_cast<Compression>(entry->compression) == Compression::NONE)
+    {
+        succeeded = readRange(entry->offset, buffer, size);
+    }
+    else if (static_cast<Compression>(entry->compression) == Compression::ZLIB)
+    {
+        const unsigned char* source = nullptr;
+        unsigned char* compressed = nullptr;
+        if (_mappedBase)
+        {
+            source = _mappedBase + entry->offset;
+        }
+        else
+        {
+            compressed = static_cast<unsigned char*>(malloc(entry->compressedSize));
+            if (compressed && readRange(entry->offset, compressed, entry->compressedSize))
+                source = compressed;
+        }
+
+        if (source)
+        {
+            uLongf destLength = static_cast<uLongf>(size);
+            int err = uncompress(buffer, &destLength, source, entry->compressedSize);
+            succeeded = (err == Z_OK && destLength == size);
+        }
+        free(compressed);
+    }
+
+    if (!succeeded)
+    {
+        CCLOG("FileArchive: failed to read %s from %s", entryName.c_str(), _path.c_str());
+        free(buffer);
+        return ret;
+    }
+
+    if (forString)
+        buffer[size] = '\0';
+
+    ret.fastSet(buffer, size);
+    return ret;
+}
+
+bool FileArchive::getMappedData(const std::string& entryName, const unsigned char** bytes, ssize_t* size) const
+{
+    CCASSERT(bytes != nullptr && size != nullptr, "Invalid parameters.");
+
+    const Entry* entry = findEntry(entryName);
+    if (!entry || !_mappedBase || static_cast<Compression>(entry->compression) != Compression::NONE)
+        return false;
+
+    *bytes = _mappedBase + entry->offset;
+    *size = static_cast<ssize_t>(entry->size);
+    return true;
+}
+
+NS_CC_END
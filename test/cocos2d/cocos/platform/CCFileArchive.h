@@ -0,0 +1,166 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FILEARCHIVE_H__
+#define __CC_FILEARCHIVE_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/CCRef.h"
+#include "base/CCData.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * @brief A read-only packed resource archive (".cpk").
+ *
+ * The archive stores many small resource files in one file so that they can be read
+ * without opening each of them individually. Its layout is:
+ *
+ *  - a 32 bytes header ("CCPK", version, entry count, data alignment, offsets),
+ *  - an index of fixed size records sorted by the 64 bits FNV-1a hash of the entry name,
+ *  - a blob with the entry names,
+ *  - the entry data. Stored (uncompressed) entries start at a multiple of the alignment.
+ *
+ * Lookups are a binary search on the hash. When the platform allows it the whole archive
+ * is memory mapped, so stored entries can be accessed in place with getMappedData().
+ * Deflated entries are inflated with zlib on every read.
+ *
+ * Archives are built offline with `tools/archive-packer/pack-archive.py` and mounted with
+ * FileUtils::addArchive().
+ *
+ * @note All numbers are little-endian.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL FileArchive : public Ref
+{
+public:
+    /** How the data of an entry is stored. */
+    enum class Compression : uint8_t
+    {
+        NONE = 0,
+        ZLIB = 1,
+    };
+
+    /**
+     * Opens an archive.
+     *
+     * @param fullPath The full path of the archive, as returned by FileUtils::fullPathForFilename().
+     * @return An autoreleased FileArchive, or nullptr if the archive can't be opened or is invalid.
+     */
+    static FileArchive* create(const std::string& fullPath);
+
+    /** Hashes an entry name the same way the packer does. */
+    static uint64_t hashName(const char* name, size_t length);
+
+    /** Returns the full path the archive was opened with. */
+    const std::string& getPath() const { return _path; }
+
+    /** Returns the number of entries in the archive. */
+    ssize_t getEntryCount() const { return static_cast<ssize_t>(_entries.size()); }
+
+    /** Returns true if the archive contains an entry with this name. */
+    bool containsEntry(const std::string& entryName) const;
+
+    /** Returns the uncompressed size of an entry, or -1 if the entry doesn't exist. */
+    ssize_t getEntrySize(const std::string& entryName) const;
+
+    /**
+     * Reads an entry.
+     *
+     * @param entryName The name of the entry, relative to the archive root.
+     * @param forString If true, a '\0' is appended after the data (not counted in the size).
+     * @return The (uncompressed) data of the entry, or Data::Null if it can't be read.
+     */
+    Data getData(const std::string& entryName, bool forString = false) const;
+
+    /**
+     * Gets the data of a stored entry without copying it.
+     *
+     * It only succeeds if the archive is memory mapped and the entry is not compressed.
+     * The returned pointer is aligned to the archive alignment and stays valid as long as the archive is alive.
+     */
+    bool getMappedData(const std::string& entryName, const unsigned char** bytes, ssize_t* size) const;
+
+CC_CONSTRUCTOR_ACCESS:
+    FileArchive();
+    virtual ~FileArchive();
+
+    bool initWithFile(const std::string& fullPath);
+
+protected:
+    struct Entry
+    {
+        uint64_t hash;
+        uint64_t offset;
+        uint32_t size;
+        uint32_t compressedSize;
+        uint32_t nameOffset;
+        uint16_t nameLength;
+        uint8_t  compression;
+        uint8_t  reserved;
+    };
+
+    const Entry* findEntry(const std::string& entryName) const;
+    bool readRange(uint64_t offset, void* buffer, size_t size) const;
+    bool readIndex();
+    void close();
+
+    std::string _path;
+    std::vector<Entry> _entries;
+    std::string _names;
+    uint64_t _fileSize;
+
+    /** Base address of the archive when it is memory mapped (or owned by the Android asset manager). */
+    const unsigned char* _mappedBase;
+    /** Opaque handle of the mapping (AAsset* on Android). */
+    void* _mapHandle;
+
+    /** Holds the whole archive when it can neither be mapped nor opened with fopen (e.g. compressed APK assets). */
+    Data _buffer;
+
+    /** Fallback when the archive can't be mapped. Reads are serialized. */
+    FILE* _fp;
+    mutable std::mutex _fileMutex;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(FileArchive);
+};
+
+// end of platform group
+/** @} */
+
+NS_CC_END
+
+#endif // __CC_FILEARCHIVE_H__
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
 #include "platform/CCSAXParser.h"
+#include "platform/CCFileArchive.h"
 #include "base/ccUtils.h"
 
 #include "tinyxml2.h"
@@ -560,6 +561,7 @@ FileUtils::FileUtils()
 
 FileUtils::~FileUtils()
 {
+    removeAllArchives();
 }
 
 bool FileUtils::writeStringToFile(std::string dataStr, const std::string& fullPath)
@@ -630,6 +632,11 @@ static Data getData(const std::string& filename, bool forString)
     {
         // Read the file from hardware
         std::string fullPath = fileutils->fullPathForFilename(filename);
+        if (fileutils->getDataFromArchive(fullPath, &ret, forString))
+        {
+            return ret;
+        }
+
         FILE *fp = fopen(fileutils->getSuitableFOpen(fullPath).c_str(), mode);
         CC_BREAK_IF(!fp);
         fseek(fp,0,SEEK_END);
@@ -797,6 +804,154 @@ std::string FileUtils::getPathForFilename(const std::string& filename, const std
     return path;
 }
 
+std::string FileUtils::getArchivePathForFilename(const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath) const
+{
+    if (_archives.empty())
+    {
+        return "";
+    }
+
+    // Archives mirror the default resource root, search paths outside of it can't be archived
+    if (searchPath.compare(0, _defaultResRootPath.length(), _defaultResRootPath) != 0)
+    {
+        return "";
+    }
+
+    std::string file = filename;
+    std::string file_path = "";
+    size_t pos = filename.find_last_of("/");
+    if (pos != std::string::npos)
+    {
+        file_path = filename.substr(0, pos+1);
+        file = filename.substr(pos+1);
+    }
+
+    // searchPath(relative to the root) + file_path + resourceDirectory + file
+    std::string entryName = searchPath.substr(_defaultResRootPath.length());
+    entryName += file_path;
+    entryName += resolutionDirectory;
+    entryName += file;
+
+    for (const auto& archive : _archives)
+    {
+        if (archive->containsEntry(entryName))
+        {
+            return archive->getPath() + "/" + entryName;
+        }
+    }
+    return "";
+}
+
+FileArchive* FileUtils::getArchiveForFullPath(const std::string& fullPath, std::string* entryName) const
+{
+    for (const auto& archive : _archives)
+    {
+        const std::string& archivePath = archive->getPath();
+        const size_t length = archivePath.length();
+        if (fullPath.length() > length + 1 && fullPath[length] == '/' && fullPath.compare(0, length, archivePath) == 0)
+        {
+            std::string name = fullPath.substr(length + 1);
+            if (archive->containsEntry(name))
+            {
+                if (entryName)
+                {
+                    *entryName = name;
+                }
+                return archive;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool FileUtils::getDataFromArchive(const std::string& fullPath, Data* data, bool forString) const
+{
+    CCASSERT(data != nullptr, "Invalid parameters.");
+
+    if (_archives.empty())
+    {
+        return false;
+    }
+
+    std::string entryName;
+    FileArchive* archive = getArchiveForFullPath(fullPath, &entryName);
+    if (archive == nullptr)
+    {
+        return false;
+    }
+
+    *data = archive->getData(entryName, forString);
+    return true;
+}
+
+bool FileUtils::addArchive(const std::string& archivePath, const bool front)
+{
+    const std::string fullPath = fullPathForFilename(archivePath);
+    if (fullPath.empty())
+    {
+        CCLOG("cocos2d: addArchive: archive %s not found", archivePath.c_str());
+        return false;
+    }
+
+    for (const auto& archive : _archives)
+    {
+        if (archive->getPath() == fullPath)
+        {
+            return true;
+        }
+    }
+
+    FileArchive* archive = FileArchive::create(fullPath);
+    if (archive == nullptr)
+    {
+        return false;
+    }
+
+    archive->retain();
+    if (front)
+    {
+        _archives.insert(_archives.begin(), archive);
+    }
+    else
+    {
+        _archives.push_back(archive);
+    }
+
+    // Cached paths may be shadowed by the archive now
+    _fullPathCache.clear();
+    return true;
+}
+
+void FileUtils::removeArchive(const std::string& archivePath)
+{
+    const std::string fullPath = isAbsolutePath(archivePath) ? archivePath : fullPathForFilename(archivePath);
+
+    for (auto iter = _archives.begin(); iter != _archives.end(); ++iter)
+    {
+        if ((*iter)->getPath() == fullPath)
+        {
+            (*iter)->release();
+            _archives.erase(iter);
+            _fullPathCache.clear();
+            break;
+        }
+    }
+}
+
+void FileUtils::removeAllArchives()
+{
+    for (auto& archive : _archives)
+    {
+        archive->release();
+    }
+
+    if (!_archives.empty())
+    {
+        _archives.clear();
+        _fullPathCache.clear();
+    }
+}
+
 std::string FileUtils::fullPathForFilename(const std::string &filename) const
 {
     if (filename.empty())
@@ -825,7 +980,12 @@ std::string FileUtils::fullPathForFilename(const std::string &filename) const
     {
         for (const auto& resolutionIt : _searchResolutionsOrderArray)
         {
-            fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            // Mounted archives shadow the file system
+            fullpath = this->getArchivePathForFilename(newFilename, resolutionIt, searchIt);
+            if (fullpath.empty())
+            {
+                fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            }
 
             if (!fullpath.empty())
             {
@@ -1008,6 +1168,10 @@ bool FileUtils::isFileExist(const std::string& filename) const
 {
     if (isAbsolutePath(filename))
     {
+        if (getArchiveForFullPath(filename, nullptr))
+        {
+            return true;
+        }
         return isFileExistInternal(filename);
     }
     else
@@ -1255,6 +1419,13 @@ long FileUtils::getFileSize(const std::string &filepath)
             return 0;
     }
 
+    std::string entryName;
+    FileArchive* archive = getArchiveForFullPath(fullpath, &entryName);
+    if (archive)
+    {
+        return (long)archive->getEntrySize(entryName);
+    }
+
     struct stat info;
     // Get data associated with "crt_stat.c":
     int result = stat(fullpath.c_str(), &info);
@@ -36,6 +36,8 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+class FileArchive;
+
 /**
  * @addtogroup platform
  * @{
@@ -292,6 +294,54 @@ public:
      */
     virtual const std::vector<std::string>& getSearchPaths() const;
 
+    /**
+     *  Mounts a packed archive (see FileArchive).
+     *
+     *  The archive acts as an overlay of the default resource root path: for every search path below the
+     *  resource root and every resolution directory, fullPathForFilename() looks into the mounted archives
+     *  before the file system. A file found in an archive gets the full path "<archive full path>/<entry name>",
+     *  which is understood by getDataFromFile(), getStringFromFile(), isFileExist() and getFileSize().
+     *
+     *  @param archivePath The archive file, it can be a relative path.
+     *  @param front If true, the archive is searched before the archives mounted previously.
+     *  @return true if the archive was opened and mounted.
+     *  @since v3.10
+     */
+    virtual bool addArchive(const std::string& archivePath, const bool front = false);
+
+    /**
+     *  Unmounts an archive mounted with addArchive().
+     *  @since v3.10
+     */
+    virtual void removeArchive(const std::string& archivePath);
+
+    /**
+     *  Unmounts all the archives.
+     *  @since v3.10
+     */
+    virtual void removeAllArchives();
+
+    /**
+     *  Reads a file from a mounted archive.
+     *
+     *  @param fullPath A full path returned by fullPathForFilename().
+     *  @param[out] data The content of the file, with a trailing '\0' if forString is true.
+     *  @param forString Whether the data is going to be used as a string.
+     *  @return false if the full path doesn't point inside a mounted archive.
+     *  @since v3.10
+     */
+    bool getDataFromArchive(const std::string& fullPath, Data* data, bool forString = false) const;
+
+    /**
+     *  Finds the mounted archive a full path points into.
+     *
+     *  @param fullPath A full path returned by fullPathForFilename().
+     *  @param[out] entryName The name of the entry inside the archive, may be nullptr.
+     *  @return The archive, or nullptr if the path is not inside a mounted archive.
+     *  @since v3.10
+     */
+    FileArchive* getArchiveForFullPath(const std::string& fullPath, std::string* entryName) const;
+
     /**
      *  Gets the writable path.
      *  @return  The path that can be write/read a file in
@@ -538,6 +588,13 @@ protected:
      */
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& directory, const std::string& filename) const;
 
+    /**
+     *  Gets full path for filename, resolution directory and search path inside the mounted archives.
+     *
+     *  @return The full path of the archived file, or an empty string if none of the archives contains it.
+     */
+    virtual std::string getArchivePathForFilename(const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath) const;
+
     /** Dictionary used to lookup filenames based on a key.
      *  It is used internally by the following methods:
      *
@@ -574,6 +631,12 @@ protected:
      */
     mutable std::unordered_map<std::string, std::string> _fullPathCache;
 
+    /**
+     *  The mounted archives, retained.
+     *  The lower index of the element in this vector, the higher priority for this archive.
+     */
+    std::vector<FileArchive*> _archives;
+
     /**
      * Writable path.
      */
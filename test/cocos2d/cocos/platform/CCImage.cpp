@@ -85,6 +85,7 @@ extern "C"
 #include "base/CCConfiguration.h"
 #include "base/ccUtils.h"
 #include "base/ZipUtils.h"
+#include "renderer/CCPixelConverter.h"
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include "android/CCFileUtils-android.h"
 #endif
@@ -2453,12 +2454,7 @@ void Image::premultipliedAlpha()
 {
     CCASSERT(_renderFormat == Texture2D::PixelFormat::RGBA8888, "The pixel format should be RGBA8888!");
     
-    unsigned int* fourBytes = (unsigned int*)_data;
-    for(int i = 0; i < _width * _height; i++)
-    {
-        unsigned char* p = _data + i * 4;
-        fourBytes[i] = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
-    }
+    PixelConverter::premultiplyAlpha(_data, static_cast<ssize_t>(_width) * _height * 4);
     
     _hasPremultipliedAlpha = true;
 }
@@ -0,0 +1,618 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCImageStreamDecoder.h"
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <setjmp.h>
+
+#include "base/ccConfig.h" // CC_USE_JPEG, CC_USE_PNG
+#include "base/ccMacros.h"
+#include "platform/CCFileUtils.h"
+#include "renderer/CCPixelConverter.h"
+
+extern "C"
+{
+#if CC_USE_PNG
+#include "png.h"
+#endif //CC_USE_PNG
+
+#if CC_USE_JPEG
+#include "jpeglib.h"
+#endif // CC_USE_JPEG
+}
+
+NS_CC_BEGIN
+
+#if CC_USE_PNG
+struct ImageStreamDecoder::PngContext
+{
+    png_structp png;
+    png_infop info;
+    bool interlaced;
+
+    static void infoCallback(png_structp png_ptr, png_infop info_ptr)
+    {
+        auto decoder = static_cast<ImageStreamDecoder*>(png_get_progressive_ptr(png_ptr));
+
+        png_byte bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+        png_uint_32 color_type = png_get_color_type(png_ptr, info_ptr);
+
+        // same transformations as Image::initWithPngData()
+        if (color_type == PNG_COLOR_TYPE_PALETTE)
+        {
+            png_set_palette_to_rgb(png_ptr);
+        }
+        if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+        {
+            bit_depth = 8;
+            png_set_expand_gray_1_2_4_to_8(png_ptr);
+        }
+        if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+        {
+            png_set_tRNS_to_alpha(png_ptr);
+        }
+        if (bit_depth == 16)
+        {
+            png_set_strip_16(png_ptr);
+        }
+        if (bit_depth < 8)
+        {
+            png_set_packing(png_ptr);
+        }
+
+        decoder->_png->interlaced = (png_set_interlace_handling(png_ptr) > 1);
+
+        png_read_update_info(png_ptr, info_ptr);
+        color_type = png_get_color_type(png_ptr, info_ptr);
+
+        Info& imageInfo = decoder->_info;
+        imageInfo.width = png_get_image_width(png_ptr, info_ptr);
+        imageInfo.height = png_get_image_height(png_ptr, info_ptr);
+        imageInfo.rowBytes = png_get_rowbytes(png_ptr, info_ptr);
+
+        switch (color_type)
+        {
+        case PNG_COLOR_TYPE_GRAY:
+            imageInfo.renderFormat = Texture2D::PixelFormat::I8;
+            break;
+        case PNG_COLOR_TYPE_GRAY_ALPHA:
+            imageInfo.renderFormat = Texture2D::PixelFormat::AI88;
+            break;
+        case PNG_COLOR_TYPE_RGB:
+            imageInfo.renderFormat = Texture2D::PixelFormat::RGB888;
+            break;
+        case PNG_COLOR_TYPE_RGB_ALPHA:
+            imageInfo.renderFormat = Texture2D::PixelFormat::RGBA8888;
+            break;
+        default:
+            png_error(png_ptr, "unsupported color type");
+            break;
+        }
+
+        if (!decoder->beginRows())
+        {
+            png_error(png_ptr, "can't allocate the image");
+        }
+    }
+
+    static void rowCallback(png_structp png_ptr, png_bytep new_row, png_uint_32 row_num, int pass)
+    {
+        CC_UNUSED_PARAM(pass);
+        auto decoder = static_cast<ImageStreamDecoder*>(png_get_progressive_ptr(png_ptr));
+
+        // rows that are not part of this interlace pass come without data
+        if (new_row == nullptr || (int)row_num >= decoder->_info.height)
+            return;
+
+        unsigned char* row = decoder->_data + row_num * decoder->_info.rowBytes;
+        if (decoder->_png->interlaced)
+        {
+            png_progressive_combine_row(png_ptr, row, new_row);
+        }
+        else
+        {
+            memcpy(row, new_row, decoder->_info.rowBytes);
+            decoder->premultiplyRow(row_num);
+            decoder->_completedRows = row_num + 1;
+        }
+    }
+
+    static void endCallback(png_structp png_ptr, png_infop info_ptr)
+    {
+        CC_UNUSED_PARAM(info_ptr);
+        auto decoder = static_cast<ImageStreamDecoder*>(png_get_progressive_ptr(png_ptr));
+
+        if (decoder->_png->interlaced)
+        {
+            // the rows are only final after the last pass
+            for (int row = 0; row < decoder->_info.height; ++row)
+            {
+                decoder->premultiplyRow(row);
+            }
+        }
+        decoder->_completedRows = decoder->_info.height;
+    }
+};
+#endif // CC_USE_PNG
+
+#if CC_USE_JPEG
+namespace
+{
+    struct JpegErrorMgr
+    {
+        struct jpeg_error_mgr pub;
+        jmp_buf setjmp_buffer;
+    };
+
+    METHODDEF(void)
+    jpegErrorExit(j_common_ptr cinfo)
+    {
+        JpegErrorMgr* err = (JpegErrorMgr*)cinfo->err;
+
+        char buffer[JMSG_LENGTH_MAX];
+        (*cinfo->err->format_message) (cinfo, buffer);
+        CCLOG("jpeg error: %s", buffer);
+
+        longjmp(err->setjmp_buffer, 1);
+    }
+}
+
+struct ImageStreamDecoder::JpegContext
+{
+    struct jpeg_decompress_struct cinfo;
+    JpegErrorMgr err;
+    struct jpeg_source_mgr source;
+
+    /** Data not consumed yet. After a suspension libjpeg restarts from the beginning of the current unit. */
+    std::vector<unsigned char> buffer;
+    /** Bytes skipped by libjpeg that haven't arrived yet. */
+    size_t pendingSkip;
+    bool endOfData;
+    bool started;
+
+    static void initSource(j_decompress_ptr cinfo)
+    {
+        CC_UNUSED_PARAM(cinfo);
+    }
+
+    static boolean fillInputBuffer(j_decompress_ptr cinfo)
+    {
+        auto context = static_cast<JpegContext*>(cinfo->client_data);
+        if (!context->endOfData)
+        {
+            // suspend until more data is appended
+            return FALSE;
+        }
+
+        // truncated file, terminate it like jdatasrc.c does
+        static const JOCTET fakeEOI[2] = { (JOCTET)0xFF, (JOCTET)JPEG_EOI };
+        cinfo->src->next_input_byte = fakeEOI;
+        cinfo->src->bytes_in_buffer = 2;
+        return TRUE;
+    }
+
+    static void skipInputData(j_decompress_ptr cinfo, long numBytes)
+    {
+        if (numBytes <= 0)
+            return;
+
+        auto context = static_cast<JpegContext*>(cinfo->client_data);
+        struct jpeg_source_mgr* source = cinfo->src;
+        if ((size_t)numBytes <= source->bytes_in_buffer)
+        {
+            source->next_input_byte += numBytes;
+            source->bytes_in_buffer -= numBytes;
+        }
+        else
+        {
+            context->pendingSkip += numBytes - source->bytes_in_buffer;
+            source->next_input_byte += source->bytes_in_buffer;
+            source->bytes_in_buffer = 0;
+        }
+    }
+
+    static void termSource(j_decompress_ptr cinfo)
+    {
+        CC_UNUSED_PARAM(cinfo);
+    }
+};
+#endif // CC_USE_JPEG
+
+ImageStreamDecoder* ImageStreamDecoder::create(Image::Format format)
+{
+    auto ret = new (std::nothrow) ImageStreamDecoder();
+    if (ret && ret->initWithFormat(format))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+ImageStreamDecoder::ImageStreamDecoder()
+: _format(Image::Format::UNKNOWN)
+, _state(State::HEADER)
+, _data(nullptr)
+, _ownsData(false)
+, _premultiply(false)
+, _completedRows(0)
+, _reportedRows(0)
+, _png(nullptr)
+, _jpeg(nullptr)
+{
+    memset(&_info, 0, sizeof(_info));
+}
+
+ImageStreamDecoder::~ImageStreamDecoder()
+{
+    destroyContexts();
+
+    if (_ownsData)
+    {
+        CC_SAFE_FREE(_data);
+    }
+}
+
+bool ImageStreamDecoder::initWithFormat(Image::Format format)
+{
+    _format = format;
+
+    switch (format)
+    {
+#if CC_USE_PNG
+    case Image::Format::PNG:
+        _png = new (std::nothrow) PngContext();
+        if (!_png)
+            return false;
+
+        _png->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+        _png->info = _png->png ? png_create_info_struct(_png->png) : nullptr;
+        _png->interlaced = false;
+        if (!_png->info)
+        {
+            destroyContexts();
+            return false;
+        }
+        png_set_progressive_read_fn(_png->png, this, PngContext::infoCallback, PngContext::rowCallback, PngContext::endCallback);
+        return true;
+#endif // CC_USE_PNG
+
+#if CC_USE_JPEG
+    case Image::Format::JPG:
+        _jpeg = new (std::nothrow) JpegContext();
+        if (!_jpeg)
+            return false;
+
+        _jpeg->pendingSkip = 0;
+        _jpeg->endOfData = false;
+        _jpeg->started = false;
+
+        _jpeg->cinfo.err = jpeg_std_error(&_jpeg->err.pub);
+        _jpeg->err.pub.error_exit = jpegErrorExit;
+        if (setjmp(_jpeg->err.setjmp_buffer))
+        {
+            delete _jpeg;
+            _jpeg = nullptr;
+            return false;
+        }
+        jpeg_create_decompress(&_jpeg->cinfo);
+        _jpeg->cinfo.client_data = _jpeg;
+
+        _jpeg->source.init_source = JpegContext::initSource;
+        _jpeg->source.fill_input_buffer = JpegContext::fillInputBuffer;
+        _jpeg->source.skip_input_data = JpegContext::skipInputData;
+        _jpeg->source.resync_to_restart = jpeg_resync_to_restart;
+        _jpeg->source.term_source = JpegContext::termSource;
+        _jpeg->source.next_input_byte = nullptr;
+        _jpeg->source.bytes_in_buffer = 0;
+        _jpeg->cinfo.src = &_jpeg->source;
+        return true;
+#endif // CC_USE_JPEG
+
+    default:
+        CCLOG("cocos2d: ImageStreamDecoder: only PNG and JPEG are supported");
+        return false;
+    }
+}
+
+void ImageStreamDecoder::destroyContexts()
+{
+#if CC_USE_PNG
+    if (_png)
+    {
+        if (_png->png)
+        {
+            png_destroy_read_struct(&_png->png, _png->info ? &_png->info : nullptr, nullptr);
+        }
+        delete _png;
+        _png = nullptr;
+    }
+#endif // CC_USE_PNG
+
+#if CC_USE_JPEG
+    if (_jpeg)
+    {
+        jpeg_destroy_decompress(&_jpeg->cinfo);
+        delete _jpeg;
+        _jpeg = nullptr;
+    }
+#endif // CC_USE_JPEG
+}
+
+bool ImageStreamDecoder::appendData(const unsigned char* data, ssize_t dataLen)
+{
+    if (_state == State::FAILED)
+        return false;
+
+    if (_state == State::DONE || data == nullptr || dataLen <= 0)
+        return true;
+
+    bool ret = false;
+    if (_png)
+    {
+        ret = appendPngData(data, dataLen);
+    }
+    else if (_jpeg)
+    {
+        ret = appendJpegData(data, dataLen, false);
+    }
+
+    if (!ret)
+    {
+        _state = State::FAILED;
+        destroyContexts();
+        return false;
+    }
+
+    finishRows(_completedRows);
+    return true;
+}
+
+bool ImageStreamDecoder::finish()
+{
+    if (_state == State::ROWS || _state == State::HEADER)
+    {
+        if (_jpeg && !appendJpegData(nullptr, 0, true))
+        {
+            _state = State::FAILED;
+        }
+        else
+        {
+            finishRows(_completedRows);
+        }
+
+        if (_state != State::DONE)
+        {
+            CCLOG("cocos2d: ImageStreamDecoder: the image data is truncated");
+            _state = State::FAILED;
+        }
+        destroyContexts();
+    }
+
+    return _state == State::DONE;
+}
+
+bool ImageStreamDecoder::decodeFile(const std::string& fullPath, ssize_t chunkSize)
+{
+    CCASSERT(chunkSize > 0, "Invalid chunk size");
+
+    FILE* fp = fopen(FileUtils::getInstance()->getSuitableFOpen(fullPath).c_str(), "rb");
+    if (!fp)
+    {
+        // not a regular file (APK asset, archived file...), decode it in one go
+        Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+        return !data.isNull() && appendData(data.getBytes(), data.getSize()) && finish();
+    }
+
+    std::vector<unsigned char> chunk(chunkSize);
+    bool ret = true;
+    while (ret && _state != State::DONE)
+    {
+        size_t readSize = fread(chunk.data(), 1, chunk.size(), fp);
+        if (readSize == 0)
+            break;
+
+        ret = appendData(chunk.data(), readSize);
+    }
+    fclose(fp);
+
+    return ret && finish();
+}
+
+bool ImageStreamDecoder::appendPngData(const unsigned char* data, ssize_t dataLen)
+{
+#if CC_USE_PNG
+    if (setjmp(png_jmpbuf(_png->png)))
+    {
+        return false;
+    }
+
+    png_process_data(_png->png, _png->info, const_cast<png_bytep>(data), dataLen);
+
+    if (_completedRows == _info.height && _state == State::ROWS)
+    {
+        _state = State::DONE;
+    }
+    return true;
+#else
+    return false;
+#endif // CC_USE_PNG
+}
+
+bool ImageStreamDecoder::appendJpegData(const unsigned char* data, ssize_t dataLen, bool endOfData)
+{
+#if CC_USE_JPEG
+    JpegContext* context = _jpeg;
+
+    if (!context->endOfData)
+    {
+        // drop what was consumed and keep the rest, libjpeg may read it again
+        std::vector<unsigned char>& buffer = context->buffer;
+        buffer.erase(buffer.begin(), buffer.end() - context->source.bytes_in_buffer);
+
+        if (context->pendingSkip > 0)
+        {
+            size_t skip = std::min(context->pendingSkip, (size_t)dataLen);
+            context->pendingSkip -= skip;
+            data += skip;
+            dataLen -= skip;
+        }
+        if (dataLen > 0)
+        {
+            buffer.insert(buffer.end(), data, data + dataLen);
+        }
+
+        context->source.next_input_byte = buffer.empty() ? nullptr : buffer.data();
+        context->source.bytes_in_buffer = buffer.size();
+        context->endOfData = endOfData;
+    }
+
+    struct jpeg_decompress_struct* cinfo = &context->cinfo;
+    if (setjmp(context->err.setjmp_buffer))
+    {
+        return false;
+    }
+
+    if (_state == State::HEADER)
+    {
+        if (!context->started)
+        {
+            if (jpeg_read_header(cinfo, TRUE) == JPEG_SUSPENDED)
+                return true;
+
+            // we only support RGB or grayscale, like Image::initWithJpgData()
+            if (cinfo->jpeg_color_space == JCS_GRAYSCALE)
+            {
+                _info.renderFormat = Texture2D::PixelFormat::I8;
+            }
+            else
+            {
+                cinfo->out_color_space = JCS_RGB;
+                _info.renderFormat = Texture2D::PixelFormat::RGB888;
+            }
+            context->started = true;
+        }
+
+        // progressive files are buffered by libjpeg, this keeps suspending until they are complete
+        if (!jpeg_start_decompress(cinfo))
+            return true;
+
+        _info.width = cinfo->output_width;
+        _info.height = cinfo->output_height;
+        _info.rowBytes = cinfo->output_width * cinfo->output_components;
+        if (!beginRows())
+            return false;
+    }
+
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        JSAMPROW row = _data + cinfo->output_scanline * _info.rowBytes;
+        if (jpeg_read_scanlines(cinfo, &row, 1) == 0)
+            break;
+    }
+    _completedRows = cinfo->output_scanline;
+
+    if (_completedRows == _info.height)
+    {
+        // jpeg_finish_decompress() is skipped like in Image::initWithJpgData(), the trailing data is not needed
+        _state = State::DONE;
+    }
+    return true;
+#else
+    return false;
+#endif // CC_USE_JPEG
+}
+
+bool ImageStreamDecoder::beginRows()
+{
+    _premultiply = (_info.renderFormat == Texture2D::PixelFormat::RGBA8888);
+    _info.hasPremultipliedAlpha = _premultiply;
+
+    unsigned char* buffer = _headerCallback ? _headerCallback(_info) : nullptr;
+    if (buffer)
+    {
+        _data = buffer;
+        _ownsData = false;
+    }
+    else
+    {
+        _data = static_cast<unsigned char*>(malloc(_info.rowBytes * _info.height));
+        _ownsData = true;
+        if (!_data)
+            return false;
+    }
+
+    _state = State::ROWS;
+    return true;
+}
+
+void ImageStreamDecoder::finishRows(int completedRows)
+{
+    if (completedRows > _reportedRows)
+    {
+        int firstRow = _reportedRows;
+        _reportedRows = completedRows;
+        if (_rowsCallback)
+        {
+            _rowsCallback(firstRow, completedRows - firstRow);
+        }
+    }
+}
+
+void ImageStreamDecoder::premultiplyRow(int row)
+{
+    if (!_premultiply)
+        return;
+
+    PixelConverter::premultiplyAlpha(_data + row * _info.rowBytes, _info.width * 4);
+}
+
+Image* ImageStreamDecoder::createImage()
+{
+    if (_state != State::DONE || !_ownsData)
+        return nullptr;
+
+    Image* image = new (std::nothrow) Image();
+    if (!image)
+        return nullptr;
+
+    image->_data = _data;
+    image->_dataLen = _info.rowBytes * _info.height;
+    image->_width = _info.width;
+    image->_height = _info.height;
+    image->_fileType = _format;
+    image->_renderFormat = _info.renderFormat;
+    image->_hasPremultipliedAlpha = _info.hasPremultipliedAlpha;
+    image->autorelease();
+
+    _data = nullptr;
+    _ownsData = false;
+    return image;
+}
+
+NS_CC_END
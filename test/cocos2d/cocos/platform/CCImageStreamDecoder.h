@@ -0,0 +1,192 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_IMAGE_STREAM_DECODER_H__
+#define __CC_IMAGE_STREAM_DECODER_H__
+
+#include <functional>
+#include <string>
+
+#include "platform/CCImage.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * @brief Decodes a PNG or a JPEG image incrementally.
+ *
+ * Image::initWithImageData() needs the whole file in memory and decodes it in one go into a buffer owned
+ * by the Image. ImageStreamDecoder accepts the encoded file in chunks, as they are read from disk or received
+ * from the network, and decodes every complete row as soon as its data is available, so reading and
+ * decoding overlap. The rows can be written straight into a buffer provided by the caller (for instance a
+ * mapped pixel buffer), which avoids copying the decoded image.
+ *
+ * The output is the same as Image's: 8 bits per component, I8, AI88, RGB888 or RGBA8888,
+ * RGBA8888 having its alpha premultiplied.
+ *
+ * @code
+ * auto decoder = ImageStreamDecoder::create(Image::Format::PNG);
+ * decoder->setRowsCallback([](int firstRow, int numberOfRows) { ... });
+ * while (...)
+ *     decoder->appendData(chunk, chunkLength);
+ * decoder->finish();
+ * Image* image = decoder->createImage();
+ * @endcode
+ *
+ * @note Interlaced PNG images are reported as a single band when their last pass is done.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL ImageStreamDecoder : public Ref
+{
+public:
+    enum class State
+    {
+        /** Waiting for the header. */
+        HEADER,
+        /** The header is parsed, rows are being decoded. */
+        ROWS,
+        /** All the rows are decoded. */
+        DONE,
+        /** The data is invalid or truncated. */
+        FAILED
+    };
+
+    /** What is known about the image once the header is parsed. */
+    struct Info
+    {
+        int width;
+        int height;
+        Texture2D::PixelFormat renderFormat;
+        ssize_t rowBytes;
+        bool hasPremultipliedAlpha;
+    };
+
+    /**
+     * Called once the header is parsed.
+     * Return a buffer of at least info.rowBytes * info.height bytes to decode into, rows are tightly packed;
+     * or return nullptr and the decoder allocates the buffer itself.
+     */
+    typedef std::function<unsigned char*(const Info& info)> HeaderCallback;
+
+    /** Called when rows [firstRow, firstRow + numberOfRows) are decoded. */
+    typedef std::function<void(int firstRow, int numberOfRows)> RowsCallback;
+
+    /**
+     * Creates a decoder.
+     * @param format Image::Format::PNG or Image::Format::JPG.
+     * @return An autoreleased decoder, or nullptr if the format is not supported on this platform.
+     */
+    static ImageStreamDecoder* create(Image::Format format);
+
+    void setHeaderCallback(const HeaderCallback& callback) { _headerCallback = callback; }
+    void setRowsCallback(const RowsCallback& callback) { _rowsCallback = callback; }
+
+    /**
+     * Feeds the next chunk of the encoded file and decodes as many rows as possible.
+     * @return false if the data is invalid.
+     */
+    bool appendData(const unsigned char* data, ssize_t dataLen);
+
+    /**
+     * Tells the decoder that there is no more data.
+     * @return true if the whole image was decoded.
+     */
+    bool finish();
+
+    /**
+     * Decodes a file by reading it in chunks.
+     * @param fullPath The full path of the file.
+     * @param chunkSize The number of bytes read at once.
+     * @return true if the whole image was decoded.
+     */
+    bool decodeFile(const std::string& fullPath, ssize_t chunkSize = 64 * 1024);
+
+    State getState() const { return _state; }
+    bool isDone() const { return _state == State::DONE; }
+
+    /** Only valid once the state is ROWS or DONE. */
+    const Info& getInfo() const { return _info; }
+
+    /** The number of rows that are complete, they are always the first rows of the image. */
+    int getDecodedRows() const { return _reportedRows; }
+
+    /** The decoded pixels, either the caller's buffer or the decoder's one. */
+    unsigned char* getData() const { return _data; }
+
+    /**
+     * Creates an Image from the decoded pixels. The Image takes the pixel buffer over.
+     * Only possible once the image is done and if the buffer was allocated by the decoder.
+     * @return An autoreleased Image or nullptr.
+     */
+    Image* createImage();
+
+CC_CONSTRUCTOR_ACCESS:
+    ImageStreamDecoder();
+    virtual ~ImageStreamDecoder();
+
+    bool initWithFormat(Image::Format format);
+
+protected:
+    struct PngContext;
+    struct JpegContext;
+
+    bool appendPngData(const unsigned char* data, ssize_t dataLen);
+    bool appendJpegData(const unsigned char* data, ssize_t dataLen, bool endOfData);
+    bool beginRows();
+    void finishRows(int completedRows);
+    void premultiplyRow(int row);
+    void destroyContexts();
+
+    Image::Format _format;
+    State _state;
+    Info _info;
+
+    unsigned char* _data;
+    bool _ownsData;
+    bool _premultiply;
+
+    int _completedRows;
+    int _reportedRows;
+
+    HeaderCallback _headerCallback;
+    RowsCallback _rowsCallback;
+
+    PngContext* _png;
+    JpegContext* _jpeg;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(ImageStreamDecoder);
+};
+
+// end of platform group
+/** @} */
+
+NS_CC_END
+
+#endif // __CC_IMAGE_STREAM_DECODER_H__
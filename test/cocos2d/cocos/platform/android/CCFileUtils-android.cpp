@@ -266,6 +266,12 @@ Data FileUtilsAndroid::getData(const std::string& filename, bool forString)
     string fullPath = fullPathForFilename(filename);
     cocosplay::updateAssets(fullPath);
 
+    Data archived;
+    if (getDataFromArchive(fullPath, &archived, forString))
+    {
+        return archived;
+    }
+
     if (fullPath[0] != '/')
     {
         string relativePath = string();
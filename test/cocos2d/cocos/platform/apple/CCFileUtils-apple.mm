@@ -444,20 +444,13 @@ std::string FileUtilsApple::getFullPathForDirectoryAndFilename(const std::string
 ValueMap FileUtilsApple::getValueMapFromFile(const std::string& filename)
 {
     std::string fullPath = fullPathForFilename(filename);
-    NSString* path = [NSString stringWithUTF8String:fullPath.c_str()];
-    NSDictionary* dict = [NSDictionary dictionaryWithContentsOfFile:path];
-
-    ValueMap ret;
-
-    if (dict != nil)
+    // read through getDataFromFile(), the plists can be entries of the mounted archives
+    Data data = getDataFromFile(fullPath);
+    if (data.isNull())
     {
-        for (id key in [dict allKeys])
-        {
-            id value = [dict objectForKey:key];
-            addValueToDict(key, value, ret);
-        }
+        return ValueMap();
     }
-    return ret;
+    return getValueMapFromData(reinterpret_cast<const char*>(data.getBytes()), static_cast<int>(data.getSize()));
 }
 
 ValueMap FileUtilsApple::getValueMapFromData(const char* filedata, int filesize)
@@ -525,11 +518,24 @@ ValueVector FileUtilsApple::getValueVectorFromFile(const std::string& filename)
     //    pPath = [[NSBundle mainBundle] pathForResource:pPath ofType:pathExtension];
     //    fixing cannot read data using Array::createWithContentsOfFile
     std::string fullPath = fullPathForFilename(filename);
-    NSString* path = [NSString stringWithUTF8String:fullPath.c_str()];
-    NSArray* array = [NSArray arrayWithContentsOfFile:path];
+    Data data = getDataFromFile(fullPath);
 
     ValueVector ret;
 
+    if (data.isNull())
+    {
+        return ret;
+    }
+
+    NSData* file = [NSData dataWithBytes:data.getBytes() length:data.getSize()];
+    NSPropertyListFormat format;
+    NSError* error;
+    id array = [NSPropertyListSerialization propertyListWithData:file options:NSPropertyListImmutable format:&format error:&error];
+    if (![array isKindOfClass:[NSArray class]])
+    {
+        return ret;
+    }
+
     for (id value in array)
     {
         addItemToArray(value, ret);
@@ -28,6 +28,7 @@ THE SOFTWARE.
 
 #include "CCFileUtils-win32.h"
 #include "platform/CCCommon.h"
+#include "platform/CCFileArchive.h"
 #include <Shlobj.h>
 #include <cstdlib>
 #include <regex>
@@ -194,6 +195,13 @@ std::string FileUtilsWin32::getSuitableFOpen(const std::string& filenameUtf8) co
 
 long FileUtilsWin32::getFileSize(const std::string &filepath)
 {
+    std::string entryName;
+    FileArchive* archive = getArchiveForFullPath(filepath, &entryName);
+    if (archive)
+    {
+        return (long)archive->getEntrySize(entryName);
+    }
+
     WIN32_FILE_ATTRIBUTE_DATA fad;
     if (!GetFileAttributesEx(StringUtf8ToWideChar(filepath).c_str(), GetFileExInfoStandard, &fad))
     {
@@ -294,6 +302,12 @@ static Data getData(const std::string& filename, bool forString)
         // read the file from hardware
         std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+        Data archived;
+        if (FileUtils::getInstance()->getDataFromArchive(fullPath, &archived, forString))
+        {
+            return archived;
+        }
+
         // check if the filename uses correct case characters
         checkFileName(fullPath, filename);
 
@@ -161,6 +161,8 @@ public:
     static const char* SHADER_NAME_POSITION_TEXTURE_COLOR;
     /**Built in shader for 2d. Support Position, Texture and Color vertex attribute, but without multiply vertex by MVP matrix.*/
     static const char* SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP;
+    /**Built in shader used by the renderer to batch quads with several textures, the texture unit is read from a_texCoord1.*/
+    static const char* SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP_MULTI_TEXTURE;
     /**Built in shader for 2d. Support Position, Texture vertex attribute, but include alpha test.*/
     static const char* SHADER_NAME_POSITION_TEXTURE_ALPHA_TEST;
     /**Built in shader for 2d. Support Position, Texture and Color vertex attribute, include alpha test and without multiply vertex by MVP matrix.*/
@@ -191,6 +193,7 @@ public:
     static const char* SHADER_NAME_LABEL_OUTLINE;
     static const char* SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL;
     static const char* SHADER_NAME_LABEL_DISTANCEFIELD_GLOW;
+    static const char* SHADER_NAME_LABEL_MULTICHANNEL_DISTANCEFIELD_NORMAL;
 
     /**Built in shader used for 3D, support Position vertex attribute, with color specified by a uniform.*/
     static const char* SHADER_3D_POSITION;
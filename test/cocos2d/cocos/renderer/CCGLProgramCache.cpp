@@ -40,6 +40,7 @@ NS_CC_BEGIN
 enum {
     kShaderType_PositionTextureColor,
     kShaderType_PositionTextureColor_noMVP,
+    kShaderType_PositionTextureColorMultiTexture_noMVP,
     kShaderType_PositionTextureColorAlphaTest,
     kShaderType_PositionTextureColorAlphaTestNoMV,
     kShaderType_PositionColor,
@@ -52,6 +53,7 @@ enum {
     kShaderType_PositionLengthTexureColor,
     kShaderType_LabelDistanceFieldNormal,
     kShaderType_LabelDistanceFieldGlow,
+    kShaderType_LabelMultiChannelDistanceFieldNormal,
     kShaderType_UIGrayScale,
     kShaderType_LabelNormal,
     kShaderType_LabelOutline,
@@ -142,6 +144,11 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_PositionTextureColor_noMVP);
     _programs.insert( std::make_pair( GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP, p ) );
 
+    // Position Texture Color without MVP shader, sampling up to 4 textures
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_PositionTextureColorMultiTexture_noMVP);
+    _programs.insert( std::make_pair( GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP_MULTI_TEXTURE, p ) );
+
     // Position Texture Color alpha test
     p = new (std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_PositionTextureColorAlphaTest);
@@ -213,6 +220,10 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_LabelDistanceFieldGlow);
     _programs.insert( std::make_pair(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_GLOW, p) );
 
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_LabelMultiChannelDistanceFieldNormal);
+    _programs.insert( std::make_pair(GLProgram::SHADER_NAME_LABEL_MULTICHANNEL_DISTANCEFIELD_NORMAL, p) );
+
     p = new (std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_UIGrayScale);
     _programs.insert(std::make_pair(GLProgram::SHADER_NAME_POSITION_GRAYSCALE, p));
@@ -292,6 +303,11 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_PositionTextureColor_noMVP);
 
+    // Position Texture Color without MVP shader, sampling up to 4 textures
+    p = getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP_MULTI_TEXTURE);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_PositionTextureColorMultiTexture_noMVP);
+
     // Position Texture Color alpha test
     p = getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_ALPHA_TEST);
     p->reset();
@@ -362,6 +378,10 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_LabelDistanceFieldGlow);
 
+    p = getGLProgram(GLProgram::SHADER_NAME_LABEL_MULTICHANNEL_DISTANCEFIELD_NORMAL);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_LabelMultiChannelDistanceFieldNormal);
+
     p = getGLProgram(GLProgram::SHADER_NAME_LABEL_NORMAL);
     p->reset();
     loadDefaultGLProgram(p, kShaderType_LabelNormal);
@@ -455,6 +475,9 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_PositionTextureColor_noMVP:
             p->initWithByteArrays(ccPositionTextureColor_noMVP_vert, ccPositionTextureColor_noMVP_frag);
             break;
+        case kShaderType_PositionTextureColorMultiTexture_noMVP:
+            p->initWithByteArrays(ccPositionTextureColorMultiTexture_noMVP_vert, ccPositionTextureColorMultiTexture_noMVP_frag);
+            break;
         case kShaderType_PositionTextureColorAlphaTest:
             p->initWithByteArrays(ccPositionTextureColor_vert, ccPositionTextureColorAlphaTest_frag);
             break;
@@ -492,6 +515,9 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_LabelDistanceFieldGlow:
             p->initWithByteArrays(ccLabel_vert, ccLabelDistanceFieldGlow_frag);
             break;
+        case kShaderType_LabelMultiChannelDistanceFieldNormal:
+            p->initWithByteArrays(ccLabel_vert, ccLabelMultiChannelDistanceFieldNormal_frag);
+            break;
         case kShaderType_UIGrayScale:
             p->initWithByteArrays(ccPositionTextureColor_noMVP_vert,
                                   ccPositionTexture_GrayScale_frag);
@@ -0,0 +1,214 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "renderer/CCPixelConverter.h"
+#include "platform/CCImage.h"
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+#include <cpu-features.h>
+#endif
+
+//#define INCLUDE_NEON  : neon code included
+//#define CHECK_NEON    : neon code is only used if the cpu supports it (armv7 on android)
+//#define INCLUDE_SSE2  : sse2 code included
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+    #if defined (__arm64__) || defined (__ARM_NEON__)
+    #define INCLUDE_NEON
+    #endif
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    #if defined (__arm64__) || defined (__aarch64__)
+    #define INCLUDE_NEON
+    #elif defined (__ARM_NEON__)
+    #define INCLUDE_NEON
+    #define CHECK_NEON
+    #endif
+#endif
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INCLUDE_SSE2
+#endif
+
+#ifdef INCLUDE_NEON
+#include <arm_neon.h>
+#include "renderer/CCPixelConverterNeon.inl"
+#endif
+
+#ifdef INCLUDE_SSE2
+#include <emmintrin.h>
+#include "renderer/CCPixelConverterSSE.inl"
+#endif
+
+NS_CC_BEGIN
+
+#if defined (INCLUDE_NEON)
+    #define SIMD_KERNEL(func) PixelConverterNeon::func
+#elif defined (INCLUDE_SSE2)
+    #define SIMD_KERNEL(func) PixelConverterSSE::func
+#endif
+
+static bool s_SIMDEnabled = true;
+
+static bool isSIMDSupported()
+{
+#if defined (CHECK_NEON)
+    static const bool supported = android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM
+        && (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0;
+    return supported;
+#elif defined (SIMD_KERNEL)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PixelConverter::isSIMDEnabled()
+{
+    return s_SIMDEnabled && isSIMDSupported();
+}
+
+void PixelConverter::setSIMDEnabled(bool enabled)
+{
+    s_SIMDEnabled = enabled;
+}
+
+void PixelConverter::premultiplyAlpha(unsigned char* data, ssize_t dataLen)
+{
+    const ssize_t pixels = dataLen / 4;
+    ssize_t i = 0;
+#if defined (SIMD_KERNEL)
+    if (isSIMDEnabled())
+        i = SIMD_KERNEL(premultiplyAlpha)(data, pixels);
+#endif
+
+    unsigned int* fourBytes = (unsigned int*)data;
+    for (; i < pixels; ++i)
+    {
+        unsigned char* p = data + i * 4;
+        fourBytes[i] = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
+    }
+}
+
+// RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA
+void PixelConverter::convertRGB888ToRGBA8888(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
+{
+    const ssize_t pixels = dataLen / 3;
+    ssize_t i = 0;
+#if defined (INCLUDE_NEON)
+    // SSE2 has no cheap 3 to 4 bytes shuffle, the C loop is as fast there
+    if (isSIMDEnabled())
+        i = PixelConverterNeon::convertRGB888ToRGBA8888(data, pixels, outData);
+#endif
+
+    for (; i < pixels; ++i)
+    {
+        outData[i * 4]     = data[i * 3];       //R
+        outData[i * 4 + 1] = data[i * 3 + 1];   //G
+        outData[i * 4 + 2] = data[i * 3 + 2];   //B
+        outData[i * 4 + 3] = 0xFF;              //A
+    }
+}
+
+// RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBB
+void PixelConverter::convertRGBA8888ToRGB888(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
+{
+    const ssize_t pixels = dataLen / 4;
+    ssize_t i = 0;
+#if defined (INCLUDE_NEON)
+    if (isSIMDEnabled())
+        i = PixelConverterNeon::convertRGBA8888ToRGB888(data, pixels, outData);
+#endif
+
+    for (; i < pixels; ++i)
+    {
+        outData[i * 3]     = data[i * 4];       //R
+        outData[i * 3 + 1] = data[i * 4 + 1];   //G
+        outData[i * 3 + 2] = data[i * 4 + 2];   //B
+    }
+}
+
+// RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGGBBBBB
+void PixelConverter::convertRGBA8888ToRGB565(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
+{
+    const ssize_t pixels = dataLen / 4;
+    ssize_t i = 0;
+#if defined (SIMD_KERNEL)
+    if (isSIMDEnabled())
+        i = SIMD_KERNEL(convertRGBA8888ToRGB565)(data, pixels, outData);
+#endif
+
+    unsigned short* out16 = (unsigned short*)outData;
+    for (; i < pixels; ++i)
+    {
+        const unsigned char* p = data + i * 4;
+        out16[i] = (p[0] & 0x00F8) << 8     //R
+            | (p[1] & 0x00FC) << 3          //G
+            | (p[2] & 0x00F8) >> 3;         //B
+    }
+}
+
+// RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRGGGGBBBBAAAA
+void PixelConverter::convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
+{
+    const ssize_t pixels = dataLen / 4;
+    ssize_t i = 0;
+#if defined (SIMD_KERNEL)
+    if (isSIMDEnabled())
+        i = SIMD_KERNEL(convertRGBA8888ToRGBA4444)(data, pixels, outData);
+#endif
+
+    unsigned short* out16 = (unsigned short*)outData;
+    for (; i < pixels; ++i)
+    {
+        const unsigned char* p = data + i * 4;
+        out16[i] = (p[0] & 0x00F0) << 8     //R
+            | (p[1] & 0x00F0) << 4          //G
+            | (p[2] & 0xF0)                 //B
+            | (p[3] & 0xF0) >> 4;           //A
+    }
+}
+
+// RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGBBBBBA
+void PixelConverter::convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t dataLen, unsigned char* outData)
+{
+    const ssize_t pixels = dataLen / 4;
+    ssize_t i = 0;
+#if defined (SIMD_KERNEL)
+    if (isSIMDEnabled())
+        i = SIMD_KERNEL(convertRGBA8888ToRGB5A1)(data, pixels, outData);
+#endif
+
+    unsigned short* out16 = (unsigned short*)outData;
+    for (; i < pixels; ++i)
+    {
+        const unsigned char* p = data + i * 4;
+        out16[i] = (p[0] & 0x00F8) << 8     //R
+            | (p[1] & 0x00F8) << 3          //G
+            | (p[2] & 0x00F8) >> 2          //B
+            | (p[3] & 0x0080) >> 7;         //A
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,65 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PIXEL_CONVERTER_H__
+#define __CC_PIXEL_CONVERTER_H__
+/// @cond DO_NOT_SHOW
+
+#include "platform/CCPlatformMacros.h"
+#include "platform/CCStdC.h"
+
+NS_CC_BEGIN
+
+/**
+ * Pixel format conversion kernels used when images are turned into textures.
+ *
+ * The hottest conversions have SSE2 and NEON versions. Like MathUtil, the SIMD code is chosen when
+ * the engine is compiled: SSE2 on x86, NEON on arm64 and iOS, and on armv7 Android NEON is used
+ * only if the CPU reports it at runtime. The results are bit exact with the C versions.
+ *
+ * `dataLen` is always the size of the source buffer in bytes.
+ */
+class CC_DLL PixelConverter
+{
+public:
+    /** Premultiplies RGBA8888 pixels in place, the same way as CC_RGB_PREMULTIPLY_ALPHA. */
+    static void premultiplyAlpha(unsigned char* data, ssize_t dataLen);
+
+    static void convertRGB888ToRGBA8888(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+    static void convertRGBA8888ToRGB888(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+    static void convertRGBA8888ToRGB565(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+    static void convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+    static void convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t dataLen, unsigned char* outData);
+
+    /** Returns true if the SIMD kernels are compiled in, supported by the CPU and not disabled. */
+    static bool isSIMDEnabled();
+
+    /** Forces the C kernels when false, e.g. to compare both versions. Enabled by default. */
+    static void setSIMDEnabled(bool enabled);
+};
+
+NS_CC_END
+
+/// @endcond
+#endif // __CC_PIXEL_CONVERTER_H__
@@ -0,0 +1,138 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+NS_CC_BEGIN
+
+// NEON kernels, 8 pixels at a time. They return how many pixels they converted,
+// PixelConverter finishes the remaining ones with the C kernels.
+class PixelConverterNeon
+{
+public:
+    inline static ssize_t premultiplyAlpha(unsigned char* data, ssize_t pixels);
+    inline static ssize_t convertRGB888ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGB888(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+};
+
+inline ssize_t PixelConverterNeon::premultiplyAlpha(unsigned char* data, ssize_t pixels)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(data + i * 4);
+        // c * (a + 1) >> 8
+        rgba.val[0] = vshrn_n_u16(vaddw_u8(vmull_u8(rgba.val[0], rgba.val[3]), rgba.val[0]), 8);
+        rgba.val[1] = vshrn_n_u16(vaddw_u8(vmull_u8(rgba.val[1], rgba.val[3]), rgba.val[1]), 8);
+        rgba.val[2] = vshrn_n_u16(vaddw_u8(vmull_u8(rgba.val[2], rgba.val[3]), rgba.val[2]), 8);
+        vst4_u8(data + i * 4, rgba);
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterNeon::convertRGB888ToRGBA8888(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x3_t rgb = vld3_u8(data + i * 3);
+        uint8x8x4_t rgba;
+        rgba.val[0] = rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = rgb.val[2];
+        rgba.val[3] = vdup_n_u8(0xFF);
+        vst4_u8(outData + i * 4, rgba);
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterNeon::convertRGBA8888ToRGB888(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(data + i * 4);
+        uint8x8x3_t rgb;
+        rgb.val[0] = rgba.val[0];
+        rgb.val[1] = rgba.val[1];
+        rgb.val[2] = rgba.val[2];
+        vst3_u8(outData + i * 3, rgb);
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterNeon::convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const uint8x8_t maskF8 = vdup_n_u8(0xF8);
+    const uint8x8_t maskFC = vdup_n_u8(0xFC);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(data + i * 4);
+        uint16x8_t r = vshll_n_u8(vand_u8(rgba.val[0], maskF8), 8);
+        uint16x8_t g = vshll_n_u8(vand_u8(rgba.val[1], maskFC), 3);
+        uint16x8_t b = vmovl_u8(vshr_n_u8(rgba.val[2], 3));
+        vst1q_u16((uint16_t*)(outData + i * 2), vorrq_u16(vorrq_u16(r, g), b));
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterNeon::convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const uint8x8_t maskF0 = vdup_n_u8(0xF0);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(data + i * 4);
+        uint16x8_t r = vshll_n_u8(vand_u8(rgba.val[0], maskF0), 8);
+        uint16x8_t g = vshll_n_u8(vand_u8(rgba.val[1], maskF0), 4);
+        uint16x8_t b = vmovl_u8(vand_u8(rgba.val[2], maskF0));
+        uint16x8_t a = vmovl_u8(vshr_n_u8(rgba.val[3], 4));
+        vst1q_u16((uint16_t*)(outData + i * 2), vorrq_u16(vorrq_u16(r, g), vorrq_u16(b, a)));
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterNeon::convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const uint8x8_t maskF8 = vdup_n_u8(0xF8);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(data + i * 4);
+        uint16x8_t r = vshll_n_u8(vand_u8(rgba.val[0], maskF8), 8);
+        uint16x8_t g = vshll_n_u8(vand_u8(rgba.val[1], maskF8), 3);
+        uint16x8_t b = vmovl_u8(vshr_n_u8(vand_u8(rgba.val[2], maskF8), 2));
+        uint16x8_t a = vmovl_u8(vshr_n_u8(rgba.val[3], 7));
+        vst1q_u16((uint16_t*)(outData + i * 2), vorrq_u16(vorrq_u16(r, g), vorrq_u16(b, a)));
+    }
+    return i;
+}
+
+NS_CC_END
@@ -0,0 +1,150 @@
+/****************************************************************************
+Copyright (c) 2015 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+NS_CC_BEGIN
+
+// SSE2 kernels. They process whole blocks of pixels and return how many pixels they converted,
+// PixelConverter finishes the remaining ones with the C kernels.
+class PixelConverterSSE
+{
+public:
+    inline static ssize_t premultiplyAlpha(unsigned char* data, ssize_t pixels);
+    inline static ssize_t convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+    inline static ssize_t convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData);
+
+private:
+    // packs the low 16 bits of the 32 bits lanes of a and b
+    inline static __m128i packLow16(__m128i a, __m128i b);
+};
+
+inline __m128i PixelConverterSSE::packLow16(__m128i a, __m128i b)
+{
+    // sign extend first so that the signed saturation of packs keeps the bits unchanged
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+inline ssize_t PixelConverterSSE::premultiplyAlpha(unsigned char* data, ssize_t pixels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+    ssize_t i = 0;
+    for (; i + 4 <= pixels; i += 4)
+    {
+        __m128i* p = (__m128i*)(data + i * 4);
+        __m128i rgba = _mm_loadu_si128(p);
+
+        // 2 pixels per register as 16 bits components, times (alpha + 1)
+        __m128i lo = _mm_unpacklo_epi8(rgba, zero);
+        __m128i hi = _mm_unpackhi_epi8(rgba, zero);
+        __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        lo = _mm_srli_epi16(_mm_mullo_epi16(lo, _mm_add_epi16(alphaLo, one)), 8);
+        hi = _mm_srli_epi16(_mm_mullo_epi16(hi, _mm_add_epi16(alphaHi, one)), 8);
+
+        // keep the original alpha
+        __m128i result = _mm_packus_epi16(lo, hi);
+        result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, rgba));
+        _mm_storeu_si128(p, result);
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterSSE::convertRGBA8888ToRGB565(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const __m128i maskR = _mm_set1_epi32(0xF8);
+    const __m128i maskG = _mm_set1_epi32(0xFC00);
+    const __m128i maskB = _mm_set1_epi32(0x1F);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i out[2];
+        for (int j = 0; j < 2; ++j)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(data + (i + j * 4) * 4));
+            __m128i r = _mm_slli_epi32(_mm_and_si128(p, maskR), 8);
+            __m128i g = _mm_srli_epi32(_mm_and_si128(p, maskG), 5);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(p, 19), maskB);
+            out[j] = _mm_or_si128(_mm_or_si128(r, g), b);
+        }
+        _mm_storeu_si128((__m128i*)(outData + i * 2), packLow16(out[0], out[1]));
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterSSE::convertRGBA8888ToRGBA4444(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const __m128i maskR = _mm_set1_epi32(0xF0);
+    const __m128i maskG = _mm_set1_epi32(0xF000);
+    const __m128i maskB = _mm_set1_epi32(0xF0);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i out[2];
+        for (int j = 0; j < 2; ++j)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(data + (i + j * 4) * 4));
+            __m128i r = _mm_slli_epi32(_mm_and_si128(p, maskR), 8);
+            __m128i g = _mm_srli_epi32(_mm_and_si128(p, maskG), 4);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), maskB);
+            __m128i a = _mm_srli_epi32(p, 28);
+            out[j] = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+        }
+        _mm_storeu_si128((__m128i*)(outData + i * 2), packLow16(out[0], out[1]));
+    }
+    return i;
+}
+
+inline ssize_t PixelConverterSSE::convertRGBA8888ToRGB5A1(const unsigned char* data, ssize_t pixels, unsigned char* outData)
+{
+    const __m128i maskR = _mm_set1_epi32(0xF8);
+    const __m128i maskG = _mm_set1_epi32(0xF800);
+    const __m128i maskB = _mm_set1_epi32(0x3E);
+
+    ssize_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        __m128i out[2];
+        for (int j = 0; j < 2; ++j)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(data + (i + j * 4) * 4));
+            __m128i r = _mm_slli_epi32(_mm_and_si128(p, maskR), 8);
+            __m128i g = _mm_srli_epi32(_mm_and_si128(p, maskG), 5);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(p, 18), maskB);
+            __m128i a = _mm_srli_epi32(p, 31);
+            out[j] = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+        }
+        _mm_storeu_si128((__m128i*)(outData + i * 2), packLow16(out[0], out[1]));
+    }
+    return i;
+}
+
+NS_CC_END
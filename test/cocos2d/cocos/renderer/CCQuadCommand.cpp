@@ -27,6 +27,7 @@
 
 #include "renderer/ccGLStateCache.h"
 #include "renderer/CCGLProgram.h"
+#include "renderer/CCGLProgramCache.h"
 #include "renderer/CCMaterial.h"
 #include "renderer/CCTechnique.h"
 #include "renderer/CCRenderer.h"
@@ -39,6 +40,7 @@ NS_CC_BEGIN
 
 QuadCommand::QuadCommand()
 :_materialID(0)
+,_multiTextureMaterialID(0)
 ,_textureID(0)
 ,_glProgramState(nullptr)
 ,_blendType(BlendFunc::DISABLE)
@@ -90,10 +92,21 @@ void QuadCommand::generateMaterialID()
         int intArray[4] = { glProgram, (int)_textureID, (int)_blendType.src, (int)_blendType.dst};
 
         _materialID = XXH32((const void*)intArray, sizeof(intArray), 0);
+
+        // the multi-texture shader only replaces the default sprite shader
+        if (_glProgramState->getGLProgram() == GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP))
+        {
+            _multiTextureMaterialID = XXH32((const void*)(intArray + 2), sizeof(int) * 2, 0) | 1;
+        }
+        else
+        {
+            _multiTextureMaterialID = 0;
+        }
     }
     else
     {
         _materialID = Renderer::MATERIAL_ID_DO_NOT_BATCH;
+        _multiTextureMaterialID = 0;
         _skipBatching = true;
     }
 }
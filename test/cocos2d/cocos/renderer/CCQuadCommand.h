@@ -68,6 +68,8 @@ public:
     void useMaterial() const;
     /**Get the material id of command.*/
     inline uint32_t getMaterialID() const { return _materialID; }
+    /**Get the material id ignoring the texture, 0 if the command can't be drawn by a multi-texture batch.*/
+    inline uint32_t getMultiTextureMaterialID() const { return _multiTextureMaterialID; }
     /**Get the openGL texture handle.*/
     inline GLuint getTextureID() const { return _textureID; }
     /**Get the pointer of the rendered quads.*/
@@ -87,6 +89,8 @@ protected:
     
     /**Generated material id.*/
     uint32_t _materialID;
+    /**Generated material id without the texture, only set for the default sprite shader.*/
+    uint32_t _multiTextureMaterialID;
     /**OpenGL handle for texture.*/
     GLuint _textureID;
     /**GLprogramstate for the command. encapsulate shaders and uniforms.*/
@@ -206,6 +206,9 @@ Renderer::Renderer()
 ,_filledVertex(0)
 ,_filledIndex(0)
 ,_numberQuads(0)
+,_quadTextureIndexVBO(0)
+,_multiTextureBatching(false)
+,_cullingEnabled(true)
 ,_glViewAssigned(false)
 ,_isRendering(false)
 ,_isDepthTestFor2D(false)
@@ -232,6 +235,7 @@ Renderer::~Renderer()
     
     glDeleteBuffers(2, _buffersVBO);
     glDeleteBuffers(2, _quadbuffersVBO);
+    glDeleteBuffers(1, &_quadTextureIndexVBO);
     
     if (Configuration::getInstance()->supportsShareableVAO())
     {
@@ -336,6 +340,13 @@ void Renderer::setupVBOAndVAO()
     glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
     glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(V3F_C4B_T2F), (GLvoid*) offsetof( V3F_C4B_T2F, texCoords));
     
+    // texture units, only read by the multi-texture shader
+    glGenBuffers(1, &_quadTextureIndexVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _quadTextureIndexVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(_quadTextureIndices[0]) * VBO_SIZE, nullptr, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD1);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD1, 1, GL_FLOAT, GL_FALSE, sizeof(_quadTextureIndices[0]), (GLvoid*) 0);
+    
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_quadIndices[0]) * INDEX_VBO_SIZE, _quadIndices, GL_STATIC_DRAW);
     
@@ -351,6 +362,7 @@ void Renderer::setupVBO()
 {
     glGenBuffers(2, &_buffersVBO[0]);
     glGenBuffers(2, &_quadbuffersVBO[0]);
+    glGenBuffers(1, &_quadTextureIndexVBO);
     mapBuffers();
 }
 
@@ -365,6 +377,9 @@ void Renderer::mapBuffers()
     glBindBuffer(GL_ARRAY_BUFFER, _quadbuffersVBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(_quadVerts[0]) * VBO_SIZE, _quadVerts, GL_DYNAMIC_DRAW);
     
+    glBindBuffer(GL_ARRAY_BUFFER, _quadTextureIndexVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(_quadTextureIndices[0]) * VBO_SIZE, nullptr, GL_DYNAMIC_DRAW);
+    
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
@@ -810,6 +825,66 @@ void Renderer::fillQuads(const QuadCommand *cmd)
     _numberQuads += cmd->getQuadCount();
 }
 
+void Renderer::buildQuadBatches()
+{
+    const int maxTextures = std::min(MAX_BATCHED_TEXTURES, Configuration::getInstance()->getMaxTextureUnits());
+    
+    _quadBatches.clear();
+    int vertex = 0;
+    int index = 0;
+    for (const auto& cmd : _batchQuadCommands)
+    {
+        uint32_t multiTextureMaterialID = cmd->getMultiTextureMaterialID();
+        GLuint textureID = cmd->getTextureID();
+        QuadBatch* batch = _quadBatches.empty() ? nullptr : &_quadBatches.back();
+        int textureIndex = -1;
+        
+        if (batch && multiTextureMaterialID != 0 && batch->multiTextureMaterialID == multiTextureMaterialID)
+        {
+            // same shader and blend function, only the texture may change
+            for (int i = 0; i < batch->textureCount; ++i)
+            {
+                if (batch->textures[i] == textureID)
+                {
+                    textureIndex = i;
+                    break;
+                }
+            }
+            if (textureIndex < 0 && batch->textureCount < maxTextures)
+            {
+                textureIndex = batch->textureCount++;
+                batch->textures[textureIndex] = textureID;
+            }
+        }
+        else if (batch && multiTextureMaterialID == 0 && batch->multiTextureMaterialID == 0
+                 && cmd->getMaterialID() != MATERIAL_ID_DO_NOT_BATCH && batch->command->getMaterialID() == cmd->getMaterialID())
+        {
+            textureIndex = 0;
+        }
+        
+        if (textureIndex < 0)
+        {
+            QuadBatch newBatch;
+            newBatch.command = cmd;
+            newBatch.multiTextureMaterialID = multiTextureMaterialID;
+            newBatch.textures[0] = textureID;
+            newBatch.textureCount = 1;
+            newBatch.startIndex = index;
+            newBatch.indexCount = 0;
+            _quadBatches.push_back(newBatch);
+            batch = &_quadBatches.back();
+            textureIndex = 0;
+        }
+        
+        int vertexCount = (int)cmd->getQuadCount() * 4;
+        std::fill(_quadTextureIndices + vertex, _quadTextureIndices + vertex + vertexCount, (GLfloat)textureIndex);
+        vertex += vertexCount;
+        
+        batch->indexCount += (int)cmd->getQuadCount() * 6;
+        index += (int)cmd->getQuadCount() * 6;
+    }
+}
+
 void Renderer::drawBatchedTriangles()
 {
     //TODO: we can improve the draw performance by insert material switching command before hand.
@@ -931,6 +1006,11 @@ void Renderer::drawBatchedQuads()
         return;
     }
     
+    if (_multiTextureBatching)
+    {
+        buildQuadBatches();
+    }
+    
     if (Configuration::getInstance()->supportsShareableVAO())
     {
         //Bind VAO
@@ -950,6 +1030,12 @@ void Renderer::drawBatchedQuads()
         memcpy(buf, _quadVerts, sizeof(_quadVerts[0])* _numberQuads * 4);
         glUnmapBuffer(GL_ARRAY_BUFFER);
         
+        if (_multiTextureBatching)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, _quadTextureIndexVBO);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(_quadTextureIndices[0]) * _numberQuads * 4, _quadTextureIndices, GL_DYNAMIC_DRAW);
+        }
+        
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
@@ -972,9 +1058,53 @@ void Renderer::drawBatchedQuads()
         // tex coords
         glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, texCoords));
         
+        if (_multiTextureBatching)
+        {
+            GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX | (1 << GLProgram::VERTEX_ATTRIB_TEX_COORD1));
+            
+            glBindBuffer(GL_ARRAY_BUFFER, _quadTextureIndexVBO);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(_quadTextureIndices[0]) * _numberQuads * 4, _quadTextureIndices, GL_DYNAMIC_DRAW);
+            glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD1, 1, GL_FLOAT, GL_FALSE, sizeof(_quadTextureIndices[0]), (GLvoid*) 0);
+        }
+        
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadbuffersVBO[1]);
     }
 
+    if (_multiTextureBatching)
+    {
+        for (const auto& batch : _quadBatches)
+        {
+            if (batch.textureCount > 1)
+            {
+                for (int i = 0; i < batch.textureCount; ++i)
+                {
+                    GL::bindTexture2DN(i, batch.textures[i]);
+                }
+                GL::blendFunc(batch.command->getBlendType().src, batch.command->getBlendType().dst);
+                
+                auto glProgram = GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP_MULTI_TEXTURE);
+                glProgram->use();
+                glProgram->setUniformsForBuiltins(batch.command->getModelView());
+                
+                // the next command must set its material again
+                _lastMaterialID = 0;
+            }
+            else if (_lastMaterialID != batch.command->getMaterialID() || batch.command->getMaterialID() == MATERIAL_ID_DO_NOT_BATCH)
+            {
+                _lastMaterialID = batch.command->getMaterialID();
+                batch.command->useMaterial();
+            }
+            
+            glDrawElements(GL_TRIANGLES, (GLsizei) batch.indexCount, GL_UNSIGNED_SHORT, (GLvoid*) (batch.startIndex*sizeof(_indices[0])) );
+            _drawnBatches++;
+            _drawnVertices += batch.indexCount;
+        }
+        _quadBatches.clear();
+        
+        // nothing left for the single texture loop below
+        _batchQuadCommands.clear();
+    }
+
 
     // FIXME: The logic of this code is confusing, and error prone
     // Needs refactoring
@@ -1074,6 +1204,9 @@ void Renderer::flushTriangles()
 // helpers
 bool Renderer::checkVisibility(const Mat4 &transform, const Size &size)
 {
+    if (!_cullingEnabled)
+        return true;
+
     auto scene = Director::getInstance()->getRunningScene();
     
     //If draw to Rendertexture, return true directly.
@@ -132,6 +132,8 @@ public:
     static const int BATCH_QUADCOMMAND_RESEVER_SIZE = 64;
     /**Reserved for material id, which means that the command could not be batched.*/
     static const int MATERIAL_ID_DO_NOT_BATCH = 0;
+    /**The max number of textures bound by a multi-texture batch, one per built-in sampler CC_Texture0 to CC_Texture3.*/
+    static const int MAX_BATCHED_TEXTURES = 4;
     /**Constructor.*/
     Renderer();
     /**Destructor.*/
@@ -190,6 +192,24 @@ public:
     /** returns whether or not a rectangle is visible or not */
     bool checkVisibility(const Mat4& transform, const Size& size);
 
+    /**
+     * Enable/Disable the culling done by checkVisibility().
+     * It must be disabled while nodes are visited with transforms that are not in world space,
+     * when they are rendered into an offscreen texture for instance.
+     * Enabled by default.
+     */
+    void setCullingEnabled(bool enabled) { _cullingEnabled = enabled; }
+    bool isCullingEnabled() const { return _cullingEnabled; }
+
+    /**
+     * Enable/Disable multi-texture batching.
+     * When enabled, consecutive QuadCommands that use the default sprite shader and the same blend function
+     * are drawn in a single call even if their textures differ, up to MAX_BATCHED_TEXTURES textures per call.
+     * Disabled by default.
+     */
+    void setMultiTextureBatching(bool enabled) { _multiTextureBatching = enabled; }
+    bool isMultiTextureBatching() const { return _multiTextureBatching; }
+
 protected:
 
     //Setup VBO or VAO based on OpenGL extensions
@@ -215,6 +235,7 @@ protected:
 
     void fillVerticesAndIndices(const TrianglesCommand* cmd);
     void fillQuads(const QuadCommand* cmd);
+    void buildQuadBatches();
 
     /* clear color set outside be used in setGLDefaultValues() */
     Color4F _clearColor;
@@ -244,6 +265,24 @@ protected:
     GLuint _quadVAO;
     GLuint _quadbuffersVBO[2]; //0: vertex  1: indices
     int _numberQuads;
+
+    //for multi-texture batching
+    struct QuadBatch
+    {
+        QuadCommand* command;
+        uint32_t multiTextureMaterialID;
+        GLuint textures[MAX_BATCHED_TEXTURES];
+        int textureCount;
+        int startIndex;
+        int indexCount;
+    };
+    //texture unit of each vertex of _quadVerts
+    GLfloat _quadTextureIndices[VBO_SIZE];
+    GLuint _quadTextureIndexVBO;
+    std::vector<QuadBatch> _quadBatches;
+    bool _multiTextureBatching;
+
+    bool _cullingEnabled;
     
     bool _glViewAssigned;
 
@@ -54,6 +54,8 @@ NS_CC_BEGIN
 TextureAtlas::TextureAtlas()
     :_indices(nullptr)
     ,_dirty(false)
+    ,_dirtyStart(0)
+    ,_dirtyEnd(0)
     ,_texture(nullptr)
     ,_quads(nullptr)
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -106,8 +108,8 @@ void TextureAtlas::setTexture(Texture2D * var)
 
 V3F_C4B_T2F_Quad* TextureAtlas::getQuads()
 {
-    //if someone accesses the quads directly, presume that changes will be made
-    _dirty = true;
+    //if someone accesses the quads directly, presume that changes will be made to any of them
+    setDirty(true);
     return _quads;
 }
 
@@ -208,7 +210,7 @@ bool TextureAtlas::initWithTexture(Texture2D *texture, ssize_t capacity)
         setupVBO();
     }
 
-    _dirty = true;
+    setDirty(true);
 
     return true;
 }
@@ -225,7 +227,7 @@ void TextureAtlas::listenRendererRecreated(EventCustom* event)
     }
     
     // set _dirty to true to force it rebinding buffer
-    _dirty = true;
+    setDirty(true);
 }
 
 std::string TextureAtlas::getDescription() const
@@ -322,8 +324,7 @@ void TextureAtlas::updateQuad(V3F_C4B_T2F_Quad *quad, ssize_t index)
 
     _quads[index] = *quad;    
 
-
-    _dirty = true;
+    markDirty(index, 1);
 
 }
 
@@ -346,8 +347,7 @@ void TextureAtlas::insertQuad(V3F_C4B_T2F_Quad *quad, ssize_t index)
 
     _quads[index] = *quad;
 
-
-    _dirty = true;
+    markDirty(index, _totalQuads - index);
 
 }
 
@@ -370,6 +370,8 @@ void TextureAtlas::insertQuads(V3F_C4B_T2F_Quad* quads, ssize_t index, ssize_t a
     }
 
 
+    markDirty(index, _totalQuads - index);
+
     auto max = index + amount;
     int j = 0;
     for (ssize_t i = index; i < max ; i++)
@@ -378,8 +380,6 @@ void TextureAtlas::insertQuads(V3F_C4B_T2F_Quad* quads, ssize_t index, ssize_t a
         index++;
         j++;
     }
-
-    _dirty = true;
 }
 
 void TextureAtlas::insertQuadFromIndex(ssize_t oldIndex, ssize_t newIndex)
@@ -407,8 +407,7 @@ void TextureAtlas::insertQuadFromIndex(ssize_t oldIndex, ssize_t newIndex)
     memmove( &_quads[dst],&_quads[src], sizeof(_quads[0]) * howMany );
     _quads[newIndex] = quadsBackup;
 
-
-    _dirty = true;
+    markDirty(MIN(oldIndex, newIndex), howMany + 1);
 }
 
 void TextureAtlas::removeQuadAtIndex(ssize_t index)
@@ -426,8 +425,7 @@ void TextureAtlas::removeQuadAtIndex(ssize_t index)
 
     _totalQuads--;
 
-
-    _dirty = true;
+    markDirty(index, _totalQuads - index);
 }
 
 void TextureAtlas::removeQuadsAtIndex(ssize_t index, ssize_t amount)
@@ -443,7 +441,7 @@ void TextureAtlas::removeQuadsAtIndex(ssize_t index, ssize_t amount)
         memmove( &_quads[index], &_quads[index+amount], sizeof(_quads[0]) * remaining );
     }
 
-    _dirty = true;
+    markDirty(index, remaining);
 }
 
 void TextureAtlas::removeAllQuads()
@@ -522,7 +520,7 @@ bool TextureAtlas::resizeCapacity(ssize_t newCapacity)
     setupIndices();
     mapBuffers();
 
-    _dirty = true;
+    setDirty(true);
 
     return true;
 }
@@ -531,6 +529,7 @@ void TextureAtlas::increaseTotalQuadsWith(ssize_t amount)
 {
     CCASSERT(amount>=0, "amount >= 0");
     _totalQuads += amount;
+    markDirty(_totalQuads - amount, amount);
 }
 
 void TextureAtlas::moveQuadsFromIndex(ssize_t oldIndex, ssize_t amount, ssize_t newIndex)
@@ -562,7 +561,7 @@ void TextureAtlas::moveQuadsFromIndex(ssize_t oldIndex, ssize_t amount, ssize_t
 
     free(tempQuads);
 
-    _dirty = true;
+    markDirty(MIN(oldIndex, newIndex), amount + std::abs(newIndex - oldIndex));
 }
 
 void TextureAtlas::moveQuadsFromIndex(ssize_t index, ssize_t newIndex)
@@ -571,6 +570,7 @@ void TextureAtlas::moveQuadsFromIndex(ssize_t index, ssize_t newIndex)
     CCASSERT(newIndex + (_totalQuads - index) <= _capacity, "moveQuadsFromIndex move is out of bounds");
 
     memmove(_quads + newIndex,_quads + index, (_totalQuads - index) * sizeof(_quads[0]));
+    markDirty(MIN(index, newIndex), _totalQuads - index + std::abs(newIndex - index));
 }
 
 void TextureAtlas::fillWithEmptyQuadsFromIndex(ssize_t index, ssize_t amount)
@@ -584,6 +584,26 @@ void TextureAtlas::fillWithEmptyQuadsFromIndex(ssize_t index, ssize_t amount)
     {
         _quads[i] = quad;
     }
+    markDirty(index, amount);
+}
+
+void TextureAtlas::markDirty(ssize_t index, ssize_t amount)
+{
+    if (amount <= 0)
+        return;
+
+    auto end = MIN(index + amount, _capacity);
+    if (_dirty)
+    {
+        _dirtyStart = MIN(_dirtyStart, index);
+        _dirtyEnd = MAX(_dirtyEnd, end);
+    }
+    else
+    {
+        _dirtyStart = index;
+        _dirtyEnd = end;
+        _dirty = true;
+    }
 }
 
 // TextureAtlas - Drawing
@@ -618,21 +638,8 @@ void TextureAtlas::drawNumberOfQuads(ssize_t numberOfQuads, ssize_t start)
         if (_dirty) 
         {
             glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-            // option 1: subdata
-//            glBufferSubData(GL_ARRAY_BUFFER, sizeof(_quads[0])*start, sizeof(_quads[0]) * n , &_quads[start] );
-
-            // option 2: data
-//            glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
-
-            // option 3: orphaning + glMapBuffer
-            glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _capacity, nullptr, GL_DYNAMIC_DRAW);
-            void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-            memcpy(buf, _quads, sizeof(_quads[0])* _totalQuads);
-            glUnmapBuffer(GL_ARRAY_BUFFER);
-            
+            updateDirtyQuads();
             glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-            _dirty = false;
         }
 
         GL::bindVAO(_VAOname);
@@ -663,8 +670,7 @@ void TextureAtlas::drawNumberOfQuads(ssize_t numberOfQuads, ssize_t start)
         // FIXME:: update is done in draw... perhaps it should be done in a timer
         if (_dirty) 
         {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(_quads[0]) * _totalQuads , &_quads[0] );
-            _dirty = false;
+            updateDirtyQuads();
         }
 
         GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
@@ -691,6 +697,28 @@ void TextureAtlas::drawNumberOfQuads(ssize_t numberOfQuads, ssize_t start)
     CHECK_GL_ERROR_DEBUG();
 }
 
+void TextureAtlas::updateDirtyQuads()
+{
+    // the array buffer must be bound
+    auto end = MIN(_dirtyEnd, _totalQuads);
+    if (_dirtyStart == 0 && end == _totalQuads && end > 0)
+    {
+        // everything changed: orphaning + glMapBuffer, so the driver doesn't wait for the previous draws
+        glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _capacity, nullptr, GL_DYNAMIC_DRAW);
+        void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+        memcpy(buf, _quads, sizeof(_quads[0]) * _totalQuads);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    else if (end > _dirtyStart)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _dirtyStart, sizeof(_quads[0]) * (end - _dirtyStart), &_quads[_dirtyStart]);
+    }
+
+    _dirty = false;
+    _dirtyStart = 0;
+    _dirtyEnd = 0;
+}
+
 
 NS_CC_END
 
@@ -210,8 +210,15 @@ public:
 
     /** Whether or not the array buffer of the VBO needs to be updated.*/
     inline bool isDirty(void) { return _dirty; }
-    /** Specify if the array buffer of the VBO needs to be updated. */
-    inline void setDirty(bool bDirty) { _dirty = bDirty; }
+    /** Specify if the array buffer of the VBO needs to be updated, true marks all the quads as modified. */
+    inline void setDirty(bool bDirty) { _dirty = bDirty; _dirtyStart = 0; _dirtyEnd = bDirty ? _capacity : 0; }
+
+    /** Marks a range of quads as modified, only the modified quads are uploaded by the next draw.
+     Use it instead of setDirty(true) after writing some of the quads returned by getQuads().
+
+     @since v3.10
+     */
+    void markDirty(ssize_t index, ssize_t amount);
 
     /**Get quads total amount.
      * @js NA
@@ -244,12 +251,16 @@ private:
     void mapBuffers();
     void setupVBOandVAO();
     void setupVBO();
+    void updateDirtyQuads();
 
 protected:
     GLushort*           _indices;
     GLuint              _VAOname;
     GLuint              _buffersVBO[2]; //0: vertex  1: indices
     bool                _dirty; //indicates whether or not the array buffer of the VBO needs to be updated
+    /** range of quads [_dirtyStart, _dirtyEnd) modified since the last upload */
+    ssize_t _dirtyStart;
+    ssize_t _dirtyEnd;
     /** quantity of quads that are going to be drawn */
     ssize_t _totalQuads;
     /** quantity of quads that can be stored with the current texture atlas size */
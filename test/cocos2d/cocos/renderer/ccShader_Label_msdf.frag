@@ -0,0 +1,22 @@
+const char* ccLabelMultiChannelDistanceFieldNormal_frag = STRINGIFY(
+
+\n#ifdef GL_ES\n
+precision mediump float; 
+\n#endif\n
+ 
+varying vec4 v_fragmentColor; 
+varying vec2 v_texCoord;
+
+uniform vec4 u_textColor;
+// half of the smoothing band, in distance units, the label sets it from its scale \n
+uniform float u_smoothing;
+ 
+void main() 
+{
+    vec3 texel = texture2D(CC_Texture0, v_texCoord).rgb;
+    // each channel keeps the edges of one corner side, the median restores the sharp corners \n
+    float dist = max(min(texel.r, texel.g), min(max(texel.r, texel.g), texel.b));
+    float alpha = smoothstep(0.5-u_smoothing, 0.5+u_smoothing, dist) * u_textColor.a; 
+    gl_FragColor = v_fragmentColor * vec4(u_textColor.rgb,alpha);
+}
+);
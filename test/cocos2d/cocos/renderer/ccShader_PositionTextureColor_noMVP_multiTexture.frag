@@ -0,0 +1,26 @@
+const char* ccPositionTextureColorMultiTexture_noMVP_frag = STRINGIFY(
+\n#ifdef GL_ES\n
+precision lowp float;
+varying mediump float v_textureIndex;
+\n#else\n
+varying float v_textureIndex;
+\n#endif\n
+
+varying vec4 v_fragmentColor;
+varying vec2 v_texCoord;
+
+void main()
+{
+    // samplers can't be indexed dynamically in GLSL ES 1.0 \n
+    vec4 texel;
+    if (v_textureIndex < 0.5)
+        texel = texture2D(CC_Texture0, v_texCoord);
+    else if (v_textureIndex < 1.5)
+        texel = texture2D(CC_Texture1, v_texCoord);
+    else if (v_textureIndex < 2.5)
+        texel = texture2D(CC_Texture2, v_texCoord);
+    else
+        texel = texture2D(CC_Texture3, v_texCoord);
+    gl_FragColor = v_fragmentColor * texel;
+}
+);
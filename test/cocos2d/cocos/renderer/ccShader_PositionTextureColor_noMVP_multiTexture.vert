@@ -0,0 +1,25 @@
+const char* ccPositionTextureColorMultiTexture_noMVP_vert = STRINGIFY(
+attribute vec4 a_position;
+attribute vec2 a_texCoord;
+attribute vec4 a_color;
+// index of the texture unit sampled by the quad \n
+attribute float a_texCoord1;
+
+\n#ifdef GL_ES\n
+varying lowp vec4 v_fragmentColor;
+varying mediump vec2 v_texCoord;
+varying mediump float v_textureIndex;
+\n#else\n
+varying vec4 v_fragmentColor;
+varying vec2 v_texCoord;
+varying float v_textureIndex;
+\n#endif\n
+
+void main()
+{
+    gl_Position = CC_PMatrix * a_position;
+    v_fragmentColor = a_color;
+    v_texCoord = a_texCoord;
+    v_textureIndex = a_texCoord1;
+}
+);
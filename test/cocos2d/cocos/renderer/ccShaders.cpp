@@ -57,6 +57,8 @@ NS_CC_BEGIN
 //
 #include "ccShader_PositionTextureColor_noMVP.frag"
 #include "ccShader_PositionTextureColor_noMVP.vert"
+#include "ccShader_PositionTextureColor_noMVP_multiTexture.frag"
+#include "ccShader_PositionTextureColor_noMVP_multiTexture.vert"
 
 //
 #include "ccShader_PositionTextureColorAlphaTest.frag"
@@ -73,6 +75,7 @@ NS_CC_BEGIN
 #include "ccShader_Label.vert"
 #include "ccShader_Label_df.frag"
 #include "ccShader_Label_df_glow.frag"
+#include "ccShader_Label_msdf.frag"
 #include "ccShader_Label_normal.frag"
 #include "ccShader_Label_outline.frag"
 
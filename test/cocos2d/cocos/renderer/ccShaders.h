@@ -57,6 +57,8 @@ extern CC_DLL const GLchar * ccPositionTextureColor_vert;
 
 extern CC_DLL const GLchar * ccPositionTextureColor_noMVP_frag;
 extern CC_DLL const GLchar * ccPositionTextureColor_noMVP_vert;
+extern CC_DLL const GLchar * ccPositionTextureColorMultiTexture_noMVP_frag;
+extern CC_DLL const GLchar * ccPositionTextureColorMultiTexture_noMVP_vert;
 
 extern CC_DLL const GLchar * ccPositionTextureColorAlphaTest_frag;
 
@@ -70,6 +72,7 @@ extern CC_DLL const GLchar * ccPositionTexture_GrayScale_frag;
 
 extern CC_DLL const GLchar * ccLabelDistanceFieldNormal_frag;
 extern CC_DLL const GLchar * ccLabelDistanceFieldGlow_frag;
+extern CC_DLL const GLchar * ccLabelMultiChannelDistanceFieldNormal_frag;
 extern CC_DLL const GLchar * ccLabelNormal_frag;
 extern CC_DLL const GLchar * ccLabelOutline_frag;
 
@@ -166,24 +166,28 @@ void RichText::insertElement(RichElement *element, int index)
 {
     _richElements.insert(index, element);
     _formatTextDirty = true;
+    invalidateCachedAncestors();
 }
     
 void RichText::pushBackElement(RichElement *element)
 {
     _richElements.pushBack(element);
     _formatTextDirty = true;
+    invalidateCachedAncestors();
 }
     
 void RichText::removeElement(int index)
 {
     _richElements.erase(index);
     _formatTextDirty = true;
+    invalidateCachedAncestors();
 }
     
 void RichText::removeElement(RichElement *element)
 {
     _richElements.eraseObject(element);
     _formatTextDirty = true;
+    invalidateCachedAncestors();
 }
     
 void RichText::formatText()
@@ -505,6 +509,7 @@ void RichText::ignoreContentAdaptWithSize(bool ignore)
     if (_ignoreSize != ignore)
     {
         _formatTextDirty = true;
+        invalidateCachedAncestors();
         Widget::ignoreContentAdaptWithSize(ignore);
     }
 }
@@ -17,9 +17,18 @@
 
 #ifndef BT_NO_PROFILE
 
+#include <thread>
 
 static btClock gProfileClock;
 
+// the profile tree isn't thread safe, only the first thread to profile records samples,
+// the worker threads of a parallel simulation are ignored
+static bool btIsProfileThread()
+{
+	static const std::thread::id profileThread = std::this_thread::get_id();
+	return std::this_thread::get_id() == profileThread;
+}
+
 
 #ifdef __CELLOS_LV2__
 #include <sys/sys_time.h>
@@ -451,6 +460,9 @@ unsigned long int			CProfileManager::ResetTime = 0;
  *=============================================================================================*/
 void	CProfileManager::Start_Profile( const char * name )
 {
+	if (!btIsProfileThread())
+		return;
+
 	if (name != CurrentNode->Get_Name()) {
 		CurrentNode = CurrentNode->Get_Sub_Node( name );
 	} 
@@ -464,6 +476,9 @@ void	CProfileManager::Start_Profile( const char * name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	if (!btIsProfileThread())
+		return;
+
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
 	if (CurrentNode->Return()) {
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+# pack-archive.py: packs a resource directory into a cocos2d-x ".cpk" archive
+#
+# Copyright (c) 2015 Chukong Technologies Inc.
+#
+# License: MIT
+# ----------------------------------------------------------------------------
+'''
+Packs a resource directory into an archive readable by cocos2d::FileArchive.
+
+Usage:
+    pack-archive.py [options] <resource dir> <output.cpk>
+
+Entry names are the paths relative to the resource directory, with '/' as separator.
+Mount the archive with FileUtils::addArchive("output.cpk") and keep loading files
+with their usual relative names.
+
+Layout (little-endian), see cocos/platform/CCFileArchive.h:
+    header   "CCPK", u32 version, u32 entry count, u32 alignment, u64 index offset, u64 names offset
+    index    u64 hash, u64 offset, u32 size, u32 compressed size, u32 name offset, u16 name length,
+             u8 compression, u8 reserved -- sorted by hash
+    names    entry names, not null terminated
+    data     entry data, stored entries are aligned
+'''
+
+import fnmatch
+import optparse
+import os
+import struct
+import sys
+import zlib
+
+ARCHIVE_MAGIC = b'CCPK'
+ARCHIVE_VERSION = 1
+HEADER_FORMAT = '<4sIIIQQ'
+ENTRY_FORMAT = '<QQIIIHBB'
+
+COMPRESSION_NONE = 0
+COMPRESSION_ZLIB = 1
+
+# These are compressed already, deflating them again only costs load time.
+DEFAULT_STORED = '*.png,*.jpg,*.jpeg,*.webp,*.pvr,*.pvr.ccz,*.pkm,*.ktx,*.mp3,*.ogg,*.m4a,*.caf,*.mp4'
+
+
+def hash_name(name):
+    ''' 64 bits FNV-1a, must match FileArchive::hashName() '''
+    h = 14695981039346656037
+    for c in bytearray(name):
+        h ^= c
+        h = (h * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def collect_files(root, excludes):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(dirpath, filename)
+            name = os.path.relpath(path, root).replace(os.sep, '/')
+            if any(fnmatch.fnmatch(name, pattern) for pattern in excludes):
+                continue
+            files.append((name, path))
+    return files
+
+
+def pack(root, output, alignment, level, stored_patterns, excludes, verbose):
+    entries = []
+    for name, path in collect_files(root, excludes):
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        compression = COMPRESSION_NONE
+        payload = data
+        if level > 0 and not any(fnmatch.fnmatch(name.lower(), p) for p in stored_patterns):
+            deflated = zlib.compress(data, level)
+            # only keep the compressed data if it saves at least 1/8
+            if len(deflated) < len(data) - len(data) // 8:
+                compression = COMPRESSION_ZLIB
+                payload = deflated
+
+        entries.append({
+            'name': name.encode('utf-8'),
+            'size': len(data),
+            'payload': payload,
+            'compression': compression,
+        })
+
+    entries.sort(key=lambda e: (hash_name(e['name']), e['name']))
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    index_offset = header_size
+    names_offset = index_offset + entry_size * len(entries)
+
+    names = b''
+    for entry in entries:
+        entry['name_offset'] = len(names)
+        names += entry['name']
+
+    offset = names_offset + len(names)
+    for entry in entries:
+        if entry['compression'] == COMPRESSION_NONE:
+            offset = align(offset, alignment)
+        entry['offset'] = offset
+        offset += len(entry['payload'])
+
+    with open(output, 'wb') as out:
+        out.write(struct.pack(HEADER_FORMAT, ARCHIVE_MAGIC, ARCHIVE_VERSION, len(entries), alignment,
+                              index_offset, names_offset))
+        for entry in entries:
+            out.write(struct.pack(ENTRY_FORMAT, hash_name(entry['name']), entry['offset'], entry['size'],
+                                  len(entry['payload']), entry['name_offset'], len(entry['name']),
+                                  entry['compression'], 0))
+        out.write(names)
+        for entry in entries:
+            out.write(b'\0' * (entry['offset'] - out.tell()))
+            out.write(entry['payload'])
+            if verbose:
+                print('%s %d -> %d%s' % (entry['name'].decode('utf-8'), entry['size'], len(entry['payload']),
+                                         ' (zlib)' if entry['compression'] == COMPRESSION_ZLIB else ''))
+
+    total = sum(e['size'] for e in entries)
+    packed = os.path.getsize(output)
+    print('%d files, %d bytes packed into %s (%d bytes)' % (len(entries), total, output, packed))
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] <resource dir> <output.cpk>')
+    parser.add_option('-a', '--alignment', type='int', default=16,
+                      help='alignment of the stored entries, use 4096 to map them by pages [default: %default]')
+    parser.add_option('-l', '--level', type='int', default=6,
+                      help='zlib compression level, 0 stores every file [default: %default]')
+    parser.add_option('-s', '--store', default=DEFAULT_STORED,
+                      help='comma separated patterns of files that are never compressed [default: %default]')
+    parser.add_option('-x', '--exclude', action='append', default=[],
+                      help='pattern of files that are not packed, can be repeated')
+    parser.add_option('-v', '--verbose', action='store_true', default=False)
+    options, args = parser.parse_args()
+
+    if len(args) != 2:
+        parser.error('expected a resource directory and an output file')
+    if options.alignment <= 0 or options.alignment & (options.alignment - 1):
+        parser.error('the alignment must be a power of 2')
+    if not os.path.isdir(args[0]):
+        parser.error('%s is not a directory' % args[0])
+
+    stored = [p.strip().lower() for p in options.store.split(',') if p.strip()]
+    pack(args[0], args[1], options.alignment, options.level, stored, options.exclude, options.verbose)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())